@@ -1,7 +1,8 @@
 /* Test "client" for the shared memory interface.
  *
  * Waits on the incoming queue, prints received samples and writes them
- * back to the other queue.
+ * back to the other queue. In state mode, the output state vector of the
+ * node is polled and copied back to its input state vector.
  *
  * Author: Georg Martin Reinke <georg.reinke@rwth-aachen.de>
  * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
@@ -9,7 +10,9 @@
  */
 
 #include <atomic>
+#include <cstring>
 #include <iostream>
+#include <sys/resource.h>
 
 #include <villas/colors.hpp>
 #include <villas/log.hpp>
@@ -19,6 +22,7 @@
 #include <villas/pool.hpp>
 #include <villas/sample.hpp>
 #include <villas/shmem.hpp>
+#include <villas/task.hpp>
 #include <villas/tool.hpp>
 #include <villas/utils.hpp>
 
@@ -36,28 +40,112 @@ protected:
 
   void usage() {
     std::cout
-        << "Usage: villas-test-shmem WNAME VECTORIZE" << std::endl
+        << "Usage: villas-test-shmem WNAME RNAME VECTORIZE [MODE]" << std::endl
+        << "       villas-test-shmem state WNAME RNAME [RATE]" << std::endl
         << "  WNAME     name of the shared memory object for the output queue"
         << std::endl
         << "  RNAME     name of the shared memory object for the input queue"
         << std::endl
         << "  VECTORIZE maximum number of samples to read/write at a time"
-        << std::endl;
+        << std::endl
+        << "  MODE      signalling mode of the queues: polling, pthread"
+#ifdef HAS_FUTEX
+        << " or futex"
+#endif
+        << " (default: pthread)" << std::endl
+        << "  RATE      rate in Hz at which the state vector is polled"
+        << " (default: 1000)" << std::endl;
 
     printCopyright();
   }
 
   void handler(int, siginfo_t *, void *) { stop = true; }
 
+  /* Attach to the state vectors created by a node with layout "state".
+   *
+   * The node owns the shared memory objects and unlinks them when stopped.
+   */
+  int mainState() {
+    int ret;
+    struct ShmemStateInterface in, out;
+
+    if (argc != 4 && argc != 5) {
+      usage();
+      return 1;
+    }
+
+    std::string wname = argv[2];
+    std::string rname = argv[3];
+    double rate = argc == 5 ? atof(argv[4]) : 1000;
+
+    if (rate <= 0)
+      throw RuntimeError("Rate must be positive");
+
+    ret = shmem_state_open(rname.c_str(), &in, 0, false);
+    if (ret < 0)
+      throw RuntimeError("Failed to open input state vector (ret={})", ret);
+
+    ret = shmem_state_open(wname.c_str(), &out, 0, false);
+    if (ret < 0)
+      throw RuntimeError("Failed to open output state vector (ret={})", ret);
+
+    auto *smp = sample_alloc_mem(in.state->capacity);
+
+    Task task;
+    task.setRate(rate);
+
+    unsigned long total = 0;
+    uint64_t last = 0;
+
+    while (!stop) {
+      if (task.wait() == 0) {
+        if (stop)
+          break;
+
+        throw SystemError("Failed to wait for task");
+      }
+
+      ret = shmem_state_read(in.state, smp, &last);
+      if (ret < 0) {
+        logger->warn("Input state vector is not consistent");
+        continue;
+      } else if (ret == 0)
+        continue;
+
+      shmem_state_write(out.state, smp);
+
+      total++;
+    }
+
+    task.stop();
+
+    logger->info("Forwarded {} states", total);
+
+    sample_free(smp);
+
+    ret = shmem_state_close(&in, false);
+    if (ret)
+      throw RuntimeError("Failed to close input state vector");
+
+    ret = shmem_state_close(&out, false);
+    if (ret)
+      throw RuntimeError("Failed to close output state vector");
+
+    return 0;
+  }
+
   int main() {
     int ret, readcnt, writecnt, avail;
 
+    if (argc >= 2 && !strcmp(argv[1], "state"))
+      return mainState();
+
     struct ShmemInterface shm;
-    struct ShmemConfig conf = {.polling = 0,
+    struct ShmemConfig conf = {.mode = QueueSignalledMode::PTHREAD,
                                .queuelen = DEFAULT_SHMEM_QUEUELEN,
                                .samplelen = DEFAULT_SHMEM_SAMPLELEN};
 
-    if (argc != 4) {
+    if (argc != 4 && argc != 5) {
       usage();
       return 1;
     }
@@ -66,6 +154,21 @@ protected:
     std::string rname = argv[2];
     int vectorize = atoi(argv[3]);
 
+    if (argc == 5) {
+      if (!strcmp(argv[4], "polling"))
+        conf.mode = QueueSignalledMode::POLLING;
+      else if (!strcmp(argv[4], "pthread"))
+        conf.mode = QueueSignalledMode::PTHREAD;
+#ifdef HAS_FUTEX
+      else if (!strcmp(argv[4], "futex"))
+        conf.mode = QueueSignalledMode::FUTEX;
+#endif
+      else
+        throw RuntimeError("Unknown mode '{}'", argv[4]);
+    }
+
+    unsigned long total = 0;
+
     ret = shmem_int_open(wname.c_str(), rname.c_str(), &shm, &conf);
     if (ret < 0)
       throw RuntimeError("Failed to open shared-memory interface");
@@ -101,8 +204,21 @@ protected:
         logger->warn("Short write");
 
       logger->info("Read / Write: {}/{}", readcnt, writecnt);
+
+      total += writecnt;
     }
 
+    // Report CPU time so that the signalling modes can be compared
+    struct rusage usage;
+    ret = getrusage(RUSAGE_SELF, &usage);
+    if (ret == 0)
+      logger->info("Forwarded {} samples: user={:.3f}s, system={:.3f}s, "
+                   "vcsw={}, ivcsw={}",
+                   total,
+                   usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6,
+                   usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6,
+                   usage.ru_nvcsw, usage.ru_nivcsw);
+
     ret = shmem_int_close(&shm);
     if (ret)
       throw RuntimeError("Failed to close shared-memory interface");
@@ -0,0 +1,108 @@
+/* Digital filters for multiple channels.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace villas {
+namespace dsp {
+
+// Second-order section: (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+struct Biquad {
+  double b0, b1, b2;
+  double a1, a2;
+};
+
+/* Filter designs.
+ *
+ * All frequencies are normalized to the sample rate (cycles per sample) and
+ * must be in the range (0, 0.5). IIR designs use the bilinear transform with
+ * frequency pre-warping. */
+namespace design {
+
+std::vector<Biquad> butterworth(unsigned order, double cutoff,
+                                bool highpass = false);
+
+// Chebyshev type I with a passband ripple in dB
+std::vector<Biquad> chebyshev1(unsigned order, double ripple, double cutoff,
+                               bool highpass = false);
+
+// Notch filter with the quality factor q = frequency / bandwidth
+std::vector<Biquad> notch(double frequency, double q);
+
+// Windowed-sinc FIR with a Hamming window
+std::vector<double> fir(unsigned taps, double cutoff, bool highpass = false);
+
+} // namespace design
+
+// A filter which processes one sample of a number of channels at once
+class Filter {
+
+protected:
+  size_t channels;
+
+public:
+  Filter(size_t chans) : channels(chans) {}
+
+  virtual ~Filter() = default;
+
+  // Filter in-place one value per channel
+  virtual void process(double *x) = 0;
+
+  virtual void reset() = 0;
+
+  size_t getChannels() const { return channels; }
+};
+
+/* Cascade of biquads in transposed direct form II.
+ *
+ * The state is stored as structure of arrays, so that each section is applied
+ * to all channels in a single vectorizable loop. */
+class BiquadCascade : public Filter {
+
+protected:
+  std::vector<Biquad> sections;
+
+  std::vector<double> z1; // sections rows of channels values
+  std::vector<double> z2;
+
+public:
+  BiquadCascade(const std::vector<Biquad> &sos, size_t chans);
+
+  virtual void process(double *x);
+
+  virtual void reset();
+
+  const std::vector<Biquad> &getSections() const { return sections; }
+};
+
+/* FIR filter.
+ *
+ * The history of all channels is kept in a mirrored ring buffer of rows, so
+ * that each tap is applied to all channels in a single vectorizable loop. */
+class FirFilter : public Filter {
+
+protected:
+  std::vector<double> coefficients;
+
+  std::vector<double> history;
+  size_t position; // Row of the newest value
+
+public:
+  FirFilter(const std::vector<double> &coeffs, size_t chans);
+
+  virtual void process(double *x);
+
+  virtual void reset();
+
+  const std::vector<double> &getCoefficients() const { return coefficients; }
+};
+
+} // namespace dsp
+} // namespace villas
@@ -0,0 +1,119 @@
+/* Spectral analysis based on precomputed twiddle factors.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <complex>
+#include <memory>
+#include <vector>
+
+namespace villas {
+namespace dsp {
+
+// A mixed-radix FFT of arbitrary length
+class FFT {
+
+public:
+  using complex = std::complex<double>;
+
+protected:
+  size_t length;
+
+  std::vector<size_t> factors;
+  std::vector<complex> twiddles; // exp(-2 pi i k / length)
+  std::vector<complex> scratch;
+
+  // Half-length transform used for real-valued inputs of even length
+  std::unique_ptr<FFT> half;
+  std::vector<complex> packed; // Also used for odd lengths
+  std::vector<complex> packedOut;
+
+  void work(complex *out, const complex *in, size_t stride,
+            const size_t *factor, size_t n);
+
+  void butterfly(complex *out, size_t stride, size_t m, size_t p);
+
+public:
+  FFT(size_t len);
+
+  size_t size() const { return length; }
+
+  // Approximate number of complex multiply-adds of a single transform
+  size_t cost() const;
+
+  const std::vector<complex> &getTwiddles() const { return twiddles; }
+
+  // Returns exp(-2 pi i k / size()) for any k
+  complex twiddle(long k) const {
+    long r = k % (long)length;
+
+    return twiddles[r < 0 ? r + length : r];
+  }
+
+  // Forward transform of size() complex values
+  void transform(const complex *in, complex *out);
+
+  // Forward transform of size() real values, writes bins 0 .. size() / 2
+  void transformReal(const double *in, complex *out);
+};
+
+/* Selected bins of the DFT of a real-valued, zero-padded signal.
+ *
+ * Depending on the number of requested bins, they are either taken from a full
+ * FFT or calculated directly from the twiddle table. */
+class Spectrum {
+
+public:
+  using complex = FFT::complex;
+
+protected:
+  FFT fft;
+
+  std::vector<double> padded;
+  std::vector<complex> bins;
+
+  // Whether the bins of the last transform() are taken from a full FFT
+  bool full;
+
+  /* Rows of twiddle factors for a contiguous range of bins
+   *
+   * Hooks request the same bins for each window. Keeping the twiddle factors
+   * of these bins in contiguous memory is much faster than a strided access
+   * to the twiddle table of the FFT. */
+  std::vector<complex> rows;
+  long rowsFirst;
+  size_t rowsCount;
+  size_t rowsLength;
+
+  void transform(const double *in, size_t len, size_t count);
+
+  complex bin(const double *in, size_t len, long k) const;
+
+  bool prepareRows(long first, size_t count, size_t len);
+
+public:
+  // Maximum number of twiddle factors in the precomputed rows
+  static constexpr size_t MAX_ROWS_SIZE = 1 << 18;
+
+  Spectrum(size_t len);
+
+  size_t size() const { return fft.size(); }
+
+  complex twiddle(long k) const { return fft.twiddle(k); }
+
+  /* Calculate the bins first .. first + count - 1 of the DFT of the first len
+   * samples of in, zero-padded to size(). */
+  void compute(const double *in, size_t len, complex *out, long first,
+               size_t count);
+
+  // Calculate the bins given by indices of the DFT of in
+  void compute(const double *in, size_t len, complex *out,
+               const std::vector<long> &indices);
+};
+
+} // namespace dsp
+} // namespace villas
@@ -7,66 +7,104 @@
 
 #pragma once
 
-#include <deque>
+#include <cstddef>
+#include <vector>
 
 namespace villas {
 namespace dsp {
 
-template <typename T, typename Container = std::deque<T>>
-class Window : protected Container {
+/* A sliding window backed by a mirrored ring buffer.
+ *
+ * The ring buffer has a power-of-two capacity. Each sample is stored twice:
+ * at its slot and at the same slot in a second copy directly behind the
+ * first one. Hence, the window is always available as a single contiguous
+ * span from the oldest to the newest sample. */
+template <typename T> class Window {
 
 public:
-  using iterator = typename Container::iterator;
-  using size_type = typename Container::size_type;
+  using size_type = std::size_t;
+  using iterator = const T *;
 
 protected:
-  virtual T filter(T in, size_type i) const { return in; }
+  std::vector<T> buffer;
 
-  class transform_iterator : public Container::const_iterator {
-  protected:
-    const Window *window;
+  size_type length;
+  size_type capacity;
+  size_type head; // Slot of the oldest sample
 
-    using base_iterator = typename Container::const_iterator;
-
-  public:
-    transform_iterator(const Window<T> *w)
-        : base_iterator(w->Container::begin()), window(w) {}
+  virtual T filter(T in, size_type i) const { return in; }
 
-    T operator*() {
-      auto i = (*this) - window->begin();
-      const auto &v = base_iterator::operator*();
+  static size_type roundCapacity(size_type l) {
+    size_type c = 1;
+    while (c < l)
+      c <<= 1;
 
-      return window->filter(v, i);
-    }
-  };
+    return c;
+  }
 
 public:
-  Window(size_type l = 0, T i = 0) : Container(l, i) {}
+  Window(size_type l = 0, T i = 0)
+      : buffer(2 * roundCapacity(l), i), length(l),
+        capacity(roundCapacity(l)), head(0) {}
+
+  virtual ~Window() = default;
 
-  T val(size_type pos) { return this->Container::operator[](pos); }
+  // Contiguous span of all samples, ordered from the oldest to the newest one
+  const T *data() const noexcept { return &buffer[head]; }
+
+  T val(size_type pos) const { return data()[pos]; }
 
   T update(T in) {
-    Container::push_back(in);
+    auto out = buffer[head];
+
+    // The slot of the oldest sample becomes the slot of the newest one
+    size_type tail = (head + length) & (capacity - 1);
 
-    auto out = (*this)[0];
+    buffer[tail] = in;
+    buffer[tail + capacity] = in;
 
-    Container::pop_front();
+    head = (head + 1) & (capacity - 1);
 
     return out;
   }
 
-  // Expose a limited number of functions from deque
+  size_type size() const noexcept { return length; }
 
-  using Container::end;
-  using Container::size;
+  size_type getLength() const noexcept { return length; }
 
-  transform_iterator begin() const noexcept { return transform_iterator(this); }
+  // Iterate over the unfiltered samples
+  iterator begin() const noexcept { return data(); }
+  iterator end() const noexcept { return data() + length; }
 
   T operator[](size_type i) const noexcept {
-    auto v = Container::operator[](i);
+    auto v = data()[i];
 
     return filter(v, i);
   }
+
+  // Sum of all unfiltered samples
+  T sum() const {
+    const T *d = data();
+    T acc = 0;
+
+#pragma omp simd reduction(+ : acc)
+    for (size_type i = 0; i < length; i++)
+      acc += d[i];
+
+    return acc;
+  }
+
+  // Dot product of the unfiltered samples with a coefficient vector
+  T dot(const T *coeffs) const {
+    const T *d = data();
+    T acc = 0;
+
+#pragma omp simd reduction(+ : acc)
+    for (size_type i = 0; i < length; i++)
+      acc += d[i] * coeffs[i];
+
+    return acc;
+  }
 };
 
 } // namespace dsp
@@ -46,6 +46,21 @@ public:
   }
 
   virtual T getCorrectionFactor() const { return correctionFactor; }
+
+  const T *getCoefficients() const { return coefficients.data(); }
+
+  // Write the weighted samples from the oldest to the newest one to out
+  void apply(T *out) const {
+    const T *d = this->data();
+    const T *c = coefficients.data();
+
+#pragma omp simd
+    for (size_type i = 0; i < this->size(); i++)
+      out[i] = d[i] * c[i];
+  }
+
+  // Sum of the weighted samples
+  T filteredSum() const { return this->dot(coefficients.data()); }
 };
 
 // From: https://en.wikipedia.org/wiki/Window_function#Cosine-sum_windows
@@ -0,0 +1,91 @@
+/* Numerically stable sliding-window sums over multiple channels.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace villas {
+namespace dsp {
+
+// Compensated (Kahan-Babuska) summation
+class CompensatedSum {
+
+protected:
+  double sum;
+  double compensation;
+
+public:
+  CompensatedSum() : sum(0), compensation(0) {}
+
+  void add(double x) {
+    // Branch-free two-sum: the rounding error of sum + x is exact
+    double s = sum + x;
+    double bp = s - sum;
+    double err = (sum - (s - bp)) + (x - bp);
+
+    sum = s;
+    compensation += err;
+  }
+
+  double value() const { return sum + compensation; }
+
+  void reset() {
+    sum = 0;
+    compensation = 0;
+  }
+};
+
+/* Sums over a sliding window of the last samples of multiple channels.
+ *
+ * The history is stored as structure of arrays: one row of all channels per
+ * sample. Thereby, a single pass over a row updates all channels at once.
+ * The running sums use compensated summation and are recalculated from the
+ * history each time the window wrapped around, so rounding errors can not
+ * accumulate over long runs.
+ *
+ * Channels can hold arbitrary terms like x, x^2 or u * i to get sums,
+ * sums of squares or cross-products. */
+class WindowStats {
+
+protected:
+  size_t length;
+  size_t channels;
+
+  std::vector<double> history; // length rows of channels values
+  std::vector<double> sums;
+  std::vector<double> compensations;
+
+  size_t position;  // Row which will be overwritten next
+  uint64_t updates; // Total number of samples
+
+  void recalculate();
+
+public:
+  WindowStats(size_t len = 0, size_t chans = 0);
+
+  void reset();
+
+  // Add one new value per channel and drop the oldest ones
+  void update(const double *in);
+
+  double sum(size_t ch) const { return sums[ch] + compensations[ch]; }
+
+  double mean(size_t ch) const { return sum(ch) / length; }
+
+  // Whether the window has been filled completely
+  bool isFull() const { return updates >= length; }
+
+  size_t getLength() const { return length; }
+
+  size_t getChannels() const { return channels; }
+};
+
+} // namespace dsp
+} // namespace villas
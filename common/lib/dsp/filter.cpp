@@ -0,0 +1,231 @@
+/* Digital filters for multiple channels.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstring>
+
+#include <villas/dsp/filter.hpp>
+#include <villas/exceptions.hpp>
+
+using namespace villas;
+using namespace villas::dsp;
+
+using complex = std::complex<double>;
+
+static void checkFrequency(double f) {
+  if (f <= 0 || f >= 0.5)
+    throw RuntimeError("Normalized frequency {} must be in the range (0, 0.5)",
+                       f);
+}
+
+/* Map the left-half plane poles of an analog low-pass prototype with unity
+ * cutoff to biquads.
+ *
+ * Each pair of complex conjugate poles forms a second-order section, a single
+ * real pole a first-order section. The zeros are placed at z = -1 for
+ * low-pass and at z = 1 for high-pass filters. Each section is normalized to
+ * unity gain at DC or Nyquist respectively. */
+static std::vector<Biquad> bilinear(const std::vector<complex> &poles,
+                                    double cutoff, bool highpass) {
+  checkFrequency(cutoff);
+
+  // Pre-warped analog cutoff for the bilinear transform s = 2 (z - 1) / (z + 1)
+  double wc = 2 * tan(M_PI * cutoff);
+  double zero = highpass ? 1 : -1;
+
+  std::vector<Biquad> sos;
+
+  for (auto p : poles) {
+    // Only take one pole of each conjugate pair
+    if (p.imag() < -1e-12)
+      continue;
+
+    complex s = highpass ? wc / p : wc * p;
+    complex z = (2.0 + s) / (2.0 - s);
+
+    Biquad bq;
+    if (std::abs(p.imag()) <= 1e-12) {
+      bq = {1, -zero, 0, -z.real(), 0};
+    } else {
+      bq = {1, -2 * zero, 1, -2 * z.real(), std::norm(z)};
+    }
+
+    // Normalize the gain at z = 1 for low-pass, z = -1 for high-pass
+    double r = -zero;
+    double num = bq.b0 + bq.b1 * r + bq.b2 * r * r;
+    double den = 1 + bq.a1 * r + bq.a2 * r * r;
+    double g = den / num;
+
+    bq.b0 *= g;
+    bq.b1 *= g;
+    bq.b2 *= g;
+
+    sos.push_back(bq);
+  }
+
+  return sos;
+}
+
+std::vector<Biquad> dsp::design::butterworth(unsigned order, double cutoff,
+                                             bool highpass) {
+  if (order < 1)
+    throw RuntimeError("Filter order must be positive");
+
+  std::vector<complex> poles;
+  for (unsigned k = 0; k < order; k++)
+    poles.push_back(std::polar(1.0, M_PI * (2 * k + order + 1) / (2 * order)));
+
+  return bilinear(poles, cutoff, highpass);
+}
+
+std::vector<Biquad> dsp::design::chebyshev1(unsigned order, double ripple,
+                                            double cutoff, bool highpass) {
+  if (order < 1)
+    throw RuntimeError("Filter order must be positive");
+
+  if (ripple <= 0)
+    throw RuntimeError("Passband ripple must be positive");
+
+  double eps = sqrt(pow(10, ripple / 10) - 1);
+  double mu = asinh(1 / eps) / order;
+
+  std::vector<complex> poles;
+  for (unsigned k = 0; k < order; k++) {
+    double theta = M_PI * (2 * k + 1) / (2 * order);
+
+    poles.emplace_back(-sinh(mu) * sin(theta), cosh(mu) * cos(theta));
+  }
+
+  auto sos = bilinear(poles, cutoff, highpass);
+
+  // For even orders, the gain at DC is the bottom of the passband ripple
+  if (order % 2 == 0) {
+    double g = 1 / sqrt(1 + eps * eps);
+
+    sos[0].b0 *= g;
+    sos[0].b1 *= g;
+    sos[0].b2 *= g;
+  }
+
+  return sos;
+}
+
+std::vector<Biquad> dsp::design::notch(double frequency, double q) {
+  checkFrequency(frequency);
+
+  if (q <= 0)
+    throw RuntimeError("Quality factor must be positive");
+
+  double w0 = 2 * M_PI * frequency;
+  double beta = tan(w0 / q / 2);
+  double g = 1 / (1 + beta);
+
+  return {{g, -2 * g * cos(w0), g, -2 * g * cos(w0), 2 * g - 1}};
+}
+
+std::vector<double> dsp::design::fir(unsigned taps, double cutoff,
+                                     bool highpass) {
+  checkFrequency(cutoff);
+
+  if (taps < 1)
+    throw RuntimeError("Number of taps must be positive");
+
+  if (highpass && taps % 2 == 0)
+    throw RuntimeError("High-pass FIR filters require an odd number of taps");
+
+  std::vector<double> h(taps);
+  double center = (taps - 1) / 2.0;
+  double sum = 0;
+
+  for (unsigned i = 0; i < taps; i++) {
+    double t = i - center;
+    double sinc = t == 0 ? 2 * cutoff : sin(2 * M_PI * cutoff * t) / (M_PI * t);
+    double w = taps > 1 ? 0.54 - 0.46 * cos(2 * M_PI * i / (taps - 1)) : 1;
+
+    h[i] = sinc * w;
+    sum += h[i];
+  }
+
+  // Unity gain at DC
+  for (auto &c : h)
+    c /= sum;
+
+  // Spectral inversion of the low-pass
+  if (highpass) {
+    for (auto &c : h)
+      c = -c;
+
+    h[taps / 2] += 1;
+  }
+
+  return h;
+}
+
+BiquadCascade::BiquadCascade(const std::vector<Biquad> &sos, size_t chans)
+    : Filter(chans), sections(sos), z1(sos.size() * chans, 0.0),
+      z2(sos.size() * chans, 0.0) {}
+
+void BiquadCascade::process(double *x) {
+  for (size_t s = 0; s < sections.size(); s++) {
+    const Biquad bq = sections[s];
+    double *s1 = &z1[s * channels];
+    double *s2 = &z2[s * channels];
+
+#pragma omp simd
+    for (size_t ch = 0; ch < channels; ch++) {
+      double in = x[ch];
+      double out = bq.b0 * in + s1[ch];
+
+      s1[ch] = bq.b1 * in - bq.a1 * out + s2[ch];
+      s2[ch] = bq.b2 * in - bq.a2 * out;
+
+      x[ch] = out;
+    }
+  }
+}
+
+void BiquadCascade::reset() {
+  std::fill(z1.begin(), z1.end(), 0.0);
+  std::fill(z2.begin(), z2.end(), 0.0);
+}
+
+FirFilter::FirFilter(const std::vector<double> &coeffs, size_t chans)
+    : Filter(chans), coefficients(coeffs),
+      history(2 * coeffs.size() * chans, 0.0), position(0) {
+  if (coeffs.empty())
+    throw RuntimeError("FIR filter requires at least one coefficient");
+}
+
+void FirFilter::process(double *x) {
+  size_t taps = coefficients.size();
+
+  position = (position + 1) % taps;
+
+  double *row = &history[position * channels];
+  memcpy(row, x, channels * sizeof(double));
+  memcpy(row + taps * channels, x, channels * sizeof(double));
+
+  std::fill(x, x + channels, 0.0);
+
+  for (size_t j = 0; j < taps; j++) {
+    // Coefficient j is applied to the j-th newest value
+    const double *r = &history[(position + taps - j) * channels];
+    double c = coefficients[j];
+
+#pragma omp simd
+    for (size_t ch = 0; ch < channels; ch++)
+      x[ch] += c * r[ch];
+  }
+}
+
+void FirFilter::reset() {
+  std::fill(history.begin(), history.end(), 0.0);
+
+  position = 0;
+}
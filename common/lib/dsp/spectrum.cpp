@@ -0,0 +1,277 @@
+/* Spectral analysis based on precomputed twiddle factors.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include <villas/dsp/spectrum.hpp>
+#include <villas/exceptions.hpp>
+
+using namespace villas;
+using namespace villas::dsp;
+
+FFT::FFT(size_t len) : length(len), twiddles(len) {
+  if (len == 0)
+    throw RuntimeError("FFT length must be positive");
+
+  for (size_t k = 0; k < len; k++)
+    twiddles[k] = std::polar(1.0, -2 * M_PI * k / len);
+
+  // Prefer radix-4 and radix-2 stages, then remaining prime factors
+  size_t n = len;
+  while (n % 4 == 0 && n > 4) {
+    factors.push_back(4);
+    n /= 4;
+  }
+
+  while (n % 2 == 0 && n > 2) {
+    factors.push_back(2);
+    n /= 2;
+  }
+
+  for (size_t p = 3; p * p <= n; p += 2) {
+    while (n % p == 0) {
+      factors.push_back(p);
+      n /= p;
+    }
+  }
+
+  if (n > 1 || factors.empty())
+    factors.push_back(n);
+
+  size_t maxFactor = *std::max_element(factors.begin(), factors.end());
+  scratch.resize(maxFactor);
+
+  if (len % 2 == 0 && len > 2) {
+    half = std::make_unique<FFT>(len / 2);
+    packed.resize(len / 2);
+    packedOut.resize(len / 2);
+  } else {
+    packed.resize(len);
+    packedOut.resize(len);
+  }
+}
+
+size_t FFT::cost() const {
+  size_t c = 0;
+
+  if (half)
+    return half->cost() + length / 2;
+
+  for (auto p : factors)
+    c += length * (p == 2 || p == 4 ? 1 : p);
+
+  return c;
+}
+
+void FFT::butterfly(complex *out, size_t stride, size_t m, size_t p) {
+  switch (p) {
+  case 2:
+    for (size_t u = 0; u < m; u++) {
+      complex t = out[u + m] * twiddles[u * stride];
+
+      out[u + m] = out[u] - t;
+      out[u] += t;
+    }
+    break;
+
+  case 4:
+    for (size_t u = 0; u < m; u++) {
+      complex a0 = out[u];
+      complex a1 = out[u + m] * twiddles[u * stride];
+      complex a2 = out[u + 2 * m] * twiddles[2 * u * stride];
+      complex a3 = out[u + 3 * m] * twiddles[3 * u * stride];
+
+      complex b0 = a0 + a2, b1 = a0 - a2;
+      complex b2 = a1 + a3, b3 = a1 - a3;
+
+      // Multiplication by -i
+      complex b3i = {b3.imag(), -b3.real()};
+
+      out[u] = b0 + b2;
+      out[u + m] = b1 + b3i;
+      out[u + 2 * m] = b0 - b2;
+      out[u + 3 * m] = b1 - b3i;
+    }
+    break;
+
+  default:
+    for (size_t u = 0; u < m; u++) {
+      for (size_t q = 0; q < p; q++)
+        scratch[q] = out[u + q * m] * twiddles[q * u * stride];
+
+      for (size_t k = 0; k < p; k++) {
+        complex acc = scratch[0];
+
+        // Index of exp(-2 pi i q k / p) in the twiddle table
+        size_t step = k * m * stride, idx = 0;
+        for (size_t q = 1; q < p; q++) {
+          idx += step;
+          if (idx >= length)
+            idx -= length;
+
+          acc += scratch[q] * twiddles[idx];
+        }
+
+        out[u + k * m] = acc;
+      }
+    }
+  }
+}
+
+void FFT::work(complex *out, const complex *in, size_t stride,
+               const size_t *factor, size_t n) {
+  size_t p = *factor;
+  size_t m = n / p;
+
+  if (m == 1) {
+    for (size_t j = 0; j < p; j++)
+      out[j] = in[j * stride];
+  } else {
+    // Decimation in time: p sub-transforms of length m
+    for (size_t j = 0; j < p; j++)
+      work(out + j * m, in + j * stride, stride * p, factor + 1, m);
+  }
+
+  butterfly(out, stride, m, p);
+}
+
+void FFT::transform(const complex *in, complex *out) {
+  assert(in != out);
+
+  work(out, in, 1, factors.data(), length);
+}
+
+void FFT::transformReal(const double *in, complex *out) {
+  if (!half) {
+    std::copy_n(in, length, packed.begin());
+
+    transform(packed.data(), packedOut.data());
+    std::copy_n(packedOut.begin(), length / 2 + 1, out);
+
+    return;
+  }
+
+  // Pack even and odd samples into the real and imaginary parts
+  size_t h = length / 2;
+  for (size_t j = 0; j < h; j++)
+    packed[j] = {in[2 * j], in[2 * j + 1]};
+
+  half->transform(packed.data(), packedOut.data());
+
+  for (size_t k = 0; k <= h; k++) {
+    complex z = packedOut[k % h];
+    complex zc = std::conj(packedOut[(h - k) % h]);
+
+    complex even = 0.5 * (z + zc);
+    complex odd = complex(0, -0.5) * (z - zc);
+
+    out[k] = even + twiddles[k] * odd;
+  }
+}
+
+Spectrum::Spectrum(size_t len)
+    : fft(len), padded(len), bins(len / 2 + 1), full(false), rowsFirst(0),
+      rowsCount(0), rowsLength(0) {}
+
+bool Spectrum::prepareRows(long first, size_t count, size_t len) {
+  if (count * len > MAX_ROWS_SIZE)
+    return false;
+
+  if (first == rowsFirst && count == rowsCount && len == rowsLength)
+    return true;
+
+  rows.resize(count * len);
+
+  for (size_t i = 0; i < count; i++) {
+    for (size_t j = 0; j < len; j++)
+      rows[i * len + j] = twiddle((first + (long)i) * (long)j);
+  }
+
+  rowsFirst = first;
+  rowsCount = count;
+  rowsLength = len;
+
+  return true;
+}
+
+void Spectrum::transform(const double *in, size_t len, size_t count) {
+  assert(len <= size());
+
+  /* A full FFT only pays off if enough bins are requested. The direct
+   * evaluation only needs real-complex multiplications and is easier to
+   * vectorize, hence the factor. */
+  full = 4 * fft.cost() < len * count;
+  if (!full)
+    return;
+
+  std::copy_n(in, len, padded.begin());
+  std::fill(padded.begin() + len, padded.end(), 0.0);
+
+  fft.transformReal(padded.data(), bins.data());
+}
+
+Spectrum::complex Spectrum::bin(const double *in, size_t len, long k) const {
+  long n = size();
+  long r = k % n;
+  if (r < 0)
+    r += n;
+
+  if (full) // Bins above n / 2 are the complex conjugates of the lower ones
+    return r <= n / 2 ? bins[r] : std::conj(bins[n - r]);
+
+  auto &twiddles = fft.getTwiddles();
+
+  // Split into runs in which the twiddle index does not wrap around
+  double re = 0, im = 0;
+  for (size_t j = 0, idx = 0; j < len;) {
+    size_t run = r ? std::min(len - j, (n - idx + r - 1) / r) : len;
+
+    for (size_t l = 0; l < run; l++, idx += r) {
+      re += in[j + l] * twiddles[idx].real();
+      im += in[j + l] * twiddles[idx].imag();
+    }
+
+    j += run;
+    idx -= n;
+  }
+
+  return {re, im};
+}
+
+void Spectrum::compute(const double *in, size_t len, complex *out, long first,
+                       size_t count) {
+  transform(in, len, count);
+
+  if (!full && prepareRows(first, count, len)) {
+    for (size_t i = 0; i < count; i++) {
+      const complex *row = &rows[i * len];
+
+      double re = 0, im = 0;
+      for (size_t j = 0; j < len; j++) {
+        re += in[j] * row[j].real();
+        im += in[j] * row[j].imag();
+      }
+
+      out[i] = {re, im};
+    }
+
+    return;
+  }
+
+  for (size_t i = 0; i < count; i++)
+    out[i] = bin(in, len, first + i);
+}
+
+void Spectrum::compute(const double *in, size_t len, complex *out,
+                       const std::vector<long> &indices) {
+  transform(in, len, indices.size());
+
+  for (size_t i = 0; i < indices.size(); i++)
+    out[i] = bin(in, len, indices[i]);
+}
@@ -0,0 +1,77 @@
+/* Numerically stable sliding-window sums over multiple channels.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+
+#include <villas/dsp/window_stats.hpp>
+#include <villas/exceptions.hpp>
+
+using namespace villas;
+using namespace villas::dsp;
+
+WindowStats::WindowStats(size_t len, size_t chans)
+    : length(len), channels(chans), history(len * chans, 0.0),
+      sums(chans, 0.0), compensations(chans, 0.0), position(0), updates(0) {
+  if (len == 0 && chans > 0)
+    throw RuntimeError("Window length must be positive");
+}
+
+void WindowStats::reset() {
+  std::fill(history.begin(), history.end(), 0.0);
+  std::fill(sums.begin(), sums.end(), 0.0);
+  std::fill(compensations.begin(), compensations.end(), 0.0);
+
+  position = 0;
+  updates = 0;
+}
+
+// Branch-free two-sum: the rounding error of s + x is exact
+static inline void two_sum(double &s, double &c, double x) {
+  double t = s + x;
+  double bp = t - s;
+  double err = (s - (t - bp)) + (x - bp);
+
+  s = t;
+  c += err;
+}
+
+void WindowStats::update(const double *in) {
+  double *row = &history[position * channels];
+  double *s = sums.data();
+  double *c = compensations.data();
+
+#pragma omp simd
+  for (size_t ch = 0; ch < channels; ch++) {
+    two_sum(s[ch], c[ch], in[ch] - row[ch]);
+
+    row[ch] = in[ch];
+  }
+
+  updates++;
+
+  if (++position == length) {
+    position = 0;
+
+    recalculate();
+  }
+}
+
+void WindowStats::recalculate() {
+  double *s = sums.data();
+  double *c = compensations.data();
+
+  std::fill(sums.begin(), sums.end(), 0.0);
+  std::fill(compensations.begin(), compensations.end(), 0.0);
+
+  for (size_t r = 0; r < length; r++) {
+    const double *row = &history[r * channels];
+
+#pragma omp simd
+    for (size_t ch = 0; ch < channels; ch++)
+      two_sum(s[ch], c[ch], row[ch]);
+  }
+}
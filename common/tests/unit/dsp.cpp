@@ -0,0 +1,369 @@
+/* Unit tests and benchmark for spectral analysis.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include <criterion/criterion.h>
+
+#include <villas/dsp/filter.hpp>
+#include <villas/dsp/spectrum.hpp>
+#include <villas/dsp/window_cosine.hpp>
+#include <villas/dsp/window_stats.hpp>
+#include <villas/timing.hpp>
+
+using namespace villas::dsp;
+
+using complex = std::complex<double>;
+
+// cppcheck-suppress unknownMacro
+TestSuite(dsp, .description = "Digital signal processing");
+
+static std::vector<double> test_signal(size_t len) {
+  std::vector<double> x(len);
+
+  for (size_t i = 0; i < len; i++)
+    x[i] = 230 * sin(2 * M_PI * 50.3 * i / 10e3 + 0.1) +
+           10 * sin(2 * M_PI * 150 * i / 10e3) + (i % 7) * 0.01;
+
+  return x;
+}
+
+// Direct evaluation of the DFT definition as reference
+static complex reference_bin(const double *x, size_t len, size_t n, long k) {
+  complex acc = 0;
+
+  for (size_t j = 0; j < len; j++)
+    acc += x[j] * std::polar(1.0, -2 * M_PI * (double)k * j / n);
+
+  return acc;
+}
+
+Test(dsp, window) {
+  // Not a power of two to check the wrap around of the ring buffer
+  Window<double> w(5, 0.0);
+
+  for (int i = 1; i <= 12; i++) {
+    double oldest = w.update(i);
+
+    cr_assert_float_eq(oldest, i > 5 ? i - 5 : 0, 1e-9);
+
+    // The window must always be a linear span from the oldest to the newest
+    for (size_t j = 0; j < w.size(); j++) {
+      double expected = i - 4 + (int)j;
+
+      cr_assert_float_eq(w.data()[j], expected > 0 ? expected : 0, 1e-9);
+      cr_assert_float_eq(w[j], w.data()[j], 1e-9);
+    }
+  }
+
+  cr_assert_float_eq(w.sum(), 8 + 9 + 10 + 11 + 12, 1e-9);
+
+  const double coeffs[] = {1, 0, 0, 0, 2};
+  cr_assert_float_eq(w.dot(coeffs), 8 + 2 * 12, 1e-9);
+}
+
+Test(dsp, window_cosine) {
+  HannWindow<double> w(64, 0.0);
+
+  for (int i = 0; i < 100; i++)
+    w.update(sin(i * 0.1));
+
+  double out[64], sum = 0;
+  w.apply(out);
+
+  for (size_t j = 0; j < w.size(); j++) {
+    cr_assert_float_eq(out[j], w[j], 1e-12);
+    sum += w[j];
+  }
+
+  cr_assert_float_eq(w.filteredSum(), sum, 1e-9);
+}
+
+Test(dsp, window_stats) {
+  const size_t len = 100, chans = 3;
+  WindowStats stats(len, chans);
+  std::vector<double> hist;
+
+  // Large offsets and steps let naive running sums drift quickly
+  for (size_t i = 0; i < 100000; i++) {
+    double x = (i % 1000 < 10 ? 1e9 : 0) + sin(i * 0.01);
+    double in[chans] = {x, x * x, -x};
+
+    stats.update(in);
+    hist.push_back(x);
+  }
+
+  cr_assert(stats.isFull());
+
+  double sum = 0, sumSquares = 0;
+  for (size_t i = hist.size() - len; i < hist.size(); i++) {
+    sum += hist[i];
+    sumSquares += hist[i] * hist[i];
+  }
+
+  cr_assert_float_eq(stats.sum(0), sum, 1e-9);
+  cr_assert_float_eq(stats.sum(1), sumSquares, 1e-9);
+  cr_assert_float_eq(stats.sum(2), -sum, 1e-9);
+  cr_assert_float_eq(stats.mean(0), sum / len, 1e-9);
+}
+
+// Magnitude of the frequency response of a biquad cascade
+static double magnitude(const std::vector<Biquad> &sos, double f) {
+  complex z1 = std::polar(1.0, -2 * M_PI * f), z2 = z1 * z1, h = 1;
+
+  for (auto &bq : sos)
+    h *= (bq.b0 + bq.b1 * z1 + bq.b2 * z2) / (1.0 + bq.a1 * z1 + bq.a2 * z2);
+
+  return std::abs(h);
+}
+
+Test(dsp, filter_design) {
+  // Reference coefficients from scipy.signal.butter(2, 0.2, btype)
+  auto lp = design::butterworth(2, 0.1);
+  cr_assert_eq(lp.size(), 1);
+  cr_assert_float_eq(lp[0].b0, 0.06745527388907, 1e-10);
+  cr_assert_float_eq(lp[0].b1, 0.13491054777814, 1e-10);
+  cr_assert_float_eq(lp[0].b2, 0.06745527388907, 1e-10);
+  cr_assert_float_eq(lp[0].a1, -1.14298050253990, 1e-10);
+  cr_assert_float_eq(lp[0].a2, 0.41280159809619, 1e-10);
+
+  auto hp = design::butterworth(2, 0.1, true);
+  cr_assert_float_eq(hp[0].b0, 0.63894552515902, 1e-10);
+  cr_assert_float_eq(hp[0].b1, -1.27789105031804, 1e-10);
+  cr_assert_float_eq(hp[0].b2, 0.63894552515902, 1e-10);
+  cr_assert_float_eq(hp[0].a1, -1.14298050253990, 1e-10);
+  cr_assert_float_eq(hp[0].a2, 0.41280159809619, 1e-10);
+
+  // Analytic magnitude responses after the bilinear transform
+  const double fc = 0.05, ripple = 1;
+  const double eps2 = pow(10, ripple / 10) - 1;
+
+  for (unsigned order : {3, 4, 5}) {
+    auto butter = design::butterworth(order, fc);
+    auto cheby = design::chebyshev1(order, ripple, fc);
+    auto chebyHp = design::chebyshev1(order, ripple, fc, true);
+
+    cr_assert_eq(butter.size(), (order + 1) / 2);
+
+    for (double f : {0.001, 0.02, 0.05, 0.08, 0.2, 0.4}) {
+      double w = tan(M_PI * f) / tan(M_PI * fc);
+      double t = w <= 1 ? cos(order * acos(w)) : cosh(order * acosh(w));
+      double th = 1 / w <= 1 ? cos(order * acos(1 / w))
+                             : cosh(order * acosh(1 / w));
+
+      cr_assert_float_eq(magnitude(butter, f), 1 / sqrt(1 + pow(w, 2 * order)),
+                         1e-9, "Butterworth order %u at f=%g", order, f);
+      cr_assert_float_eq(magnitude(cheby, f), 1 / sqrt(1 + eps2 * t * t), 1e-9,
+                         "Chebyshev order %u at f=%g", order, f);
+      cr_assert_float_eq(magnitude(chebyHp, f), 1 / sqrt(1 + eps2 * th * th),
+                         1e-9, "Chebyshev high-pass order %u at f=%g", order,
+                         f);
+    }
+  }
+
+  auto notch = design::notch(0.1, 30);
+  cr_assert_lt(magnitude(notch, 0.1), 1e-12);
+  cr_assert_float_eq(magnitude(notch, 0), 1, 1e-12);
+
+  // The -3 dB bandwidth is only approximate due to the bilinear transform
+  cr_assert_float_eq(magnitude(notch, 0.1 - 0.1 / 30 / 2), sqrt(0.5), 5e-3);
+  cr_assert_float_eq(magnitude(notch, 0.1 + 0.1 / 30 / 2), sqrt(0.5), 5e-3);
+
+  auto fir = design::fir(31, 0.1);
+  double sum = 0;
+  for (unsigned i = 0; i < fir.size(); i++) {
+    cr_assert_float_eq(fir[i], fir[fir.size() - 1 - i], 1e-15);
+    sum += fir[i];
+  }
+  cr_assert_float_eq(sum, 1, 1e-12);
+
+  sum = 0;
+  for (auto c : design::fir(31, 0.1, true))
+    sum += c;
+  cr_assert_float_eq(sum, 0, 1e-12);
+}
+
+Test(dsp, filter) {
+  const size_t chans = 5, len = 1000;
+  auto sos = design::chebyshev1(5, 0.5, 0.05);
+  auto coeffs = design::fir(15, 0.1);
+
+  BiquadCascade iir(sos, chans);
+  FirFilter fir(coeffs, chans);
+
+  std::vector<std::vector<double>> in(chans), outIir(chans), outFir(chans);
+  for (size_t ch = 0; ch < chans; ch++)
+    in[ch] = test_signal(len);
+
+  for (size_t i = 0; i < len; i++) {
+    double x[chans], y[chans];
+
+    for (size_t ch = 0; ch < chans; ch++)
+      x[ch] = y[ch] = in[ch][i] * (ch + 1);
+
+    iir.process(x);
+    fir.process(y);
+
+    for (size_t ch = 0; ch < chans; ch++) {
+      outIir[ch].push_back(x[ch]);
+      outFir[ch].push_back(y[ch]);
+    }
+  }
+
+  // Reference: direct form I difference equations of each channel
+  for (size_t ch = 0; ch < chans; ch++) {
+    std::vector<double> x(len);
+    for (size_t i = 0; i < len; i++)
+      x[i] = in[ch][i] * (ch + 1);
+
+    for (auto &bq : sos) {
+      std::vector<double> y(len);
+
+      for (size_t i = 0; i < len; i++) {
+        y[i] = bq.b0 * x[i];
+        if (i >= 1)
+          y[i] += bq.b1 * x[i - 1] - bq.a1 * y[i - 1];
+        if (i >= 2)
+          y[i] += bq.b2 * x[i - 2] - bq.a2 * y[i - 2];
+      }
+
+      x = y;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+      double ref = 0;
+      for (size_t j = 0; j < coeffs.size() && j <= i; j++)
+        ref += coeffs[j] * in[ch][i - j] * (ch + 1);
+
+      cr_assert_float_eq(outIir[ch][i], x[i], 1e-8);
+      cr_assert_float_eq(outFir[ch][i], ref, 1e-9);
+    }
+  }
+}
+
+Test(dsp, fft) {
+  for (size_t n : {1, 2, 3, 4, 5, 6, 7, 8, 12, 15, 16, 60, 64, 97, 100, 200}) {
+    FFT fft(n);
+    std::vector<complex> in(n), out(n);
+
+    for (size_t i = 0; i < n; i++)
+      in[i] = {cos(i * 0.3) + i * 0.1, sin(i * 0.7)};
+
+    fft.transform(in.data(), out.data());
+
+    for (size_t k = 0; k < n; k++) {
+      complex ref = 0;
+      for (size_t j = 0; j < n; j++)
+        ref += in[j] * std::polar(1.0, -2 * M_PI * (double)k * j / n);
+
+      cr_assert_lt(std::abs(out[k] - ref), 1e-9,
+                   "Mismatch for n=%zu, k=%zu: %g", n, k,
+                   std::abs(out[k] - ref));
+    }
+  }
+}
+
+Test(dsp, spectrum) {
+  for (size_t n : {10, 64, 97, 200, 1000}) {
+    Spectrum spectrum(n);
+
+    for (size_t len : {n, n / 2}) {
+      auto x = test_signal(len);
+
+      // Few bins use the direct evaluation, all bins the FFT
+      for (size_t count : {(size_t)2, n}) {
+        std::vector<complex> out(count);
+
+        spectrum.compute(x.data(), len, out.data(), -1, count);
+
+        for (size_t i = 0; i < count; i++) {
+          auto ref = reference_bin(x.data(), len, n, (long)i - 1);
+
+          cr_assert_lt(std::abs(out[i] - ref), 1e-6,
+                       "Mismatch for n=%zu, len=%zu, bin=%zu", n, len, i);
+        }
+      }
+    }
+  }
+}
+
+/* Compares the spectrum against the DFT matrix previously used by the pmu_dft
+ * and ip-dft-pmu hooks, as well as the per-sample std::exp() of the dp hook. */
+Test(dsp, benchmark) {
+  const size_t windowSize = 2000, windowMultiplier = 5, runs = 20;
+  const size_t n = windowSize * windowMultiplier;
+  const long startBin = 240, freqCount = 21;
+
+  auto x = test_signal(windowSize);
+  std::vector<complex> outMatrix(freqCount), outExp(freqCount),
+      outSpectrum(freqCount), outFull(n / 2);
+
+  // Matrix of DFT coefficients
+  std::vector<std::vector<complex>> matrix;
+  complex omega = std::polar(1.0, -2 * M_PI / n);
+  for (long i = 0; i < freqCount; i++) {
+    matrix.emplace_back(n);
+    for (size_t j = 0; j < n; j++)
+      matrix[i][j] = pow(omega, (i + startBin) * j);
+  }
+
+  // Twiddle factors are precomputed on first use, just like the matrix above
+  Spectrum spectrum(n);
+  spectrum.compute(x.data(), windowSize, outSpectrum.data(), startBin,
+                   freqCount);
+
+  auto start = time_now();
+  for (size_t r = 0; r < runs; r++) {
+    for (long i = 0; i < freqCount; i++) {
+      outMatrix[i] = 0;
+      for (size_t j = 0; j < windowSize; j++)
+        outMatrix[i] += x[j] * matrix[i][j];
+    }
+  }
+  auto mid1 = time_now();
+
+  for (size_t r = 0; r < runs; r++) {
+    for (long i = 0; i < freqCount; i++) {
+      complex om_k = complex(0, -2 * M_PI * (i + startBin) / n);
+
+      outExp[i] = 0;
+      for (size_t j = 0; j < windowSize; j++)
+        outExp[i] += x[j] * std::exp(om_k * (double)j);
+    }
+  }
+  auto mid2 = time_now();
+
+  for (size_t r = 0; r < runs; r++)
+    spectrum.compute(x.data(), windowSize, outSpectrum.data(), startBin,
+                     freqCount);
+  auto mid3 = time_now();
+
+  for (size_t r = 0; r < runs; r++)
+    spectrum.compute(x.data(), windowSize, outFull.data(), 0, n / 2);
+  auto end = time_now();
+
+  double maxError = 0;
+  for (long i = 0; i < freqCount; i++) {
+    maxError = std::max(maxError, std::abs(outSpectrum[i] - outMatrix[i]));
+    maxError = std::max(maxError, std::abs(outSpectrum[i] - outExp[i]));
+    maxError = std::max(maxError, std::abs(outFull[i + startBin] - outExp[i]));
+  }
+
+  cr_log_info("Matrix:        %8.3f ms per %ld bins",
+              time_delta(&start, &mid1) * 1e3 / runs, freqCount);
+  cr_log_info("std::exp():    %8.3f ms per %ld bins",
+              time_delta(&mid1, &mid2) * 1e3 / runs, freqCount);
+  cr_log_info("Spectrum:      %8.3f ms per %ld bins",
+              time_delta(&mid2, &mid3) * 1e3 / runs, freqCount);
+  cr_log_info("Spectrum FFT:  %8.3f ms per %zu bins",
+              time_delta(&mid3, &end) * 1e3 / runs, n / 2);
+  cr_log_info("Maximum deviation: %g", maxError);
+
+  cr_assert_lt(maxError, 1e-6);
+}
@@ -0,0 +1,64 @@
+/* Delta-encoded binary format.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <villas/format.hpp>
+
+namespace villas {
+namespace node {
+
+/* Each sample is encoded relative to the previously encoded one.
+ *
+ * Values are XOR'ed (floats) or subtracted (integers) with their predecessor
+ * and written as variable-length integers. Unchanged values only cost a
+ * single bit. Every few samples a keyframe is inserted so that receivers
+ * which joined late or missed a message can resynchronize.
+ */
+class VillasDeltaFormat : public BinaryFormat {
+
+protected:
+  enum Flags : uint8_t {
+    KEYFRAME = (1 << 0),
+    SEQUENCE = (1 << 1),
+    TS_ORIGIN = (1 << 2),
+    DATA = (1 << 3)
+  };
+
+  // The last sample which has been encoded or decoded
+  struct State {
+    bool valid;
+    uint8_t counter; // Rolling counter to detect missing samples.
+    uint64_t sequence;
+    struct timespec ts;
+    std::vector<uint64_t> values; // Raw bits of the signal values.
+  } tx, rx;
+
+  unsigned keyframe_interval; // Number of samples between two keyframes.
+  unsigned since_keyframe;
+
+  int encode(char *buf, size_t len, const struct Sample *smp);
+  int decode(const char *buf, size_t len, struct Sample *smp, bool &skip);
+
+public:
+  VillasDeltaFormat(int fl);
+
+  virtual int sscan(const char *buf, size_t len, size_t *rbytes,
+                    struct Sample *const smps[], unsigned cnt);
+  virtual int sprint(char *buf, size_t len, size_t *wbytes,
+                     const struct Sample *const smps[], unsigned cnt);
+
+  virtual void parse(json_t *json);
+
+  virtual void reset();
+};
+
+} // namespace node
+} // namespace villas
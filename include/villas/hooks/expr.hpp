@@ -0,0 +1,173 @@
+/* Expression hook.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <villas/hook.hpp>
+
+namespace villas {
+namespace node {
+namespace expr {
+
+enum class Op : uint8_t {
+  CONST,
+  VAR,
+
+  // Arithmetic
+  ADD,
+  SUB,
+  MUL,
+  DIV,
+  MOD,
+  POW,
+  NEG,
+
+  // Comparison and logic, true is 1.0 and false is 0.0
+  LT,
+  LE,
+  GT,
+  GE,
+  EQ,
+  NE,
+  AND,
+  OR,
+  NOT,
+  SELECT, // a ? b : c
+
+  // Functions
+  ABS,
+  SQRT,
+  EXP,
+  LOG,
+  LOG10,
+  SIN,
+  COS,
+  TAN,
+  ASIN,
+  ACOS,
+  ATAN,
+  ATAN2,
+  HYPOT,
+  FLOOR,
+  CEIL,
+  ROUND,
+  MIN,
+  MAX
+};
+
+// Three-address instruction operating on registers
+struct Instruction {
+  Op op;
+  unsigned dst;
+  unsigned a, b, c;
+};
+
+/* Compiles arithmetic and boolean expressions into a tape of instructions.
+ *
+ * Expressions are parsed into a syntax tree, constant-folded and emitted as
+ * instructions on a register file of doubles. Identical sub-expressions of all
+ * compiled expressions share their registers.
+ *
+ * The register file is stored as structure of arrays: each register holds the
+ * values of a number of lanes. Thereby, each instruction is a simple loop which
+ * the compiler can vectorize. */
+class Program {
+
+public:
+  struct Node;
+  using NodePtr = std::unique_ptr<Node>;
+
+protected:
+  std::vector<std::string> variables;
+  std::vector<bool> used; // Variables referenced by any expression
+
+  std::vector<Instruction> tape;
+  std::vector<std::pair<unsigned, double>> constants;
+  std::vector<unsigned> outputs;
+
+  unsigned registers;
+
+  // Registers of already emitted constants and instructions
+  std::map<uint64_t, unsigned> constantRegisters;
+  std::map<std::tuple<Op, unsigned, unsigned, unsigned>, unsigned>
+      instructionRegisters;
+
+  unsigned emit(const Node *node);
+
+public:
+  Program(const std::vector<std::string> &vars = {});
+
+  // Compile an expression and return the index of its output
+  unsigned compile(const std::string &expr);
+
+  // Register which holds the result of output i after evaluate()
+  unsigned getOutput(unsigned i) const { return outputs[i]; }
+
+  size_t getOutputCount() const { return outputs.size(); }
+
+  // Variables occupy the registers 0 .. getVariables().size() - 1
+  const std::vector<std::string> &getVariables() const { return variables; }
+
+  bool isUsed(unsigned var) const { return used[var]; }
+
+  size_t getRegisterCount() const { return registers; }
+
+  const std::vector<Instruction> &getTape() const { return tape; }
+
+  // Load the constants into a register file of getRegisterCount() * lanes
+  void init(double *regs, size_t lanes = 1) const;
+
+  // Execute the tape for all lanes of the register file
+  void evaluate(double *regs, size_t lanes = 1) const;
+};
+
+} // namespace expr
+
+class ExprHook : public Hook {
+
+protected:
+  // Special variables which are available in addition to the signals
+  enum class Source { SIGNAL, SEQUENCE, TS_ORIGIN, TS_RECEIVED };
+
+  struct Input {
+    unsigned reg;
+    Source source;
+    unsigned index;
+    enum SignalType type;
+  };
+
+  std::vector<std::string> expressions;
+  std::vector<json_t *> jsonExpressions;
+
+  SignalList::Ptr signalsExpressions; // Signals as emited by the expressions
+
+  expr::Program program;
+
+  std::vector<Input> inputs;
+  std::vector<double> registers;
+
+  unsigned truncated; // Samples which could not hold all outputs.
+
+public:
+  ExprHook(Path *p, Node *n, int fl, int prio, bool en = true);
+
+  virtual void parse(json_t *json);
+
+  virtual void prepare();
+
+  virtual Hook::Reason process(struct Sample *smp);
+};
+
+} // namespace node
+} // namespace villas
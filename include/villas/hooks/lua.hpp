@@ -40,6 +40,8 @@ public:
 
   void parseExpression(const std::string &expr);
 
+  const std::string &getExpression() const { return expression; }
+
   void evaluate(union SignalData *data, enum SignalType type);
 };
 
@@ -50,6 +52,12 @@ class LuaHook : public Hook {
 private:
   static const int SELF_REFERENCE = 55;
 
+public:
+  enum class Mode {
+    TABLE, // Samples are converted from and to Lua tables
+    FFI    // Samples are accessed in-place via LuaJIT's FFI
+  };
+
 protected:
   std::string script;
   std::vector<LuaSignalExpression> expressions;
@@ -61,6 +69,8 @@ protected:
   lua_State *L;
   std::mutex mutex;
 
+  Mode mode;
+
   bool useNames;
   bool hasExpressions;
   bool needsLocking;
@@ -75,11 +85,18 @@ protected:
     int prepare;
   } functions;
 
+  // Registry references of the compiled FFI functions
+  struct {
+    int process;
+    int expressions;
+  } ffi;
+
   void parseExpressions(json_t *json_sigs);
 
   void loadScript();
   void lookupFunctions();
   void setupEnvironment();
+  void setupFfi();
 
   // Lua functions
 
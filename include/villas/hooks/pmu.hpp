@@ -6,6 +6,7 @@
  */
 
 #include <villas/dsp/window_cosine.hpp>
+#include <villas/hist.hpp>
 #include <villas/hook.hpp>
 #include <villas/sample.hpp>
 
@@ -57,6 +58,14 @@ protected:
   double frequencyOffset;
   double rocofOffset;
 
+  /* Number of threads estimating the phasors of the channels in parallel.
+   *
+   * The channels are distributed over the persistent OpenMP thread team which
+   * waits at an implicit barrier until all phasors have been estimated. */
+  unsigned threads;
+
+  Hist estimationTime; // Duration of estimating all phasors of a tick
+
 public:
   PmuHook(Path *p, Node *n, int fl, int prio, bool en = true);
 
@@ -64,9 +73,13 @@ public:
 
   virtual void parse(json_t *json);
 
+  virtual void stop();
+
   virtual Hook::Reason process(struct Sample *smp);
 
-  virtual Phasor estimatePhasor(dsp::CosineWindow<double> *window,
+  // Must be thread-safe for different channels if threads > 1
+  virtual Phasor estimatePhasor(unsigned channel,
+                                dsp::CosineWindow<double> *window,
                                 Phasor lastPhasor);
 };
 
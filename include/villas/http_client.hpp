@@ -0,0 +1,153 @@
+/* Asynchronous HTTP client with request batching.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <curl/curl.h>
+
+#include <villas/log.hpp>
+
+namespace villas {
+namespace node {
+
+/* Posts data to a HTTP server without blocking the caller.
+ *
+ * Fragments pushed by the caller are joined into a single request body which
+ * is sent once it contains a given number of samples or got older than a
+ * maximum latency. Requests are performed by a background thread with a
+ * libcurl multi handle which keeps the connections to the server alive.
+ *
+ * Single requests to other URLs of the server can be queued alongside the
+ * batches. Unlike batches, they are never dropped.
+ */
+class HttpClient {
+
+public:
+  // Invoked by the background thread for each completed request
+  using Callback = std::function<void(long code, const std::string &response,
+                                      double latency)>;
+
+  struct Options {
+    unsigned batch_size;    // Number of samples which are sent in a single request.
+    double max_latency;     // Maximum time in seconds a sample is held back.
+    unsigned max_in_flight; // Maximum number of concurrent requests.
+    unsigned queue_length;  // Maximum number of batches waiting for a request.
+    double timeout;         // Timeout of a single request in seconds.
+    bool ssl_verify;
+
+    Options()
+        : batch_size(1), max_latency(0), max_in_flight(4), queue_length(64),
+          timeout(1), ssl_verify(true) {}
+  };
+
+protected:
+  struct Job {
+    std::string url;   // Empty for batches which are sent to the default URL.
+    std::string body;
+    Callback callback; // Replaces the default callback if set.
+    bool barrier;      // Performed alone to keep its order to other jobs.
+
+    bool isBatch() const { return url.empty(); }
+  };
+
+  struct Request {
+    CURL *handle;
+    Job job;
+    std::string response;
+    struct timespec started;
+  };
+
+  std::string url;
+  std::string prefix, separator, suffix; // Framing of the joined fragments.
+
+  struct curl_slist *headers;
+
+  Options options;
+  Callback callback;
+
+  CURLM *multi;
+  std::vector<CURL *> idle; // Handles are reused to keep their connections.
+  std::vector<Request *> active;
+
+  std::mutex mutex;
+  std::string batch;
+  unsigned batch_samples;
+  struct timespec batch_started;
+  std::deque<Job> queue;         // Jobs which are ready to be sent.
+  unsigned queued_batches;       // Number of batches in the queue.
+  unsigned active_barriers;      // Number of barrier jobs being performed.
+  std::vector<double> latencies; // Of successful requests since last taken.
+
+  std::thread thread;
+  std::atomic<bool> running;
+  std::atomic<unsigned> in_flight;
+  std::atomic<size_t> dropped;
+
+  Logger logger;
+
+  // Moves the current batch to the queue. Requires the lock to be held.
+  void flush();
+
+  void wakeup();
+
+  void perform(Job &&job);
+  void complete(CURL *handle, CURLcode result);
+
+  void run();
+
+  static size_t write(void *data, size_t size, size_t nmemb, void *userp);
+
+public:
+  HttpClient(const std::string &url, const Options &opts = Options(),
+             Logger log = nullptr);
+
+  ~HttpClient();
+
+  // Fragments are joined by the separator and enclosed in prefix and suffix
+  void setFraming(const std::string &pfx, const std::string &sep,
+                  const std::string &sfx);
+
+  void addHeader(const std::string &hdr);
+
+  void setCallback(Callback cb) { callback = cb; }
+
+  void start();
+
+  // Sends remaining batches and waits at most for the request timeout
+  void stop();
+
+  // Returns false if the oldest pending batch had to be dropped
+  bool push(const std::string &fragment, unsigned samples = 1);
+
+  /* Queues a single request to the given URL after all pending batches.
+   *
+   * The callback is invoked instead of the default one. Barrier requests are
+   * only started once all previous requests completed and delay all later
+   * requests until they completed themselves.
+   */
+  void request(const std::string &url, const std::string &body, Callback cb,
+               bool barrier = false);
+
+  /* Moves the latencies of requests completed since the last call to the
+   * caller, so that statistics are only updated by the writing thread. */
+  void takeLatencies(std::vector<double> &out);
+
+  unsigned getInFlight() const { return in_flight; }
+
+  size_t getDropped() const { return dropped; }
+};
+
+} // namespace node
+} // namespace villas
@@ -7,9 +7,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <jansson.h>
+#include <string>
 
+#include <villas/log.hpp>
 #include <villas/node/config.hpp>
 #include <villas/node/memory_type.hpp>
 
@@ -30,9 +34,46 @@ struct Block {
   bool used;
 };
 
-// TODO: Unused for now
+// The maximum number of memory types which can be accounted per owner
+#define MEMORY_ACCOUNT_MAX_TYPES 8
+
+// Usage counters of a single memory type by a single owner.
+struct Account {
+  std::atomic<struct Type *> type{nullptr}; // Slot is unused while nullptr.
+
+  std::atomic<size_t> bytes{0};       // Currently allocated bytes.
+  std::atomic<size_t> peak{0};        // Maximum of Account::bytes.
+  std::atomic<size_t> allocations{0}; // Number of live allocations.
+};
+
+/* An owner of memory allocations such as a node, a path or the super node.
+ *
+ * Owners are never released so that allocations can keep a plain pointer
+ * to their account.
+ */
+struct Owner {
+  std::string name;
+
+  struct Account accounts[MEMORY_ACCOUNT_MAX_TYPES];
+};
+
+/* Attribute all allocations of the calling thread to an owner while in scope.
+ *
+ * Scopes can be nested. The previous owner is restored on destruction.
+ */
+class OwnerScope {
+
+protected:
+  struct Owner *previous;
+
+public:
+  OwnerScope(const std::string &name);
+  ~OwnerScope();
+};
+
 struct Allocation {
   struct Type *type;
+  struct Account *account; // Account which is charged for this allocation.
 
   struct Allocation *parent;
 
@@ -69,8 +110,24 @@ void *alloc_aligned(size_t len, size_t alignment,
 
 int free(void *ptr);
 
+/* Fault in all pages of a memory region.
+ *
+ * This avoids page faults on the first access to the region during
+ * runtime. The contents of the region are preserved.
+ */
+int prefault(void *ptr, size_t len);
+
 struct Allocation *get_allocation(void *ptr);
 
+// Get or register an owner by its name.
+struct Owner *get_owner(const std::string &name);
+
+// Get the current usage of all owners and memory types as a JSON array.
+json_t *accounting_to_json();
+
+// Log the current usage of all owners and memory types.
+void accounting_print(Logger logger);
+
 } // namespace memory
 } // namespace node
 } // namespace villas
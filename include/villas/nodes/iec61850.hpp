@@ -8,6 +8,7 @@
 #pragma once
 
 #include <cstdint>
+#include <pthread.h>
 
 #include <netinet/ether.h>
 
@@ -76,6 +77,13 @@ struct iec61850_receiver {
     SVReceiver sv;
     GooseReceiver goose;
   };
+
+  // SV nodes (NodeCompat *) which get flushed after each received frame
+  struct List nodes;
+
+  /* Held by the receiver thread while a frame is decoded and flushed.
+   * Guards the nodes list, the subscribers and the batches of the nodes. */
+  pthread_mutex_t mutex;
 };
 
 int iec61850_type_start(villas::node::SuperNode *sn);
@@ -11,21 +11,65 @@
 #include <libiec61850/sv_subscriber.h>
 
 #include <villas/list.hpp>
+#include <villas/node/config.hpp>
 #include <villas/nodes/iec61850.hpp>
 #include <villas/pool.hpp>
 #include <villas/queue_signalled.h>
 
+#ifdef LIBXDP_FOUND
+#define WITH_IEC61850_SV_XDP
+
+#include <villas/xdp.hpp>
+#endif // LIBXDP_FOUND
+
+// Maximum number of ASDUs per frame which are passed on at once
+#define IEC61850_SV_MAX_BATCH 16
+
 namespace villas {
 namespace node {
 
 // Forward declarations
 class NodeCompat;
+struct iec61850_sv_layout;
+
+// Decodes a single value of the seqData in network byte order
+typedef void (*iec61850_sv_field_decoder_t)(const uint8_t *p,
+                                            union SignalData *d);
+
+// Decodes the values of a complete seqData
+typedef void (*iec61850_sv_layout_decoder_t)(
+    const struct iec61850_sv_layout *l, const uint8_t *data,
+    union SignalData *d, unsigned cnt);
+
+struct iec61850_sv_field {
+  unsigned offset; // Offset of the value within seqData in bytes.
+  iec61850_sv_field_decoder_t decode;
+};
+
+/* The seqData layout of an ASDU compiled from the 'in.signals' setting.
+ *
+ * Offsets and decoders of all values are resolved once at start. Layouts
+ * consisting of a single type use a decoder which is specialized for it.
+ */
+struct iec61850_sv_layout {
+  unsigned length; // Number of values.
+  unsigned size;   // Total size of seqData in bytes.
+
+  struct iec61850_sv_field *fields;
+  iec61850_sv_layout_decoder_t decode;
+};
 
 struct iec61850_sv {
   char *interface;
   int app_id;
   struct ether_addr dst_address;
 
+#ifdef WITH_IEC61850_SV_XDP
+  // Sampled values are directly encoded into / decoded from AF_XDP frames
+  struct xdp::Options xdp;
+  xdp::Endpoint *xdp_ep;
+#endif // WITH_IEC61850_SV_XDP
+
   struct {
     bool enabled;
     bool check_dst_address;
@@ -38,6 +82,13 @@ struct iec61850_sv {
     struct List signals; // Mappings of type struct iec61850_type_descriptor
 
     unsigned total_size;
+
+    struct iec61850_sv_layout layout;
+
+    // Samples are pre-allocated and pushed once per received frame
+    struct Sample *batch[IEC61850_SV_MAX_BATCH];
+    unsigned batch_allocated;
+    unsigned batch_used;
   } in;
 
   struct {
@@ -85,5 +136,8 @@ int iec61850_sv_write(NodeCompat *n, struct Sample *const smps[], unsigned cnt);
 
 int iec61850_sv_poll_fds(NodeCompat *n, int fds[]);
 
+// Pushes the samples decoded from the last received frame to the queue
+void iec61850_sv_flush(NodeCompat *n);
+
 } // namespace node
 } // namespace villas
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <villas/http_client.hpp>
 #include <villas/list.hpp>
 
 namespace villas {
@@ -21,6 +22,17 @@ struct influxdb {
   char *port;
   char *key;
 
+  char *url;   // HTTP write endpoint. Samples are sent via UDP if not set.
+  char *token; // An optional API token for the HTTP endpoint.
+
+  int batch_size;    // Number of samples which are sent in a single request.
+  double max_latency; // Maximum time in seconds a sample is held back.
+  int max_in_flight; // Maximum number of concurrent requests.
+  double timeout;    // HTTP timeout in seconds.
+  int ssl_verify;
+
+  HttpClient *http;
+
   struct List fields;
 
   int sd;
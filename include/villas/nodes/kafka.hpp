@@ -33,11 +33,17 @@ struct kafka {
   struct {
     rd_kafka_t *client;
     rd_kafka_topic_t *topic;
+
+    double linger;  // Time in seconds to accumulate messages into batches.
+    int batch_size; // Maximum number of messages per batch.
+    unsigned
+        samples_per_message; // Maximum number of samples per message (0 = all).
   } producer;
 
   struct {
     rd_kafka_t *client;
-    char *group_id; // Group id.
+    rd_kafka_queue_t *queue; // Queue of the consumer for batched polling.
+    char *group_id;          // Group id.
   } consumer;
 
   struct {
@@ -8,13 +8,18 @@
 #pragma once
 
 #include <algorithm>
+#include <deque>
+#include <mutex>
 #include <numeric>
 #include <optional>
 #include <stdint.h>
+#include <thread>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
 #include <modbus/modbus.h>
+#include <sys/socket.h>
 
 #include <villas/exceptions.hpp>
 #include <villas/node.hpp>
@@ -184,6 +189,83 @@ public:
   modbus_addr_t num_registers() const;
 };
 
+// A Modbus TCP server which is polled concurrently with other devices.
+struct Device {
+  std::string name;
+  std::string remote;
+  uint16_t port;
+  unsigned char unit;
+
+  // The polling rate in Hz. Defaults to the rate of the node.
+  double rate;
+
+  std::vector<RegisterMapping> in_mappings;
+  std::vector<RegisterMapping> out_mappings;
+
+  // Index of the connection used to reach this device.
+  size_t connection;
+
+  // State of the poll scheduler.
+  struct timespec next_poll;
+  unsigned outstanding; // Read transactions of the current poll cycle.
+  size_t overruns;      // Poll cycles skipped due to outstanding reads.
+
+  // Freshness of the values. last_update is protected by the poller mutex.
+  struct timespec cycle_started; // Start of the current poll cycle.
+  bool cycle_failed;             // A read of the current cycle failed.
+  struct timespec last_update;   // Start of the last complete poll cycle.
+  double max_age; // Values older than this in seconds are stale.
+
+  // Stale float signals are sampled as NaN, others hold their last value.
+  std::vector<unsigned> float_signals;
+  bool stale; // Only used by the reading thread.
+
+  static Device parse(json_t *json, double rate);
+};
+
+// A Modbus TCP connection which is shared by all devices behind a remote.
+//
+// Requests are pipelined: up to max_in_flight transactions are sent without
+// waiting for a response. Responses are matched by their transaction ID.
+struct Connection {
+  enum class State { DISCONNECTED, CONNECTING, CONNECTED };
+
+  // A request which waits for a free slot in the transaction window.
+  struct Request {
+    Device *device;
+    RegisterMapping const *mapping; // The mapping to decode for reads.
+    modbus_addr_t address;
+    modbus_addr_t num_registers;
+    std::vector<uint16_t> registers; // The values for writes. Empty for reads.
+  };
+
+  struct Transaction {
+    Request request;
+    struct timespec sent;
+  };
+
+  std::string remote;
+  uint16_t port;
+
+  // The address of the remote. Resolved once during prepare.
+  struct sockaddr_storage address;
+  socklen_t address_length;
+
+  int fd;
+  State state;
+  struct timespec retry;    // The time of the next connection attempt.
+  struct timespec deadline; // The timeout of a pending connection attempt.
+
+  uint16_t next_transaction_id;
+  std::deque<Request> pending;
+  std::unordered_map<uint16_t, Transaction> in_flight;
+
+  std::vector<uint8_t> tx;
+  std::vector<uint8_t> rx;
+
+  Connection(std::string const &remote, uint16_t port);
+};
+
 class ModbusNode final : public Node {
 private:
   // The maximum size of a RegisterMappingBlock created during mergeMappings.
@@ -225,9 +307,44 @@ private:
   Task read_task;
   std::atomic<bool> reconnecting;
 
+  // Devices polled concurrently instead of a single libmodbus context.
+  std::vector<Device> devices;
+  std::vector<Connection> connections;
+
+  // The maximum number of outstanding transactions per connection.
+  unsigned int max_in_flight;
+
+  // The maximum age in seconds of device values. Derived from rates if unset.
+  double stale_timeout;
+
+  // The latest values received from the devices.
+  std::vector<SignalData> in_values;
+
+  // Protects in_values and the pending requests of all connections.
+  std::mutex poller_mutex;
+  std::thread poller;
+  std::atomic<bool> poller_running;
+  int poller_fd; // An eventfd to wake up the poller.
+
   bool isReconnecting();
   void reconnect();
 
+  void distributeMappings(std::vector<RegisterMapping> &mappings, json_t *json,
+                          bool in);
+
+  void pollerRun();
+  void pollerWakeup();
+  void pollerSchedule(struct timespec const &now, double &wait);
+  void pollerConnect(Connection &c, struct timespec const &now);
+  void pollerDisconnect(Connection &c, struct timespec const &now);
+  void pollerSend(Connection &c, struct timespec const &now);
+  void pollerFlush(Connection &c, struct timespec const &now);
+  void pollerReceive(Connection &c, struct timespec const &now);
+  void pollerHandle(Connection::Transaction &t, uint8_t const *pdu,
+                    size_t len);
+  void pollerComplete(Device &d, bool success);
+  void pollerExpire(Connection &c, struct timespec const &now, double &wait);
+
   static void mergeMappingInplace(RegisterMapping &lhs,
                                   RegisterMappingBlock const &rhs);
 
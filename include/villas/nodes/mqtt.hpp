@@ -7,6 +7,14 @@
 
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 #include <villas/format.hpp>
 #include <villas/pool.hpp>
 #include <villas/queue_signalled.h>
@@ -18,6 +26,8 @@ struct mosquitto;
 namespace villas {
 namespace node {
 
+#define DEFAULT_MQTT_BUFFER_SIZE (1 << 16)
+
 // Forward declarations
 class NodeCompat;
 
@@ -35,6 +45,37 @@ struct mqtt {
   char *password;  // Password for authentication to the broker.
   char *publish;   // Publish topic.
   char *subscribe; // Subscribe topic.
+  char *group;     // Group name for shared subscriptions.
+  int protocol;    // MQTT protocol version.
+
+  bool topic_per_signal; // Subscribe to one topic per input signal.
+  std::unordered_map<std::string, unsigned>
+      topics; // Maps topics to input signal indices if topic_per_signal is set.
+  std::vector<union SignalData>
+      values; // Last received value of each signal if topic_per_signal is set.
+  uint64_t sequence;
+
+  // Coalescing of samples from multiple writes into a single message
+  struct {
+    unsigned size;      // Maximum number of samples per published message.
+    double max_latency; // Maximum time a sample is held back before publishing.
+
+    struct Pool pool;
+    std::vector<struct Sample *> samples; // Samples which are not yet published.
+    std::chrono::steady_clock::time_point deadline;
+
+    std::mutex lock;
+    std::condition_variable cv;
+    std::thread thread;
+    bool running;
+  } batch;
+
+  std::vector<char> buffer; // For serializing published messages.
+
+  // Send times of messages which are not acknowledged by the broker yet, by message ID.
+  std::unordered_map<int, struct timespec> inflight;
+  std::vector<double> latencies; // Of acknowledged messages. Taken by writes.
+  std::mutex inflight_lock;      // Guards inflight and latencies.
 
   struct {
     int enabled;       // Enable SSL encrypted connection to broker.
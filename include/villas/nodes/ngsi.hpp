@@ -13,9 +13,12 @@
 
 #pragma once
 
+#include <mutex>
+
 #include <curl/curl.h>
 #include <jansson.h>
 
+#include <villas/http_client.hpp>
 #include <villas/list.hpp>
 #include <villas/task.hpp>
 
@@ -43,8 +46,19 @@ struct ngsi {
 
   struct curl_slist *headers; // List of HTTP request headers for libcurl
 
+  HttpClient *http; // Performs all requests to the context broker.
+
+  int batch_size;     // Number of updates which are sent in a single request.
+  double max_latency; // Maximum time in seconds an update is held back.
+  int max_in_flight;  // Maximum number of concurrent update requests.
+
+  struct {
+    std::mutex lock; // Guards the fields below.
+    json_t *entity;  // Result of the last completed query. Taken by reads.
+    bool pending;    // A query is being performed.
+  } query;
+
   struct {
-    CURL *curl; // libcurl: handle
     struct List
         signals; // A mapping between indices of the VILLASnode samples and the attributes in ngsi::context
   } in, out;
@@ -10,6 +10,8 @@
 #include <atomic>
 #include <thread>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <sw/redis++/redis++.h>
 
@@ -93,6 +95,22 @@ struct redis {
   double
       rate; // Rate for polling key updates if keyspace notifications are disabled.
 
+  bool async; // Poll for updates in a separate thread.
+  std::thread poller;
+  std::atomic<bool> polling;
+
+  bool transaction; // Wrap each batch of writes in a MULTI/EXEC transaction.
+
+  // Dedicated connections for batched writes with a single round trip.
+  sw::redis::Pipeline *pipeline;
+  sw::redis::Transaction *tx;
+
+  // Maps signal names to indices of the input signals for mode = 'hash'.
+  std::unordered_map<std::string, unsigned> fields;
+
+  // Field-value pairs for mode = 'hash' which are reused across writes.
+  std::vector<std::pair<std::string, std::string>> kvs;
+
   Format *formatter;
 
   struct Pool pool;
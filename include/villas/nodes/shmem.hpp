@@ -12,6 +12,7 @@
 #include <villas/pool.hpp>
 #include <villas/queue.h>
 #include <villas/shmem.hpp>
+#include <villas/task.hpp>
 
 namespace villas {
 namespace node {
@@ -25,6 +26,12 @@ struct shmem {
   struct ShmemConfig conf;    // Interface configuration struct.
   char **exec;                // External program to execute on start.
   struct ShmemInterface intf; // Shmem interface
+
+  bool state;        // Exchange shared state vectors instead of queued samples.
+  double rate;       // Rate at which the input state vector is sampled.
+  struct Task task;  // Timer for sampling the input state vector.
+  uint64_t last_seq; // Sequence lock counter of the last input snapshot.
+  struct ShmemStateInterface state_in, state_out; // Shared state vectors
 };
 
 char *shmem_print(NodeCompat *n);
@@ -37,6 +44,8 @@ int shmem_stop(NodeCompat *n);
 
 int shmem_init(NodeCompat *n);
 
+int shmem_destroy(NodeCompat *n);
+
 int shmem_prepare(NodeCompat *n);
 
 int shmem_read(NodeCompat *n, struct Sample *const smps[], unsigned cnt);
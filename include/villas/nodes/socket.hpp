@@ -11,6 +11,12 @@
 #include <villas/node/config.hpp>
 #include <villas/socket_addr.hpp>
 
+#if defined(LIBXDP_FOUND) && defined(WITH_SOCKET_LAYER_ETH)
+#define WITH_SOCKET_LAYER_XDP
+
+#include <villas/xdp.hpp>
+#endif // LIBXDP_FOUND
+
 namespace villas {
 namespace node {
 
@@ -29,6 +35,12 @@ struct Socket {
 
   Format *formatter;
 
+#ifdef WITH_SOCKET_LAYER_XDP
+  // Kernel-bypass via AF_XDP sockets for the Ethernet layer
+  struct xdp::Options xdp;
+  xdp::Endpoint *xdp_ep; // Sends and receives on the local interface.
+#endif // WITH_SOCKET_LAYER_XDP
+
   // Multicast options
   struct multicast {
     int enabled;         // Is multicast enabled?
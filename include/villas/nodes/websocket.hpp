@@ -7,6 +7,13 @@
 
 #pragma once
 
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
 #include <fmt/ostream.h>
 #include <libwebsockets.h>
 #include <villas/buffer.hpp>
@@ -26,6 +33,34 @@ namespace villas {
 namespace node {
 
 #define DEFAULT_WEBSOCKET_QUEUE_LENGTH (DEFAULT_QUEUE_LENGTH * 64)
+#define DEFAULT_WEBSOCKET_FRAME_QUEUE_LENGTH 64
+
+// What to do if the frame queue of a slow connection is full.
+enum class WebSocketOverflow {
+  DROP_OLDEST, // Discard the oldest queued frame.
+  DROP_NEWEST, // Discard the frame which is about to be queued.
+  DISCONNECT   // Close the connection.
+};
+
+/* A serialized message which is shared by all connections using the same format.
+ *
+ * lws_write() requires LWS_PRE bytes in front of the payload.
+ */
+class WebSocketFrame : public std::vector<char> {
+
+public:
+  bool binary;      // Send as binary instead of text message.
+  unsigned samples; // Number of samples contained in this frame.
+
+  WebSocketFrame(size_t len, bool bin)
+      : std::vector<char>(LWS_PRE + len), binary(bin), samples(0) {}
+
+  char *payload() { return data() + LWS_PRE; }
+
+  size_t length() const { return size() - LWS_PRE; }
+
+  void setLength(size_t len) { resize(LWS_PRE + len); }
+};
 
 // Internal data per websocket node
 struct websocket {
@@ -34,6 +69,15 @@ struct websocket {
 
   bool wait; // Wait until all destinations are connected.
 
+  bool compression; // Negotiate the permessage-deflate extension for connections of this node.
+
+  bool broadcast; // Serialize samples once per format and share the frames between all connections.
+  unsigned frame_queue_length; // Maximum number of frames queued per connection in broadcast mode.
+  enum WebSocketOverflow overflow; // Policy for connections which can not keep up.
+
+  // Formatters for serializing frames in broadcast mode by format name.
+  std::map<std::string, Format *> *formatters;
+
   struct Pool pool;
   struct CQueueSignalled
       queue; // For samples which are received from WebSockets
@@ -65,8 +109,18 @@ struct websocket_connection {
   struct lws *wsi;
   NodeCompat *node;
   Format *formatter;
+  char *format;        // Name of the format used by this connection.
   struct CQueue queue; // For samples which are sent to the Websocket
 
+  struct {
+    std::deque<std::shared_ptr<WebSocketFrame>>
+        *queue;        // For shared frames which are sent in broadcast mode.
+    std::mutex *lock;  // Protects the frame queue.
+    size_t sent;       // Number of frames sent.
+    size_t dropped;    // Number of frames dropped due to overflows.
+    size_t backlog;    // Maximum number of frames queued at once.
+  } frames;
+
   struct websocket_destination *destination;
 
   struct {
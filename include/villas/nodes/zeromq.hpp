@@ -7,11 +7,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <jansson.h>
 
 #include <villas/format.hpp>
 #include <villas/list.hpp>
+#include <villas/pool.hpp>
 #include <villas/super_node.hpp>
 
 #if ZMQ_BUILD_DRAFT_API &&                                                     \
@@ -23,10 +25,23 @@
 namespace villas {
 namespace node {
 
+#define DEFAULT_ZEROMQ_BUFFERS 64
+
 // Forward declarations
 class NodeCompat;
 struct Sample;
 
+/* A pooled buffer which is handed over to ZeroMQ without copying.
+ *
+ * All frames of a multipart message share the same buffer which is
+ * returned to its pool once ZeroMQ released the last of them.
+ */
+struct zeromq_buffer {
+  std::atomic<int> refcnt;
+  struct Pool *pool;
+  char data[];
+};
+
 struct zeromq {
   int ipv6;
 
@@ -54,6 +69,10 @@ struct zeromq {
     char *filter;
     int bind, pending;
   } in, out;
+
+  int multipart; // Send each sample in a separate frame of a multipart message.
+
+  struct Pool pool; // Serialization buffers for zero-copy sends.
 };
 
 char *zeromq_print(NodeCompat *n);
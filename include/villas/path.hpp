@@ -66,7 +66,7 @@ public:
 
   std::vector<struct pollfd> pfds;
 
-  struct Pool pool;
+  struct PoolClasses pool;
   struct Sample *last_sample;
   int last_sequence;
 
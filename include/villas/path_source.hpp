@@ -33,16 +33,21 @@ protected:
 
   bool masked;
 
-  struct Pool pool;
+  struct PoolClasses pool; // Size-classed pool for samples read from the node.
 
   MappingList mappings; // List of mappings (struct MappingEntry).
 
+  // Number of read samples which might be held by secondary path sources
+  virtual unsigned getSecondaryBacklog() { return 0; }
+
 public:
   PathSource(Path *p, Node *n);
   virtual ~PathSource();
 
   void check();
 
+  void prepare();
+
   int read(int i);
 
   virtual void writeToSecondaries(struct Sample *smps[], unsigned cnt) {}
@@ -50,6 +55,8 @@ public:
   Node *getNode() const { return node; }
 
   Path *getPath() const { return path; }
+
+  json_t *toJson();
 };
 
 using PathSourceList = std::vector<PathSource::Ptr>;
@@ -74,6 +81,8 @@ protected:
   SecondaryPathSourceList
       secondaries; // List of secondary path sources (PathSource).
 
+  virtual unsigned getSecondaryBacklog();
+
 public:
   MasterPathSource(Path *p, Node *n);
 
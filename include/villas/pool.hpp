@@ -10,6 +10,8 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <jansson.h>
 #include <sys/types.h>
 
 #include <villas/common.hpp>
@@ -30,11 +32,39 @@ struct Pool {
   size_t blocksz;   // Length of a block in bytes
   size_t alignment; // Alignment of a block in bytes
 
+  ptrdiff_t
+      classes_off; // Offset to the size class set this pool belongs to. See pool_classes().
+
   struct CQueue queue; // The queue which is used to keep track of free blocks
 };
 
+// The maximum number of size classes in a struct PoolClasses
+#define POOL_MAX_CLASSES 24
+
+#define POOL_NO_CLASSES PTRDIFF_MIN
+
+/* A set of pools with power-of-two block sizes.
+ *
+ * Blocks are taken from the smallest class which fits the requested size.
+ * If that class is exhausted, the next larger one is used instead. Each block
+ * remembers its own pool so it can be released with pool_put() as usual.
+ */
+struct PoolClasses {
+  enum State state;
+
+  unsigned num_classes; // Number of valid entries in PoolClasses::pools
+
+  struct Pool pools[POOL_MAX_CLASSES]; // Pools ordered by ascending block size.
+};
+
 #define pool_buffer(p) ((char *)(p) + (p)->buffer_off)
 
+// Get the address of the size class set to which the pool belongs.
+#define pool_classes(p)                                                        \
+  ((p)->classes_off == POOL_NO_CLASSES                                         \
+       ? nullptr                                                               \
+       : (struct PoolClasses *)((char *)(p) + (p)->classes_off))
+
 /* Initiazlize a pool
  *
  * @param[inout] p The pool data structure.
@@ -68,5 +98,47 @@ void *pool_get(struct Pool *p);
 // Release a memory block back to the pool.
 int pool_put(struct Pool *p, void *buf);
 
+// Get the number of blocks which are currently available in the pool.
+size_t pool_available(struct Pool *p);
+
+/* Initialize a set of size-classed pools
+ *
+ * Each block consists of a fixed header of \p hdrsz bytes followed by a
+ * payload. The payload sizes of the classes are the powers of two between
+ * \p min_payload and \p max_payload. The largest class reserves \p cnt
+ * blocks for users which always need the full payload size. Each smaller
+ * class only serves shorter samples and reserves \p small_cnt blocks.
+ *
+ * @param[inout] pc The size class set.
+ * @param[in] cnt The number of blocks reserved by the largest class.
+ * @param[in] small_cnt The number of blocks reserved by each smaller class.
+ * @param[in] hdrsz The size of the fixed part of each block in bytes.
+ * @param[in] min_payload The payload size of the smallest class in bytes.
+ * @param[in] max_payload The payload size of the largest class in bytes.
+ * @param[in] mem The type of memory which should be used for the pools.
+ * @retval 0 The pools have been successfully initialized.
+ * @retval <>0 There was an error during the pool initialization.
+ */
+int pool_classes_init(struct PoolClasses *pc, size_t cnt, size_t small_cnt,
+                      size_t hdrsz, size_t min_payload, size_t max_payload,
+                      struct memory::Type *mem = memory::default_type)
+    __attribute__((warn_unused_result));
+
+// Destroy and release memory used by all pools of a size class set.
+int pool_classes_destroy(struct PoolClasses *pc)
+    __attribute__((warn_unused_result));
+
+/* Get the smallest pool of a size class set whose blocks hold \p blocksz bytes.
+ *
+ * @return The pool or nullptr if \p blocksz exceeds the largest class.
+ */
+struct Pool *pool_classes_select(struct PoolClasses *pc, size_t blocksz);
+
+// Get the largest pool of a size class set.
+struct Pool *pool_classes_largest(struct PoolClasses *pc);
+
+// Get block size, total and used blocks for each class in a JSON array.
+json_t *pool_classes_to_json(struct PoolClasses *pc);
+
 } // namespace node
 } // namespace villas
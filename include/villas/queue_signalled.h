@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <pthread.h>
 
 #include <villas/node/config.hpp>
@@ -21,10 +23,16 @@ enum class QueueSignalledMode {
   POLLING,
 #ifdef HAS_EVENTFD
   EVENTFD,
-
+#endif
+#ifdef HAS_FUTEX
+  FUTEX, // Spin-then-sleep on a futex. Writers only wake sleeping readers.
 #endif
 };
 
+// Bounds for the adaptive number of spins before a reader sleeps on the futex
+#define QUEUE_SIGNALLED_FUTEX_SPIN_MIN 16
+#define QUEUE_SIGNALLED_FUTEX_SPIN_MAX 4096
+
 enum class QueueSignalledFlags { PROCESS_SHARED = (1 << 4) };
 
 // Wrapper around queue that uses POSIX CV's for signalling writes.
@@ -41,6 +49,13 @@ struct CQueueSignalled {
     } pthread;
 #ifdef __linux__
     int eventfd;
+#endif
+#ifdef HAS_FUTEX
+    struct {
+      std::atomic<uint32_t> seq; // Futex word which is incremented on each write.
+      std::atomic<uint32_t> waiters; // Number of readers sleeping on the futex.
+      unsigned spin; // Current number of spins before sleeping.
+    } futex;
 #endif
   };
 };
@@ -35,6 +35,7 @@ namespace node {
 
 // Forward declarations
 struct Pool;
+struct PoolClasses;
 
 // Parts of a sample that can be serialized / de-serialized by the IO formats
 enum class SampleFlags {
@@ -97,10 +98,19 @@ struct Sample {
 
 struct Sample *sample_alloc(struct Pool *p);
 
+// Allocate a sample from the smallest size class which holds \p capacity values.
+struct Sample *sample_alloc(struct PoolClasses *pc, unsigned capacity);
+
 struct Sample *sample_alloc_mem(int capacity);
 
 int sample_init(struct Sample *s);
 
+/* Clone a sample into a new block of its pool.
+ *
+ * If the pool of the sample is part of a size class set, the clone is taken
+ * from the smallest class which fits sample_required_capacity() and has free
+ * blocks left.
+ */
 struct Sample *sample_clone(struct Sample *smp);
 
 void sample_free(struct Sample *s);
@@ -110,6 +120,17 @@ void sample_free(struct Sample *s);
  *  Use the sample_incref() function to increase it. */
 int sample_alloc_many(struct Pool *p, struct Sample *smps[], int cnt);
 
+/* Request \p cnt samples with at least \p capacity values from the smallest
+ * fitting class of the size class set \p pc. */
+int sample_alloc_many(struct PoolClasses *pc, struct Sample *smps[], int cnt,
+                      unsigned capacity);
+
+/* Get the number of values a clone of the sample requires.
+ *
+ * This is the larger one of the current length and the number of signals
+ * described by the sample. */
+unsigned sample_required_capacity(const struct Sample *s);
+
 // Release an array of samples back to their pools
 void sample_free_many(struct Sample *smps[], int cnt);
 
@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <ctime>
+
 #include <villas/pool.hpp>
 #include <villas/queue.h>
 #include <villas/queue_signalled.h>
@@ -14,6 +17,7 @@
 
 #define DEFAULT_SHMEM_QUEUELEN 512u
 #define DEFAULT_SHMEM_SAMPLELEN 64u
+#define DEFAULT_SHMEM_STATE_RETRIES 1024u
 
 namespace villas {
 namespace node {
@@ -21,18 +25,46 @@ namespace node {
 /* Struct containing all parameters that need to be known when creating a new
  * shared memory object. */
 struct ShmemConfig {
-  int polling;   // Whether to use polling instead of POSIX CVs
-  int queuelen;  // Size of the queues (in elements)
+  enum QueueSignalledMode mode; // Signalling mode of the queues
+  int queuelen;                 // Size of the queues (in elements)
   int samplelen; // Maximum number of data entries in a single sample
 };
 
 // The structure that actually resides in the shared memory.
 struct ShmemShared {
-  int polling; // Whether to use a pthread_cond_t to signal if new samples are written to incoming queue.
+  enum QueueSignalledMode
+      mode; // How writers signal new samples in the incoming queue to readers.
   struct CQueueSignalled queue; // Queue for samples passed in both directions.
   struct Pool pool;             // Pool for the samples in the queues.
 };
 
+/* A shared state vector with a fixed layout.
+ *
+ * Instead of passing samples through queues, a single writer updates the
+ * values in place. Readers take consistent snapshots by means of a sequence
+ * lock: ShmemState::seq is odd while an update is in progress and readers
+ * retry if it changed during their copy.
+ */
+struct ShmemState {
+  std::atomic<uint64_t> seq; // Sequence lock counter.
+
+  unsigned capacity; // Number of values for which memory is reserved.
+  unsigned length;   // Number of valid values.
+  int flags;         // See enum SampleFlags.
+  uint64_t sequence; // Sequence number of the current state.
+
+  struct timespec ts; // Origin timestamp of the current state.
+
+  union SignalData data[]; // Values of the state vector.
+};
+
+// Relevant information for a mapped state vector.
+struct ShmemStateInterface {
+  const char *name;         // Name of the shmem object.
+  size_t len;               // Total size of the region.
+  struct ShmemState *state; // The mapped state vector.
+};
+
 // Relevant information for one direction of the interface.
 struct shmem_dir {
   void *base;                 // Base address of the region.
@@ -103,6 +135,55 @@ int shmem_int_write(struct ShmemInterface *shm,
 int shmem_int_alloc(struct ShmemInterface *shm, struct Sample *smps[],
                     unsigned cnt);
 
+/* Open a shared state vector.
+ *
+ * @param name Name of the POSIX shared memory object.
+ * @param st The state interface structure which will be initialized.
+ * @param capacity Number of values of the state vector. Only used when creating.
+ * @param create Create and initialize the shared memory object if true.
+ * @retval 0 The state vector was opened successfully.
+ * @retval <0 An error occured; errno is set accordingly.
+ */
+int shmem_state_open(const char *name, struct ShmemStateInterface *st,
+                     unsigned capacity, bool create);
+
+/* Unmap a shared state vector.
+ *
+ * @param st The state interface.
+ * @param unlink Also remove the shared memory object.
+ */
+int shmem_state_close(struct ShmemStateInterface *st, bool unlink);
+
+/* Begin an update of the state vector.
+ *
+ * The writer can directly modify ShmemState::data afterwards.
+ * Only a single writer is allowed per state vector.
+ *
+ * @return A pointer to the values of the state vector.
+ */
+union SignalData *shmem_state_write_begin(struct ShmemState *st);
+
+// Publish an update which has been started with shmem_state_write_begin().
+void shmem_state_write_end(struct ShmemState *st, unsigned length,
+                           uint64_t sequence, const struct timespec *ts);
+
+// Copy the values of a sample into the state vector.
+int shmem_state_write(struct ShmemState *st, const struct Sample *smp);
+
+/* Take a consistent snapshot of the state vector.
+ *
+ * The reader gives up after \p retries attempts which overlapped with an
+ * update. This avoids spinning forever if the writer died mid-update.
+ *
+ * @retval 1 A new state has been copied to \p smp.
+ * @retval 0 The state did not change since the snapshot with sequence lock
+ *           counter \p last.
+ * @retval -1 No consistent snapshot could be taken; errno is set to EBUSY.
+ */
+int shmem_state_read(struct ShmemState *st, struct Sample *smp,
+                     uint64_t *last,
+                     unsigned retries = DEFAULT_SHMEM_STATE_RETRIES);
+
 /* Returns the total size of the shared memory region with the given size of
  * the input/output queues (in elements) and the given number of data elements
  * per struct Sample. */
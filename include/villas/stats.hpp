@@ -50,7 +50,11 @@ public:
     // RTP metrics
     RTP_LOSS_FRACTION, // Fraction lost since last RTP SR/RR.
     RTP_PKTS_LOST,     // Cumul. no. pkts lost.
-    RTP_JITTER         // Interarrival jitter.
+    RTP_JITTER,        // Interarrival jitter.
+
+    // Message broker metrics
+    DELIVERY_LATENCY, // Time until a sent message is acknowledged by the broker.
+    IN_FLIGHT // Number of sent messages which are not acknowledged yet.
   };
 
   enum class Type { LAST, HIGHEST, LOWEST, MEAN, VAR, STDDEV, TOTAL };
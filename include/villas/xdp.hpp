@@ -0,0 +1,229 @@
+/* Kernel-bypass packet I/O with AF_XDP sockets.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <jansson.h>
+#include <net/ethernet.h>
+#include <xdp/xsk.h>
+
+#include <villas/log.hpp>
+
+namespace villas {
+namespace xdp {
+
+#define XDP_MAX_QUEUES 16 // Limited by the number of poll fds of a node
+#define XDP_DEFAULT_FRAMES 4096
+#define XDP_DEFAULT_BATCH 64
+
+// Frames which each socket hands to the kernel for reception
+#define XDP_FILL_FRAMES (XSK_RING_PROD__DEFAULT_NUM_DESCS / 2)
+
+enum class Mode {
+  AUTO,   // Let the kernel choose the best available mode.
+  SKB,    // Generic XDP. Works with every driver including veth.
+  NATIVE, // Driver XDP.
+};
+
+struct Options {
+  bool enabled;
+  bool zerocopy; // Map the UMEM directly into the NIC rings.
+  enum Mode mode;
+  unsigned frames; // Number of frames in the UMEM.
+  unsigned num_queues;
+  unsigned queues[XDP_MAX_QUEUES];
+};
+
+// Parses the 'xdp' setting of a node
+void parse(json_t *json, struct Options *o);
+
+/* A memory area for packet buffers which is registered with the kernel.
+ *
+ * All sockets of an interface share the same UMEM. Each socket brings its
+ * own fill and completion rings. Frames are handed out from a common pool.
+ */
+class Umem {
+
+public:
+  using Ptr = std::shared_ptr<Umem>;
+
+  static constexpr uint64_t INVALID_FRAME = UINT64_MAX;
+
+protected:
+  struct xsk_umem *umem;
+  struct xsk_ring_prod fill;
+  struct xsk_ring_cons comp;
+
+  void *area;
+  size_t frame_size;
+  unsigned num_frames;
+
+  std::mutex mutex;
+  std::vector<uint64_t> free_frames;
+  std::set<unsigned> queues; // Queues which are bound to a socket.
+
+public:
+  Umem(unsigned frames, size_t frame_size = XSK_UMEM__DEFAULT_FRAME_SIZE);
+  ~Umem();
+
+  // Returns the UMEM of an interface, creating it on first use
+  static Ptr get(const std::string &ifname, unsigned frames);
+
+  /* Each queue of an interface can only be bound to a single socket.
+   * Returns false if the queue is already in use. */
+  bool bind(unsigned queue);
+  void unbind(unsigned queue);
+
+  unsigned getFree();
+
+  struct xsk_umem *getHandle() { return umem; }
+
+  uint8_t *getData(uint64_t addr) {
+    return (uint8_t *)xsk_umem__get_data(area, addr);
+  }
+
+  size_t getFrameSize() const { return frame_size; }
+
+  // Strips the headroom offset which the kernel might have added
+  uint64_t getFrame(uint64_t addr) const { return addr - addr % frame_size; }
+
+  unsigned alloc(uint64_t *frames, unsigned cnt);
+  void free(const uint64_t *frames, unsigned cnt);
+};
+
+// An AF_XDP socket which is bound to a single queue of an interface
+class Socket {
+
+protected:
+  Umem::Ptr umem;
+
+  struct xsk_socket *xsk;
+  struct xsk_ring_cons rx;
+  struct xsk_ring_prod tx;
+  struct xsk_ring_prod fill;
+  struct xsk_ring_cons comp;
+
+  unsigned queue;
+  unsigned tx_pending; // Frames which have not been completed by the kernel.
+  uint64_t tx_frame;   // Frame which is currently filled by the caller.
+
+  Logger logger;
+
+  // Returns frames of completed transmissions to the UMEM
+  void complete();
+
+  // Hands empty frames to the kernel for reception
+  void refill(unsigned cnt);
+
+public:
+  Socket(Umem::Ptr umem, const std::string &ifname, unsigned queue,
+         const struct Options *o);
+  ~Socket();
+
+  int getFD() { return xsk_socket__fd(xsk); }
+
+  /* Invokes handler(const uint8_t *frame, size_t len) for at most max
+   * received frames. Frames are recycled after the handler returned.
+   */
+  template <typename Handler> unsigned receive(unsigned max, Handler handler) {
+    uint32_t idx_rx, idx_fill;
+
+    unsigned rcvd = xsk_ring_cons__peek(&rx, max, &idx_rx);
+    if (rcvd == 0) {
+      if (xsk_ring_prod__needs_wakeup(&fill))
+        recvfrom(getFD(), nullptr, 0, MSG_DONTWAIT, nullptr, nullptr);
+
+      return 0;
+    }
+
+    for (unsigned i = 0; i < rcvd; i++) {
+      auto *desc = xsk_ring_cons__rx_desc(&rx, idx_rx + i);
+
+      handler(umem->getData(desc->addr), (size_t)desc->len);
+    }
+
+    // Received frames go straight back to the fill ring
+    if (xsk_ring_prod__reserve(&fill, rcvd, &idx_fill) == rcvd) {
+      for (unsigned i = 0; i < rcvd; i++)
+        *xsk_ring_prod__fill_addr(&fill, idx_fill + i) = umem->getFrame(
+            xsk_ring_cons__rx_desc(&rx, idx_rx + i)->addr);
+
+      xsk_ring_prod__submit(&fill, rcvd);
+    } else {
+      for (unsigned i = 0; i < rcvd; i++) {
+        uint64_t frame =
+            umem->getFrame(xsk_ring_cons__rx_desc(&rx, idx_rx + i)->addr);
+        umem->free(&frame, 1);
+      }
+    }
+
+    xsk_ring_cons__release(&rx, rcvd);
+
+    return rcvd;
+  }
+
+  /* Returns a buffer of getFrameSize() bytes for the next outgoing frame or
+   * nullptr if no frame is available.
+   */
+  uint8_t *reserve();
+
+  // Queues the frame returned by reserve() for transmission
+  int submit(size_t len);
+
+  // Notifies the kernel about queued frames
+  void flush();
+};
+
+// A set of sockets for the queues of a single interface
+class Endpoint {
+
+protected:
+  std::string ifname;
+  Umem::Ptr umem;
+
+  std::vector<std::unique_ptr<Socket>> sockets;
+  unsigned next; // Socket which is polled first for the next read.
+
+  struct ether_addr address;
+
+public:
+  Endpoint(const std::string &ifname, const struct Options *o);
+
+  int getFDs(int fds[]);
+
+  const struct ether_addr *getAddress() const { return &address; }
+
+  size_t getFrameSize() const { return umem->getFrameSize(); }
+
+  // Transmission always uses the socket of the first queue
+  Socket &getTx() { return *sockets[0]; }
+
+  // Receives from the queues in a round-robin fashion
+  template <typename Handler> unsigned receive(unsigned max, Handler handler) {
+    unsigned rcvd = 0;
+
+    for (unsigned i = 0; i < sockets.size() && rcvd < max; i++) {
+      auto &s = sockets[(next + i) % sockets.size()];
+
+      rcvd += s->receive(max - rcvd, handler);
+    }
+
+    next = (next + 1) % sockets.size();
+
+    return rcvd;
+  }
+};
+
+} // namespace xdp
+} // namespace villas
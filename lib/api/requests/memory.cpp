@@ -0,0 +1,43 @@
+/* The "memory" API request.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <jansson.h>
+
+#include <villas/api/request.hpp>
+#include <villas/api/response.hpp>
+#include <villas/node/memory.hpp>
+
+namespace villas {
+namespace node {
+namespace api {
+
+class MemoryRequest : public Request {
+
+public:
+  using Request::Request;
+
+  virtual Response *execute() {
+    if (method != Session::Method::GET)
+      throw InvalidMethod(this);
+
+    if (body != nullptr)
+      throw BadRequest("Memory endpoint does not accept any body data");
+
+    return new JsonResponse(session, HTTP_STATUS_OK,
+                            memory::accounting_to_json());
+  }
+};
+
+// Register API request
+static char n[] = "memory";
+static char r[] = "/memory";
+static char d[] = "Get memory usage per owner and memory type";
+static RequestPlugin<MemoryRequest, n, r, d> p;
+
+} // namespace api
+} // namespace node
+} // namespace villas
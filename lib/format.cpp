@@ -13,6 +13,7 @@
 #include <villas/exceptions.hpp>
 #include <villas/format.hpp>
 #include <villas/node/config.hpp>
+#include <villas/node/memory.hpp>
 #include <villas/sample.hpp>
 #include <villas/utils.hpp>
 
@@ -60,6 +61,10 @@ Format::Format(int fl) : flags(fl), real_precision(17), signals(nullptr) {
 
   if (!in.buffer || !out.buffer)
     throw MemoryAllocationError();
+
+  // Avoid page faults when the buffers are used for the first time
+  memory::prefault(in.buffer, in.buflen);
+  memory::prefault(out.buffer, out.buflen);
 }
 
 Format::~Format() {
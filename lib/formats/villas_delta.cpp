@@ -0,0 +1,391 @@
+/* Delta-encoded binary format.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <cstring>
+
+#include <villas/exceptions.hpp>
+#include <villas/formats/villas_delta.hpp>
+#include <villas/sample.hpp>
+#include <villas/signal.hpp>
+#include <villas/utils.hpp>
+
+using namespace villas;
+using namespace villas::node;
+
+#define DEFAULT_KEYFRAME_INTERVAL 100
+
+// Little-endian base 128 variable-length integers
+static bool put_varint(char *&ptr, const char *end, uint64_t v) {
+  do {
+    if (ptr >= end)
+      return false;
+
+    uint8_t b = v & 0x7f;
+    v >>= 7;
+
+    *ptr++ = b | (v ? 0x80 : 0);
+  } while (v);
+
+  return true;
+}
+
+static bool get_varint(const char *&ptr, const char *end, uint64_t &v) {
+  v = 0;
+
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (ptr >= end)
+      return false;
+
+    uint8_t b = *ptr++;
+
+    v |= (uint64_t)(b & 0x7f) << shift;
+    if (!(b & 0x80))
+      return true;
+  }
+
+  return false;
+}
+
+// Maps signed integers with a small magnitude to small unsigned integers
+static uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (v >> 63); }
+
+static int64_t unzigzag(uint64_t u) { return (u >> 1) ^ -(int64_t)(u & 1); }
+
+static uint64_t to_bits(const union SignalData &d, enum SignalType type) {
+  uint64_t bits;
+
+  if (type == SignalType::BOOLEAN)
+    return d.b ? 1 : 0;
+
+  memcpy(&bits, &d, sizeof(bits));
+
+  return bits;
+}
+
+static void from_bits(union SignalData &d, enum SignalType type,
+                      uint64_t bits) {
+  if (type == SignalType::BOOLEAN)
+    d.b = bits != 0;
+  else
+    memcpy(&d, &bits, sizeof(bits));
+}
+
+// Integers are subtracted while all other types are XOR'ed with their predecessor
+static uint64_t delta(enum SignalType type, uint64_t cur, uint64_t prev) {
+  return type == SignalType::INTEGER ? zigzag(cur - prev) : cur ^ prev;
+}
+
+static uint64_t undelta(enum SignalType type, uint64_t d, uint64_t prev) {
+  return type == SignalType::INTEGER ? prev + unzigzag(d) : d ^ prev;
+}
+
+VillasDeltaFormat::VillasDeltaFormat(int fl)
+    : BinaryFormat(fl), keyframe_interval(DEFAULT_KEYFRAME_INTERVAL) {
+  reset();
+}
+
+void VillasDeltaFormat::reset() {
+  tx.valid = false;
+  tx.counter = 0;
+  tx.values.clear();
+
+  rx.valid = false;
+  rx.counter = 0;
+  rx.values.clear();
+
+  since_keyframe = 0;
+}
+
+int VillasDeltaFormat::encode(char *buf, size_t len, const struct Sample *smp) {
+  char *ptr = buf;
+  const char *end = buf + len;
+  int fl = flags & smp->flags;
+
+  uint8_t hdr = 0;
+  if (fl & (int)SampleFlags::HAS_SEQUENCE)
+    hdr |= SEQUENCE;
+  if (fl & (int)SampleFlags::HAS_TS_ORIGIN)
+    hdr |= TS_ORIGIN;
+  if (fl & (int)SampleFlags::HAS_DATA)
+    hdr |= DATA;
+
+  unsigned length = hdr & DATA ? smp->length : 0;
+
+  bool key = !tx.valid || since_keyframe >= keyframe_interval ||
+             length != tx.values.size();
+  if (key)
+    hdr |= KEYFRAME;
+
+  if (ptr + 2 > end)
+    return -1;
+
+  *ptr++ = hdr;
+  *ptr++ = tx.counter;
+
+  if (hdr & SEQUENCE) {
+    uint64_t v = key ? smp->sequence : zigzag(smp->sequence - tx.sequence);
+    if (!put_varint(ptr, end, v))
+      return -1;
+  }
+
+  if (hdr & TS_ORIGIN) {
+    if (key) {
+      if (!put_varint(ptr, end, smp->ts.origin.tv_sec) ||
+          !put_varint(ptr, end, smp->ts.origin.tv_nsec))
+        return -1;
+    } else {
+      int64_t ns = (smp->ts.origin.tv_sec - tx.ts.tv_sec) * 1000000000LL +
+                   (smp->ts.origin.tv_nsec - tx.ts.tv_nsec);
+      if (!put_varint(ptr, end, zigzag(ns)))
+        return -1;
+    }
+  }
+
+  std::vector<uint64_t> values(length);
+
+  if (hdr & DATA) {
+    if (!put_varint(ptr, end, length))
+      return -1;
+
+    for (unsigned i = 0; i < length; i++)
+      values[i] = to_bits(smp->data[i], sample_format(smp, i));
+
+    // Bitmap of the values which have changed since the previous sample
+    if (!key) {
+      size_t mlen = (length + 7) / 8;
+      if (ptr + mlen > end)
+        return -1;
+
+      memset(ptr, 0, mlen);
+      for (unsigned i = 0; i < length; i++) {
+        if (values[i] != tx.values[i])
+          ptr[i / 8] |= 1 << (i % 8);
+      }
+
+      ptr += mlen;
+    }
+
+    for (unsigned i = 0; i < length; i++) {
+      if (key) {
+        auto type = sample_format(smp, i);
+        uint64_t v =
+            type == SignalType::INTEGER ? zigzag(values[i]) : values[i];
+        if (!put_varint(ptr, end, v))
+          return -1;
+      } else if (values[i] != tx.values[i]) {
+        if (!put_varint(ptr, end,
+                        delta(sample_format(smp, i), values[i], tx.values[i])))
+          return -1;
+      }
+    }
+  }
+
+  // Only commit state for samples which did fit into the buffer
+  tx.valid = true;
+  tx.counter++;
+  tx.sequence = smp->sequence;
+  tx.ts = smp->ts.origin;
+  tx.values = std::move(values);
+
+  since_keyframe = key ? 1 : since_keyframe + 1;
+
+  return ptr - buf;
+}
+
+int VillasDeltaFormat::decode(const char *buf, size_t len, struct Sample *smp,
+                              bool &skip) {
+  const char *ptr = buf;
+  const char *end = buf + len;
+  uint64_t v;
+
+  if (ptr + 2 > end)
+    return -1;
+
+  uint8_t hdr = *ptr++;
+  uint8_t counter = *ptr++;
+
+  bool key = hdr & KEYFRAME;
+
+  // Deltas can only be applied on top of their direct predecessor
+  skip = !key && (!rx.valid || counter != (uint8_t)(rx.counter + 1));
+
+  smp->flags = 0;
+  smp->signals = signals;
+
+  if (hdr & SEQUENCE) {
+    if (!get_varint(ptr, end, v))
+      return -1;
+
+    smp->sequence = key ? v : rx.sequence + unzigzag(v);
+    smp->flags |= (int)SampleFlags::HAS_SEQUENCE;
+  }
+
+  if (hdr & TS_ORIGIN) {
+    if (key) {
+      uint64_t sec, nsec;
+      if (!get_varint(ptr, end, sec) || !get_varint(ptr, end, nsec))
+        return -1;
+
+      smp->ts.origin.tv_sec = sec;
+      smp->ts.origin.tv_nsec = nsec;
+    } else {
+      if (!get_varint(ptr, end, v))
+        return -1;
+
+      int64_t ns = rx.ts.tv_sec * 1000000000LL + rx.ts.tv_nsec + unzigzag(v);
+
+      smp->ts.origin.tv_sec = ns / 1000000000LL;
+      smp->ts.origin.tv_nsec = ns % 1000000000LL;
+    }
+
+    smp->flags |= (int)SampleFlags::HAS_TS_ORIGIN;
+  }
+
+  unsigned length = 0;
+  if (hdr & DATA) {
+    if (!get_varint(ptr, end, v))
+      return -1;
+
+    length = v;
+
+    // Each value occupies at least one bit of the mask or one byte
+    if (length > (size_t)(end - ptr) * 8)
+      return -1;
+
+    if (!key && length != rx.values.size())
+      skip = true;
+
+    const char *mask = nullptr;
+    if (!key) {
+      mask = ptr;
+      ptr += (length + 7) / 8;
+      if (ptr > end)
+        return -1;
+    }
+
+    std::vector<uint64_t> values = key || skip ? std::vector<uint64_t>(length)
+                                               : rx.values;
+
+    for (unsigned i = 0; i < length; i++) {
+      auto type = signals && i < signals->size()
+                      ? signals->getByIndex(i)->type
+                      : SignalType::FLOAT;
+
+      if (key) {
+        if (!get_varint(ptr, end, v))
+          return -1;
+
+        values[i] = type == SignalType::INTEGER ? unzigzag(v) : v;
+      } else if (mask[i / 8] & (1 << (i % 8))) {
+        if (!get_varint(ptr, end, v))
+          return -1;
+
+        if (!skip)
+          values[i] = undelta(type, v, rx.values[i]);
+      }
+
+      if (!skip && i < smp->capacity)
+        from_bits(smp->data[i], type, values[i]);
+    }
+
+    if (!skip)
+      rx.values = std::move(values);
+
+    smp->length = MIN(length, smp->capacity);
+    smp->flags |= (int)SampleFlags::HAS_DATA;
+  } else
+    smp->length = 0;
+
+  if (skip)
+    rx.valid = false;
+  else {
+    rx.valid = true;
+    rx.counter = counter;
+    rx.sequence = smp->sequence;
+    rx.ts = smp->ts.origin;
+
+    if (!(hdr & DATA))
+      rx.values.clear();
+  }
+
+  return ptr - buf;
+}
+
+int VillasDeltaFormat::sprint(char *buf, size_t len, size_t *wbytes,
+                              const struct Sample *const smps[], unsigned cnt) {
+  unsigned i;
+  char *ptr = buf;
+
+  for (i = 0; i < cnt; i++) {
+    int ret = encode(ptr, buf + len - ptr, smps[i]);
+    if (ret < 0)
+      break;
+
+    ptr += ret;
+  }
+
+  if (wbytes)
+    *wbytes = ptr - buf;
+
+  return i;
+}
+
+int VillasDeltaFormat::sscan(const char *buf, size_t len, size_t *rbytes,
+                             struct Sample *const smps[], unsigned cnt) {
+  unsigned i = 0;
+  const char *ptr = buf;
+
+  while (i < cnt && ptr < buf + len) {
+    bool skip;
+
+    int ret = decode(ptr, buf + len - ptr, smps[i], skip);
+    if (ret < 0)
+      break;
+
+    ptr += ret;
+
+    // Samples are dropped until the next keyframe if a predecessor is missing
+    if (skip)
+      logger->debug("Skipping delta without predecessor");
+    else
+      i++;
+  }
+
+  if (rbytes)
+    *rbytes = ptr - buf;
+
+  return i;
+}
+
+void VillasDeltaFormat::parse(json_t *json) {
+  int ret;
+  json_error_t err;
+  int ki = -1;
+
+  ret = json_unpack_ex(json, &err, 0, "{ s?: i }", "keyframe_interval", &ki);
+  if (ret)
+    throw ConfigError(json, err, "node-config-format-villas-delta",
+                      "Failed to parse format configuration");
+
+  if (ki == 0)
+    throw ConfigError(json, "node-config-format-villas-delta-keyframe-interval",
+                      "The keyframe_interval setting must be positive");
+  else if (ki > 0)
+    keyframe_interval = ki;
+
+  Format::parse(json);
+}
+
+// Register format
+static char n[] = "villas.delta";
+static char d[] = "VILLAS binary format with delta encoding against the "
+                  "previous sample";
+static FormatPlugin<VillasDeltaFormat, n, d,
+                    (int)SampleFlags::HAS_TS_ORIGIN |
+                        (int)SampleFlags::HAS_SEQUENCE |
+                        (int)SampleFlags::HAS_DATA>
+    p;
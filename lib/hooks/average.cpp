@@ -5,6 +5,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <villas/dsp/window_stats.hpp>
 #include <villas/hook.hpp>
 #include <villas/node/exceptions.hpp>
 #include <villas/sample.hpp>
@@ -53,7 +54,8 @@ public:
   }
 
   virtual Hook::Reason process(struct Sample *smp) {
-    double avg, sum = 0;
+    double avg;
+    dsp::CompensatedSum sum;
     int n = 0;
 
     assert(state == State::STARTED);
@@ -61,11 +63,11 @@ public:
     for (unsigned index : signalIndices) {
       switch (sample_format(smp, index)) {
       case SignalType::INTEGER:
-        sum += smp->data[index].i;
+        sum.add(smp->data[index].i);
         break;
 
       case SignalType::FLOAT:
-        sum += smp->data[index].f;
+        sum.add(smp->data[index].f);
         break;
 
       case SignalType::INVALID:
@@ -77,7 +79,7 @@ public:
       n++;
     }
 
-    avg = sum / n;
+    avg = sum.value() / n;
 
     if (offset >= smp->length)
       return Reason::ERROR;
@@ -10,6 +10,7 @@
 
 #include <complex>
 
+#include <villas/dsp/spectrum.hpp>
 #include <villas/dsp/window.hpp>
 #include <villas/hook.hpp>
 #include <villas/sample.hpp>
@@ -39,18 +40,23 @@ protected:
   int fharmonics_len;
 
   dsp::Window<double> window;
+  dsp::Spectrum *spectrum;
+
+  std::vector<long> bins;
+  std::vector<std::complex<double>> spectrumCoeffs;
 
   void step(double *in, std::complex<float> *out) {
     int N = window.size();
-    std::complex<double> om_k, corr;
+    std::complex<double> corr;
     double newest = *in;
     __attribute__((unused)) double oldest = window.update(newest);
 
-    for (int k = 0; k < fharmonics_len; k++) {
-      om_k = 2.0i * M_PI * (double)fharmonics[k] / (double)N;
+    // Full DFT: sum_n x_n * exp(om_k * n) is bin -k of the spectrum
+    spectrum->compute(window.data(), N, spectrumCoeffs.data(), bins);
 
-      // Correction for stationary phasor
-      corr = std::exp(-om_k * (steps - (N + 1)));
+    for (int k = 0; k < fharmonics_len; k++) {
+      // Correction for stationary phasor: exp(-om_k * (steps - (N + 1)))
+      corr = spectrum->twiddle(fharmonics[k] * ((long)steps - (N + 1)));
       //corr = 1;
 
 #if 0
@@ -63,16 +69,7 @@ protected:
 			if (fharmonics[k] == 0)
 				out[k] /= 2.0;
 #else
-      // Full DFT
-      std::complex<double> X_k = 0;
-
-      for (int n = 0; n < N; n++) {
-        double x_n = window[n];
-
-        X_k += x_n * std::exp(om_k * (double)n);
-      }
-
-      out[k] = X_k / (corr * (double)N);
+      out[k] = spectrumCoeffs[k] / (corr * (double)N);
 #endif
     }
   }
@@ -97,7 +94,7 @@ public:
   DPHook(Path *p, Node *n, int fl, int prio, bool en = true)
       : Hook(p, n, fl, prio, en), signal_name(nullptr), signal_index(0),
         inverse(0), f0(50.0), timestep(50e-6), time(), steps(0),
-        coeffs(), fharmonics(), fharmonics_len(0) {}
+        coeffs(), fharmonics(), fharmonics_len(0), spectrum(nullptr) {}
 
   virtual ~DPHook() {
     // Release memory
@@ -107,6 +104,9 @@ public:
     if (coeffs)
       delete coeffs;
 
+    if (spectrum)
+      delete spectrum;
+
     if (signal_name)
       free(signal_name);
   }
@@ -126,6 +126,17 @@ public:
           "Windows size is 0: f0 * timestep < 1.0 not satisfied");
     }
 
+    if (spectrum)
+      delete spectrum;
+
+    spectrum = new dsp::Spectrum(window.size());
+
+    spectrumCoeffs.resize(fharmonics_len);
+
+    bins.clear();
+    for (int i = 0; i < fharmonics_len; i++)
+      bins.push_back(-fharmonics[i]);
+
     state = State::STARTED;
   }
 
@@ -0,0 +1,745 @@
+/* Expression hook.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include <villas/exceptions.hpp>
+#include <villas/hooks/expr.hpp>
+#include <villas/sample.hpp>
+#include <villas/signal_list.hpp>
+#include <villas/timing.hpp>
+
+namespace villas {
+namespace node {
+namespace expr {
+
+struct Program::Node {
+  Op op;
+  double value;      // For Op::CONST
+  unsigned variable; // For Op::VAR
+  std::vector<NodePtr> args;
+
+  Node(Op o, double v = 0, unsigned var = 0) : op(o), value(v), variable(var) {}
+};
+
+// Semantics of all operations, shared by the constant folding and the tape
+static inline double apply(Op op, double a, double b, double c) {
+  switch (op) {
+  case Op::ADD:
+    return a + b;
+  case Op::SUB:
+    return a - b;
+  case Op::MUL:
+    return a * b;
+  case Op::DIV:
+    return a / b;
+  case Op::MOD:
+    return std::fmod(a, b);
+  case Op::POW:
+    return std::pow(a, b);
+  case Op::NEG:
+    return -a;
+
+  case Op::LT:
+    return a < b ? 1.0 : 0.0;
+  case Op::LE:
+    return a <= b ? 1.0 : 0.0;
+  case Op::GT:
+    return a > b ? 1.0 : 0.0;
+  case Op::GE:
+    return a >= b ? 1.0 : 0.0;
+  case Op::EQ:
+    return a == b ? 1.0 : 0.0;
+  case Op::NE:
+    return a != b ? 1.0 : 0.0;
+  case Op::AND:
+    return (a != 0) & (b != 0) ? 1.0 : 0.0;
+  case Op::OR:
+    return (a != 0) | (b != 0) ? 1.0 : 0.0;
+  case Op::NOT:
+    return a == 0 ? 1.0 : 0.0;
+  case Op::SELECT:
+    return a != 0 ? b : c;
+
+  case Op::ABS:
+    return std::fabs(a);
+  case Op::SQRT:
+    return std::sqrt(a);
+  case Op::EXP:
+    return std::exp(a);
+  case Op::LOG:
+    return std::log(a);
+  case Op::LOG10:
+    return std::log10(a);
+  case Op::SIN:
+    return std::sin(a);
+  case Op::COS:
+    return std::cos(a);
+  case Op::TAN:
+    return std::tan(a);
+  case Op::ASIN:
+    return std::asin(a);
+  case Op::ACOS:
+    return std::acos(a);
+  case Op::ATAN:
+    return std::atan(a);
+  case Op::ATAN2:
+    return std::atan2(a, b);
+  case Op::HYPOT:
+    return std::hypot(a, b);
+  case Op::FLOOR:
+    return std::floor(a);
+  case Op::CEIL:
+    return std::ceil(a);
+  case Op::ROUND:
+    return std::round(a);
+  case Op::MIN:
+    return std::fmin(a, b);
+  case Op::MAX:
+    return std::fmax(a, b);
+
+  case Op::CONST:
+  case Op::VAR:
+    break;
+  }
+
+  return std::numeric_limits<double>::quiet_NaN();
+}
+
+static const std::map<std::string, std::pair<Op, unsigned>> functions = {
+    {"abs", {Op::ABS, 1}},     {"sqrt", {Op::SQRT, 1}},
+    {"exp", {Op::EXP, 1}},     {"log", {Op::LOG, 1}},
+    {"log10", {Op::LOG10, 1}}, {"sin", {Op::SIN, 1}},
+    {"cos", {Op::COS, 1}},     {"tan", {Op::TAN, 1}},
+    {"asin", {Op::ASIN, 1}},   {"acos", {Op::ACOS, 1}},
+    {"atan", {Op::ATAN, 1}},   {"atan2", {Op::ATAN2, 2}},
+    {"hypot", {Op::HYPOT, 2}}, {"floor", {Op::FLOOR, 1}},
+    {"ceil", {Op::CEIL, 1}},   {"round", {Op::ROUND, 1}},
+    {"min", {Op::MIN, 2}},     {"max", {Op::MAX, 2}},
+    {"pow", {Op::POW, 2}},     {"fmod", {Op::MOD, 2}}};
+
+static const std::map<std::string, double> namedConstants = {{"pi", M_PI},
+                                                              {"e", M_E}};
+
+static bool isConst(const Program::NodePtr &n, double v) {
+  return n->op == Op::CONST && n->value == v;
+}
+
+/* Create a node and fold it if possible.
+ *
+ * Operations on constants are evaluated right away. Some algebraic identities
+ * are simplified as well, as long as they do not change the result for NaN or
+ * infinite operands. */
+static Program::NodePtr makeNode(Op op, std::vector<Program::NodePtr> args) {
+  bool allConst = true;
+  for (auto &arg : args)
+    allConst &= arg->op == Op::CONST;
+
+  if (allConst) {
+    double v[3] = {0, 0, 0};
+    for (unsigned i = 0; i < args.size(); i++)
+      v[i] = args[i]->value;
+
+    return std::make_unique<Program::Node>(Op::CONST,
+                                           apply(op, v[0], v[1], v[2]));
+  }
+
+  switch (op) {
+  case Op::ADD:
+    if (isConst(args[1], 0))
+      return std::move(args[0]);
+    if (isConst(args[0], 0))
+      return std::move(args[1]);
+    break;
+
+  case Op::SUB:
+  case Op::DIV:
+  case Op::MUL:
+    if (op == Op::SUB && isConst(args[1], 0))
+      return std::move(args[0]);
+    if (op != Op::SUB && isConst(args[1], 1))
+      return std::move(args[0]);
+    if (op == Op::MUL && isConst(args[0], 1))
+      return std::move(args[1]);
+    break;
+
+  case Op::POW:
+    if (isConst(args[1], 1))
+      return std::move(args[0]);
+    break;
+
+  case Op::SELECT:
+    if (args[0]->op == Op::CONST)
+      return std::move(args[args[0]->value != 0 ? 1 : 2]);
+    break;
+
+  default:
+    break;
+  }
+
+  auto n = std::make_unique<Program::Node>(op);
+  n->args = std::move(args);
+
+  return n;
+}
+
+static Program::NodePtr makeNode(Op op, Program::NodePtr a,
+                                 Program::NodePtr b = nullptr,
+                                 Program::NodePtr c = nullptr) {
+  std::vector<Program::NodePtr> args;
+
+  args.push_back(std::move(a));
+  if (b)
+    args.push_back(std::move(b));
+  if (c)
+    args.push_back(std::move(c));
+
+  return makeNode(op, std::move(args));
+}
+
+// Recursive descent parser
+class Parser {
+
+protected:
+  const std::string &str;
+  const std::vector<std::string> &variables;
+  std::vector<bool> &used;
+  size_t pos;
+
+  void skip() {
+    while (pos < str.size() && isspace(str[pos]))
+      pos++;
+  }
+
+  bool accept(const char *tok) {
+    skip();
+
+    size_t len = strlen(tok);
+    if (str.compare(pos, len, tok) != 0)
+      return false;
+
+    // Do not match the prefix of a longer operator
+    if (len == 1 && pos + 1 < str.size() && str[pos + 1] == '=' &&
+        strchr("<>=!", tok[0]))
+      return false;
+
+    pos += len;
+    return true;
+  }
+
+  void expect(const char *tok) {
+    if (!accept(tok))
+      error(fmt::format("Expected '{}'", tok));
+  }
+
+  [[noreturn]] void error(const std::string &msg) {
+    throw RuntimeError("{} at position {} of expression: {}", msg, pos, str);
+  }
+
+  Program::NodePtr variable(const std::string &name) {
+    for (unsigned i = 0; i < variables.size(); i++) {
+      if (variables[i] == name) {
+        used[i] = true;
+        return std::make_unique<Program::Node>(Op::VAR, 0, i);
+      }
+    }
+
+    auto it = namedConstants.find(name);
+    if (it != namedConstants.end())
+      return std::make_unique<Program::Node>(Op::CONST, it->second);
+
+    error(fmt::format("Unknown variable '{}'", name));
+  }
+
+  Program::NodePtr primary() {
+    skip();
+
+    if (pos >= str.size())
+      error("Unexpected end");
+
+    if (accept("(")) {
+      auto n = ternary();
+      expect(")");
+      return n;
+    }
+
+    // Quoted names for signals which are no valid identifiers
+    if (accept("${")) {
+      size_t end = str.find('}', pos);
+      if (end == std::string::npos)
+        error("Missing '}'");
+
+      auto name = str.substr(pos, end - pos);
+      pos = end + 1;
+
+      return variable(name);
+    }
+
+    if (isdigit(str[pos]) || str[pos] == '.') {
+      const char *start = str.c_str() + pos;
+      char *end;
+
+      double v = strtod(start, &end);
+      if (end == start)
+        error("Invalid number");
+
+      pos += end - start;
+
+      return std::make_unique<Program::Node>(Op::CONST, v);
+    }
+
+    if (isalpha(str[pos]) || str[pos] == '_') {
+      size_t start = pos;
+      while (pos < str.size() && (isalnum(str[pos]) || str[pos] == '_'))
+        pos++;
+
+      auto name = str.substr(start, pos - start);
+
+      if (!accept("("))
+        return variable(name);
+
+      auto it = functions.find(name);
+      if (it == functions.end())
+        error(fmt::format("Unknown function '{}'", name));
+
+      std::vector<Program::NodePtr> args;
+      if (!accept(")")) {
+        do
+          args.push_back(ternary());
+        while (accept(","));
+
+        expect(")");
+      }
+
+      if (args.size() != it->second.second)
+        error(fmt::format("Function '{}' expects {} arguments", name,
+                          it->second.second));
+
+      return makeNode(it->second.first, std::move(args));
+    }
+
+    error(fmt::format("Unexpected character '{}'", str[pos]));
+  }
+
+  // Exponentiation is right-associative and binds stronger than unary minus
+  Program::NodePtr power() {
+    auto n = primary();
+
+    if (accept("^"))
+      return makeNode(Op::POW, std::move(n), unary());
+
+    return n;
+  }
+
+  Program::NodePtr unary() {
+    if (accept("-"))
+      return makeNode(Op::NEG, unary());
+    if (accept("+"))
+      return unary();
+    if (accept("!"))
+      return makeNode(Op::NOT, unary());
+
+    return power();
+  }
+
+  Program::NodePtr multiplicative() {
+    auto n = unary();
+
+    while (true) {
+      if (accept("*"))
+        n = makeNode(Op::MUL, std::move(n), unary());
+      else if (accept("/"))
+        n = makeNode(Op::DIV, std::move(n), unary());
+      else if (accept("%"))
+        n = makeNode(Op::MOD, std::move(n), unary());
+      else
+        return n;
+    }
+  }
+
+  Program::NodePtr additive() {
+    auto n = multiplicative();
+
+    while (true) {
+      if (accept("+"))
+        n = makeNode(Op::ADD, std::move(n), multiplicative());
+      else if (accept("-"))
+        n = makeNode(Op::SUB, std::move(n), multiplicative());
+      else
+        return n;
+    }
+  }
+
+  Program::NodePtr relational() {
+    auto n = additive();
+
+    while (true) {
+      if (accept("<="))
+        n = makeNode(Op::LE, std::move(n), additive());
+      else if (accept(">="))
+        n = makeNode(Op::GE, std::move(n), additive());
+      else if (accept("<"))
+        n = makeNode(Op::LT, std::move(n), additive());
+      else if (accept(">"))
+        n = makeNode(Op::GT, std::move(n), additive());
+      else
+        return n;
+    }
+  }
+
+  Program::NodePtr equality() {
+    auto n = relational();
+
+    while (true) {
+      if (accept("=="))
+        n = makeNode(Op::EQ, std::move(n), relational());
+      else if (accept("!="))
+        n = makeNode(Op::NE, std::move(n), relational());
+      else
+        return n;
+    }
+  }
+
+  Program::NodePtr logicalAnd() {
+    auto n = equality();
+
+    while (accept("&&"))
+      n = makeNode(Op::AND, std::move(n), equality());
+
+    return n;
+  }
+
+  Program::NodePtr logicalOr() {
+    auto n = logicalAnd();
+
+    while (accept("||"))
+      n = makeNode(Op::OR, std::move(n), logicalAnd());
+
+    return n;
+  }
+
+  Program::NodePtr ternary() {
+    auto n = logicalOr();
+
+    if (accept("?")) {
+      auto a = ternary();
+      expect(":");
+      auto b = ternary();
+
+      return makeNode(Op::SELECT, std::move(n), std::move(a), std::move(b));
+    }
+
+    return n;
+  }
+
+public:
+  Parser(const std::string &s, const std::vector<std::string> &vars,
+         std::vector<bool> &u)
+      : str(s), variables(vars), used(u), pos(0) {}
+
+  Program::NodePtr parse() {
+    auto n = ternary();
+
+    skip();
+    if (pos != str.size())
+      error("Unexpected trailing characters");
+
+    return n;
+  }
+};
+
+Program::Program(const std::vector<std::string> &vars)
+    : variables(vars), used(vars.size(), false), registers(vars.size()) {}
+
+unsigned Program::compile(const std::string &expr) {
+  auto root = Parser(expr, variables, used).parse();
+
+  outputs.push_back(emit(root.get()));
+
+  return outputs.size() - 1;
+}
+
+unsigned Program::emit(const Node *node) {
+  if (node->op == Op::VAR)
+    return node->variable;
+
+  if (node->op == Op::CONST) {
+    uint64_t bits;
+    memcpy(&bits, &node->value, sizeof(bits));
+
+    auto it = constantRegisters.find(bits);
+    if (it != constantRegisters.end())
+      return it->second;
+
+    unsigned reg = registers++;
+
+    constants.emplace_back(reg, node->value);
+    constantRegisters[bits] = reg;
+
+    return reg;
+  }
+
+  unsigned regs[3];
+  for (unsigned i = 0; i < 3; i++)
+    regs[i] = i < node->args.size() ? emit(node->args[i].get()) : regs[0];
+
+  // Re-use the result of an identical sub-expression
+  auto key = std::make_tuple(node->op, regs[0], regs[1], regs[2]);
+  auto it = instructionRegisters.find(key);
+  if (it != instructionRegisters.end())
+    return it->second;
+
+  unsigned dst = registers++;
+
+  tape.push_back({node->op, dst, regs[0], regs[1], regs[2]});
+  instructionRegisters[key] = dst;
+
+  return dst;
+}
+
+void Program::init(double *regs, size_t lanes) const {
+  for (unsigned i = 0; i < registers * lanes; i++)
+    regs[i] = 0;
+
+  for (auto &c : constants) {
+    for (size_t l = 0; l < lanes; l++)
+      regs[c.first * lanes + l] = c.second;
+  }
+}
+
+template <Op op>
+static void evaluateLanes(double *d, const double *a, const double *b,
+                          const double *c, size_t lanes) {
+#pragma omp simd
+  for (size_t l = 0; l < lanes; l++)
+    d[l] = apply(op, a[l], b[l], c[l]);
+}
+
+void Program::evaluate(double *regs, size_t lanes) const {
+  for (auto &ins : tape) {
+    double *d = regs + ins.dst * lanes;
+    const double *a = regs + ins.a * lanes;
+    const double *b = regs + ins.b * lanes;
+    const double *c = regs + ins.c * lanes;
+
+    // Dispatch once per instruction, not per lane
+    switch (ins.op) {
+#define CASE(o)                                                                \
+  case Op::o:                                                                  \
+    evaluateLanes<Op::o>(d, a, b, c, lanes);                                   \
+    break;
+
+      CASE(ADD)
+      CASE(SUB)
+      CASE(MUL)
+      CASE(DIV)
+      CASE(MOD)
+      CASE(POW)
+      CASE(NEG)
+      CASE(LT)
+      CASE(LE)
+      CASE(GT)
+      CASE(GE)
+      CASE(EQ)
+      CASE(NE)
+      CASE(AND)
+      CASE(OR)
+      CASE(NOT)
+      CASE(SELECT)
+      CASE(ABS)
+      CASE(SQRT)
+      CASE(EXP)
+      CASE(LOG)
+      CASE(LOG10)
+      CASE(SIN)
+      CASE(COS)
+      CASE(TAN)
+      CASE(ASIN)
+      CASE(ACOS)
+      CASE(ATAN)
+      CASE(ATAN2)
+      CASE(HYPOT)
+      CASE(FLOOR)
+      CASE(CEIL)
+      CASE(ROUND)
+      CASE(MIN)
+      CASE(MAX)
+
+#undef CASE
+
+    case Op::CONST:
+    case Op::VAR:
+      break;
+    }
+  }
+}
+
+} // namespace expr
+
+ExprHook::ExprHook(Path *p, Node *n, int fl, int prio, bool en)
+    : Hook(p, n, fl, prio, en),
+      signalsExpressions(std::make_shared<SignalList>()), truncated(0) {}
+
+void ExprHook::parse(json_t *json) {
+  int ret;
+  size_t i;
+  json_error_t err;
+  json_t *json_signals;
+  json_t *json_signal;
+
+  assert(state != State::STARTED);
+
+  Hook::parse(json);
+
+  ret = json_unpack_ex(json, &err, 0, "{ s: o }", "signals", &json_signals);
+  if (ret)
+    throw ConfigError(json, err, "node-config-hook-expr");
+
+  signalsExpressions->clear();
+  ret = signalsExpressions->parse(json_signals);
+  if (ret)
+    throw ConfigError(json_signals, "node-config-hook-expr-signals",
+                      "Setting 'signals' must be a list of dicts");
+
+  expressions.clear();
+  jsonExpressions.clear();
+
+  json_array_foreach(json_signals, i, json_signal) {
+    const char *expr;
+
+    ret = json_unpack_ex(json_signal, &err, 0, "{ s: s }", "expression",
+                         &expr);
+    if (ret)
+      throw ConfigError(json_signal, err, "node-config-hook-expr-signals");
+
+    expressions.push_back(expr);
+    jsonExpressions.push_back(json_signal);
+  }
+
+  state = State::PARSED;
+}
+
+void ExprHook::prepare() {
+  std::vector<std::string> vars;
+
+  // Signals of the input samples, followed by the special variables
+  for (auto sig : *signals)
+    vars.push_back(sig->name);
+
+  vars.push_back("sequence");
+  vars.push_back("ts_origin");
+  vars.push_back("ts_received");
+
+  program = expr::Program(vars);
+
+  for (unsigned i = 0; i < expressions.size(); i++) {
+    try {
+      program.compile(expressions[i]);
+    } catch (RuntimeError &e) {
+      throw ConfigError(jsonExpressions[i], "node-config-hook-expr-signals",
+                        "Failed to compile expression: {}", e.what());
+    }
+  }
+
+  // Only load the variables which are referenced by the expressions
+  inputs.clear();
+  for (unsigned i = 0; i < vars.size(); i++) {
+    if (!program.isUsed(i))
+      continue;
+
+    if (i < signals->size())
+      inputs.push_back(
+          {i, ExprHook::Source::SIGNAL, i, signals->getByIndex(i)->type});
+    else
+      inputs.push_back({i, (ExprHook::Source)(i - signals->size() + 1), 0,
+                        SignalType::FLOAT});
+  }
+
+  if (program.getOutputCount() != signalsExpressions->size())
+    throw RuntimeError("Expressions produce {} outputs for {} signals",
+                       program.getOutputCount(), signalsExpressions->size());
+
+  registers.resize(program.getRegisterCount());
+  program.init(registers.data());
+
+  logger->debug("Compiled {} expressions into {} instructions on {} registers",
+                expressions.size(), program.getTape().size(),
+                program.getRegisterCount());
+
+  signals = signalsExpressions;
+}
+
+Hook::Reason ExprHook::process(struct Sample *smp) {
+  assert(state == State::STARTED);
+
+  double *regs = registers.data();
+
+  for (auto &in : inputs) {
+    switch (in.source) {
+    case Source::SIGNAL:
+      regs[in.reg] =
+          in.index < smp->length
+              ? smp->data[in.index].cast(in.type, SignalType::FLOAT).f
+              : std::numeric_limits<double>::quiet_NaN();
+      break;
+
+    case Source::SEQUENCE:
+      regs[in.reg] = smp->sequence;
+      break;
+
+    case Source::TS_ORIGIN:
+      regs[in.reg] = time_to_double(&smp->ts.origin);
+      break;
+
+    case Source::TS_RECEIVED:
+      regs[in.reg] = time_to_double(&smp->ts.received);
+      break;
+    }
+  }
+
+  program.evaluate(regs);
+
+  // Samples allocated for fewer signals can not hold all outputs
+  unsigned outputs = program.getOutputCount();
+  if (outputs > smp->capacity) {
+    if (truncated++ % 1000 == 0)
+      logger->warn("Truncating {} outputs to sample capacity {} "
+                   "(truncated={})",
+                   outputs, smp->capacity, truncated);
+
+    outputs = smp->capacity;
+  }
+
+  for (unsigned i = 0; i < outputs; i++) {
+    auto sig = signalsExpressions->getByIndex(i);
+
+    union SignalData d;
+    d.f = regs[program.getOutput(i)];
+
+    smp->data[i] = d.cast(SignalType::FLOAT, sig->type);
+  }
+
+  smp->length = outputs;
+
+  return Reason::OK;
+}
+
+// Register hook
+static char n[] = "expr";
+static char d[] = "Calculate signals from arithmetic and boolean expressions";
+static HookPlugin<ExprHook, n, d,
+                  (int)Hook::Flags::NODE_READ | (int)Hook::Flags::NODE_WRITE |
+                      (int)Hook::Flags::PATH,
+                  1>
+    p;
+
+} // namespace node
+} // namespace villas
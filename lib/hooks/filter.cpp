@@ -0,0 +1,322 @@
+/* Filter hook.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <villas/dsp/filter.hpp>
+#include <villas/exceptions.hpp>
+#include <villas/hook.hpp>
+#include <villas/sample.hpp>
+#include <villas/signal_list.hpp>
+
+namespace villas {
+namespace node {
+
+/* Applies FIR and IIR filters to signals.
+ *
+ * All signals which share a filter design are filtered together. Their state
+ * is kept as structure of arrays, so each filter section processes all of its
+ * signals in a single vectorizable loop. */
+class FilterHook : public Hook {
+
+protected:
+  struct Bank {
+    json_t *json;
+
+    std::vector<std::string> signalNames;
+    std::vector<unsigned> signalIndices;
+    std::vector<enum SignalType> signalTypes;
+
+    std::unique_ptr<dsp::Filter> filter;
+    std::vector<double> buffer;
+  };
+
+  double rate;
+
+  std::vector<Bank> banks;
+
+  unsigned minLength; // Samples must contain all filtered signals.
+  unsigned skipped;   // Number of samples passed through unfiltered.
+
+  // Normalize a frequency from the configuration to the sample rate
+  double normalize(json_t *json, double f) {
+    double n = f / rate;
+
+    if (n <= 0 || n >= 0.5)
+      throw ConfigError(json, "node-config-hook-filter-frequency",
+                        "Frequency {} Hz must be between 0 and the Nyquist "
+                        "frequency of {} Hz",
+                        f, rate / 2);
+
+    return n;
+  }
+
+  std::unique_ptr<dsp::Filter> makeFilter(json_t *json, size_t channels) {
+    int ret;
+    json_error_t err;
+    json_t *json_coefficients = nullptr;
+
+    const char *type_str;
+    const char *response_str = "lowpass";
+    int order = 2;
+    int taps = 31;
+    double cutoff = -1;
+    double frequency = -1;
+    double ripple = 1;
+    double q = 30;
+
+    ret = json_unpack_ex(
+        json, &err, 0,
+        "{ s: s, s?: s, s?: i, s?: i, s?: F, s?: F, s?: F, s?: F, s?: o }",
+        "type", &type_str, "response", &response_str, "order", &order, "taps",
+        &taps, "cutoff", &cutoff, "frequency", &frequency, "ripple", &ripple,
+        "q", &q, "coefficients", &json_coefficients);
+    if (ret)
+      throw ConfigError(json, err, "node-config-hook-filter-filters");
+
+    bool highpass;
+    if (!strcmp(response_str, "lowpass"))
+      highpass = false;
+    else if (!strcmp(response_str, "highpass"))
+      highpass = true;
+    else
+      throw ConfigError(json, "node-config-hook-filter-response",
+                        "Invalid response: {}", response_str);
+
+    try {
+      if (!strcmp(type_str, "notch")) {
+        if (frequency < 0)
+          throw ConfigError(json, "node-config-hook-filter-frequency",
+                            "Notch filters require the setting 'frequency'");
+
+        auto sos = dsp::design::notch(normalize(json, frequency), q);
+
+        return std::make_unique<dsp::BiquadCascade>(sos, channels);
+      }
+
+      if (!strcmp(type_str, "fir") && json_coefficients) {
+        size_t i;
+        json_t *json_coefficient;
+        std::vector<double> coeffs;
+
+        if (!json_is_array(json_coefficients))
+          throw ConfigError(json_coefficients,
+                            "node-config-hook-filter-coefficients",
+                            "Setting 'coefficients' must be a list of numbers");
+
+        json_array_foreach(json_coefficients, i, json_coefficient) {
+          if (!json_is_number(json_coefficient))
+            throw ConfigError(json_coefficient,
+                              "node-config-hook-filter-coefficients",
+                              "Setting 'coefficients' must be a list of "
+                              "numbers");
+
+          coeffs.push_back(json_number_value(json_coefficient));
+        }
+
+        return std::make_unique<dsp::FirFilter>(coeffs, channels);
+      }
+
+      if (cutoff < 0)
+        throw ConfigError(json, "node-config-hook-filter-cutoff",
+                          "Filters of type '{}' require the setting 'cutoff'",
+                          type_str);
+
+      double fc = normalize(json, cutoff);
+
+      if (!strcmp(type_str, "fir")) {
+        if (taps < 1)
+          throw ConfigError(json, "node-config-hook-filter-taps",
+                            "The number of taps must be positive");
+
+        auto coeffs = dsp::design::fir(taps, fc, highpass);
+
+        return std::make_unique<dsp::FirFilter>(coeffs, channels);
+      }
+
+      if (order < 1)
+        throw ConfigError(json, "node-config-hook-filter-order",
+                          "The filter order must be positive");
+
+      if (!strcmp(type_str, "butterworth")) {
+        auto sos = dsp::design::butterworth(order, fc, highpass);
+
+        return std::make_unique<dsp::BiquadCascade>(sos, channels);
+      }
+
+      if (!strcmp(type_str, "chebyshev")) {
+        auto sos = dsp::design::chebyshev1(order, ripple, fc, highpass);
+
+        return std::make_unique<dsp::BiquadCascade>(sos, channels);
+      }
+    } catch (RuntimeError &e) {
+      throw ConfigError(json, "node-config-hook-filter-filters",
+                        "Invalid filter design: {}", e.what());
+    }
+
+    throw ConfigError(json, "node-config-hook-filter-type",
+                      "Invalid filter type: {}", type_str);
+  }
+
+public:
+  FilterHook(Path *p, Node *n, int fl, int prio, bool en = true)
+      : Hook(p, n, fl, prio, en), rate(-1), minLength(0), skipped(0) {}
+
+  virtual void parse(json_t *json) {
+    int ret;
+    size_t i, j;
+    json_error_t err;
+    json_t *json_filters;
+    json_t *json_filter;
+    json_t *json_signals;
+    json_t *json_signal;
+
+    assert(state != State::STARTED);
+
+    Hook::parse(json);
+
+    ret = json_unpack_ex(json, &err, 0, "{ s: F, s: o }", "rate", &rate,
+                         "filters", &json_filters);
+    if (ret)
+      throw ConfigError(json, err, "node-config-hook-filter");
+
+    if (rate <= 0)
+      throw ConfigError(json, "node-config-hook-filter-rate",
+                        "Setting 'rate' must be positive");
+
+    if (!json_is_array(json_filters))
+      throw ConfigError(json_filters, "node-config-hook-filter-filters",
+                        "Setting 'filters' must be a list of filters");
+
+    banks.clear();
+
+    json_array_foreach(json_filters, i, json_filter) {
+      Bank bank;
+
+      json_signals = json_object_get(json_filter, "signals");
+      if (!json_signals)
+        json_signals = json_object_get(json_filter, "signal");
+
+      if (json_signals && json_is_array(json_signals)) {
+        json_array_foreach(json_signals, j, json_signal) {
+          if (!json_is_string(json_signal))
+            throw ConfigError(json_signal, "node-config-hook-filter-signals",
+                              "Invalid value for setting 'signals'");
+
+          bank.signalNames.push_back(json_string_value(json_signal));
+        }
+      } else if (json_signals && json_is_string(json_signals))
+        bank.signalNames.push_back(json_string_value(json_signals));
+      else
+        throw ConfigError(json_filter, "node-config-hook-filter-signals",
+                          "Missing 'signals' setting");
+
+      // Check the design early
+      makeFilter(json_filter, 0);
+
+      bank.json = json_filter;
+      banks.push_back(std::move(bank));
+    }
+
+    state = State::PARSED;
+  }
+
+  virtual void prepare() {
+    assert(state == State::CHECKED);
+
+    minLength = 0;
+
+    for (auto &bank : banks) {
+      bank.signalIndices.clear();
+      bank.signalTypes.clear();
+
+      for (auto &name : bank.signalNames) {
+        int index = signals->getIndexByName(name);
+        if (index < 0)
+          throw ConfigError(bank.json, "node-config-hook-filter-signals",
+                            "Failed to find signal {}", name);
+
+        bank.signalIndices.push_back(index);
+        bank.signalTypes.push_back(signals->getByIndex(index)->type);
+
+        minLength = std::max(minLength, (unsigned)index + 1);
+      }
+
+      bank.filter = makeFilter(bank.json, bank.signalIndices.size());
+      bank.buffer.resize(bank.signalIndices.size());
+    }
+
+    state = State::PREPARED;
+  }
+
+  virtual void start() {
+    assert(state == State::PREPARED || state == State::STOPPED);
+
+    for (auto &bank : banks)
+      bank.filter->reset();
+
+    state = State::STARTED;
+  }
+
+  virtual void restart() {
+    assert(state == State::STARTED);
+
+    for (auto &bank : banks)
+      bank.filter->reset();
+  }
+
+  virtual Hook::Reason process(struct Sample *smp) {
+    assert(state == State::STARTED);
+
+    // Short samples are passed through so the filter state stays intact
+    if (smp->length < minLength) {
+      if (skipped++ % 1000 == 0)
+        logger->warn("Passing through sample with {} of {} required signals "
+                     "unfiltered (skipped={})",
+                     smp->length, minLength, skipped);
+
+      return Reason::OK;
+    }
+
+    for (auto &bank : banks) {
+      double *x = bank.buffer.data();
+      size_t channels = bank.signalIndices.size();
+
+      for (size_t ch = 0; ch < channels; ch++) {
+        unsigned index = bank.signalIndices[ch];
+
+        x[ch] =
+            smp->data[index].cast(bank.signalTypes[ch], SignalType::FLOAT).f;
+      }
+
+      bank.filter->process(x);
+
+      for (size_t ch = 0; ch < channels; ch++) {
+        union SignalData d;
+        d.f = x[ch];
+
+        smp->data[bank.signalIndices[ch]] =
+            d.cast(SignalType::FLOAT, bank.signalTypes[ch]);
+      }
+    }
+
+    return Reason::OK;
+  }
+};
+
+// Register hook
+static char n[] = "filter";
+static char d[] = "Apply FIR and IIR filters to signals";
+static HookPlugin<FilterHook, n, d,
+                  (int)Hook::Flags::NODE_READ | (int)Hook::Flags::PATH>
+    p;
+
+} // namespace node
+} // namespace villas
@@ -6,6 +6,8 @@
  */
 
 #include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <map>
 #include <vector>
 
@@ -18,6 +20,7 @@ extern "C" {
 #include <villas/exceptions.hpp>
 #include <villas/hooks/lua.hpp>
 #include <villas/node.hpp>
+#include <villas/node/config.hpp>
 #include <villas/path.hpp>
 #include <villas/sample.hpp>
 #include <villas/signal.hpp>
@@ -410,8 +413,8 @@ void LuaSignalExpression::evaluate(union SignalData *data,
 LuaHook::LuaHook(Path *p, Node *n, int fl, int prio, bool en)
     : Hook(p, n, fl, prio, en),
       signalsExpressions(std::make_shared<SignalList>()), L(luaL_newstate()),
-      useNames(true), hasExpressions(false), needsLocking(false),
-      functions({0}) {}
+      mode(Mode::TABLE), useNames(true), hasExpressions(false),
+      needsLocking(false), functions({0}), ffi({LUA_NOREF, LUA_NOREF}) {}
 
 LuaHook::~LuaHook() { lua_close(L); }
 
@@ -436,6 +439,7 @@ void LuaHook::parseExpressions(json_t *json_sigs) {
 void LuaHook::parse(json_t *json) {
   int ret;
   const char *script_str = nullptr;
+  const char *mode_str = nullptr;
   int names = 1;
   json_error_t err;
   json_t *json_signals = nullptr;
@@ -444,14 +448,30 @@ void LuaHook::parse(json_t *json) {
 
   Hook::parse(json);
 
-  ret = json_unpack_ex(json, &err, 0, "{ s?: s, s?: o, s?: b }", "script",
-                       &script_str, "signals", &json_signals, "use_names",
-                       &names);
+  ret = json_unpack_ex(json, &err, 0, "{ s?: s, s?: o, s?: b, s?: s }",
+                       "script", &script_str, "signals", &json_signals,
+                       "use_names", &names, "mode", &mode_str);
   if (ret)
     throw ConfigError(json, err, "node-config-hook-lua");
 
   useNames = names;
 
+  if (mode_str) {
+    if (!strcmp(mode_str, "table"))
+      mode = Mode::TABLE;
+    else if (!strcmp(mode_str, "ffi")) {
+#ifdef WITH_LUAJIT
+      mode = Mode::FFI;
+#else
+      throw ConfigError(json, "node-config-hook-lua-mode",
+                        "Mode 'ffi' requires VILLASnode to be built with "
+                        "LuaJIT");
+#endif
+    } else
+      throw ConfigError(json, "node-config-hook-lua-mode",
+                        "Invalid mode: {}", mode_str);
+  }
+
   if (script_str)
     script = script_str;
 
@@ -536,6 +556,151 @@ void LuaHook::setupEnvironment() {
                &dispatch<&LuaHook::luaRegisterApiHandler>);
 }
 
+/* Compile the FFI variants of process() and the signal expressions.
+ *
+ * Both receive a pointer to the struct Sample as light userdata and cast it
+ * into a cdata view over the sample. This avoids the conversion from and to
+ * Lua tables. All signal expressions are compiled into a single chunk which
+ * evaluates them in one call and lets LuaJIT trace them as a whole. */
+void LuaHook::setupFfi() {
+  int ret;
+
+  // Determine the layout of struct Sample for the FFI declaration
+  alignas(struct Sample) char buf[sizeof(struct Sample)];
+  auto *smp = reinterpret_cast<struct Sample *>(buf);
+
+  size_t offsetFlagsEnd = (char *)&smp->flags - buf + sizeof(smp->flags);
+  size_t offsetTs = (char *)&smp->ts - buf;
+  size_t offsetTsEnd = offsetTs + sizeof(smp->ts);
+  size_t offsetData = (char *)smp->data - buf;
+
+  std::string chunk = fmt::format(R"(
+local process = ...
+local ffi = require("ffi")
+
+ffi.cdef[[
+typedef union {{
+  double f;
+  int64_t i;
+  bool b;
+  float z[2];
+}} villas_signal_data;
+
+typedef struct {{
+  int{}_t tv_sec;
+  long tv_nsec;
+}} villas_timespec;
+
+struct villas_sample {{
+  uint64_t sequence;
+  unsigned length;
+  unsigned capacity;
+  int flags;
+  char _reserved1[{}];
+  struct {{
+    villas_timespec origin;
+    villas_timespec received;
+  }} ts;
+  char _reserved2[{}];
+  villas_signal_data data[0];
+}};
+]]
+
+local cast = ffi.cast
+local sample_t = ffi.typeof("struct villas_sample *")
+
+local function tonum(v)
+  if v == true then return 1 elseif v == false then return 0 end
+  return v
+end
+
+local function tobool(v)
+  if type(v) == "number" then return v ~= 0 end
+  return v
+end
+
+local process_ffi = process and function(ptr)
+  return process(cast(sample_t, ptr))
+end
+)",
+                                  8 * sizeof(time_t),
+                                  offsetTs - offsetFlagsEnd,
+                                  offsetData - offsetTsEnd);
+
+  if (hasExpressions) {
+    chunk += "\nlocal function expressions_ffi(ptr)\n"
+             "  local smp = cast(sample_t, ptr)\n";
+
+    // Evaluate all expressions before we overwrite the sample data
+    for (unsigned i = 0; i < expressions.size(); i++)
+      chunk += fmt::format("  local v{} = ({})\n", i,
+                           expressions[i].getExpression());
+
+    chunk += "  local data = smp.data\n";
+
+    for (unsigned i = 0; i < expressions.size(); i++) {
+      auto sig = signalsExpressions->getByIndex(i);
+      if (!sig)
+        continue;
+
+      std::string assign;
+      switch (sig->type) {
+      case SignalType::BOOLEAN:
+        assign = fmt::format("data[{0}].b = tobool(v{0})", i);
+        break;
+
+      case SignalType::INTEGER:
+        assign = fmt::format("data[{0}].i = tonum(v{0})", i);
+        break;
+
+      case SignalType::COMPLEX:
+        assign = fmt::format("data[{0}].z[0] = tonum(v{0}); "
+                             "data[{0}].z[1] = 0",
+                             i);
+        break;
+
+      case SignalType::FLOAT:
+      default:
+        assign = fmt::format("data[{0}].f = tonum(v{0})", i);
+        break;
+      }
+
+      chunk += fmt::format("  if v{} ~= nil then {} end\n", i, assign);
+    }
+
+    chunk += "end\n";
+  } else
+    chunk += "\nlocal expressions_ffi = nil\n";
+
+  chunk += "\nreturn process_ffi, expressions_ffi\n";
+
+  ret = luaL_loadbuffer(L, chunk.c_str(), chunk.size(), "ffi");
+  if (ret)
+    throw LuaError(L, ret);
+
+  if (functions.process)
+    lua_pushvalue(L, functions.process);
+  else
+    lua_pushnil(L);
+
+  ret = lua_pcall(L, 1, 2, 0);
+  if (ret)
+    throw LuaError(L, ret);
+
+  ffi.expressions = luaL_ref(L, LUA_REGISTRYINDEX);
+  ffi.process = luaL_ref(L, LUA_REGISTRYINDEX);
+
+  // Map signal names to indices of the sample data
+  lua_createtable(L, 0, signals->size());
+  for (unsigned i = 0; i < signals->size(); i++) {
+    auto sig = signals->getByIndex(i);
+
+    lua_pushinteger(L, i);
+    lua_setfield(L, -2, sig->name.c_str());
+  }
+  lua_setglobal(L, "signals");
+}
+
 void LuaHook::prepare() {
   // Load Lua standard libraries
   luaL_openlibs(L);
@@ -564,9 +729,13 @@ void LuaHook::prepare() {
   if (hasExpressions) {
     for (auto &expr : expressions)
       expr.prepare();
+  }
 
+  if (mode == Mode::FFI)
+    setupFfi();
+
+  if (hasExpressions)
     signals = signalsExpressions;
-  }
 
   if (!functions.process && !hasExpressions)
     logger->warn(
@@ -663,10 +832,16 @@ Hook::Reason LuaHook::process(struct Sample *smp) {
   if (functions.process) {
     logger->debug("Executing Lua function: process(smp)");
 
-    lua_pushsample(L, smp, useNames);
+    if (mode == Mode::FFI) {
+      lua_rawgeti(L, LUA_REGISTRYINDEX, ffi.process);
+      lua_pushlightuserdata(L, smp);
+    } else {
+      lua_pushsample(L, smp, useNames);
+
+      lua_pushvalue(L, functions.process);
+      lua_pushvalue(L, -2); // Push a copy since lua_pcall() will pop it
+    }
 
-    lua_pushvalue(L, functions.process);
-    lua_pushvalue(L, -2); // Push a copy since lua_pcall() will pop it
     int ret = lua_pcall(L, 1, 1, 0);
     if (ret)
       throw LuaError(L, ret);
@@ -682,21 +857,32 @@ Hook::Reason LuaHook::process(struct Sample *smp) {
 
     lua_pop(L, 1);
 
-    lua_tosample(L, smp, signalsProcessed, useNames);
+    // In FFI mode, process() modified the sample in-place
+    if (mode == Mode::TABLE)
+      lua_tosample(L, smp, signalsProcessed, useNames);
   } else
     reason = Reason::OK;
 
   // After that evaluate expressions
   if (hasExpressions) {
-    lua_pushsample(L, smp, useNames);
-    lua_setglobal(L, "smp");
+    if (mode == Mode::FFI) {
+      lua_rawgeti(L, LUA_REGISTRYINDEX, ffi.expressions);
+      lua_pushlightuserdata(L, smp);
 
-    for (unsigned i = 0; i < expressions.size(); i++) {
-      auto sig = signalsExpressions->getByIndex(i);
-      if (!sig)
-        continue;
+      int ret = lua_pcall(L, 1, 0, 0);
+      if (ret)
+        throw LuaError(L, ret);
+    } else {
+      lua_pushsample(L, smp, useNames);
+      lua_setglobal(L, "smp");
+
+      for (unsigned i = 0; i < expressions.size(); i++) {
+        auto sig = signalsExpressions->getByIndex(i);
+        if (!sig)
+          continue;
 
-      expressions[i].evaluate(&smp->data[i], sig->type);
+        expressions[i].evaluate(&smp->data[i], sig->type);
+      }
     }
 
     smp->length = expressions.size();
@@ -5,6 +5,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <villas/dsp/window_stats.hpp>
 #include <villas/hook.hpp>
 #include <villas/sample.hpp>
 
@@ -14,16 +15,15 @@ namespace node {
 class MovingAverageHook : public MultiSignalHook {
 
 protected:
-  std::vector<std::vector<double>> smpMemory;
+  dsp::WindowStats stats; // Sums of all signals
 
-  double accumulator;
+  std::vector<double> values;
   unsigned windowSize;
-  uint64_t smpMemoryPosition;
 
 public:
   MovingAverageHook(Path *p, Node *n, int fl, int prio, bool en = true)
-      : MultiSignalHook(p, n, fl, prio, en), smpMemory(), accumulator(0.0),
-        windowSize(10), smpMemoryPosition(0) {}
+      : MultiSignalHook(p, n, fl, prio, en), stats(), values(),
+        windowSize(10) {}
 
   virtual void prepare() {
     MultiSignalHook::prepare();
@@ -38,10 +38,13 @@ public:
             "The ma hook can only operate on signals of type float!");
     }
 
+    if (windowSize < 1)
+      throw RuntimeError("Window size must be greater 0 but is set to {}",
+                         windowSize);
+
     // Initialize sample memory
-    smpMemory.clear();
-    for (unsigned i = 0; i < signalIndices.size(); i++)
-      smpMemory.emplace_back(windowSize, 0.0);
+    stats = dsp::WindowStats(windowSize, signalIndices.size());
+    values.resize(signalIndices.size());
 
     state = State::PREPARED;
   }
@@ -66,25 +69,15 @@ public:
     assert(state == State::STARTED);
 
     unsigned i = 0;
-    for (auto index : signalIndices) {
-      // The new value
-      double newValue = smp->data[index].f;
-
-      // Append the new value to the history memory
-      smpMemory[i][smpMemoryPosition % windowSize] = newValue;
+    for (auto index : signalIndices)
+      values[i++] = smp->data[index].f;
 
-      // Get the old value from the history
-      double oldValue = smpMemory[i][(smpMemoryPosition + 1) % windowSize];
-
-      // Update the accumulator
-      accumulator += newValue;
-      accumulator -= oldValue;
-
-      smp->data[index].f = accumulator / windowSize;
-      i++;
-    }
+    // Update the sums of all signals in a single pass
+    stats.update(values.data());
 
-    smpMemoryPosition++;
+    i = 0;
+    for (auto index : signalIndices)
+      smp->data[index].f = stats.mean(i++);
 
     return Reason::OK;
   }
@@ -18,7 +18,7 @@ PmuHook::PmuHook(Path *p, Node *n, int fl, int prio, bool en)
       windowSize(1), channelNameEnable(true), angleUnitFactor(1.0),
       lastSequence(0), nextRun({0}), init(false), initSampleCount(0),
       phaseOffset(0.0), amplitudeOffset(0.0), frequencyOffset(0.0),
-      rocofOffset(0.0) {}
+      rocofOffset(0.0), threads(1), estimationTime() {}
 
 void PmuHook::prepare() {
   MultiSignalHook::prepare();
@@ -84,6 +84,8 @@ void PmuHook::parse(json_t *json) {
   const char *angleUnitC = nullptr;
   const char *timeAlignC = nullptr;
 
+  int threads_int = threads;
+
   json_error_t err;
 
   assert(state != State::STARTED);
@@ -93,13 +95,13 @@ void PmuHook::parse(json_t *json) {
   ret = json_unpack_ex(
       json, &err, 0,
       "{ s?: i, s?: F, s?: F, s?: F, s?: s, s?: s, s?: b, s?: s, s?: F, s?: F, "
-      "s?: F, s?: F}",
+      "s?: F, s?: F, s?: i }",
       "sample_rate", &sampleRate, "dft_rate", &phasorRate, "nominal_freq",
       &nominalFreq, "number_plc", &numberPlc, "window_type", &windowTypeC,
       "angle_unit", &angleUnitC, "add_channel_name", &channelNameEnable,
       "timestamp_align", &timeAlignC, "phase_offset", &phaseOffset,
       "amplitude_offset", &amplitudeOffset, "frequency_offset",
-      &frequencyOffset, "rocof_offset", &rocofOffset);
+      &frequencyOffset, "rocof_offset", &rocofOffset, "threads", &threads_int);
 
   if (ret)
     throw ConfigError(json, err, "node-config-hook-pmu");
@@ -125,6 +127,20 @@ void PmuHook::parse(json_t *json) {
         "Number of power line cycles cannot be less than 0 tried to set {}",
         numberPlc);
 
+  if (threads_int < 1)
+    throw ConfigError(json, "node-config-hook-pmu-threads",
+                      "Number of threads must be at least 1");
+
+  threads = threads_int;
+
+#ifndef _OPENMP
+  if (threads > 1) {
+    logger->warn("Built without OpenMP support. Estimating phasors "
+                 "sequentially");
+    threads = 1;
+  }
+#endif
+
   if (!windowTypeC)
     logger->info("No Window type given, assume no windowing");
   else if (strcmp(windowTypeC, "flattop") == 0)
@@ -164,6 +180,17 @@ void PmuHook::parse(json_t *json) {
                       "Timestamp alignment {} not recognized", timeAlignC);
 }
 
+void PmuHook::stop() {
+  Hook::stop();
+
+  if (estimationTime.getTotal() > 0)
+    logger->info("Phasor estimation of {} channels with {} threads took {:g} "
+                 "us on average and {:g} us at most",
+                 signalIndices.size(), threads,
+                 estimationTime.getMean() * 1e6,
+                 estimationTime.getHighest() * 1e6);
+}
+
 Hook::Reason PmuHook::process(struct Sample *smp) {
   assert(state == State::STARTED);
 
@@ -186,12 +213,22 @@ Hook::Reason PmuHook::process(struct Sample *smp) {
   Status phasorStatus = Status::VALID;
   timespec phasorTimestamp = {0};
   if (run) {
-    for (unsigned i = 0; i < signalIndices.size(); i++) {
-      lastPhasors[i] = estimatePhasor(windows[i], lastPhasors[i]);
+    auto start = time_now();
+    unsigned channels = signalIndices.size();
+
+#pragma omp parallel for num_threads(std::min(threads, channels))              \
+    schedule(static) if (threads > 1 && channels > 1)
+    for (unsigned i = 0; i < channels; i++)
+      lastPhasors[i] = estimatePhasor(i, windows[i], lastPhasors[i]);
+
+    for (unsigned i = 0; i < channels; i++) {
       if (lastPhasors[i].valid != Status::VALID)
         phasorStatus = Status::INVALID;
     }
 
+    auto end = time_now();
+    estimationTime.put(time_delta(&start, &end));
+
     // Align time tag
     double currentTimeTag = time_to_double(&smp->ts.origin);
     double alignedTime = currentTimeTag - fmod(currentTimeTag, 1 / phasorRate);
@@ -199,7 +236,7 @@ Hook::Reason PmuHook::process(struct Sample *smp) {
 
     size_t tsPos = 0;
     if (timeAlignType == TimeAlign::RIGHT)
-      tsPos = windowSize;
+      tsPos = windowSize - 1;
     else if (timeAlignType == TimeAlign::LEFT)
       tsPos = 0;
     else if (timeAlignType == TimeAlign::CENTER)
@@ -236,7 +273,8 @@ Hook::Reason PmuHook::process(struct Sample *smp) {
   return Reason::OK;
 }
 
-PmuHook::Phasor PmuHook::estimatePhasor(dsp::CosineWindow<double> *window,
+PmuHook::Phasor PmuHook::estimatePhasor(unsigned channel,
+                                        dsp::CosineWindow<double> *window,
                                         Phasor lastPhasor) {
   return {0., 0., 0., 0., Status::INVALID};
 }
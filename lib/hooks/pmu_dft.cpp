@@ -10,6 +10,7 @@
 #include <vector>
 #include <villas/timing.hpp>
 
+#include <villas/dsp/spectrum.hpp>
 #include <villas/dumper.hpp>
 #include <villas/hook.hpp>
 #include <villas/sample.hpp>
@@ -29,6 +30,11 @@ protected:
 
   enum class EstimationType { NONE, QUADRATIC, IpDFT };
 
+  enum class DftMethod {
+    FULL,   // Calculate the DFT of the full window on each output
+    SLIDING // Recursively update each bin with each new sample
+  };
+
   enum class TimeAlign {
     LEFT,
     CENTER,
@@ -57,15 +63,29 @@ protected:
   enum PaddingType paddingType;
   enum EstimationType estType;
   enum TimeAlign timeAlignType;
+  enum DftMethod dftMethod;
 
   std::vector<std::vector<double>> smpMemoryData;
   std::vector<timespec> smpMemoryTs;
 #ifdef DFT_MEM_DUMP
   std::vector<double> ppsMemory;
 #endif
-  std::vector<std::vector<std::complex<double>>> matrix;
+  std::vector<dsp::Spectrum> spectra;
+  std::vector<std::vector<double>> windowedData;
   std::vector<std::vector<std::complex<double>>> results;
   std::vector<double> filterWindowCoefficents;
+  std::vector<double>
+      windowCosineCoefficents; // Window as sum of cosines: c_0 + c_1 cos(x) + ...
+
+  /* State of the sliding DFT.
+   *
+   * The bins are extended by (windowCosineCoefficents.size() - 1) * windowMultiplier
+   * on each side so that the window can be applied as a convolution in the
+   * frequency domain. */
+  std::vector<std::vector<std::complex<double>>> slidingBins;
+  std::vector<std::complex<double>> slidingRotate; // omega^-k
+  std::vector<std::complex<double>> slidingInsert; // omega^(k * windowSize)
+  unsigned slidingMargin; // Number of additional bins on each side
   std::vector<std::vector<double>> absResults;
   std::vector<double> absFrequencies;
 
@@ -116,11 +136,14 @@ public:
   PmuDftHook(Path *p, Node *n, int fl, int prio, bool en = true)
       : MultiSignalHook(p, n, fl, prio, en), windowType(WindowType::NONE),
         paddingType(PaddingType::ZERO), estType(EstimationType::NONE),
-        timeAlignType(TimeAlign::CENTER), smpMemoryData(), smpMemoryTs(),
+        timeAlignType(TimeAlign::CENTER), dftMethod(DftMethod::FULL),
+        smpMemoryData(), smpMemoryTs(),
 #ifdef DFT_MEM_DUMP
         ppsMemory(),
 #endif
-        matrix(), results(), filterWindowCoefficents(), absResults(),
+        spectra(), windowedData(), results(), filterWindowCoefficents(),
+        windowCosineCoefficents(), slidingBins(), slidingRotate(),
+        slidingInsert(), slidingMargin(0), absResults(),
         absFrequencies(), calcCount(0), sampleRate(0), startFrequency(0),
         endFreqency(0), frequencyResolution(0), rate(0), ppsIndex(0),
         windowSize(0), windowMultiplier(0), freqCount(0), channelNameEnable(1),
@@ -209,11 +232,6 @@ public:
 
     freqCount = ceil((endFreqency - startFrequency) / frequencyResolution) + 1;
 
-    // Initialize matrix of dft coeffients
-    matrix.clear();
-    for (unsigned i = 0; i < freqCount; i++)
-      matrix.emplace_back(windowSize * windowMultiplier, 0.0);
-
     // Initalize dft results matrix
     results.clear();
     for (unsigned i = 0; i < signalIndices.size(); i++) {
@@ -226,9 +244,13 @@ public:
     for (unsigned i = 0; i < freqCount; i++)
       absFrequencies.emplace_back(startFrequency + i * frequencyResolution);
 
-    generateDftMatrix();
     calculateWindow(windowType);
 
+    if (dftMethod == DftMethod::FULL)
+      generateSpectra();
+    else
+      generateSlidingDft();
+
     state = State::PREPARED;
   }
 
@@ -242,6 +264,7 @@ public:
     const char *estimateTypeC = nullptr;
     const char *angleUnitC = nullptr;
     const char *timeAlignC = nullptr;
+    const char *dftMethodC = nullptr;
 
     json_error_t err;
 
@@ -252,7 +275,7 @@ public:
     ret = json_unpack_ex(
         json, &err, 0,
         "{ s?: i, s?: F, s?: F, s?: F, s?: i, s?: i, s?: s, s?: s, s?: s, s?: "
-        "i, s?: s, s?: b, s?: s, s?: F, s?: F, s?: F, s?: F}",
+        "i, s?: s, s?: b, s?: s, s?: F, s?: F, s?: F, s?: F, s?: s }",
         "sample_rate", &sampleRate, "start_freqency", &startFrequency,
         "end_freqency", &endFreqency, "frequency_resolution",
         &frequencyResolution, "dft_rate", &rate, "window_size_factor",
@@ -261,7 +284,8 @@ public:
         "angle_unit", &angleUnitC, "add_channel_name", &channelNameEnable,
         "timestamp_align", &timeAlignC, "phase_offset", &phaseOffset,
         "amplitude_offset", &amplitudeOffset, "frequency_offset",
-        &frequencyOffset, "rocof_offset", &rocofOffset);
+        &frequencyOffset, "rocof_offset", &rocofOffset, "dft_method",
+        &dftMethodC);
     if (ret)
       throw ConfigError(json, err, "node-config-hook-dft");
 
@@ -294,6 +318,14 @@ public:
       throw ConfigError(json, "node-config-hook-dft-timestamp-alignment",
                         "Timestamp alignment {} not recognized", timeAlignC);
 
+    if (!dftMethodC || strcmp(dftMethodC, "full") == 0)
+      dftMethod = DftMethod::FULL;
+    else if (strcmp(dftMethodC, "sliding") == 0)
+      dftMethod = DftMethod::SLIDING;
+    else
+      throw ConfigError(json, "node-config-hook-dft-method",
+                        "DFT method {} not recognized", dftMethodC);
+
     if (!angleUnitC)
       logger->info("No angle type given, assume rad");
     else if (strcmp(angleUnitC, "rad") == 0)
@@ -345,10 +377,25 @@ public:
 
     // Update sample memory
     unsigned i = 0;
+    unsigned pos = smpMemPos % windowSize;
     for (auto index : signalIndices) {
-      smpMemoryData[i++][smpMemPos % windowSize] = smp->data[index].f;
+      double oldValue = smpMemoryData[i][pos];
+      double newValue = smp->data[index].f;
+
+      smpMemoryData[i][pos] = newValue;
+
+      if (dftMethod == DftMethod::SLIDING)
+        updateSlidingDft(slidingBins[i], oldValue, newValue);
+
+      i++;
+    }
+    smpMemoryTs[pos] = smp->ts.origin;
+
+    // Periodically recalculate the sliding DFT to avoid accumulating errors
+    if (dftMethod == DftMethod::SLIDING && pos == windowSize - 1) {
+      for (unsigned i = 0; i < signalIndices.size(); i++)
+        anchorSlidingDft(smpMemoryData[i], slidingBins[i], pos);
     }
-    smpMemoryTs[smpMemPos % windowSize] = smp->ts.origin;
 
 #ifdef DFT_MEM_DUMP
     ppsMemory[smpMemPos % windowSize] = smp->data[ppsIndex].f;
@@ -381,8 +428,11 @@ public:
       for (unsigned i = 0; i < signalIndices.size(); i++) {
         Phasor currentResult = {0, 0, 0, 0};
 
-        calculateDft(PaddingType::ZERO, smpMemoryData[i], results[i],
-                     smpMemPos);
+        if (dftMethod == DftMethod::SLIDING)
+          calculateSlidingDftResults(slidingBins[i], results[i]);
+        else
+          calculateDft(PaddingType::ZERO, smpMemoryData[i], results[i],
+                       smpMemPos, spectra[i], windowedData[i]);
 
         unsigned maxPos = 0;
         double absAmplitude = 0;
@@ -493,17 +543,96 @@ public:
   }
 
   /*
-   * This function generates the furie coeffients for the calculateDft function
+   * This function prepares the twiddle factors for the calculateDft function
+   *
+   * Each signal gets its own spectrum as they are calculated in parallel.
+   */
+  void generateSpectra() {
+    spectra.clear();
+    windowedData.clear();
+
+    for (unsigned i = 0; i < signalIndices.size(); i++) {
+      spectra.emplace_back(windowSize * windowMultiplier);
+      windowedData.emplace_back(windowSize * windowMultiplier, 0.0);
+    }
+  }
+
+  /*
+   * This function prepares the twiddle factors and state of the sliding DFT
+   *
+   * The sliding DFT keeps S_k = sum_{j=1}^{N} x[n-N+j] * omega^(k*j) for each
+   * bin k. This matches the sample order used by calculateDft(), which puts the
+   * newest sample at position 0 (equivalent to position N for a periodic window).
    */
-  void generateDftMatrix() {
+  void generateSlidingDft() {
     using namespace std::complex_literals;
 
     omega = exp((-2i * M_PI) / (double)(windowSize * windowMultiplier));
-    unsigned startBin = floor(startFrequency / frequencyResolution);
+    int startBin = floor(startFrequency / frequencyResolution);
+
+    slidingMargin = (windowCosineCoefficents.size() - 1) * windowMultiplier;
+
+    unsigned binCount = freqCount + 2 * slidingMargin;
+
+    slidingRotate.resize(binCount);
+    slidingInsert.resize(binCount);
+
+    for (unsigned e = 0; e < binCount; e++) {
+      int k = startBin + (int)e - (int)slidingMargin;
+
+      slidingRotate[e] = pow(omega, -k);
+      slidingInsert[e] = pow(omega, k * (double)windowSize);
+    }
+
+    slidingBins.clear();
+    for (unsigned i = 0; i < signalIndices.size(); i++)
+      slidingBins.emplace_back(binCount, 0.0);
+  }
 
+  /*
+   * This function updates all bins of the sliding DFT with a new sample in O(1) per bin
+   */
+  void updateSlidingDft(std::vector<std::complex<double>> &bins,
+                        double oldValue, double newValue) {
+    for (unsigned e = 0; e < bins.size(); e++)
+      bins[e] =
+          slidingRotate[e] * bins[e] - oldValue + newValue * slidingInsert[e];
+  }
+
+  /*
+   * This function recalculates the sliding DFT bins from the sample memory
+   */
+  void anchorSlidingDft(std::vector<double> &ringBuffer,
+                        std::vector<std::complex<double>> &bins,
+                        unsigned ringBufferPos) {
+    for (unsigned e = 0; e < bins.size(); e++) {
+      std::complex<double> w = 1. / slidingRotate[e], wj = w;
+
+      bins[e] = 0;
+      for (unsigned j = 1; j <= windowSize; j++, wj *= w)
+        bins[e] += ringBuffer[(ringBufferPos + j) % windowSize] * wj;
+    }
+  }
+
+  /*
+   * This function applies the window to the sliding DFT bins
+   *
+   * Multiplying with c_l * cos(2 * pi * l * j / N) in the time domain corresponds to
+   * averaging the bins which are l * windowMultiplier apart in the frequency domain.
+   */
+  void calculateSlidingDftResults(std::vector<std::complex<double>> &bins,
+                                  std::vector<std::complex<double>> &results) {
     for (unsigned i = 0; i < freqCount; i++) {
-      for (unsigned j = 0; j < windowSize * windowMultiplier; j++)
-        matrix[i][j] = pow(omega, (i + startBin) * j);
+      unsigned e = i + slidingMargin;
+
+      results[i] = windowCosineCoefficents[0] * bins[e];
+
+      for (unsigned l = 1; l < windowCosineCoefficents.size(); l++) {
+        unsigned d = l * windowMultiplier;
+
+        results[i] +=
+            0.5 * windowCosineCoefficents[l] * (bins[e - d] + bins[e + d]);
+      }
     }
   }
 
@@ -512,33 +641,31 @@ public:
    */
   void calculateDft(enum PaddingType padding, std::vector<double> &ringBuffer,
                     std::vector<std::complex<double>> &results,
-                    unsigned ringBufferPos) {
+                    unsigned ringBufferPos, dsp::Spectrum &spectrum,
+                    std::vector<double> &tmpSmpWindow) {
     /* RingBuffer size needs to be equal to windowSize
      * prepare sample window The following parts can be combined */
-    double tmpSmpWindow[windowSize];
-
     for (unsigned i = 0; i < windowSize; i++)
       tmpSmpWindow[i] = ringBuffer[(i + ringBufferPos) % windowSize] *
                         filterWindowCoefficents[i];
 
 #ifdef DFT_MEM_DUMP
     if (dumperEnable)
-      origSigSync.writeDataBinary(windowSize, tmpSmpWindow);
+      origSigSync.writeDataBinary(windowSize, tmpSmpWindow.data());
 #endif
 
-    for (unsigned i = 0; i < freqCount; i++) {
-      results[i] = 0;
+    unsigned len = windowSize;
+    if (padding == PaddingType::SIG_REPEAT) { // Repeat samples
+      len = windowSize * windowMultiplier;
 
-      for (unsigned j = 0; j < windowSize * windowMultiplier; j++) {
-        if (padding == PaddingType::ZERO) {
-          if (j < windowSize)
-            results[i] += tmpSmpWindow[j] * matrix[i][j];
-          else
-            results[i] += 0;
-        } else if (padding == PaddingType::SIG_REPEAT) // Repeat samples
-          results[i] += tmpSmpWindow[j % windowSize] * matrix[i][j];
-      }
+      for (unsigned j = windowSize; j < len; j++)
+        tmpSmpWindow[j] = tmpSmpWindow[j % windowSize];
     }
+
+    long startBin = floor(startFrequency / frequencyResolution);
+
+    spectrum.compute(tmpSmpWindow.data(), len, results.data(), startBin,
+                     freqCount);
   }
 
   /*
@@ -547,14 +674,8 @@ public:
   void calculateWindow(enum WindowType windowTypeIn) {
     switch (windowTypeIn) {
     case WindowType::FLATTOP:
-      for (unsigned i = 0; i < windowSize; i++) {
-        filterWindowCoefficents[i] =
-            0.21557895 - 0.41663158 * cos(2 * M_PI * i / (windowSize)) +
-            0.277263158 * cos(4 * M_PI * i / (windowSize)) -
-            0.083578947 * cos(6 * M_PI * i / (windowSize)) +
-            0.006947368 * cos(8 * M_PI * i / (windowSize));
-        windowCorrectionFactor += filterWindowCoefficents[i];
-      }
+      windowCosineCoefficents = {0.21557895, -0.41663158, 0.277263158,
+                                 -0.083578947, 0.006947368};
       break;
 
     case WindowType::HAMMING:
@@ -563,23 +684,26 @@ public:
       if (windowTypeIn == WindowType::HAMMING)
         a0 = 25. / 46;
 
-      for (unsigned i = 0; i < windowSize; i++) {
-        filterWindowCoefficents[i] =
-            a0 - (1 - a0) * cos(2 * M_PI * i / (windowSize));
-        windowCorrectionFactor += filterWindowCoefficents[i];
-      }
-
+      windowCosineCoefficents = {a0, -(1 - a0)};
       break;
     }
 
     default:
-      for (unsigned i = 0; i < windowSize; i++) {
-        filterWindowCoefficents[i] = 1;
-        windowCorrectionFactor += filterWindowCoefficents[i];
-      }
+      windowCosineCoefficents = {1};
       break;
     }
 
+    windowCorrectionFactor = 0;
+    for (unsigned i = 0; i < windowSize; i++) {
+      filterWindowCoefficents[i] = 0;
+
+      for (unsigned l = 0; l < windowCosineCoefficents.size(); l++)
+        filterWindowCoefficents[i] +=
+            windowCosineCoefficents[l] * cos(2 * M_PI * l * i / (windowSize));
+
+      windowCorrectionFactor += filterWindowCoefficents[i];
+    }
+
     windowCorrectionFactor /= windowSize;
   }
 
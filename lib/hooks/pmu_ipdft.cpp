@@ -5,6 +5,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <villas/dsp/spectrum.hpp>
 #include <villas/hooks/pmu.hpp>
 
 namespace villas {
@@ -13,16 +14,19 @@ namespace node {
 class IpDftPmuHook : public PmuHook {
 
 protected:
-  std::complex<double> omega;
-  std::vector<std::vector<std::complex<double>>> dftMatrix;
-  std::vector<std::complex<double>> dftResult;
+  // Separate buffers for each channel as they might be estimated in parallel
+  std::vector<dsp::Spectrum> spectra;
+  std::vector<std::vector<double>> dftWindows;
+  std::vector<std::vector<std::complex<double>>> dftResults;
 
   unsigned frequencyCount; // Number of requency bins that are calculated
   double estimationRange;  // The range around nominalFreq used for estimation
+  unsigned startBin;
 
 public:
   IpDftPmuHook(Path *p, Node *n, int fl, int prio, bool en = true)
-      : PmuHook(p, n, fl, prio, en), frequencyCount(0), estimationRange(0)
+      : PmuHook(p, n, fl, prio, en), spectra(), dftWindows(), dftResults(),
+        frequencyCount(0), estimationRange(0), startBin(0)
 
   {}
 
@@ -36,20 +40,16 @@ public:
     frequencyCount =
         ceil((endFrequency - startFrequency) / frequencyResolution);
 
-    // Initialize matrix of dft coeffients
-    dftMatrix.clear();
-    for (unsigned i = 0; i < frequencyCount; i++)
-      dftMatrix.emplace_back(windowSize, 0.0);
+    startBin = floor(startFrequency / frequencyResolution);
 
-    using namespace std::complex_literals;
+    spectra.clear();
+    dftWindows.clear();
+    dftResults.clear();
 
-    omega = exp((-2i * M_PI) / (double)(windowSize));
-    unsigned startBin = floor(startFrequency / frequencyResolution);
-
-    for (unsigned i = 0; i < frequencyCount; i++) {
-      for (unsigned j = 0; j < windowSize; j++)
-        dftMatrix[i][j] = pow(omega, (i + startBin) * j);
-      dftResult.push_back(0.0);
+    for (unsigned i = 0; i < signalIndices.size(); i++) {
+      spectra.emplace_back(windowSize);
+      dftWindows.emplace_back(windowSize, 0.0);
+      dftResults.emplace_back(frequencyCount, 0.0);
     }
   }
 
@@ -76,18 +76,20 @@ public:
           estimationRange);
   }
 
-  PmuHook::Phasor estimatePhasor(dsp::CosineWindow<double> *window,
+  PmuHook::Phasor estimatePhasor(unsigned channel,
+                                 dsp::CosineWindow<double> *window,
                                  PmuHook::Phasor lastPhasor) {
     PmuHook::Phasor phasor = {0};
 
+    auto &dftWindow = dftWindows[channel];
+    auto &dftResult = dftResults[channel];
+
     // Calculate DFT
-    for (unsigned i = 0; i < frequencyCount; i++) {
-      dftResult[i] = 0;
+    const unsigned size = window->size();
+    window->apply(dftWindow.data());
 
-      const unsigned size = (*window).size();
-      for (unsigned j = 0; j < size; j++)
-        dftResult[i] += (*window)[j] * dftMatrix[i][j];
-    }
+    spectra[channel].compute(dftWindow.data(), size, dftResult.data(),
+                             startBin, frequencyCount);
     // End calculate DFT
 
     // Find max bin
@@ -5,6 +5,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <villas/dsp/window_stats.hpp>
 #include <villas/hook.hpp>
 #include <villas/sample.hpp>
 
@@ -36,14 +37,15 @@ protected:
     std::string current;
   };
 
+  // Terms of each pairing which are integrated over the window
+  enum Term { TERM_UU, TERM_II, TERM_UI, TERM_COUNT };
+
   std::vector<PairingsStr> pairingsStr;
-  std::vector<std::vector<double>> smpMemory;
   std::vector<PowerPairing> pairings;
   std::vector<timespec> smpMemoryTs;
 
-  std::vector<double> accumulator_u;  // Integral over u
-  std::vector<double> accumulator_i;  // Integral over I
-  std::vector<double> accumulator_ui; // Integral over U*I
+  dsp::WindowStats stats; // Integrals over U*U, I*I and U*I for each pairing
+  std::vector<double> terms;
 
   unsigned windowSize;
   uint64_t smpMemoryPosition;
@@ -58,8 +60,8 @@ protected:
 
 public:
   PowerHook(Path *p, Node *n, int fl, int prio, bool en = true)
-      : MultiSignalHook(p, n, fl, prio, en), smpMemory(), pairings(),
-        smpMemoryTs(), windowSize(0), smpMemoryPosition(0),
+      : MultiSignalHook(p, n, fl, prio, en), pairings(), smpMemoryTs(),
+        stats(), terms(), windowSize(0), smpMemoryPosition(0),
         calcActivePower(true), calcReactivePower(true), caclApparentPower(true),
         calcCosPhi(true), channelNameEnable(false), angleUnitFactor(1),
         timeAlignType(TimeAlign::CENTER) {}
@@ -139,21 +141,13 @@ public:
       }
     }
 
-    // Initialize sampMemory to 0
-    smpMemory.clear();
-    for (unsigned i = 0; i < signalIndices.size(); i++)
-      smpMemory.emplace_back(windowSize, 0.0);
-
     smpMemoryTs.clear();
     for (unsigned i = 0; i < windowSize; i++)
       smpMemoryTs.push_back({0});
 
     // Init empty accumulators for each pairing
-    for (size_t i = 0; i < pairings.size(); i++) {
-      accumulator_i.push_back(0.0);
-      accumulator_u.push_back(0.0);
-      accumulator_ui.push_back(0.0);
-    }
+    stats = dsp::WindowStats(windowSize, pairings.size() * TERM_COUNT);
+    terms.resize(pairings.size() * TERM_COUNT);
 
     // Signal state prepared
     state = State::PREPARED;
@@ -246,43 +240,34 @@ public:
 
     smpMemoryTs[smpMemoryPosition % windowSize] = smp->ts.origin;
 
-    // Loop over all pairings
+    // Update the U, I and U*I integrals of all pairings in a single pass
     for (size_t i = 0; i < pairings.size(); i++) {
       auto pair = pairings[i];
 
-      // Update U integral
-      double oldValueU =
-          smpMemory[pair.voltageIndex][smpMemoryPosition % windowSize];
-      double newValueU = smp->data[pair.voltageIndex].f;
-      smpMemory[pair.voltageIndex][smpMemoryPosition % windowSize] =
-          newValueU; // Save for later
+      double u = smp->data[pair.voltageIndex].f;
+      double c = smp->data[pair.currentIndex].f;
 
-      accumulator_u[i] -= oldValueU * oldValueU;
-      accumulator_u[i] += newValueU * newValueU;
-
-      // Update I integral
-      double newValueI = smp->data[pair.currentIndex].f;
-      double oldValueI =
-          smpMemory[pair.currentIndex][smpMemoryPosition % windowSize];
-      smpMemory[pair.currentIndex][smpMemoryPosition % windowSize] =
-          newValueI; // Save for later
+      terms[i * TERM_COUNT + TERM_UU] = u * u;
+      terms[i * TERM_COUNT + TERM_II] = c * c;
+      terms[i * TERM_COUNT + TERM_UI] = u * c;
+    }
 
-      accumulator_i[i] -= oldValueI * oldValueI;
-      accumulator_i[i] += newValueI * newValueI;
+    stats.update(terms.data());
 
-      // Update UI Integral
-      accumulator_ui[i] -= oldValueI * oldValueU;
-      accumulator_ui[i] += newValueI * newValueU;
+    // Loop over all pairings
+    for (size_t i = 0; i < pairings.size(); i++) {
+      double sumUU = std::max(stats.sum(i * TERM_COUNT + TERM_UU), 0.0);
+      double sumII = std::max(stats.sum(i * TERM_COUNT + TERM_II), 0.0);
+      double sumUI = stats.sum(i * TERM_COUNT + TERM_UI);
 
       // Calc active power power
-      double P = (1.0 / windowSize) * accumulator_ui[i];
+      double P = (1.0 / windowSize) * sumUI;
 
       // Calc apparent power
-      double S =
-          (1.0 / windowSize) * pow(accumulator_i[i] * accumulator_u[i], 0.5);
+      double S = (1.0 / windowSize) * sqrt(sumII * sumUU);
 
       // Calc reactive power
-      double Q = pow(S * S - P * P, 0.5);
+      double Q = sqrt(std::max(S * S - P * P, 0.0));
 
       // Calc cos phi
       double PHI = atan2(Q, P) * angleUnitFactor;
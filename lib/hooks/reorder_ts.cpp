@@ -5,61 +5,174 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
-#include "villas/exceptions.hpp"
 #include <algorithm>
 #include <cstring>
 #include <ctime>
+#include <deque>
 #include <vector>
 
+#include <villas/exceptions.hpp>
 #include <villas/hook.hpp>
+#include <villas/pool.hpp>
 #include <villas/sample.hpp>
 #include <villas/timing.hpp>
 
 namespace villas {
 namespace node {
 
+/* Reorders samples by their origin timestamp.
+ *
+ * Up to window_size samples are held in a binary min-heap keyed by their
+ * origin timestamp and arrival order. Once the window is full, each new sample
+ * releases the oldest held one. The held samples are allocated from a pool
+ * owned by the hook, so that the memory is bounded and the pools of the nodes
+ * are not drained.
+ *
+ * With max_latency set, the arrival times of the held samples are tracked in
+ * a separate queue as the heap is ordered by origin timestamp. Samples are
+ * released as long as the longest held one exceeds the limit. */
 class ReorderTsHook : public Hook {
 
 protected:
-  std::vector<Sample *> window;
+  struct Entry {
+    struct timespec ts;       // Origin timestamp of the sample
+    struct timespec received; // Time at which the sample was added
+    uint64_t arrival;         // Keeps samples with equal timestamps in order
+    struct Sample *smp;
+  };
+
+  // Comparator for a min-heap on top of std::push_heap / std::pop_heap
+  static bool later(const Entry &lhs, const Entry &rhs) {
+    auto cmp = time_cmp(&lhs.ts, &rhs.ts);
+
+    return cmp ? cmp > 0 : lhs.arrival > rhs.arrival;
+  }
+
+  // Arrival order of the held samples for the max_latency check
+  struct Pending {
+    uint64_t arrival;
+    struct timespec received;
+    bool held;
+  };
+
+  std::vector<Entry> heap;
+  std::deque<Pending> pending;
   std::size_t window_size;
-  Sample *buffer;
-
-  void swapSample(Sample *lhs, Sample *rhs) {
-    if (buffer) {
-      sample_copy(buffer, lhs);
-      sample_copy(lhs, rhs);
-      sample_copy(rhs, buffer);
-    } else {
-      buffer = sample_clone(lhs);
-      if (!buffer)
-        throw RuntimeError{"Out of memory."};
-
-      sample_copy(lhs, rhs);
-      sample_copy(rhs, buffer);
-    }
+  double max_latency; // Maximum time a sample is held in seconds
+
+  struct Pool pool;
+  bool pool_initialized;
+
+  uint64_t arrival;
+
+  bool released;
+  struct timespec last; // Timestamp of the last released sample
+
+  uint64_t dropped;
+
+  void clear() {
+    for (auto &e : heap)
+      sample_decref(e.smp);
+
+    heap.clear();
+    pending.clear();
+
+    released = false;
+  }
+
+  void initPool(unsigned capacity) {
+    // One spare block for the exchange of a new and a released sample
+    int ret = pool_init(&pool, window_size + 1, SAMPLE_LENGTH(capacity));
+    if (ret)
+      throw RuntimeError("Failed to initialize memory pool");
+
+    pool_initialized = true;
+  }
+
+  void destroyPool() {
+    if (!pool_initialized)
+      return;
+
+    int ret = pool_destroy(&pool);
+    if (ret)
+      throw RuntimeError("Failed to destroy memory pool");
+
+    pool_initialized = false;
+  }
+
+  // Mark a released sample and discard the leading released ones
+  void forget(uint64_t arr) {
+    auto it = std::lower_bound(
+        pending.begin(), pending.end(), arr,
+        [](const Pending &p, uint64_t a) { return p.arrival < a; });
+
+    if (it != pending.end() && it->arrival == arr)
+      it->held = false;
+
+    while (!pending.empty() && !pending.front().held)
+      pending.pop_front();
+  }
+
+  // Check whether the oldest held sample must be released
+  bool mustRelease(const struct timespec *now) {
+    if (heap.empty())
+      return false;
+
+    if (heap.size() >= window_size)
+      return true;
+
+    return max_latency > 0 && !pending.empty() &&
+           time_delta(&pending.front().received, now) >= max_latency;
   }
 
 public:
   ReorderTsHook(Path *p, Node *n, int fl, int prio, bool en = true)
-      : Hook(p, n, fl, prio, en), window{}, window_size(16), buffer(nullptr) {}
+      : Hook(p, n, fl, prio, en), window_size(16), max_latency(0), pool(),
+        pool_initialized(false), arrival(0), released(false), last(),
+        dropped(0) {}
+
+  virtual ~ReorderTsHook() {
+    clear();
+
+    if (pool_initialized)
+      (void)pool_destroy(&pool);
+  }
 
   virtual void parse(json_t *json) {
+    int ret;
+    json_error_t err;
+    int window = window_size;
+
     assert(state != State::STARTED);
 
-    json_error_t err;
-    int ret =
-        json_unpack_ex(json, &err, 0, "{ s?: i }", "window_size", &window_size);
+    Hook::parse(json);
+
+    ret = json_unpack_ex(json, &err, 0, "{ s?: i, s?: F }", "window_size",
+                         &window, "max_latency", &max_latency);
     if (ret)
       throw ConfigError(json, err, "node-config-hook-reorder-ts");
 
+    if (window < 1)
+      throw ConfigError(json, "node-config-hook-reorder-ts-window-size",
+                        "Setting 'window_size' must be positive");
+
+    if (max_latency < 0)
+      throw ConfigError(json, "node-config-hook-reorder-ts-max-latency",
+                        "Setting 'max_latency' must not be negative");
+
+    window_size = window;
+
     state = State::PARSED;
   }
 
   virtual void start() {
     assert(state == State::PREPARED || state == State::STOPPED);
 
-    window.reserve(window_size);
+    heap.reserve(window_size);
+
+    arrival = 0;
+    dropped = 0;
+    released = false;
 
     state = State::STARTED;
   }
@@ -67,79 +180,95 @@ public:
   virtual void stop() {
     assert(state == State::STARTED);
 
-    for (auto sample : window)
-      sample_free(sample);
-
-    if (buffer)
-      sample_free(buffer);
+    clear();
+    destroyPool();
 
-    window.clear();
+    if (dropped)
+      logger->warn("Dropped {} samples which arrived too late", dropped);
 
     state = State::STOPPED;
   }
 
-  virtual Hook::Reason process(Sample *smp) {
+  virtual void restart() {
     assert(state == State::STARTED);
-    assert(smp);
 
-    if (window.empty()) {
-      auto new_smp = sample_clone(smp);
-      if (!new_smp)
-        throw RuntimeError{"Out of memory."};
+    clear();
+  }
 
-      window.push_back(new_smp);
+  virtual Hook::Reason process(struct Sample *smp) {
+    assert(state == State::STARTED);
+    assert(smp);
 
-      logger->debug("window.size={}/{}", window.size(), window_size);
+    // The capacity of the held samples is taken from the first sample
+    if (!pool_initialized)
+      initPool(std::max<unsigned>(smp->capacity, signals->size()));
+
+    // The sample arrived after a newer one has already been released
+    if (released && time_cmp(&smp->ts.origin, &last) < 0) {
+      dropped++;
+      logger->debug("Dropping late sample: sequence={}", smp->sequence);
 
       return Hook::Reason::SKIP_SAMPLE;
     }
 
-    for (std::size_t i = window.size() - 1;; i--) {
-      if (time_cmp(&smp->ts.origin, &window[i]->ts.origin) >= 0) {
-        if (i != window.size() - 1)
-          logger->warn("Fixing reordered Sample");
+    auto now = time_now();
+
+    Entry entry = {smp->ts.origin, now, arrival++, nullptr};
 
-        if (window.size() == window_size) {
-          Sample *window_sample = window.front();
-          std::copy(++std::begin(window), std::next(std::begin(window), i + 1),
-                    std::begin(window));
-          window[i] = window_sample;
-          swapSample(window_sample, smp);
+    if (!mustRelease(&now)) {
+      entry.smp = sample_alloc(&pool);
+      if (!entry.smp)
+        throw RuntimeError("Out of memory");
 
-          return Hook::Reason::OK;
-        } else {
-          window.push_back(nullptr);
-          std::copy_backward(std::next(std::begin(window), i + 1),
-                             --std::end(window), std::end(window));
+      sample_copy(entry.smp, smp);
 
-          auto new_smp = sample_clone(smp);
-          if (!new_smp)
-            throw RuntimeError{"Out of memory."};
+      heap.push_back(entry);
+      std::push_heap(heap.begin(), heap.end(), later);
 
-          window[i + 1] = new_smp;
+      if (max_latency > 0)
+        pending.push_back({entry.arrival, now, true});
+
+      return Hook::Reason::SKIP_SAMPLE;
+    }
 
-          logger->debug("window.size={}/{}", window.size(), window_size);
+    // The new sample is older than all held ones and passes directly
+    if (time_cmp(&smp->ts.origin, &heap.front().ts) < 0) {
+      logger->debug("Fixing reordered sample: sequence={}", smp->sequence);
 
-          return Hook::Reason::SKIP_SAMPLE;
-        }
-      }
+      last = smp->ts.origin;
+      released = true;
 
-      if (!i)
-        break;
+      return Hook::Reason::OK;
     }
 
-    logger->error("Could not reorder Sample");
+    /* Exchange the new sample with the oldest held one. The new sample is
+     * stored in the spare block and the block of the released one becomes the
+     * new spare. */
+    std::pop_heap(heap.begin(), heap.end(), later);
 
-    return Hook::Reason::SKIP_SAMPLE;
-  }
+    Entry &oldest = heap.back();
+    struct Sample *held = oldest.smp;
 
-  virtual void restart() {
-    assert(state == State::STARTED);
+    entry.smp = sample_alloc(&pool);
+    if (!entry.smp)
+      throw RuntimeError("Out of memory");
+
+    sample_copy(entry.smp, smp);
+    sample_copy(smp, held);
+    sample_decref(held);
+
+    last = oldest.ts;
+    released = true;
+
+    if (max_latency > 0) {
+      pending.push_back({entry.arrival, now, true});
+      forget(oldest.arrival);
+    }
 
-    for (auto sample : window)
-      sample_free(sample);
+    oldest = entry;
+    std::push_heap(heap.begin(), heap.end(), later);
 
-    window.clear();
+    return Hook::Reason::OK;
   }
 };
 
@@ -0,0 +1,359 @@
+/* Resample hook.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <villas/exceptions.hpp>
+#include <villas/hook.hpp>
+#include <villas/sample.hpp>
+#include <villas/signal_list.hpp>
+#include <villas/timing.hpp>
+
+namespace villas {
+namespace node {
+
+/* Converts the sample rate of all float signals to a lower output rate.
+ *
+ * Output samples are placed on a grid of multiples of the output period,
+ * aligned to full seconds of the origin timestamps. Each output value is
+ * calculated from the history of input samples as a weighted sum whose weights
+ * depend on the fractional position of the output instant between two input
+ * samples.
+ *
+ * As hooks can only forward or skip samples, the output rate can not exceed
+ * the input rate. An input sample is forwarded with the interpolated values
+ * and the timestamp of an output instant, or skipped if no output instant is
+ * due. */
+class ResampleHook : public Hook {
+
+protected:
+  enum class Mode { LINEAR, CUBIC, FIR } mode;
+
+  double rate;      // Output rate
+  double inputRate; // Nominal input rate
+  double cutoff;    // Cutoff frequency relative to the Nyquist frequency
+  unsigned taps;
+  unsigned phases;
+
+  unsigned channels;
+  std::vector<enum SignalType> types; // Only float signals are interpolated
+
+  // Polyphase filter bank: (phases + 1) rows of taps weights
+  std::vector<double> bank;
+
+  // Mirrored ring buffer of taps rows with channels values each
+  std::vector<double> history;
+  unsigned position; // Row of the newest sample
+  unsigned filled;   // Number of valid rows
+
+  std::vector<double> weights;
+  std::vector<double> output;
+
+  // Time base for the output grid
+  bool aligned;
+  time_t reference;
+  int64_t next; // Index of the next output instant relative to reference
+  double last;  // Time of the last input sample relative to reference
+
+  uint64_t sequence;
+
+  double sinc(double x) {
+    return x == 0 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+  }
+
+  void prepareFilterBank() {
+    // Cutoff in cycles per input sample
+    double fc = 0.5 * cutoff * rate / inputRate;
+    double half = taps / 2.0;
+
+    bank.resize((phases + 1) * taps);
+
+    for (unsigned p = 0; p <= phases; p++) {
+      double *row = &bank[p * taps];
+      double sum = 0;
+
+      for (unsigned j = 0; j < taps; j++) {
+        // Distance of tap j from the output instant in input samples
+        double t = j - (half - 1) - (double)p / phases;
+
+        // Windowed sinc with a Blackman window spanning all taps
+        double w = 0.42 + 0.5 * cos(M_PI * t / half) +
+                   0.08 * cos(2 * M_PI * t / half);
+
+        row[j] = 2 * fc * sinc(2 * fc * t) * w;
+        sum += row[j];
+      }
+
+      // Unity gain for DC
+      for (unsigned j = 0; j < taps; j++)
+        row[j] /= sum;
+    }
+  }
+
+  // Calculate the weights of the taps for an output instant at frac in [0, 1)
+  void calculateWeights(double frac) {
+    switch (mode) {
+    case Mode::LINEAR:
+      weights[0] = 1 - frac;
+      weights[1] = frac;
+      break;
+
+    case Mode::CUBIC: {
+      // Catmull-Rom spline between taps 1 and 2
+      double t = frac, t2 = t * t, t3 = t2 * t;
+
+      weights[0] = 0.5 * (-t3 + 2 * t2 - t);
+      weights[1] = 0.5 * (3 * t3 - 5 * t2 + 2);
+      weights[2] = 0.5 * (-3 * t3 + 4 * t2 + t);
+      weights[3] = 0.5 * (t3 - t2);
+      break;
+    }
+
+    case Mode::FIR: {
+      // Linear interpolation between the two closest phases
+      double f = frac * phases;
+      unsigned p = std::min((unsigned)f, phases - 1);
+      double a = f - p;
+
+      const double *r0 = &bank[p * taps];
+      const double *r1 = &bank[(p + 1) * taps];
+
+      for (unsigned j = 0; j < taps; j++)
+        weights[j] = (1 - a) * r0[j] + a * r1[j];
+      break;
+    }
+    }
+  }
+
+  // Weighted sum over the history of all channels at once
+  void filter() {
+    double *out = output.data();
+
+    std::fill(output.begin(), output.end(), 0.0);
+
+    for (unsigned j = 0; j < taps; j++) {
+      // Tap j refers to the j-th newest sample
+      const double *row = &history[(position + taps - j) * channels];
+      double w = weights[j];
+
+#pragma omp simd
+      for (unsigned ch = 0; ch < channels; ch++)
+        out[ch] += w * row[ch];
+    }
+  }
+
+  void reset() {
+    std::fill(history.begin(), history.end(), 0.0);
+
+    position = 0;
+    filled = 0;
+  }
+
+public:
+  ResampleHook(Path *p, Node *n, int fl, int prio, bool en = true)
+      : Hook(p, n, fl, prio, en), mode(Mode::FIR), rate(0), inputRate(0),
+        cutoff(0.9), taps(32), phases(64), channels(0), position(0),
+        filled(0), aligned(false), reference(0), next(0), last(0),
+        sequence(0) {}
+
+  virtual void parse(json_t *json) {
+    int ret;
+    json_error_t err;
+    const char *mode_str = nullptr;
+    int taps_int = taps;
+    int phases_int = phases;
+
+    assert(state != State::STARTED);
+
+    Hook::parse(json);
+
+    ret = json_unpack_ex(json, &err, 0,
+                         "{ s: F, s: F, s?: s, s?: F, s?: i, s?: i }", "rate",
+                         &rate, "input_rate", &inputRate, "mode", &mode_str,
+                         "cutoff", &cutoff, "taps", &taps_int, "phases",
+                         &phases_int);
+    if (ret)
+      throw ConfigError(json, err, "node-config-hook-resample");
+
+    if (mode_str) {
+      if (!strcmp(mode_str, "linear"))
+        mode = Mode::LINEAR;
+      else if (!strcmp(mode_str, "cubic"))
+        mode = Mode::CUBIC;
+      else if (!strcmp(mode_str, "fir"))
+        mode = Mode::FIR;
+      else
+        throw ConfigError(json, "node-config-hook-resample-mode",
+                          "Invalid mode: {}", mode_str);
+    }
+
+    if (rate <= 0 || inputRate <= 0)
+      throw ConfigError(json, "node-config-hook-resample-rate",
+                        "Rates must be positive");
+
+    if (rate > inputRate)
+      throw ConfigError(json, "node-config-hook-resample-rate",
+                        "The output rate must not exceed the input rate as "
+                        "hooks can not create new samples");
+
+    if (mode == Mode::FIR) {
+      if (taps_int < 2 || taps_int % 2)
+        throw ConfigError(json, "node-config-hook-resample-taps",
+                          "The number of taps must be even and at least 2");
+
+      if (phases_int < 1)
+        throw ConfigError(json, "node-config-hook-resample-phases",
+                          "The number of phases must be positive");
+
+      if (cutoff <= 0 || cutoff > 1)
+        throw ConfigError(json, "node-config-hook-resample-cutoff",
+                          "The cutoff must be in the range (0, 1]");
+
+      taps = taps_int;
+      phases = phases_int;
+    } else
+      taps = mode == Mode::LINEAR ? 2 : 4;
+
+    state = State::PARSED;
+  }
+
+  virtual void prepare() {
+    assert(state == State::CHECKED);
+
+    channels = signals->size();
+
+    types.clear();
+    for (auto sig : *signals)
+      types.push_back(sig->type);
+
+    if (mode == Mode::FIR)
+      prepareFilterBank();
+
+    history.resize(2 * taps * channels);
+    weights.resize(taps);
+    output.resize(channels);
+
+    state = State::PREPARED;
+  }
+
+  virtual void start() {
+    assert(state == State::PREPARED || state == State::STOPPED);
+
+    reset();
+
+    aligned = false;
+    sequence = 0;
+
+    state = State::STARTED;
+  }
+
+  virtual void restart() {
+    assert(state == State::STARTED);
+
+    reset();
+
+    aligned = false;
+    sequence = 0;
+  }
+
+  virtual Hook::Reason process(struct Sample *smp) {
+    assert(state == State::STARTED);
+
+    if (!(smp->flags & (int)SampleFlags::HAS_TS_ORIGIN))
+      throw RuntimeError("Missing origin timestamp");
+
+    if (!aligned || smp->flags & (int)SampleFlags::NEW_SIMULATION) {
+      reset();
+
+      reference = smp->ts.origin.tv_sec;
+      aligned = true;
+    }
+
+    double now = (smp->ts.origin.tv_sec - reference) +
+                 smp->ts.origin.tv_nsec * 1e-9;
+
+    // Restart the interpolation after gaps or jumps back in time
+    if (filled && (now <= last || (now - last) * inputRate > 2.5))
+      reset();
+
+    if (!filled)
+      next = ceil(now * rate);
+
+    last = now;
+
+    // Append the new sample to the history
+    position = (position + 1) % taps;
+
+    double *row = &history[position * channels];
+    for (unsigned ch = 0; ch < channels; ch++) {
+      row[ch] = ch < smp->length
+                    ? smp->data[ch].cast(types[ch], SignalType::FLOAT).f
+                    : 0.0;
+    }
+
+    memcpy(row + taps * channels, row, channels * sizeof(double));
+
+    if (filled < taps)
+      filled++;
+
+    // Output instants are interpolated between the taps (taps / 2 - 1) and
+    // (taps / 2) samples back from the newest one
+    double center = taps / 2 - 1;
+    double frac;
+
+    while (true) {
+      frac = (now - next / rate) * inputRate - center;
+      if (frac < 1)
+        break;
+
+      // Missed output instant, e.g. during the initial filling of the history
+      next++;
+    }
+
+    if (frac < 0 || filled < taps)
+      return Reason::SKIP_SAMPLE;
+
+    calculateWeights(frac);
+    filter();
+
+    for (unsigned ch = 0; ch < channels && ch < smp->length; ch++) {
+      if (types[ch] == SignalType::FLOAT)
+        smp->data[ch].f = output[ch];
+    }
+
+    double out = next / rate;
+    double secs = floor(out);
+
+    smp->ts.origin.tv_sec = reference + (time_t)secs;
+    smp->ts.origin.tv_nsec = round((out - secs) * 1e9);
+
+    if (smp->ts.origin.tv_nsec >= 1000000000L) {
+      smp->ts.origin.tv_sec++;
+      smp->ts.origin.tv_nsec -= 1000000000L;
+    }
+
+    smp->sequence = sequence++;
+    smp->flags |= (int)SampleFlags::HAS_SEQUENCE;
+
+    next++;
+
+    return Reason::OK;
+  }
+};
+
+// Register hook
+static char n[] = "resample";
+static char d[] = "Resample signals to a lower rate with interpolation";
+static HookPlugin<ResampleHook, n, d,
+                  (int)Hook::Flags::NODE_READ | (int)Hook::Flags::NODE_WRITE |
+                      (int)Hook::Flags::PATH>
+    p;
+
+} // namespace node
+} // namespace villas
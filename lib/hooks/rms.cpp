@@ -5,6 +5,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <villas/dsp/window_stats.hpp>
 #include <villas/hook.hpp>
 #include <villas/sample.hpp>
 
@@ -14,16 +15,15 @@ namespace node {
 class RMSHook : public MultiSignalHook {
 
 protected:
-  std::vector<std::vector<double>> smpMemory;
+  dsp::WindowStats stats; // Sums of squares of all signals
 
-  std::vector<double> accumulator;
+  std::vector<double> squares;
   unsigned windowSize;
-  uint64_t smpMemoryPosition;
 
 public:
   RMSHook(Path *p, Node *n, int fl, int prio, bool en = true)
-      : MultiSignalHook(p, n, fl, prio, en), smpMemory(), windowSize(0),
-        smpMemoryPosition(0) {}
+      : MultiSignalHook(p, n, fl, prio, en), stats(), squares(),
+        windowSize(0) {}
 
   virtual void prepare() {
     MultiSignalHook::prepare();
@@ -39,11 +39,8 @@ public:
     }
 
     /* Initialize memory for each channel*/
-    smpMemory.clear();
-    for (unsigned i = 0; i < signalIndices.size(); i++) {
-      accumulator.push_back(0.0);
-      smpMemory.emplace_back(windowSize, 0.0);
-    }
+    stats = dsp::WindowStats(windowSize, signalIndices.size());
+    squares.resize(signalIndices.size());
 
     state = State::PREPARED;
   }
@@ -77,27 +74,22 @@ public:
 
     unsigned i = 0;
     for (auto index : signalIndices) {
-      // Square the new value
-      double newValue = pow(smp->data[index].f, 2);
-
-      // Get the old value from the history
-      double oldValue = smpMemory[i][smpMemoryPosition % windowSize];
+      double value = smp->data[index].f;
 
-      // Append the new value to the history memory
-      smpMemory[i][smpMemoryPosition % windowSize] = newValue;
+      squares[i++] = value * value;
+    }
 
-      // Update the accumulator
-      accumulator[index] += newValue;
-      accumulator[index] -= oldValue;
+    // Update the sums of squares of all signals in a single pass
+    stats.update(squares.data());
 
-      auto rms = pow(accumulator[index] / windowSize, 0.5);
+    i = 0;
+    for (auto index : signalIndices) {
+      // Rounding may result in a tiny negative mean
+      auto rms = sqrt(std::max(stats.mean(i++), 0.0));
 
       smp->data[index].f = rms;
-      i++;
     }
 
-    smpMemoryPosition++;
-
     return Reason::OK;
   }
 };
@@ -0,0 +1,331 @@
+/* Asynchronous HTTP client with request batching.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+
+#include <villas/exceptions.hpp>
+#include <villas/http_client.hpp>
+#include <villas/node/config.hpp>
+#include <villas/timing.hpp>
+
+using namespace villas;
+using namespace villas::node;
+
+// curl_multi_poll() and curl_multi_wakeup() are available since 7.68.0
+#if LIBCURL_VERSION_NUM >= 0x074400
+#define CURL_HAS_MULTI_WAKEUP
+#endif
+
+HttpClient::HttpClient(const std::string &u, const Options &opts, Logger log)
+    : url(u), headers(nullptr), options(opts), multi(nullptr),
+      batch_samples(0), queued_batches(0), active_barriers(0), running(false),
+      in_flight(0), dropped(0),
+      logger(log ? log : Log::get("http")) {
+  multi = curl_multi_init();
+  if (!multi)
+    throw RuntimeError("Failed to create libcurl multi handle");
+
+  // Limit the number of connections to the number of concurrent requests
+  curl_multi_setopt(multi, CURLMOPT_MAX_TOTAL_CONNECTIONS,
+                    (long)options.max_in_flight);
+  curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, (long)options.max_in_flight);
+}
+
+HttpClient::~HttpClient() {
+  if (running)
+    stop();
+
+  for (auto *handle : idle)
+    curl_easy_cleanup(handle);
+
+  curl_multi_cleanup(multi);
+  curl_slist_free_all(headers);
+}
+
+void HttpClient::setFraming(const std::string &pfx, const std::string &sep,
+                            const std::string &sfx) {
+  prefix = pfx;
+  separator = sep;
+  suffix = sfx;
+}
+
+void HttpClient::addHeader(const std::string &hdr) {
+  headers = curl_slist_append(headers, hdr.c_str());
+}
+
+void HttpClient::start() {
+  running = true;
+
+  thread = std::thread(&HttpClient::run, this);
+}
+
+void HttpClient::stop() {
+  running = false;
+
+  wakeup();
+
+  if (thread.joinable())
+    thread.join();
+
+  if (dropped > 0)
+    logger->warn("Dropped {} batches as the server was too slow",
+                 (size_t)dropped);
+}
+
+bool HttpClient::push(const std::string &fragment, unsigned samples) {
+  bool ok = true, wake;
+
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+
+    // The background thread needs to re-arm its timeout for new batches
+    wake = batch_samples == 0;
+
+    if (batch_samples == 0) {
+      batch = prefix;
+      batch_started = time_now();
+    } else
+      batch += separator;
+
+    batch += fragment;
+    batch_samples += samples;
+
+    if (batch_samples >= options.batch_size) {
+      ok = queued_batches < options.queue_length;
+      wake = true;
+
+      flush();
+    }
+  }
+
+  if (wake)
+    wakeup();
+
+  return ok;
+}
+
+void HttpClient::request(const std::string &u, const std::string &body,
+                         Callback cb, bool barrier) {
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+
+    // Keep the order to the fragments pushed before
+    flush();
+
+    queue.push_back(Job{u, body, cb, barrier});
+  }
+
+  wakeup();
+}
+
+void HttpClient::flush() {
+  if (batch_samples == 0)
+    return;
+
+  // Bound the memory used if the server can not keep up
+  if (queued_batches >= options.queue_length) {
+    auto it = std::find_if(queue.begin(), queue.end(),
+                           [](const Job &j) { return j.isBatch(); });
+
+    queue.erase(it);
+    queued_batches--;
+    dropped++;
+  }
+
+  queue.push_back(Job{"", std::move(batch), nullptr, false});
+  queue.back().body += suffix;
+  queued_batches++;
+
+  batch.clear();
+  batch_samples = 0;
+}
+
+void HttpClient::wakeup() {
+#ifdef CURL_HAS_MULTI_WAKEUP
+  curl_multi_wakeup(multi);
+#endif
+}
+
+size_t HttpClient::write(void *data, size_t size, size_t nmemb, void *userp) {
+  auto *req = (Request *)userp;
+
+  req->response.append((const char *)data, size * nmemb);
+
+  return size * nmemb;
+}
+
+void HttpClient::perform(Job &&job) {
+  CURL *handle;
+
+  if (idle.empty()) {
+    handle = curl_easy_init();
+    if (!handle)
+      throw RuntimeError("Failed to create libcurl handle");
+
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(handle, CURLOPT_USERAGENT, HTTP_USER_AGENT);
+    curl_easy_setopt(handle, CURLOPT_SSL_VERIFYPEER, (long)options.ssl_verify);
+    curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS,
+                     (long)(options.timeout * 1e3));
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, HttpClient::write);
+  } else {
+    handle = idle.back();
+    idle.pop_back();
+  }
+
+  auto *req = new Request;
+  req->handle = handle;
+  req->job = std::move(job);
+  req->started = time_now();
+
+  auto &u = req->job.isBatch() ? url : req->job.url;
+  auto &body = req->job.body;
+
+  curl_easy_setopt(handle, CURLOPT_URL, u.c_str());
+  curl_easy_setopt(handle, CURLOPT_PRIVATE, req);
+  curl_easy_setopt(handle, CURLOPT_WRITEDATA, req);
+  curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE, (long)body.size());
+  curl_easy_setopt(handle, CURLOPT_POSTFIELDS, body.c_str());
+
+  curl_multi_add_handle(multi, handle);
+
+  if (req->job.barrier)
+    active_barriers++;
+
+  active.push_back(req);
+  in_flight++;
+}
+
+void HttpClient::complete(CURL *handle, CURLcode result) {
+  Request *req;
+  long code = 0;
+
+  curl_easy_getinfo(handle, CURLINFO_PRIVATE, (char **)&req);
+
+  auto now = time_now();
+  auto latency = time_delta(&req->started, &now);
+
+  if (result != CURLE_OK)
+    logger->warn("HTTP request failed: {}", curl_easy_strerror(result));
+  else {
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &code);
+    if (code >= 300)
+      logger->warn("HTTP request failed with status {}: {}", code,
+                   req->response);
+  }
+
+  if (code >= 200 && code < 300 && req->job.isBatch()) {
+    std::lock_guard<std::mutex> guard(mutex);
+
+    latencies.push_back(latency);
+  }
+
+  auto &cb = req->job.callback ? req->job.callback : callback;
+  if (cb)
+    cb(code, req->response, latency);
+
+  if (req->job.barrier)
+    active_barriers--;
+
+  curl_multi_remove_handle(multi, handle);
+
+  // Handles of failed requests might have a broken connection
+  if (result == CURLE_OK)
+    idle.push_back(handle);
+  else
+    curl_easy_cleanup(handle);
+
+  active.erase(std::find(active.begin(), active.end(), req));
+  delete req;
+
+  in_flight--;
+}
+
+void HttpClient::takeLatencies(std::vector<double> &out) {
+  std::lock_guard<std::mutex> guard(mutex);
+
+  out.clear();
+  out.swap(latencies);
+}
+
+void HttpClient::run() {
+  struct timespec stopped = {0, 0};
+
+  while (true) {
+    int timeout = 100;
+    bool draining = !running;
+
+    if (draining && stopped.tv_sec == 0)
+      stopped = time_now();
+
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+
+      auto now = time_now();
+
+      if (batch_samples > 0) {
+        auto age = time_delta(&batch_started, &now);
+
+        if (draining || age >= options.max_latency)
+          flush();
+        else
+          timeout = std::min<int>(timeout, (options.max_latency - age) * 1e3);
+      }
+
+      while (!queue.empty() && in_flight < options.max_in_flight) {
+        // Barriers are performed alone
+        if (active_barriers > 0 || (queue.front().barrier && in_flight > 0))
+          break;
+
+        if (queue.front().isBatch())
+          queued_batches--;
+
+        perform(std::move(queue.front()));
+        queue.pop_front();
+      }
+
+      if (draining) {
+        if (queue.empty() && in_flight == 0)
+          break;
+
+        if (time_delta(&stopped, &now) > options.timeout) {
+          logger->warn("Aborting {} pending requests", in_flight + queue.size());
+          break;
+        }
+      }
+    }
+
+#ifdef CURL_HAS_MULTI_WAKEUP
+    curl_multi_poll(multi, nullptr, 0, timeout, nullptr);
+#else
+    curl_multi_wait(multi, nullptr, 0, std::min(timeout, 10), nullptr);
+#endif
+
+    int still_running, left;
+    curl_multi_perform(multi, &still_running);
+
+    CURLMsg *msg;
+    while ((msg = curl_multi_info_read(multi, &left))) {
+      if (msg->msg == CURLMSG_DONE)
+        complete(msg->easy_handle, msg->data.result);
+    }
+  }
+
+  // Cancel requests which did not complete in time
+  for (auto *req : active) {
+    curl_multi_remove_handle(multi, req->handle);
+    curl_easy_cleanup(req->handle);
+
+    delete req;
+  }
+
+  active.clear();
+  active_barriers = 0;
+  in_flight = 0;
+}
@@ -5,6 +5,8 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <list>
+#include <mutex>
 #include <unordered_map>
 
 #include <cerrno>
@@ -26,8 +28,115 @@ using namespace villas::node;
 using namespace villas::node::memory;
 
 static std::unordered_map<void *, struct Allocation *> allocations;
+static std::mutex allocations_mutex;
+
+static std::list<struct Owner> owners; // A list keeps the addresses stable
+static std::unordered_map<std::string, struct Owner *> owners_by_name;
+static std::mutex owners_mutex;
+
+static thread_local struct Owner *current_owner = nullptr;
+
 static Logger logger;
 
+// Find the account of the current owner for memory type \p m.
+static struct Account *get_account(struct Type *m) {
+  static struct Owner *global = get_owner("global");
+
+  struct Owner *o = current_owner ? current_owner : global;
+
+  for (auto &a : o->accounts) {
+    struct Type *t = a.type.load(std::memory_order_acquire);
+    if (t == m)
+      return &a;
+
+    // Claim an unused slot
+    if (t == nullptr && a.type.compare_exchange_strong(t, m))
+      return &a;
+    else if (t == m)
+      return &a;
+  }
+
+  return nullptr;
+}
+
+static void account_charge(struct Account *a, size_t len) {
+  size_t bytes = a->bytes.fetch_add(len) + len;
+  size_t peak = a->peak.load(std::memory_order_relaxed);
+
+  while (bytes > peak && !a->peak.compare_exchange_weak(peak, bytes))
+    ;
+
+  a->allocations++;
+}
+
+static void account_discharge(struct Account *a, size_t len) {
+  a->bytes -= len;
+  a->allocations--;
+}
+
+OwnerScope::OwnerScope(const std::string &name) : previous(current_owner) {
+  current_owner = get_owner(name);
+}
+
+OwnerScope::~OwnerScope() { current_owner = previous; }
+
+struct Owner *villas::node::memory::get_owner(const std::string &name) {
+  std::lock_guard<std::mutex> guard(owners_mutex);
+
+  auto it = owners_by_name.find(name);
+  if (it != owners_by_name.end())
+    return it->second;
+
+  auto &o = owners.emplace_back();
+  o.name = name;
+
+  owners_by_name[name] = &o;
+
+  return &o;
+}
+
+json_t *villas::node::memory::accounting_to_json() {
+  std::lock_guard<std::mutex> guard(owners_mutex);
+
+  json_t *json_owners = json_array();
+
+  for (auto &o : owners) {
+    for (auto &a : o.accounts) {
+      struct Type *t = a.type.load(std::memory_order_acquire);
+      if (!t)
+        continue;
+
+      json_array_append_new(
+          json_owners,
+          json_pack("{ s: s, s: s, s: I, s: I, s: I }", "owner",
+                    o.name.c_str(), "type", t->name, "bytes",
+                    (json_int_t)a.bytes.load(), "peak",
+                    (json_int_t)a.peak.load(), "allocations",
+                    (json_int_t)a.allocations.load()));
+    }
+  }
+
+  return json_owners;
+}
+
+void villas::node::memory::accounting_print(Logger logger) {
+  std::lock_guard<std::mutex> guard(owners_mutex);
+
+  logger->info("Memory usage:");
+
+  for (auto &o : owners) {
+    for (auto &a : o.accounts) {
+      struct Type *t = a.type.load(std::memory_order_acquire);
+      if (!t)
+        continue;
+
+      logger->info("  {}: type={}, bytes={:#x}, peak={:#x}, allocations={}",
+                   o.name, t->name, a.bytes.load(), a.peak.load(),
+                   a.allocations.load());
+    }
+  }
+}
+
 int villas::node::memory::init(int hugepages) {
   int ret;
 
@@ -114,7 +223,15 @@ void *villas::node::memory::alloc_aligned(size_t len, size_t alignment,
     return nullptr;
   }
 
-  allocations[ma->address] = ma;
+  ma->account = get_account(m);
+  if (ma->account)
+    account_charge(ma->account, ma->length);
+
+  {
+    std::lock_guard<std::mutex> guard(allocations_mutex);
+
+    allocations[ma->address] = ma;
+  }
 
   logger->debug("Allocated {:#x} bytes of {:#x}-byte-aligned {} memory: {}",
                 ma->length, ma->alignment, ma->type->name, ma->address);
@@ -126,7 +243,7 @@ int villas::node::memory::free(void *ptr) {
   int ret;
 
   // Find corresponding memory allocation entry
-  struct Allocation *ma = allocations[ptr];
+  struct Allocation *ma = get_allocation(ptr);
   if (!ma)
     return -1;
 
@@ -137,19 +254,59 @@ int villas::node::memory::free(void *ptr) {
   if (ret)
     return ret;
 
+  if (ma->account)
+    account_discharge(ma->account, ma->length);
+
   // Remove allocation entry
-  auto iter = allocations.find(ptr);
-  if (iter == allocations.end())
-    return -1;
+  {
+    std::lock_guard<std::mutex> guard(allocations_mutex);
+
+    auto iter = allocations.find(ptr);
+    if (iter == allocations.end())
+      return -1;
+
+    allocations.erase(iter);
+  }
 
-  allocations.erase(iter);
   delete ma;
 
   return 0;
 }
 
+int villas::node::memory::prefault(void *ptr, size_t len) {
+  size_t pgsz = kernel::getPageSize();
+
+  if (len == 0)
+    return 0;
+
+#ifdef __linux__
+  // madvise() requires a page-aligned start address
+  uintptr_t start = (uintptr_t)ptr & ~(uintptr_t)(pgsz - 1);
+  madvise((void *)start, (uintptr_t)ptr + len - start, MADV_WILLNEED);
+#endif
+
+  /* Touch each page with a write. We read and write back the same
+   * value so that the contents are preserved. */
+  for (char *p = (char *)ptr; p < (char *)ptr + len; p += pgsz) {
+    volatile char *v = p;
+    *v = *v;
+  }
+
+  // The last page might not have been touched by the loop above
+  volatile char *last = (char *)ptr + len - 1;
+  *last = *last;
+
+  return 0;
+}
+
 struct Allocation *villas::node::memory::get_allocation(void *ptr) {
-  return allocations[ptr];
+  std::lock_guard<std::mutex> guard(allocations_mutex);
+
+  auto iter = allocations.find(ptr);
+  if (iter == allocations.end())
+    return nullptr;
+
+  return iter->second;
 }
 
 struct Type *villas::node::memory::default_type = nullptr;
@@ -105,7 +105,7 @@ static struct Allocation *mmap_alloc(size_t len, size_t alignment,
 
   if (m->flags & (int)Flags::HUGEPAGE) {
 #ifdef __linux__
-    flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+    flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE;
 #else
     flags = MAP_PRIVATE | MAP_ANONYMOUS;
 #endif
@@ -117,7 +117,12 @@ static struct Allocation *mmap_alloc(size_t len, size_t alignment,
 #endif
     sz = hugepgsz;
   } else {
+#ifdef __linux__
+    // Prefault the pages to avoid first-touch latencies during runtime
+    flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE;
+#else
     flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#endif
     fd = -1;
 
     sz = pgsz;
@@ -81,7 +81,15 @@ static void *iec61850_thread(void *ctx) {
         GooseReceiver_tick(r->goose);
         break;
       case iec61850_receiver::Type::SAMPLED_VALUES:
+        pthread_mutex_lock(&r->mutex);
+
         SVReceiver_tick(r->sv);
+
+        // All ASDUs of the frame have been decoded by now
+        for (unsigned j = 0; j < list_length(&r->nodes); j++)
+          iec61850_sv_flush((NodeCompat *)list_at(&r->nodes, j));
+
+        pthread_mutex_unlock(&r->mutex);
         break;
       }
     }
@@ -268,7 +276,9 @@ int villas::node::iec61850_receiver_destroy(struct iec61850_receiver *r) {
 
   free(r->interface);
 
-  return 0;
+  pthread_mutex_destroy(&r->mutex);
+
+  return list_destroy(&r->nodes);
 }
 
 struct iec61850_receiver *
@@ -299,6 +309,14 @@ struct iec61850_receiver *villas::node::iec61850_receiver_create(
     r->interface = strdup(intf);
     r->type = t;
 
+    int ret = list_init(&r->nodes);
+    if (ret)
+      throw RuntimeError("Failed to initialize list");
+
+    ret = pthread_mutex_init(&r->mutex, nullptr);
+    if (ret)
+      throw RuntimeError("Failed to initialize mutex");
+
     switch (r->type) {
     case iec61850_receiver::Type::GOOSE:
       r->goose = GooseReceiver_create();
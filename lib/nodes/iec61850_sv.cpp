@@ -6,6 +6,7 @@
  */
 
 #include <cstring>
+#include <endian.h>
 #include <libiec61850/sv_publisher.h>
 #include <libiec61850/sv_subscriber.h>
 #include <net/ethernet.h>
@@ -69,27 +70,230 @@ static unsigned iec61850_sv_setup_asdu(NodeCompat *n, struct Sample *smp) {
   return new_length;
 }
 
+static uint16_t iec61850_sv_load16(const uint8_t *p) {
+  uint16_t v;
+  memcpy(&v, p, sizeof(v));
+  return be16toh(v);
+}
+
+static uint32_t iec61850_sv_load32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return be32toh(v);
+}
+
+static uint64_t iec61850_sv_load64(const uint8_t *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return be64toh(v);
+}
+
+static void iec61850_sv_decode_int8(const uint8_t *p, union SignalData *d) {
+  d->i = (int8_t)p[0];
+}
+
+static void iec61850_sv_decode_int16(const uint8_t *p, union SignalData *d) {
+  d->i = (int16_t)iec61850_sv_load16(p);
+}
+
+static void iec61850_sv_decode_int32(const uint8_t *p, union SignalData *d) {
+  d->i = (int32_t)iec61850_sv_load32(p);
+}
+
+static void iec61850_sv_decode_int64(const uint8_t *p, union SignalData *d) {
+  d->i = (int64_t)iec61850_sv_load64(p);
+}
+
+static void iec61850_sv_decode_int8u(const uint8_t *p, union SignalData *d) {
+  d->i = p[0];
+}
+
+static void iec61850_sv_decode_int16u(const uint8_t *p, union SignalData *d) {
+  d->i = iec61850_sv_load16(p);
+}
+
+static void iec61850_sv_decode_int32u(const uint8_t *p, union SignalData *d) {
+  d->i = iec61850_sv_load32(p);
+}
+
+static void iec61850_sv_decode_float32(const uint8_t *p, union SignalData *d) {
+  uint32_t u = iec61850_sv_load32(p);
+  float f;
+
+  memcpy(&f, &u, sizeof(f));
+  d->f = f;
+}
+
+static void iec61850_sv_decode_float64(const uint8_t *p, union SignalData *d) {
+  uint64_t u = iec61850_sv_load64(p);
+
+  memcpy(&d->f, &u, sizeof(d->f));
+}
+
+// Values of unsupported types are skipped
+static void iec61850_sv_decode_none(const uint8_t *p, union SignalData *d) {}
+
+static iec61850_sv_field_decoder_t
+iec61850_sv_field_decoder(enum IEC61850Type t) {
+  switch (t) {
+  case IEC61850Type::INT8:
+    return iec61850_sv_decode_int8;
+
+  case IEC61850Type::INT16:
+    return iec61850_sv_decode_int16;
+
+  case IEC61850Type::INT32:
+    return iec61850_sv_decode_int32;
+
+  case IEC61850Type::INT64:
+    return iec61850_sv_decode_int64;
+
+  case IEC61850Type::INT8U:
+    return iec61850_sv_decode_int8u;
+
+  case IEC61850Type::INT16U:
+    return iec61850_sv_decode_int16u;
+
+  case IEC61850Type::INT32U:
+    return iec61850_sv_decode_int32u;
+
+  case IEC61850Type::FLOAT32:
+    return iec61850_sv_decode_float32;
+
+  case IEC61850Type::FLOAT64:
+    return iec61850_sv_decode_float64;
+
+  default:
+    return iec61850_sv_decode_none;
+  }
+}
+
+static void iec61850_sv_decode_generic(const struct iec61850_sv_layout *l,
+                                       const uint8_t *data,
+                                       union SignalData *d, unsigned cnt) {
+  for (unsigned k = 0; k < cnt; k++) {
+    auto *f = &l->fields[k];
+
+    f->decode(data + f->offset, &d[k]);
+  }
+}
+
+// Specialized decoders for layouts consisting of a single type
+template <void (*decode)(const uint8_t *, union SignalData *), unsigned size>
+static void iec61850_sv_decode_uniform(const struct iec61850_sv_layout *l,
+                                       const uint8_t *data,
+                                       union SignalData *d, unsigned cnt) {
+  for (unsigned k = 0; k < cnt; k++)
+    decode(data + k * size, &d[k]);
+}
+
+static int iec61850_sv_layout_compile(struct iec61850_sv_layout *l,
+                                      struct List *signals) {
+  l->length = list_length(signals);
+  l->size = 0;
+  l->fields = new struct iec61850_sv_field[l->length];
+  if (!l->fields)
+    throw MemoryAllocationError();
+
+  bool uniform = true;
+  enum IEC61850Type type = IEC61850Type::FLOAT32;
+
+  for (unsigned k = 0; k < l->length; k++) {
+    auto *td = (struct iec61850_type_descriptor *)list_at(signals, k);
+
+    l->fields[k].offset = l->size;
+    l->fields[k].decode = iec61850_sv_field_decoder(td->iec_type);
+
+    if (k == 0)
+      type = td->iec_type;
+    else if (td->iec_type != type)
+      uniform = false;
+
+    l->size += td->size;
+  }
+
+  l->decode = iec61850_sv_decode_generic;
+
+  if (uniform) {
+    switch (type) {
+    case IEC61850Type::INT32:
+      l->decode =
+          iec61850_sv_decode_uniform<iec61850_sv_decode_int32, sizeof(int32_t)>;
+      break;
+
+    case IEC61850Type::FLOAT32:
+      l->decode =
+          iec61850_sv_decode_uniform<iec61850_sv_decode_float32, sizeof(float)>;
+      break;
+
+    case IEC61850Type::FLOAT64:
+      l->decode = iec61850_sv_decode_uniform<iec61850_sv_decode_float64,
+                                             sizeof(double)>;
+      break;
+
+    default: {
+    }
+    }
+  }
+
+  return 0;
+}
+
+static void iec61850_sv_layout_destroy(struct iec61850_sv_layout *l) {
+  delete[] l->fields;
+
+  l->fields = nullptr;
+}
+
+// Decodes the seqData of an ASDU into a sample
+static void iec61850_sv_layout_decode(const struct iec61850_sv_layout *l,
+                                      const uint8_t *data, size_t len,
+                                      struct Sample *smp) {
+  unsigned cnt = MIN(l->length, smp->capacity);
+
+  // Truncated ASDUs are decoded up to the last complete value
+  if (len < l->size) {
+    unsigned k;
+    for (k = 0; k < cnt; k++) {
+      unsigned end = k + 1 < l->length ? l->fields[k + 1].offset : l->size;
+      if (end > len)
+        break;
+    }
+
+    cnt = k;
+
+    iec61850_sv_decode_generic(l, data, smp->data, cnt);
+  } else
+    l->decode(l, data, smp->data, cnt);
+
+  smp->length = cnt;
+  smp->flags |= (int)SampleFlags::HAS_DATA;
+}
+
 static void iec61850_sv_listener(SVSubscriber subscriber, void *ctx,
                                  SVSubscriber_ASDU asdu) {
   auto *n = (NodeCompat *)ctx;
   auto *i = n->getData<struct iec61850_sv>();
   struct Sample *smp;
 
-  const char *sv_id = SVSubscriber_ASDU_getSvId(asdu);
-  int smp_cnt = SVSubscriber_ASDU_getSmpCnt(asdu);
-  size_t data_size = (size_t)SVSubscriber_ASDU_getDataSize(asdu);
-
-  n->logger->debug("Received sample: sv_id={}, smp_cnt={}", sv_id, smp_cnt);
-
-  smp = sample_alloc(&i->in.pool);
-  if (!smp) {
-    n->logger->warn("Pool underrun in subscriber");
-    return;
+  // Samples are usually pre-allocated by the last flush
+  if (i->in.batch_used == i->in.batch_allocated) {
+    int allocated = sample_alloc_many(
+        &i->in.pool, i->in.batch + i->in.batch_allocated,
+        IEC61850_SV_MAX_BATCH - i->in.batch_allocated);
+    if (allocated > 0)
+      i->in.batch_allocated += allocated;
+
+    if (i->in.batch_used == i->in.batch_allocated) {
+      n->logger->warn("Pool underrun in subscriber");
+      return;
+    }
   }
 
-  smp->sequence = smp_cnt;
-  smp->flags = (int)SampleFlags::HAS_SEQUENCE | (int)SampleFlags::HAS_DATA;
-  smp->length = 0;
+  smp = i->in.batch[i->in.batch_used++];
+
+  smp->sequence = SVSubscriber_ASDU_getSmpCnt(asdu);
+  smp->flags = (int)SampleFlags::HAS_SEQUENCE;
   smp->signals = n->getInputSignals(false);
 
   if (SVSubscriber_ASDU_hasRefrTm(asdu)) {
@@ -100,60 +304,443 @@ static void iec61850_sv_listener(SVSubscriber subscriber, void *ctx,
     smp->flags |= (int)SampleFlags::HAS_TS_ORIGIN;
   }
 
-  for (size_t j = 0, off = 0;
-       j < MIN(list_length(&i->in.signals), smp->capacity) &&
-       off < MIN(i->in.total_size, data_size);
-       j++) {
-    struct iec61850_type_descriptor *td =
-        (struct iec61850_type_descriptor *)list_at(&i->in.signals, j);
-    auto sig = smp->signals->getByIndex(j);
-    if (!sig)
-      continue;
+  iec61850_sv_layout_decode(&i->in.layout, asdu->dataBuffer,
+                            MAX(asdu->dataBufferLength, 0), smp);
+}
 
-    switch (td->iec_type) {
-    case IEC61850Type::INT8:
-      smp->data[j].i = SVSubscriber_ASDU_getINT8(asdu, off);
-      break;
+void villas::node::iec61850_sv_flush(NodeCompat *n) {
+  auto *i = n->getData<struct iec61850_sv>();
+  unsigned used = i->in.batch_used;
 
-    case IEC61850Type::INT16:
-      smp->data[j].i = SVSubscriber_ASDU_getINT16(asdu, off);
-      break;
+  if (used > 0) {
+    int pushed = queue_signalled_push_many(&i->in.queue,
+                                           (void **)i->in.batch, used);
+    if (pushed < 0)
+      pushed = 0;
 
-    case IEC61850Type::INT32:
-      smp->data[j].i = SVSubscriber_ASDU_getINT32(asdu, off);
-      break;
+    if ((unsigned)pushed < used) {
+      n->logger->warn("Queue overrun in subscriber: dropped {} samples",
+                      used - pushed);
+
+      sample_decref_many(i->in.batch + pushed, used - pushed);
+    }
+
+    // Move remaining pre-allocated samples to the front
+    memmove(i->in.batch, i->in.batch + used,
+            (i->in.batch_allocated - used) * sizeof(struct Sample *));
+
+    i->in.batch_allocated -= used;
+    i->in.batch_used = 0;
+  }
+
+  // Pre-allocate samples for the next frame
+  if (i->in.batch_allocated < IEC61850_SV_MAX_BATCH) {
+    int allocated = sample_alloc_many(
+        &i->in.pool, i->in.batch + i->in.batch_allocated,
+        IEC61850_SV_MAX_BATCH - i->in.batch_allocated);
+    if (allocated > 0)
+      i->in.batch_allocated += allocated;
+  }
+}
+
+static bool iec61850_sv_xdp_enabled(struct iec61850_sv *i) {
+#ifdef WITH_IEC61850_SV_XDP
+  return i->xdp.enabled;
+#else
+  return false;
+#endif // WITH_IEC61850_SV_XDP
+}
+
+#ifdef WITH_IEC61850_SV_XDP
+#define ETH_HDR_LEN 14
+#define ETH_VLAN_TAG_LEN 4
+#define ETH_P_SV 0x88BA
+#define SV_HDR_LEN 8 // APPID, length and two reserved fields.
+
+// Returns the value of a BER tag-length pair and advances the pointer
+static const uint8_t *ber_decode_header(const uint8_t *p, const uint8_t *end,
+                                        uint8_t *tag, size_t *len) {
+  if (end - p < 2)
+    return nullptr;
+
+  *tag = *p++;
+
+  if (*p < 0x80)
+    *len = *p++;
+  else if (*p == 0x81 && end - p >= 2) {
+    *len = p[1];
+    p += 2;
+  } else if (*p == 0x82 && end - p >= 3) {
+    *len = (p[1] << 8) | p[2];
+    p += 3;
+  } else
+    return nullptr;
+
+  if ((size_t)(end - p) < *len)
+    return nullptr;
+
+  return p;
+}
+
+static size_t ber_header_size(size_t len) {
+  return len < 0x80 ? 2 : len < 0x100 ? 3 : 4;
+}
+
+static uint8_t *ber_encode_header(uint8_t *p, uint8_t tag, size_t len) {
+  *p++ = tag;
+
+  if (len < 0x80)
+    *p++ = len;
+  else if (len < 0x100) {
+    *p++ = 0x81;
+    *p++ = len;
+  } else {
+    *p++ = 0x82;
+    *p++ = len >> 8;
+    *p++ = len;
+  }
+
+  return p;
+}
+
+static uint8_t *ber_encode_uint(uint8_t *p, uint8_t tag, uint32_t value,
+                                unsigned size) {
+  p = ber_encode_header(p, tag, size);
+
+  for (unsigned k = size; k > 0; k--)
+    *p++ = value >> ((k - 1) * 8);
+
+  return p;
+}
+
+static uint64_t iec61850_sv_decode_uint(const uint8_t *p, unsigned size) {
+  uint64_t value = 0;
+
+  for (unsigned k = 0; k < size; k++)
+    value = (value << 8) | p[k];
+
+  return value;
+}
+
+static void iec61850_sv_encode_value(uint8_t *p,
+                                     const struct iec61850_type_descriptor *td,
+                                     const union SignalData *data) {
+  uint64_t raw;
+
+  switch (td->iec_type) {
+  case IEC61850Type::BOOLEAN:
+    raw = data->b;
+    break;
+
+  case IEC61850Type::FLOAT32: {
+    float f = data->f;
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    raw = u;
+    break;
+  }
+
+  case IEC61850Type::FLOAT64:
+    memcpy(&raw, &data->f, sizeof(raw));
+    break;
+
+  default:
+    raw = data->i;
+  }
+
+  for (unsigned k = td->size; k > 0; k--)
+    *p++ = raw >> ((k - 1) * 8);
+}
+
+// Decodes a single ASDU of a received savPdu into a sample
+static void iec61850_sv_xdp_decode_asdu(NodeCompat *n, const uint8_t *p,
+                                        const uint8_t *end,
+                                        struct Sample *smp) {
+  auto *i = n->getData<struct iec61850_sv>();
+
+  uint8_t tag;
+  size_t len;
+
+  smp->flags = 0;
+  smp->length = 0;
+  smp->signals = n->getInputSignals(false);
 
-    case IEC61850Type::INT8U:
-      smp->data[j].i = SVSubscriber_ASDU_getINT8U(asdu, off);
+  while (p < end && (p = ber_decode_header(p, end, &tag, &len))) {
+    switch (tag) {
+    case 0x82: // smpCnt
+      smp->sequence = iec61850_sv_decode_uint(p, len);
+      smp->flags |= (int)SampleFlags::HAS_SEQUENCE;
       break;
 
-    case IEC61850Type::INT16U:
-      smp->data[j].i = SVSubscriber_ASDU_getINT16U(asdu, off);
+    case 0x84: // refrTm
+      if (len == 8) {
+        uint64_t frac = iec61850_sv_decode_uint(p + 4, 3);
+
+        smp->ts.origin.tv_sec = iec61850_sv_decode_uint(p, 4);
+        smp->ts.origin.tv_nsec = (frac * 1000000000) >> 24;
+        smp->flags |= (int)SampleFlags::HAS_TS_ORIGIN;
+      }
       break;
 
-    case IEC61850Type::INT32U:
-      smp->data[j].i = SVSubscriber_ASDU_getINT32U(asdu, off);
+    case 0x87: // seqData
+      iec61850_sv_layout_decode(&i->in.layout, p, len, smp);
       break;
+    }
+
+    p += len;
+  }
+}
+
+// Returns the number of ASDUs of a frame which have been decoded
+static unsigned iec61850_sv_xdp_decode(NodeCompat *n, const uint8_t *frame,
+                                       size_t frame_len,
+                                       struct Sample *const smps[],
+                                       unsigned cnt) {
+  auto *i = n->getData<struct iec61850_sv>();
+
+  const uint8_t *p = frame, *end = frame + frame_len;
+  unsigned decoded = 0;
+
+  uint8_t tag;
+  size_t len;
+
+  if (frame_len < ETH_HDR_LEN + SV_HDR_LEN)
+    return 0;
+
+  if (i->in.check_dst_address &&
+      memcmp(frame, i->dst_address.ether_addr_octet, ETHER_ADDR_LEN))
+    return 0;
+
+  p += 2 * ETH_ALEN;
+
+  // Skip an IEEE 802.1Q tag
+  if (iec61850_sv_decode_uint(p, 2) == ETHERTYPE_VLAN)
+    p += ETH_VLAN_TAG_LEN;
+
+  // All frames of the queue end up here, not only sampled values
+  if (iec61850_sv_decode_uint(p, 2) != ETH_P_SV)
+    return 0;
+
+  p += 2;
+
+  if (end - p < SV_HDR_LEN ||
+      iec61850_sv_decode_uint(p, 2) != (unsigned)i->app_id)
+    return 0;
+
+  p += SV_HDR_LEN;
+
+  // savPdu
+  p = ber_decode_header(p, end, &tag, &len);
+  if (!p || tag != 0x60)
+    return 0;
+
+  end = p + len;
+
+  while (p < end && (p = ber_decode_header(p, end, &tag, &len))) {
+    // seqASDU
+    if (tag == 0xA2) {
+      const uint8_t *q = p, *qend = p + len;
+      size_t asdu_len;
+
+      while (q < qend && (q = ber_decode_header(q, qend, &tag, &asdu_len))) {
+        if (tag == 0x30) {
+          if (decoded < cnt)
+            iec61850_sv_xdp_decode_asdu(n, q, q + asdu_len, smps[decoded++]);
+          else
+            n->logger->warn("Dropped ASDU as read buffer is full");
+        }
+
+        q += asdu_len;
+      }
+    }
+
+    p += len;
+  }
+
+  return decoded;
+}
+
+static int iec61850_sv_xdp_read(NodeCompat *n, struct Sample *const smps[],
+                                unsigned cnt) {
+  auto *i = n->getData<struct iec61850_sv>();
+
+  unsigned decoded = 0;
+
+  while (decoded < cnt &&
+         i->xdp_ep->receive(1, [&](const uint8_t *frame, size_t len) {
+           decoded += iec61850_sv_xdp_decode(n, frame, len, smps + decoded,
+                                             cnt - decoded);
+         }) > 0)
+    ;
 
+  return decoded;
+}
+
+// Encodes a sample as a savPdu with a single ASDU into an Ethernet frame
+static size_t iec61850_sv_xdp_encode(NodeCompat *n, uint8_t *frame,
+                                     size_t frame_len, struct Sample *smp) {
+  auto *i = n->getData<struct iec61850_sv>();
+
+  auto sv_id = i->out.sv_id ? i->out.sv_id : "";
+  auto dat_set = n->getNameShort();
+
+  size_t sv_id_len = strlen(sv_id);
+
+  unsigned values = MIN(smp->length, list_length(&i->out.signals));
+  size_t data_len = 0;
+  for (unsigned k = 0; k < values; k++) {
+    auto *td = (struct iec61850_type_descriptor *)list_at(&i->out.signals, k);
+
+    data_len += td->size;
+  }
+
+  // Calculate lengths from the inside out
+  size_t asdu_len = ber_header_size(sv_id_len) + sv_id_len +
+                    ber_header_size(dat_set.size()) + dat_set.size() + 4 + 6 +
+                    3 + ber_header_size(data_len) + data_len;
+
+  if (smp->flags & (int)SampleFlags::HAS_TS_ORIGIN)
+    asdu_len += 10;
+
+  if (i->out.smp_rate >= 0)
+    asdu_len += 4;
+
+  if (i->out.smp_mod >= 0)
+    asdu_len += 4;
+
+  size_t seq_len = ber_header_size(asdu_len) + asdu_len;
+  size_t pdu_len = 3 + ber_header_size(seq_len) + seq_len;
+  size_t sv_len = SV_HDR_LEN + ber_header_size(pdu_len) + pdu_len;
+  size_t hdr_len =
+      ETH_HDR_LEN + (i->out.vlan.enabled ? ETH_VLAN_TAG_LEN : 0);
+
+  if (hdr_len + sv_len > frame_len)
+    return 0;
+
+  uint8_t *p = frame;
+
+  memcpy(p, i->dst_address.ether_addr_octet, ETH_ALEN);
+  memcpy(p + ETH_ALEN, i->xdp_ep->getAddress(), ETH_ALEN);
+  p += 2 * ETH_ALEN;
+
+  if (i->out.vlan.enabled) {
+    uint16_t tci = (i->out.vlan.priority << 13) | (i->out.vlan.id & 0xFFF);
+
+    *p++ = ETHERTYPE_VLAN >> 8;
+    *p++ = ETHERTYPE_VLAN & 0xFF;
+    *p++ = tci >> 8;
+    *p++ = tci;
+  }
+
+  *p++ = ETH_P_SV >> 8;
+  *p++ = ETH_P_SV & 0xFF;
+
+  // APPID, length, reserved 1 and 2
+  *p++ = i->app_id >> 8;
+  *p++ = i->app_id;
+  *p++ = sv_len >> 8;
+  *p++ = sv_len;
+  memset(p, 0, 4);
+  p += 4;
+
+  p = ber_encode_header(p, 0x60, pdu_len);
+  p = ber_encode_uint(p, 0x80, 1, 1); // noASDU
+  p = ber_encode_header(p, 0xA2, seq_len);
+  p = ber_encode_header(p, 0x30, asdu_len);
+
+  p = ber_encode_header(p, 0x80, sv_id_len);
+  memcpy(p, sv_id, sv_id_len);
+  p += sv_id_len;
+
+  p = ber_encode_header(p, 0x81, dat_set.size());
+  memcpy(p, dat_set.c_str(), dat_set.size());
+  p += dat_set.size();
+
+  p = ber_encode_uint(
+      p, 0x82,
+      smp->flags & (int)SampleFlags::HAS_SEQUENCE ? smp->sequence : 0, 2);
+  p = ber_encode_uint(p, 0x83, i->out.conf_rev, 4);
+
+  if (smp->flags & (int)SampleFlags::HAS_TS_ORIGIN) {
+    uint32_t frac = ((uint64_t)smp->ts.origin.tv_nsec << 24) / 1000000000;
+
+    p = ber_encode_header(p, 0x84, 8);
+    for (unsigned k = 4; k > 0; k--)
+      *p++ = smp->ts.origin.tv_sec >> ((k - 1) * 8);
+    *p++ = frac >> 16;
+    *p++ = frac >> 8;
+    *p++ = frac;
+    *p++ = 0; // Time quality
+  }
+
+  p = ber_encode_uint(p, 0x85, MAX(i->out.smp_synch, 0), 1);
+
+  if (i->out.smp_rate >= 0)
+    p = ber_encode_uint(p, 0x86, i->out.smp_rate, 2);
+
+  p = ber_encode_header(p, 0x87, data_len);
+  for (unsigned k = 0; k < values; k++) {
+    auto *td = (struct iec61850_type_descriptor *)list_at(&i->out.signals, k);
+    auto sig = smp->signals->getByIndex(k);
+
+    SignalData data = smp->data[k];
+
+    switch (td->iec_type) {
     case IEC61850Type::FLOAT32:
-      smp->data[j].f = SVSubscriber_ASDU_getFLOAT32(asdu, off);
+    case IEC61850Type::FLOAT64:
+      data = smp->data[k].cast(sig->type, SignalType::FLOAT);
       break;
 
-    case IEC61850Type::FLOAT64:
-      smp->data[j].f = SVSubscriber_ASDU_getFLOAT64(asdu, off);
+    case IEC61850Type::BOOLEAN:
+      data = smp->data[k].cast(sig->type, SignalType::BOOLEAN);
       break;
 
-    default: {
+    default:
+      data = smp->data[k].cast(sig->type, SignalType::INTEGER);
+    }
+
+    iec61850_sv_encode_value(p, td, &data);
+    p += td->size;
+  }
+
+  if (i->out.smp_mod >= 0)
+    p = ber_encode_uint(p, 0x88, i->out.smp_mod, 2);
+
+  return p - frame;
+}
+
+static int iec61850_sv_xdp_write(NodeCompat *n, struct Sample *const smps[],
+                                 unsigned cnt) {
+  auto *i = n->getData<struct iec61850_sv>();
+  auto &tx = i->xdp_ep->getTx();
+
+  unsigned sent;
+  for (sent = 0; sent < cnt; sent++) {
+    uint8_t *frame = tx.reserve();
+    if (!frame) {
+      n->logger->warn("No free AF_XDP frames left for sending");
+      break;
     }
+
+    size_t len =
+        iec61850_sv_xdp_encode(n, frame, i->xdp_ep->getFrameSize(), smps[sent]);
+    if (len == 0) {
+      n->logger->warn("Sample does not fit into a single frame");
+      break;
     }
 
-    off += td->size;
-    smp->length++;
+    if (tx.submit(len)) {
+      n->logger->warn("AF_XDP transmit ring is full");
+      break;
+    }
   }
 
-  int pushed __attribute__((unused));
-  pushed = queue_signalled_push(&i->in.queue, smp);
+  // Kick the kernel once per batch
+  tx.flush();
+
+  return sent;
 }
+#endif // WITH_IEC61850_SV_XDP
 
 int villas::node::iec61850_sv_parse(NodeCompat *n, json_t *json) {
   int ret;
@@ -171,15 +758,25 @@ int villas::node::iec61850_sv_parse(NodeCompat *n, json_t *json) {
   json_t *json_out = nullptr;
   json_t *json_signals = nullptr;
   json_t *json_vlan = nullptr;
+  json_t *json_xdp = nullptr;
   json_error_t err;
 
-  ret =
-      json_unpack_ex(json, &err, 0, "{ s?: o, s?: o, s: s, s?: i, s?: s }",
-                     "out", &json_out, "in", &json_in, "interface", &interface,
-                     "app_id", &i->app_id, "dst_address", &dst_address);
+  ret = json_unpack_ex(
+      json, &err, 0, "{ s?: o, s?: o, s: s, s?: i, s?: s, s?: o }", "out",
+      &json_out, "in", &json_in, "interface", &interface, "app_id", &i->app_id,
+      "dst_address", &dst_address, "xdp", &json_xdp);
   if (ret)
     throw ConfigError(json, err, "node-config-node-iec61850-sv");
 
+  if (json_xdp) {
+#ifdef WITH_IEC61850_SV_XDP
+    xdp::parse(json_xdp, &i->xdp);
+#else
+    throw ConfigError(json_xdp, "node-config-node-iec61850-sv-xdp",
+                      "This build has no AF_XDP support");
+#endif // WITH_IEC61850_SV_XDP
+  }
+
   if (interface)
     i->interface = strdup(interface);
 
@@ -279,6 +876,11 @@ char *villas::node::iec61850_sv_print(NodeCompat *n) {
   buf = strf("interface=%s, app_id=%#x, dst_address=%s", i->interface,
              i->app_id, ether_ntoa(&i->dst_address));
 
+#ifdef WITH_IEC61850_SV_XDP
+  if (i->xdp.enabled)
+    strcatf(&buf, ", xdp.queues=%u", i->xdp.num_queues);
+#endif // WITH_IEC61850_SV_XDP
+
   // Publisher part
   if (i->out.enabled) {
     strcatf(&buf, ", out.sv_id=%s, out.conf_rev=%d", i->out.sv_id,
@@ -306,8 +908,13 @@ int villas::node::iec61850_sv_start(NodeCompat *n) {
   int ret;
   auto *i = n->getData<struct iec61850_sv>();
 
+#ifdef WITH_IEC61850_SV_XDP
+  if (i->xdp.enabled)
+    i->xdp_ep = new xdp::Endpoint(i->interface, &i->xdp);
+#endif // WITH_IEC61850_SV_XDP
+
   // Initialize publisher
-  if (i->out.enabled) {
+  if (i->out.enabled && !iec61850_sv_xdp_enabled(i)) {
     CommParameters comm_params = {.vlanPriority = uint8_t(i->out.vlan.priority),
                                   .vlanId = uint16_t(i->out.vlan.id),
                                   .appId = uint16_t(i->app_id)};
@@ -323,8 +930,27 @@ int villas::node::iec61850_sv_start(NodeCompat *n) {
                             n->getNameShort().c_str(), i->out.conf_rev);
   }
 
-  // Start subscriber
   if (i->in.enabled) {
+    ret = iec61850_sv_layout_compile(&i->in.layout, &i->in.signals);
+    if (ret)
+      return ret;
+  }
+
+  // Start subscriber
+  if (i->in.enabled && !iec61850_sv_xdp_enabled(i)) {
+    // Initialize pool and queue to pass samples between threads
+    ret = pool_init(&i->in.pool, 1024,
+                    SAMPLE_LENGTH(n->getInputSignals(false)->size()));
+    if (ret)
+      return ret;
+
+    ret = queue_signalled_init(&i->in.queue, 1024);
+    if (ret)
+      return ret;
+
+    i->in.batch_allocated = 0;
+    i->in.batch_used = 0;
+
     struct iec61850_receiver *r =
         iec61850_receiver_create(iec61850_receiver::Type::SAMPLED_VALUES,
                                  i->interface, i->in.check_dst_address);
@@ -335,19 +961,18 @@ int villas::node::iec61850_sv_start(NodeCompat *n) {
     // Install a callback handler for the subscriber
     SVSubscriber_setListener(i->in.subscriber, iec61850_sv_listener, n);
 
+    pthread_mutex_lock(&r->mutex);
+
+    // The receiver flushes our batch of samples after each frame
+    list_push(&r->nodes, n);
+
     // Connect the subscriber to the receiver
     SVReceiver_addSubscriber(i->in.receiver, i->in.subscriber);
 
-    // Initialize pool and queue to pass samples between threads
-    ret = pool_init(&i->in.pool, 1024,
-                    SAMPLE_LENGTH(n->getInputSignals(false)->size()));
-    if (ret)
-      return ret;
-
-    ret = queue_signalled_init(&i->in.queue, 1024);
-    if (ret)
-      return ret;
+    pthread_mutex_unlock(&r->mutex);
+  }
 
+  if (i->in.enabled) {
     for (unsigned k = 0; k < list_length(&i->in.signals); k++) {
       struct iec61850_type_descriptor *td =
           (struct iec61850_type_descriptor *)list_at(&i->in.signals, k);
@@ -367,8 +992,42 @@ int villas::node::iec61850_sv_stop(NodeCompat *n) {
   int ret;
   auto *i = n->getData<struct iec61850_sv>();
 
-  if (i->in.enabled)
+#ifdef WITH_IEC61850_SV_XDP
+  if (i->xdp.enabled) {
+    delete i->xdp_ep;
+    i->xdp_ep = nullptr;
+
+    if (i->in.enabled)
+      iec61850_sv_layout_destroy(&i->in.layout);
+
+    return 0;
+  }
+#endif // WITH_IEC61850_SV_XDP
+
+  if (i->in.enabled) {
+    auto *r = iec61850_receiver_lookup(iec61850_receiver::Type::SAMPLED_VALUES,
+                                       i->interface);
+
+    /* Once the subscriber and the node are removed under the lock, the
+     * receiver thread does not touch the layout and the batch anymore. */
+    pthread_mutex_lock(&r->mutex);
+
     SVReceiver_removeSubscriber(i->in.receiver, i->in.subscriber);
+    list_remove_all(&r->nodes, n);
+
+    pthread_mutex_unlock(&r->mutex);
+
+    SVSubscriber_destroy(i->in.subscriber);
+    i->in.subscriber = nullptr;
+
+    iec61850_sv_layout_destroy(&i->in.layout);
+
+    // Return pre-allocated samples to the pool
+    sample_decref_many(i->in.batch, i->in.batch_allocated);
+
+    i->in.batch_allocated = 0;
+    i->in.batch_used = 0;
+  }
 
   ret = queue_signalled_close(&i->in.queue);
   if (ret)
@@ -400,6 +1059,11 @@ int villas::node::iec61850_sv_init(NodeCompat *n) {
 
   i->out.asdu_length = 0;
 
+#ifdef WITH_IEC61850_SV_XDP
+  i->xdp.enabled = false;
+  i->xdp_ep = nullptr;
+#endif // WITH_IEC61850_SV_XDP
+
   return 0;
 }
 
@@ -412,7 +1076,7 @@ int villas::node::iec61850_sv_destroy(NodeCompat *n) {
     SVPublisher_destroy(i->out.publisher);
 
   // Deinitialize subscriber
-  if (i->in.enabled) {
+  if (i->in.enabled && !iec61850_sv_xdp_enabled(i)) {
     ret = queue_signalled_destroy(&i->in.queue);
     if (ret)
       return ret;
@@ -434,6 +1098,11 @@ int villas::node::iec61850_sv_read(NodeCompat *n, struct Sample *const smps[],
   if (!i->in.enabled)
     return -1;
 
+#ifdef WITH_IEC61850_SV_XDP
+  if (i->xdp_ep)
+    return iec61850_sv_xdp_read(n, smps, cnt);
+#endif // WITH_IEC61850_SV_XDP
+
   pulled = queue_signalled_pull_many(&i->in.queue, (void **)smpt, cnt);
 
   sample_copy_many(smps, smpt, pulled);
@@ -449,6 +1118,11 @@ int villas::node::iec61850_sv_write(NodeCompat *n, struct Sample *const smps[],
   if (!i->out.enabled)
     return -1;
 
+#ifdef WITH_IEC61850_SV_XDP
+  if (i->xdp_ep)
+    return iec61850_sv_xdp_write(n, smps, cnt);
+#endif // WITH_IEC61850_SV_XDP
+
   for (unsigned j = 0; j < cnt; j++) {
     auto *smp = smps[j];
 
@@ -538,6 +1212,11 @@ int villas::node::iec61850_sv_write(NodeCompat *n, struct Sample *const smps[],
 int villas::node::iec61850_sv_poll_fds(NodeCompat *n, int fds[]) {
   auto *i = n->getData<struct iec61850_sv>();
 
+#ifdef WITH_IEC61850_SV_XDP
+  if (i->xdp_ep)
+    return i->xdp_ep->getFDs(fds);
+#endif // WITH_IEC61850_SV_XDP
+
   fds[0] = queue_signalled_fd(&i->in.queue);
 
   return 1;
@@ -7,6 +7,8 @@
 
 #include <cinttypes>
 #include <cstring>
+#include <fmt/format.h>
+#include <iterator>
 #include <netdb.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -18,12 +20,17 @@
 #include <villas/nodes/influxdb.hpp>
 #include <villas/sample.hpp>
 #include <villas/signal.hpp>
+#include <villas/stats.hpp>
 #include <villas/utils.hpp>
 
 using namespace villas;
 using namespace villas::node;
 using namespace villas::utils;
 
+#define DEFAULT_INFLUXDB_BATCH_SIZE 1000
+#define DEFAULT_INFLUXDB_MAX_LATENCY 0.1
+#define DEFAULT_INFLUXDB_MAX_IN_FLIGHT 4
+
 int villas::node::influxdb_parse(NodeCompat *n, json_t *json) {
   auto *i = n->getData<struct influxdb>();
 
@@ -31,19 +38,45 @@ int villas::node::influxdb_parse(NodeCompat *n, json_t *json) {
   int ret;
 
   char *tmp, *host, *port, *lasts;
-  const char *server, *key;
-
-  ret = json_unpack_ex(json, &err, 0, "{ s: s, s: s }", "server", &server,
-                       "key", &key);
+  const char *server, *key, *token = nullptr;
+
+  i->batch_size = DEFAULT_INFLUXDB_BATCH_SIZE;
+  i->max_latency = DEFAULT_INFLUXDB_MAX_LATENCY;
+  i->max_in_flight = DEFAULT_INFLUXDB_MAX_IN_FLIGHT;
+  i->timeout = 1;
+  i->ssl_verify = 1;
+
+  ret = json_unpack_ex(json, &err, 0,
+                       "{ s: s, s: s, s?: s, s?: i, s?: F, s?: i, s?: F, s?: b }",
+                       "server", &server, "key", &key, "token", &token,
+                       "batch_size", &i->batch_size, "max_latency",
+                       &i->max_latency, "max_in_flight", &i->max_in_flight,
+                       "timeout", &i->timeout, "ssl_verify", &i->ssl_verify);
   if (ret)
     throw ConfigError(json, err, "node-config-node-influx");
 
+  if (i->batch_size <= 0)
+    throw ConfigError(json, "node-config-node-influx-batch-size",
+                      "Setting 'batch_size' must be positive");
+
+  if (i->max_in_flight <= 0)
+    throw ConfigError(json, "node-config-node-influx-max-in-flight",
+                      "Setting 'max_in_flight' must be positive");
+
+  i->key = strdup(key);
+  i->token = token ? strdup(token) : nullptr;
+
+  // Use the HTTP API if the server is given as an URL
+  if (!strncmp(server, "http://", 7) || !strncmp(server, "https://", 8)) {
+    i->url = strdup(server);
+    return 0;
+  }
+
   tmp = strdup(server);
 
   host = strtok_r(tmp, ":", &lasts);
   port = strtok_r(nullptr, "", &lasts);
 
-  i->key = strdup(key);
   i->host = strdup(host);
   i->port = strdup(port ? port : "8089");
 
@@ -58,6 +91,26 @@ int villas::node::influxdb_open(NodeCompat *n) {
 
   struct addrinfo hints, *servinfo, *p;
 
+  if (i->url) {
+    HttpClient::Options opts;
+
+    opts.batch_size = i->batch_size;
+    opts.max_latency = i->max_latency;
+    opts.max_in_flight = i->max_in_flight;
+    opts.timeout = i->timeout;
+    opts.ssl_verify = i->ssl_verify;
+
+    i->http = new HttpClient(i->url, opts, n->logger);
+
+    i->http->addHeader("Content-Type: text/plain; charset=utf-8");
+    if (i->token)
+      i->http->addHeader(fmt::format("Authorization: Token {}", i->token));
+
+    i->http->start();
+
+    return 0;
+  }
+
   memset(&hints, 0, sizeof hints);
   hints.ai_family = AF_UNSPEC;
   hints.ai_socktype = SOCK_DGRAM;
@@ -89,7 +142,13 @@ int villas::node::influxdb_open(NodeCompat *n) {
 int villas::node::influxdb_close(NodeCompat *n) {
   auto *i = n->getData<struct influxdb>();
 
-  close(i->sd);
+  if (i->http) {
+    i->http->stop();
+
+    delete i->http;
+    i->http = nullptr;
+  } else
+    close(i->sd);
 
   if (i->host)
     free(i->host);
@@ -97,77 +156,108 @@ int villas::node::influxdb_close(NodeCompat *n) {
     free(i->port);
   if (i->key)
     free(i->key);
+  if (i->url)
+    free(i->url);
+  if (i->token)
+    free(i->token);
+
+  return 0;
+}
+
+// Appends a sample in the InfluxDB line protocol
+static int influxdb_format(NodeCompat *n, std::string &buf,
+                           const struct Sample *smp) {
+  auto *i = n->getData<struct influxdb>();
+  auto out = std::back_inserter(buf);
+
+  // Key
+  buf += i->key;
+
+  // Fields
+  for (unsigned j = 0; j < smp->length; j++) {
+    const auto *data = &smp->data[j];
+    auto sig = smp->signals->getByIndex(j);
+    if (!sig)
+      return -1;
+
+    if (sig->type != SignalType::BOOLEAN && sig->type != SignalType::FLOAT &&
+        sig->type != SignalType::INTEGER && sig->type != SignalType::COMPLEX) {
+      n->logger->warn("Unsupported signal format. Skipping");
+      continue;
+    }
+
+    buf += j == 0 ? ' ' : ',';
+
+    switch (sig->type) {
+    case SignalType::COMPLEX:
+      fmt::format_to(out, "{}_re={:f},{}_im={:f}", sig->name,
+                     std::real(data->z), sig->name, std::imag(data->z));
+      break;
+
+    case SignalType::BOOLEAN:
+      fmt::format_to(out, "{}={}", sig->name, data->b ? "true" : "false");
+      break;
+
+    case SignalType::FLOAT:
+      fmt::format_to(out, "{}={:f}", sig->name, data->f);
+      break;
+
+    case SignalType::INTEGER:
+      fmt::format_to(out, "{}={}", sig->name, data->i);
+      break;
+
+    default: {
+    }
+    }
+  }
+
+  // Timestamp
+  fmt::format_to(out, " {}{:09}\n", (long long)smp->ts.origin.tv_sec,
+                 (long long)smp->ts.origin.tv_nsec);
 
   return 0;
 }
 
 int villas::node::influxdb_write(NodeCompat *n, struct Sample *const smps[],
                                  unsigned cnt) {
+  int ret;
   auto *i = n->getData<struct influxdb>();
 
-  char *buf = strf("");
-  ssize_t sentlen, buflen;
+  std::string buf;
+  ssize_t sentlen;
 
   for (unsigned k = 0; k < cnt; k++) {
-    const struct Sample *smp = smps[k];
-
-    // Key
-    strcatf(&buf, "%s", i->key);
-
-    // Fields
-    for (unsigned j = 0; j < smp->length; j++) {
-      const auto *data = &smp->data[j];
-      auto sig = smp->signals->getByIndex(j);
-      if (!sig)
-        return -1;
-
-      if (sig->type != SignalType::BOOLEAN && sig->type != SignalType::FLOAT &&
-          sig->type != SignalType::INTEGER &&
-          sig->type != SignalType::COMPLEX) {
-        n->logger->warn("Unsupported signal format. Skipping");
-        continue;
-      }
-
-      strcatf(&buf, "%c", j == 0 ? ' ' : ',');
-      if (sig->type == SignalType::COMPLEX) {
-        strcatf(&buf, "%s_re=%f, %s_im=%f", sig->name.c_str(),
-                std::real(data->z), sig->name.c_str(), std::imag(data->z));
-      } else {
-        strcatf(&buf, "%s=", sig->name.c_str());
-
-        switch (sig->type) {
-        case SignalType::BOOLEAN:
-          strcatf(&buf, "%s", data->b ? "true" : "false");
-          break;
-
-        case SignalType::FLOAT:
-          strcatf(&buf, "%f", data->f);
-          break;
-
-        case SignalType::INTEGER:
-          strcatf(&buf, "%" PRIi64, data->i);
-          break;
-
-        default: {
-        }
-        }
-      }
+    ret = influxdb_format(n, buf, smps[k]);
+    if (ret)
+      return ret;
+  }
+
+  // Batches are joined and sent by the background thread of the client
+  if (i->http) {
+    if (!i->http->push(buf, cnt))
+      n->logger->warn("Server is too slow. Dropping oldest batch");
+
+    // Statistics are only updated here as the client completes in background
+    auto stats = n->getStats();
+    if (stats) {
+      std::vector<double> latencies;
+      i->http->takeLatencies(latencies);
+
+      for (auto latency : latencies)
+        stats->update(Stats::Metric::DELIVERY_LATENCY, latency);
+
+      stats->update(Stats::Metric::IN_FLIGHT, i->http->getInFlight());
     }
 
-    // Timestamp
-    strcatf(&buf, " %lld%09lld\n", (long long)smp->ts.origin.tv_sec,
-            (long long)smp->ts.origin.tv_nsec);
+    return cnt;
   }
 
-  buflen = strlen(buf) + 1;
-  sentlen = send(i->sd, buf, buflen, 0);
+  sentlen = send(i->sd, buf.c_str(), buf.size() + 1, 0);
   if (sentlen < 0)
     return -1;
-  else if (sentlen < buflen)
+  else if (sentlen < (ssize_t)buf.size() + 1)
     n->logger->warn("Partial sent");
 
-  free(buf);
-
   return cnt;
 }
 
@@ -175,7 +265,13 @@ char *villas::node::influxdb_print(NodeCompat *n) {
   auto *i = n->getData<struct influxdb>();
   char *buf = nullptr;
 
-  strcatf(&buf, "host=%s, port=%s, key=%s", i->host, i->port, i->key);
+  if (i->url)
+    strcatf(&buf,
+            "url=%s, key=%s, batch_size=%d, max_latency=%.3f, "
+            "max_in_flight=%d",
+            i->url, i->key, i->batch_size, i->max_latency, i->max_in_flight);
+  else
+    strcatf(&buf, "host=%s, port=%s, key=%s", i->host, i->port, i->key);
 
   return buf;
 }
@@ -12,6 +12,7 @@
 #include <villas/exceptions.hpp>
 #include <villas/node_compat.hpp>
 #include <villas/nodes/kafka.hpp>
+#include <villas/stats.hpp>
 #include <villas/utils.hpp>
 
 using namespace villas;
@@ -50,38 +51,89 @@ static void kafka_logger_cb(const rd_kafka_t *rk, int level, const char *fac,
   }
 }
 
-static void kafka_message_cb(void *ctx, const rd_kafka_message_t *msg) {
-  int ret;
-  auto *n = (NodeCompat *)ctx;
-  auto *k = n->getData<struct kafka>();
-  struct Sample *smps[n->in.vectorize];
-
-  n->logger->debug("Received a message of {} bytes from broker {}", msg->len,
-                   k->server);
+static void kafka_delivery_cb(rd_kafka_t *rk, const rd_kafka_message_t *msg,
+                              void *opaque) {
+  auto *n = (NodeCompat *)opaque;
 
-  ret = sample_alloc_many(&k->pool, smps, n->in.vectorize);
-  if (ret <= 0) {
-    n->logger->warn("Pool underrun in consumer");
+  if (msg->err) {
+    n->logger->warn("Failed to deliver message: {}", rd_kafka_err2str(msg->err));
     return;
   }
 
-  ret = k->formatter->sscan((char *)msg->payload, msg->len, nullptr, smps,
-                            n->in.vectorize);
-  if (ret < 0) {
-    n->logger->warn("Received an invalid message");
-    n->logger->warn("  Payload: {}", (char *)msg->payload);
-    return;
+  // Time between rd_kafka_produce_batch() and the acknowledgement of the broker
+  int64_t latency = rd_kafka_message_latency(msg);
+
+  auto stats = n->getStats();
+  if (stats && latency >= 0)
+    stats->update(Stats::Metric::DELIVERY_LATENCY, latency * 1e-6);
+}
+
+static void kafka_enqueue(NodeCompat *n, struct Sample *smps[], unsigned cnt) {
+  auto *k = n->getData<struct kafka>();
+
+  int pushed = queue_signalled_push_many(&k->queue, (void **)smps, cnt);
+  if (pushed < 0)
+    pushed = 0;
+
+  if ((unsigned)pushed < cnt) {
+    n->logger->warn("Failed to enqueue samples");
+    sample_decref_many(smps + pushed, cnt - pushed);
   }
+}
 
-  if (ret == 0) {
-    n->logger->debug("Skip empty message");
-    sample_decref_many(smps, n->in.vectorize);
-    return;
+// Decode a batch of messages and pass the samples in batches of up to in.vectorize to kafka_read()
+static void kafka_consume_batch(NodeCompat *n, rd_kafka_message_t *msgs[],
+                                unsigned cnt) {
+  int ret;
+  auto *k = n->getData<struct kafka>();
+
+  unsigned vec = n->in.vectorize;
+  unsigned filled = 0;
+  struct Sample *smps[vec];
+  struct Sample *scanned[vec];
+
+  for (unsigned i = 0; i < cnt; i++) {
+    auto *msg = msgs[i];
+
+    if (msg->err) {
+      if (msg->err != RD_KAFKA_RESP_ERR__PARTITION_EOF)
+        n->logger->warn("Failed to consume message: {}",
+                        rd_kafka_message_errstr(msg));
+      continue;
+    }
+
+    n->logger->debug("Received a message of {} bytes from broker {}", msg->len,
+                     k->server);
+
+    ret = sample_alloc_many(&k->pool, scanned, vec);
+    if (ret <= 0) {
+      n->logger->warn("Pool underrun in consumer");
+      break;
+    }
+
+    int alloc = ret;
+
+    ret = k->formatter->sscan((char *)msg->payload, msg->len, nullptr, scanned,
+                              alloc);
+    if (ret < 0) {
+      n->logger->warn("Received an invalid message");
+      ret = 0;
+    } else if (ret == 0)
+      n->logger->debug("Skip empty message");
+
+    sample_decref_many(scanned + ret, alloc - ret);
+
+    if (filled + ret > vec) {
+      kafka_enqueue(n, smps, filled);
+      filled = 0;
+    }
+
+    for (int j = 0; j < ret; j++)
+      smps[filled++] = scanned[j];
   }
 
-  ret = queue_signalled_push_many(&k->queue, (void **)smps, n->in.vectorize);
-  if (ret < (int)n->in.vectorize)
-    n->logger->warn("Failed to enqueue samples");
+  if (filled > 0)
+    kafka_enqueue(n, smps, filled);
 }
 
 static void *kafka_loop_thread(void *ctx) {
@@ -99,13 +151,22 @@ static void *kafka_loop_thread(void *ctx) {
       auto *k = n->getData<struct kafka>();
 
       // Execute kafka loop for this client
-      if (k->consumer.client) {
-        rd_kafka_message_t *msg =
-            rd_kafka_consumer_poll(k->consumer.client, k->timeout * 1000);
-        if (msg) {
-          kafka_message_cb((void *)n, msg);
-          rd_kafka_message_destroy(msg);
+      if (k->consumer.queue) {
+        unsigned cnt = n->in.vectorize;
+        rd_kafka_message_t *msgs[cnt];
+
+        ssize_t rcvd = rd_kafka_consume_batch_queue(
+            k->consumer.queue, k->timeout * 1000, msgs, cnt);
+        if (rcvd < 0) {
+          n->logger->warn("Failed to consume messages: {}",
+                          rd_kafka_err2str(rd_kafka_last_error()));
+          continue;
         }
+
+        kafka_consume_batch(n, msgs, rcvd);
+
+        for (ssize_t j = 0; j < rcvd; j++)
+          rd_kafka_message_destroy(msgs[j]);
       }
     }
   }
@@ -133,9 +194,13 @@ int villas::node::kafka_init(NodeCompat *n) {
   k->timeout = 1.0;
 
   k->consumer.client = nullptr;
+  k->consumer.queue = nullptr;
   k->consumer.group_id = nullptr;
   k->producer.client = nullptr;
   k->producer.topic = nullptr;
+  k->producer.linger = -1;
+  k->producer.batch_size = -1;
+  k->producer.samples_per_message = 0;
 
   k->sasl.mechanisms = nullptr;
   k->sasl.username = nullptr;
@@ -158,6 +223,7 @@ int villas::node::kafka_parse(NodeCompat *n, json_t *json) {
   const char *protocol;
   const char *client_id = "villas-node";
   const char *group_id = nullptr;
+  int samples_per_message = 0;
 
   json_error_t err;
   json_t *json_ssl = nullptr;
@@ -165,9 +231,12 @@ int villas::node::kafka_parse(NodeCompat *n, json_t *json) {
   json_t *json_format = nullptr;
 
   ret = json_unpack_ex(json, &err, 0,
-                       "{ s?: { s?: s }, s?: { s?: s, s?: s }, s?: o, s: s, "
-                       "s?: F, s: s, s?: s, s?: o, s?: o }",
-                       "out", "produce", &produce, "in", "consume", &consume,
+                       "{ s?: { s?: s, s?: F, s?: i, s?: i }, s?: { s?: s, s?: "
+                       "s }, s?: o, s: s, s?: F, s: s, s?: s, s?: o, s?: o }",
+                       "out", "produce", &produce, "linger",
+                       &k->producer.linger, "batch_size",
+                       &k->producer.batch_size, "samples_per_message",
+                       &samples_per_message, "in", "consume", &consume,
                        "group_id", &group_id, "format", &json_format, "server",
                        &server, "timeout", &k->timeout, "protocol", &protocol,
                        "client_id", &client_id, "ssl", &json_ssl, "sasl",
@@ -187,6 +256,12 @@ int villas::node::kafka_parse(NodeCompat *n, json_t *json) {
     throw ConfigError(json, "node-config-node-kafka-protocol",
                       "Invalid security protocol: {}", protocol);
 
+  if (samples_per_message < 0)
+    throw ConfigError(json, "node-config-node-kafka-samples-per-message",
+                      "Setting 'out.samples_per_message' must not be negative");
+
+  k->producer.samples_per_message = samples_per_message;
+
   if (!k->produce && !k->consume)
     throw ConfigError(json, "node-config-node-kafka",
                       "At least one topic has to be specified for node {}",
@@ -263,6 +338,16 @@ char *villas::node::kafka_print(NodeCompat *n) {
   if (k->produce)
     strcatf(&buf, ", out.produce=%s", k->produce);
 
+  if (k->producer.linger >= 0)
+    strcatf(&buf, ", out.linger=%g", k->producer.linger);
+
+  if (k->producer.batch_size > 0)
+    strcatf(&buf, ", out.batch_size=%d", k->producer.batch_size);
+
+  if (k->producer.samples_per_message > 0)
+    strcatf(&buf, ", out.samples_per_message=%u",
+            k->producer.samples_per_message);
+
   if (k->consume)
     strcatf(&buf, ", in.consume=%s", k->consume);
 
@@ -276,6 +361,9 @@ int villas::node::kafka_destroy(NodeCompat *n) {
   if (k->producer.client)
     rd_kafka_destroy(k->producer.client);
 
+  if (k->consumer.queue)
+    rd_kafka_queue_destroy(k->consumer.queue);
+
   if (k->consumer.client)
     rd_kafka_destroy(k->consumer.client);
 
@@ -365,6 +453,28 @@ int villas::node::kafka_start(NodeCompat *n) {
     if (!rdkconf_prod)
       throw MemoryAllocationError();
 
+    // Delivery reports are used to measure the latency of the broker
+    rd_kafka_conf_set_opaque(rdkconf_prod, n);
+    rd_kafka_conf_set_dr_msg_cb(rdkconf_prod, kafka_delivery_cb);
+
+    if (k->producer.linger >= 0) {
+      auto linger = fmt::format("{}", k->producer.linger * 1e3);
+
+      ret = rd_kafka_conf_set(rdkconf_prod, "linger.ms", linger.c_str(), errstr,
+                              sizeof(errstr));
+      if (ret != RD_KAFKA_CONF_OK)
+        goto kafka_config_error;
+    }
+
+    if (k->producer.batch_size > 0) {
+      auto batch_size = fmt::format("{}", k->producer.batch_size);
+
+      ret = rd_kafka_conf_set(rdkconf_prod, "batch.num.messages",
+                              batch_size.c_str(), errstr, sizeof(errstr));
+      if (ret != RD_KAFKA_CONF_OK)
+        goto kafka_config_error;
+    }
+
     k->producer.client =
         rd_kafka_new(RD_KAFKA_PRODUCER, rdkconf_prod, errstr, sizeof(errstr));
     if (!k->producer.client)
@@ -419,6 +529,11 @@ int villas::node::kafka_start(NodeCompat *n) {
       throw RuntimeError("Error subscribing to {} at {}: {}", k->consume,
                          k->server, rd_kafka_err2str((rd_kafka_resp_err_t)ret));
 
+    // Messages are consumed in batches from the queue of the consumer group
+    k->consumer.queue = rd_kafka_queue_get_consumer(k->consumer.client);
+    if (!k->consumer.queue)
+      throw RuntimeError("Failed to get consumer queue for {}", k->consume);
+
     n->logger->info("Subscribed consumer from bootstrap server {}", k->server);
   }
 
@@ -541,27 +656,72 @@ int villas::node::kafka_write(NodeCompat *n, struct Sample *const smps[],
   int ret;
   auto *k = n->getData<struct kafka>();
 
-  size_t wbytes;
+  if (!k->produce) {
+    n->logger->warn(
+        "No produce possible because no produce topic is configured");
+    return cnt;
+  }
 
-  char data[DEFAULT_FORMAT_BUFFER_LENGTH];
+  unsigned per_msg = k->producer.samples_per_message
+                         ? MIN(k->producer.samples_per_message, cnt)
+                         : cnt;
+  unsigned num_msgs = (cnt + per_msg - 1) / per_msg;
 
-  ret = k->formatter->sprint(data, sizeof(data), &wbytes, smps, cnt);
-  if (ret < 0)
-    return ret;
+  rd_kafka_message_t msgs[num_msgs];
+  memset(msgs, 0, sizeof(msgs));
 
-  if (k->produce) {
-    ret = rd_kafka_produce(k->producer.topic, RD_KAFKA_PARTITION_UA,
-                           RD_KAFKA_MSG_F_COPY, data, wbytes, NULL, 0, NULL);
+  /* The buffers are handed over to librdkafka with RD_KAFKA_MSG_F_FREE
+   * which frees them after delivery. */
+  for (unsigned i = 0; i < num_msgs; i++) {
+    size_t wbytes;
+    unsigned off = i * per_msg;
 
-    if (ret != RD_KAFKA_RESP_ERR_NO_ERROR) {
-      n->logger->warn("Publish failed");
-      return -abs(ret);
+    char *buf = (char *)malloc(DEFAULT_FORMAT_BUFFER_LENGTH);
+    if (!buf)
+      throw MemoryAllocationError();
+
+    ret = k->formatter->sprint(buf, DEFAULT_FORMAT_BUFFER_LENGTH, &wbytes,
+                               smps + off, MIN(per_msg, cnt - off));
+    if (ret < 0) {
+      free(buf);
+
+      for (unsigned j = 0; j < i; j++)
+        free(msgs[j].payload);
+
+      return ret;
     }
-  } else
-    n->logger->warn(
-        "No produce possible because no produce topic is configured");
 
-  return cnt;
+    // Shrinking is done in-place by the allocator
+    char *shrunk = (char *)realloc(buf, wbytes ? wbytes : 1);
+
+    msgs[i].payload = shrunk ? shrunk : buf;
+    msgs[i].len = wbytes;
+  }
+
+  int produced =
+      rd_kafka_produce_batch(k->producer.topic, RD_KAFKA_PARTITION_UA,
+                             RD_KAFKA_MSG_F_FREE, msgs, num_msgs);
+
+  unsigned sent = 0;
+  for (unsigned i = 0; i < num_msgs; i++) {
+    unsigned off = i * per_msg;
+
+    if (msgs[i].err) {
+      n->logger->warn("Publish failed: {}", rd_kafka_err2str(msgs[i].err));
+
+      // Payloads of failed messages are still owned by us
+      free(msgs[i].payload);
+    } else
+      sent += MIN(per_msg, cnt - off);
+  }
+
+  // Serve delivery reports
+  rd_kafka_poll(k->producer.client, 0);
+
+  if (produced <= 0)
+    return -1;
+
+  return sent;
 }
 
 int villas::node::kafka_poll_fds(NodeCompat *n, int fds[]) {
@@ -30,6 +30,20 @@
  * - The special case in blockDistance makes causes the bit mappings to be grouped
  *   first, before any adjacent registers.
  *
+ * With the "devices" setting, many Modbus TCP servers are polled by a single
+ * node. libmodbus only supports a single blocking transaction at a time, so
+ * these devices are handled by a poller thread with non-blocking sockets
+ * instead:
+ *
+ * 1. Devices with the same remote address share a connection.
+ * 2. Each device is polled at its own rate. A poll cycle is skipped if the
+ *    previous one is still outstanding.
+ * 3. Up to "max_in_flight" requests are sent per connection without waiting
+ *    for a response. Responses are matched by their transaction ID.
+ * 4. The decoded values are kept in in_values and sampled at the node rate.
+ *    While the last complete poll cycle of a device is older than its maximum
+ *    age, its float signals are sampled as NaN.
+ *
  * Author: Philipp Jungkamp <philipp.jungkamp@opal-rt.com>
  * SPDX-FileCopyrightText: 2023 OPAL-RT Germany GmbH
  * SPDX-License-Identifier: Apache-2.0
@@ -37,6 +51,15 @@
 
 #include <atomic>
 #include <chrono>
+#include <limits>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 #include <fmt/format.h>
 
@@ -360,6 +383,453 @@ void ModbusNode::reconnect() {
   }).detach();
 }
 
+Connection::Connection(std::string const &remote, uint16_t port)
+    : remote(remote), port(port), address{}, address_length(0), fd(-1),
+      state(State::DISCONNECTED), retry{0, 0}, deadline{0, 0},
+      next_transaction_id(0), pending{}, in_flight{}, tx{}, rx{} {
+  struct addrinfo hints = {}, *res;
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  auto service = std::to_string(port);
+
+  int ret = getaddrinfo(remote.c_str(), service.c_str(), &hints, &res);
+  if (ret)
+    throw RuntimeError("Failed to resolve {}: {}", remote, gai_strerror(ret));
+
+  memcpy(&address, res->ai_addr, res->ai_addrlen);
+  address_length = res->ai_addrlen;
+
+  freeaddrinfo(res);
+}
+
+// Length of the MBAP header including the unit identifier.
+static constexpr size_t MBAP_HEADER_LENGTH = 7;
+
+static void put16(std::vector<uint8_t> &buf, uint16_t value) {
+  buf.push_back(value >> 8);
+  buf.push_back(value & 0xFF);
+}
+
+static uint16_t get16(uint8_t const *p) { return (p[0] << 8) | p[1]; }
+
+// Append a Modbus TCP application data unit to the transmit buffer.
+static void encodeRequest(std::vector<uint8_t> &buf, uint16_t transaction_id,
+                          Connection::Request const &req) {
+  auto write = !req.registers.empty();
+  auto length = write ? 7 + 2 * req.num_registers : 6;
+
+  // MBAP header
+  put16(buf, transaction_id);
+  put16(buf, 0); // Protocol identifier
+  put16(buf, length);
+  buf.push_back(req.device->unit);
+
+  if (write) {
+    buf.push_back(MODBUS_FC_WRITE_MULTIPLE_REGISTERS);
+    put16(buf, req.address);
+    put16(buf, req.num_registers);
+    buf.push_back(2 * req.num_registers);
+
+    for (auto reg : req.registers)
+      put16(buf, reg);
+  } else {
+    buf.push_back(MODBUS_FC_READ_HOLDING_REGISTERS);
+    put16(buf, req.address);
+    put16(buf, req.num_registers);
+  }
+}
+
+void ModbusNode::pollerWakeup() {
+  uint64_t incr = 1;
+
+  if (::write(poller_fd, &incr, sizeof(incr)) < 0)
+    logger->warn("Failed to wake up poller: {}", strerror(errno));
+}
+
+void ModbusNode::pollerConnect(Connection &c, struct timespec const &now) {
+  c.fd = socket(c.address.ss_family,
+                SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+  if (c.fd < 0) {
+    logger->warn("Failed to create socket: {}", strerror(errno));
+    pollerDisconnect(c, now);
+    return;
+  }
+
+  // Requests are small and latency sensitive
+  int nodelay = 1;
+  setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+  int ret = ::connect(c.fd, (struct sockaddr *)&c.address, c.address_length);
+  if (ret == 0)
+    c.state = Connection::State::CONNECTED;
+  else if (errno == EINPROGRESS) {
+    auto timeout = time_from_double(response_timeout);
+
+    c.state = Connection::State::CONNECTING;
+    c.deadline = time_add(&now, &timeout);
+  } else {
+    logger->warn("Failed to connect to {}:{}: {}", c.remote, c.port,
+                 strerror(errno));
+    pollerDisconnect(c, now);
+  }
+}
+
+void ModbusNode::pollerDisconnect(Connection &c, struct timespec const &now) {
+  if (c.fd >= 0) {
+    close(c.fd);
+    c.fd = -1;
+  }
+
+  if (!c.in_flight.empty())
+    logger->warn("Lost {} transactions to {}:{}", c.in_flight.size(), c.remote,
+                 c.port);
+
+  c.state = Connection::State::DISCONNECTED;
+  c.in_flight.clear();
+  c.tx.clear();
+  c.rx.clear();
+
+  {
+    std::lock_guard<std::mutex> guard(poller_mutex);
+    c.pending.clear();
+  }
+
+  for (auto &d : devices) {
+    if (&connections[d.connection] == &c)
+      d.outstanding = 0;
+  }
+
+  auto interval = time_from_double(reconnect_interval);
+  c.retry = time_add(&now, &interval);
+}
+
+void ModbusNode::pollerSchedule(struct timespec const &now, double &wait) {
+  for (auto &d : devices) {
+    if (d.in_mappings.empty())
+      continue;
+
+    auto &c = connections[d.connection];
+
+    if (time_cmp(&now, &d.next_poll) >= 0) {
+      if (c.state != Connection::State::CONNECTED)
+        ; // Skip this cycle
+      else if (d.outstanding > 0) {
+        // The device did not answer all requests of the last cycle yet
+        if (d.overruns++ % 1000 == 0)
+          logger->warn("Device {} can not keep up with its polling rate "
+                       "(overruns={})",
+                       d.name, d.overruns);
+      } else {
+        std::lock_guard<std::mutex> guard(poller_mutex);
+
+        for (auto &mapping : d.in_mappings) {
+          auto address = blockBegin(mapping);
+
+          c.pending.push_back(Connection::Request{
+              .device = &d,
+              .mapping = &mapping,
+              .address = address,
+              .num_registers = (modbus_addr_t)(blockEnd(mapping) - address),
+              .registers = {},
+          });
+        }
+
+        d.outstanding = d.in_mappings.size();
+        d.cycle_started = now;
+        d.cycle_failed = false;
+      }
+
+      // Advance the schedule and skip cycles which have been missed
+      auto period = time_from_double(1.0 / d.rate);
+      d.next_poll = time_add(&d.next_poll, &period);
+      if (time_cmp(&d.next_poll, &now) <= 0)
+        d.next_poll = time_add(&now, &period);
+    }
+
+    wait = std::min(wait, time_delta(&now, &d.next_poll));
+  }
+}
+
+void ModbusNode::pollerSend(Connection &c, struct timespec const &now) {
+  {
+    std::lock_guard<std::mutex> guard(poller_mutex);
+
+    while (!c.pending.empty() && c.in_flight.size() < max_in_flight) {
+      auto id = c.next_transaction_id++;
+
+      // Skip IDs of transactions which are still waiting for a response
+      if (c.in_flight.count(id))
+        continue;
+
+      encodeRequest(c.tx, id, c.pending.front());
+
+      c.in_flight.emplace(id, Connection::Transaction{
+                                  .request = std::move(c.pending.front()),
+                                  .sent = now,
+                              });
+      c.pending.pop_front();
+    }
+  }
+
+  pollerFlush(c, now);
+}
+
+void ModbusNode::pollerFlush(Connection &c, struct timespec const &now) {
+  if (c.tx.empty())
+    return;
+
+  auto sent = ::send(c.fd, c.tx.data(), c.tx.size(), MSG_NOSIGNAL);
+  if (sent < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+      return;
+
+    logger->warn("Failed to send to {}:{}: {}", c.remote, c.port,
+                 strerror(errno));
+    pollerDisconnect(c, now);
+    return;
+  }
+
+  c.tx.erase(c.tx.begin(), c.tx.begin() + sent);
+}
+
+void ModbusNode::pollerReceive(Connection &c, struct timespec const &now) {
+  uint8_t buf[4096];
+
+  auto received = ::recv(c.fd, buf, sizeof(buf), 0);
+  if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    return;
+
+  if (received <= 0) {
+    logger->warn("Connection to {}:{} closed: {}", c.remote, c.port,
+                 received < 0 ? strerror(errno) : "end of file");
+    pollerDisconnect(c, now);
+    return;
+  }
+
+  c.rx.insert(c.rx.end(), buf, buf + received);
+
+  // Process all complete application data units
+  size_t offset = 0;
+  while (c.rx.size() - offset >= MBAP_HEADER_LENGTH) {
+    auto *adu = c.rx.data() + offset;
+    auto length = get16(adu + 4);
+
+    // The length field covers the unit identifier and the PDU
+    if (length < 3 || length > MODBUS_TCP_MAX_ADU_LENGTH - 6) {
+      logger->warn("Received invalid frame from {}:{}", c.remote, c.port);
+      pollerDisconnect(c, now);
+      return;
+    }
+
+    if (c.rx.size() - offset < 6 + (size_t)length)
+      break;
+
+    auto it = c.in_flight.find(get16(adu));
+    if (it != c.in_flight.end()) {
+      pollerHandle(it->second, adu + MBAP_HEADER_LENGTH, length - 1);
+      c.in_flight.erase(it);
+    } else
+      logger->debug("Received response for unknown transaction {} from {}:{}",
+                    get16(adu), c.remote, c.port);
+
+    offset += 6 + length;
+  }
+
+  c.rx.erase(c.rx.begin(), c.rx.begin() + offset);
+}
+
+void ModbusNode::pollerHandle(Connection::Transaction &t, uint8_t const *pdu,
+                              size_t len) {
+  auto &req = t.request;
+  auto *d = req.device;
+
+  if (pdu[0] & 0x80) {
+    logger->warn("Device {} responded with exception {} to function {}",
+                 d->name, len > 1 ? pdu[1] : 0, pdu[0] & 0x7F);
+
+    if (req.mapping)
+      pollerComplete(*d, false);
+
+    return;
+  }
+
+  if (!req.mapping)
+    return;
+
+  size_t bytes = 2 * req.num_registers;
+  if (pdu[0] != MODBUS_FC_READ_HOLDING_REGISTERS || len < 2 + bytes ||
+      pdu[1] != bytes) {
+    logger->warn("Received invalid response from device {}", d->name);
+    pollerComplete(*d, false);
+    return;
+  }
+
+  uint16_t registers[MODBUS_MAX_READ_REGISTERS];
+  for (size_t i = 0; i < req.num_registers; i++)
+    registers[i] = get16(pdu + 2 + 2 * i);
+
+  {
+    std::lock_guard<std::mutex> guard(poller_mutex);
+
+    readMapping(*req.mapping, registers, req.num_registers, in_values.data(),
+                in_values.size());
+  }
+
+  pollerComplete(*d, true);
+}
+
+void ModbusNode::pollerComplete(Device &d, bool success) {
+  if (!success)
+    d.cycle_failed = true;
+
+  if (--d.outstanding > 0 || d.cycle_failed)
+    return;
+
+  // The values of the device are at least as recent as the request
+  std::lock_guard<std::mutex> guard(poller_mutex);
+  d.last_update = d.cycle_started;
+}
+
+void ModbusNode::pollerExpire(Connection &c, struct timespec const &now,
+                              double &wait) {
+  for (auto it = c.in_flight.begin(); it != c.in_flight.end();) {
+    auto age = time_delta(&it->second.sent, &now);
+
+    if (age < response_timeout) {
+      wait = std::min(wait, response_timeout - age);
+      ++it;
+      continue;
+    }
+
+    auto &req = it->second.request;
+
+    logger->warn("Response timeout for device {} at address {}",
+                 req.device->name, req.address);
+
+    if (req.mapping)
+      pollerComplete(*req.device, false);
+
+    it = c.in_flight.erase(it);
+  }
+}
+
+void ModbusNode::pollerRun() {
+  std::vector<struct pollfd> pfds;
+  std::vector<Connection *> pconns;
+
+  while (poller_running) {
+    auto now = time_now();
+    double wait = 1.0;
+
+    for (auto &c : connections) {
+      if (c.state == Connection::State::CONNECTING) {
+        // Unreachable hosts would otherwise block the connection for minutes
+        if (time_cmp(&now, &c.deadline) >= 0) {
+          logger->warn("Timeout while connecting to {}:{}", c.remote, c.port);
+          pollerDisconnect(c, now);
+        } else
+          wait = std::min(wait, time_delta(&now, &c.deadline));
+      }
+
+      if (c.state != Connection::State::DISCONNECTED)
+        continue;
+
+      if (time_cmp(&now, &c.retry) >= 0)
+        pollerConnect(c, now);
+      else
+        wait = std::min(wait, time_delta(&now, &c.retry));
+    }
+
+    pollerSchedule(now, wait);
+
+    pfds.clear();
+    pconns.clear();
+
+    pfds.push_back({.fd = poller_fd, .events = POLLIN, .revents = 0});
+    pconns.push_back(nullptr);
+
+    for (auto &c : connections) {
+      if (c.state == Connection::State::CONNECTED) {
+        pollerExpire(c, now, wait);
+        pollerSend(c, now);
+      } else {
+        // Writes to unavailable devices are discarded
+        std::lock_guard<std::mutex> guard(poller_mutex);
+        c.pending.clear();
+      }
+
+      if (c.state == Connection::State::DISCONNECTED)
+        continue;
+
+      short events = c.state == Connection::State::CONNECTING ? POLLOUT
+                     : c.tx.empty() ? POLLIN
+                                    : POLLIN | POLLOUT;
+
+      pfds.push_back({.fd = c.fd, .events = events, .revents = 0});
+      pconns.push_back(&c);
+    }
+
+    int ret = ::poll(pfds.data(), pfds.size(), std::max(wait, 0.0) * 1e3);
+    if (ret < 0) {
+      if (errno == EINTR)
+        continue;
+
+      logger->error("Failed to poll: {}", strerror(errno));
+      break;
+    }
+
+    now = time_now();
+
+    if (pfds[0].revents & POLLIN) {
+      uint64_t cnt;
+      if (::read(poller_fd, &cnt, sizeof(cnt)) < 0)
+        logger->warn("Failed to read from eventfd: {}", strerror(errno));
+    }
+
+    for (size_t i = 1; i < pfds.size(); i++) {
+      auto &c = *pconns[i];
+      auto revents = pfds[i].revents;
+
+      if (!revents)
+        continue;
+
+      if (c.state == Connection::State::CONNECTING) {
+        int err = 0;
+        socklen_t errlen = sizeof(err);
+
+        getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &errlen);
+        if (err) {
+          logger->warn("Failed to connect to {}:{}: {}", c.remote, c.port,
+                       strerror(err));
+          pollerDisconnect(c, now);
+        } else {
+          logger->info("Connected to {}:{}", c.remote, c.port);
+          c.state = Connection::State::CONNECTED;
+        }
+
+        continue;
+      }
+
+      if (revents & POLLIN)
+        pollerReceive(c, now);
+
+      if (c.state == Connection::State::CONNECTED && (revents & POLLOUT))
+        pollerFlush(c, now);
+
+      if (c.state == Connection::State::CONNECTED &&
+          (revents & (POLLERR | POLLHUP)) && !(revents & POLLIN)) {
+        logger->warn("Connection to {}:{} failed", c.remote, c.port);
+        pollerDisconnect(c, now);
+      }
+    }
+  }
+
+  auto now = time_now();
+  for (auto &c : connections)
+    pollerDisconnect(c, now);
+}
+
 void ModbusNode::mergeMappingInplace(RegisterMapping &lhs,
                                      RegisterMappingBlock const &rhs) {
   if (auto lhs_single = std::get_if<RegisterMappingSingle>(&lhs))
@@ -507,6 +977,61 @@ int ModbusNode::readMapping(RegisterMappingBlock const &block,
 int ModbusNode::_read(struct Sample *smps[], unsigned cnt) {
   read_task.wait();
 
+  // The poller keeps the latest values of all devices
+  if (!devices.empty()) {
+    std::lock_guard<std::mutex> guard(poller_mutex);
+
+    auto now = time_now();
+    struct timespec oldest = {0, 0};
+
+    for (auto &d : devices) {
+      if (d.in_mappings.empty())
+        continue;
+
+      bool stale = d.last_update.tv_sec == 0 ||
+                   time_delta(&d.last_update, &now) > d.max_age;
+      if (stale != d.stale) {
+        if (stale)
+          logger->warn("Values of device {} are stale", d.name);
+        else
+          logger->info("Values of device {} are up to date", d.name);
+
+        d.stale = stale;
+      }
+
+      if (!stale &&
+          (oldest.tv_sec == 0 || time_cmp(&d.last_update, &oldest) < 0))
+        oldest = d.last_update;
+    }
+
+    for (unsigned int i = 0; i < cnt; ++i) {
+      auto smp = smps[i];
+      smp->length = num_in_signals;
+      smp->flags |= (int)SampleFlags::HAS_DATA;
+
+      assert(smp->length <= smp->capacity);
+
+      std::copy_n(in_values.begin(), smp->length, smp->data);
+
+      // Only the signals of unavailable devices are invalidated
+      for (auto &d : devices) {
+        if (!d.stale)
+          continue;
+
+        for (auto index : d.float_signals)
+          smp->data[index].f = std::numeric_limits<double>::quiet_NaN();
+      }
+
+      // The origin is the oldest poll cycle of the up to date devices
+      if (oldest.tv_sec != 0) {
+        smp->ts.origin = oldest;
+        smp->flags |= (int)SampleFlags::HAS_TS_ORIGIN;
+      }
+    }
+
+    return cnt;
+  }
+
   for (unsigned int i = 0; i < cnt; ++i) {
     auto smp = smps[i];
     smp->length = num_in_signals;
@@ -592,6 +1117,45 @@ int ModbusNode::writeMapping(RegisterMappingBlock const &block,
 }
 
 int ModbusNode::_write(struct Sample *smps[], unsigned cnt) {
+  // Writes are queued to the poller
+  if (!devices.empty()) {
+    {
+      std::lock_guard<std::mutex> guard(poller_mutex);
+
+      for (unsigned int i = 0; i < cnt; ++i) {
+        auto smp = smps[i];
+
+        assert(smp->length == num_out_signals);
+
+        for (auto &d : devices) {
+          auto &c = connections[d.connection];
+
+          for (auto &mapping : d.out_mappings) {
+            auto address = blockBegin(mapping);
+            auto num_registers = blockEnd(mapping) - address;
+            auto registers = std::vector<uint16_t>(num_registers);
+
+            if (auto ret = writeMapping(mapping, registers.data(),
+                                        num_registers, smp->data, smp->length))
+              return ret;
+
+            c.pending.push_back(Connection::Request{
+                .device = &d,
+                .mapping = nullptr,
+                .address = address,
+                .num_registers = (modbus_addr_t)num_registers,
+                .registers = std::move(registers),
+            });
+          }
+        }
+      }
+    }
+
+    pollerWakeup();
+
+    return cnt;
+  }
+
   for (unsigned int i = 0; i < cnt; ++i) {
     auto smp = smps[i];
 
@@ -611,14 +1175,58 @@ ModbusNode::ModbusNode(const uuid_t &id, const std::string &name)
       connection_settings(), rate(-1), response_timeout(1), in_mappings{},
       num_in_signals(0), out_mappings{}, num_out_signals(0),
       reconnect_interval(10), read_buffer{}, write_buffer{},
-      modbus_context(nullptr), read_task(), reconnecting(false) {}
+      modbus_context(nullptr), read_task(), reconnecting(false), devices{},
+      connections{}, max_in_flight(4), stale_timeout(-1), in_values{},
+      poller_mutex(), poller(), poller_running(false), poller_fd(-1) {}
 
 ModbusNode::~ModbusNode() {
+  if (poller.joinable()) {
+    poller_running = false;
+    pollerWakeup();
+    poller.join();
+  }
+
+  if (poller_fd >= 0)
+    close(poller_fd);
+
   if (modbus_context)
     modbus_free(modbus_context);
 }
 
 int ModbusNode::prepare() {
+  if (!devices.empty()) {
+    size_t calls = 0;
+
+    for (auto &d : devices) {
+      mergeMappings(d.in_mappings, max_block_size - 2);
+      mergeMappings(d.out_mappings, 0);
+
+      calls += d.in_mappings.size();
+
+      // Allow for a single missed poll cycle by default
+      d.max_age = stale_timeout > 0 ? stale_timeout
+                                    : response_timeout + 2 / d.rate;
+
+      // Devices behind the same remote share a connection
+      auto c = std::find_if(
+          std::begin(connections), std::end(connections),
+          [&d](auto &c) { return c.remote == d.remote && c.port == d.port; });
+
+      d.connection = std::distance(std::begin(connections), c);
+      if (c == std::end(connections))
+        connections.emplace_back(d.remote, d.port);
+    }
+
+    if (in.enabled)
+      read_task.setRate(rate);
+
+    logger->info("Polling {} devices over {} connections with {} Modbus calls "
+                 "per cycle",
+                 devices.size(), connections.size(), calls);
+
+    return Node::prepare();
+  }
+
   mergeMappings(in_mappings, max_block_size - 2);
   mergeMappings(out_mappings, 0);
 
@@ -720,6 +1328,40 @@ Tcp Tcp::parse(json_t *json) {
   };
 }
 
+Device Device::parse(json_t *json, double rate) {
+  char const *name = nullptr;
+  char const *remote = nullptr;
+  int port = 502;
+  int unit = 0xFF;
+
+  json_error_t err;
+  int ret = json_unpack_ex(
+      json, &err, 0, "{ s?: s, s: s, s?: i, s?: i, s?: F }", "name", &name,
+      "remote", &remote, "port", &port, "unit", &unit, "rate", &rate);
+  if (ret)
+    throw ConfigError(json, err, "node-config-node-modbus-devices");
+
+  return Device{
+      .name = name ? name : fmt::format("{}:{}/{}", remote, port, unit),
+      .remote = remote,
+      .port = (uint16_t)port,
+      .unit = (unsigned char)unit,
+      .rate = rate,
+      .in_mappings = {},
+      .out_mappings = {},
+      .connection = 0,
+      .next_poll = {0, 0},
+      .outstanding = 0,
+      .overruns = 0,
+      .cycle_started = {0, 0},
+      .cycle_failed = false,
+      .last_update = {0, 0},
+      .max_age = 0,
+      .float_signals = {},
+      .stale = false,
+  };
+}
+
 RegisterMappingSingle RegisterMappingSingle::parse(unsigned int index,
                                                    Signal::Ptr signal,
                                                    json_t *json) {
@@ -817,6 +1459,45 @@ unsigned int ModbusNode::parseMappings(std::vector<RegisterMapping> &mappings,
   return json_array_size(json);
 }
 
+void ModbusNode::distributeMappings(std::vector<RegisterMapping> &mappings,
+                                    json_t *json, bool in) {
+  size_t i;
+  json_t *signal_json;
+
+  json_array_foreach(json, i, signal_json) {
+    char const *name = nullptr;
+    Device *device = nullptr;
+
+    json_error_t err;
+    if (json_unpack_ex(signal_json, &err, 0, "{ s?: s }", "device", &name))
+      throw ConfigError(signal_json, err, "node-config-node-modbus-signal");
+
+    if (name) {
+      for (auto &d : devices) {
+        if (d.name == name)
+          device = &d;
+      }
+
+      if (!device)
+        throw ConfigError(signal_json, "node-config-node-modbus-signal-device",
+                          "Unknown device: {}", name);
+    } else if (devices.size() == 1)
+      device = &devices.front();
+    else
+      throw ConfigError(signal_json, "node-config-node-modbus-signal-device",
+                        "Setting 'device' is required for multiple devices");
+
+    if (in && device->rate <= 0)
+      throw ConfigError(signal_json, "node-config-node-modbus-devices-rate",
+                        "Missing polling rate for device {}", device->name);
+
+    auto &target = in ? device->in_mappings : device->out_mappings;
+    target.push_back(std::move(mappings[i]));
+  }
+
+  mappings.clear();
+}
+
 int ModbusNode::parse(json_t *json) {
   if (auto ret = Node::parse(json))
     return ret;
@@ -825,20 +1506,48 @@ int ModbusNode::parse(json_t *json) {
   char const *transport = nullptr;
   json_t *in_json = nullptr;
   json_t *out_json = nullptr;
+  json_t *devices_json = nullptr;
 
   if (json_unpack_ex(
           json, &err, 0,
-          "{ s: s, s?: F, s?: F, s?: i, s?: i, s?: F, s?: o, s?: o }",
+          "{ s: s, s?: F, s?: F, s?: i, s?: i, s?: F, s?: o, s?: o, s?: o, s?: "
+          "i, s?: F }",
           "transport", &transport, "response_timeout", &response_timeout,
           "reconnect_interval", &reconnect_interval, "min_block_usage",
           &min_block_usage, "max_block_size", &max_block_size, "rate", &rate,
-          "in", &in_json, "out", &out_json))
+          "in", &in_json, "out", &out_json, "devices", &devices_json,
+          "max_in_flight", &max_in_flight, "stale_timeout", &stale_timeout))
     throw ConfigError(json, err, "node-config-node-modbus");
 
   if (in.enabled && rate < 0)
     throw RuntimeError{"missing polling rate for Modbus reads"};
 
-  if (!strcmp(transport, "rtu"))
+  if (devices_json) {
+    if (strcmp(transport, "tcp"))
+      throw ConfigError(json, "node-config-node-modbus-devices",
+                        "Setting 'devices' requires transport 'tcp'");
+
+    if (!json_is_array(devices_json) || json_array_size(devices_json) == 0)
+      throw ConfigError(devices_json, "node-config-node-modbus-devices",
+                        "Setting 'devices' must be a non-empty array");
+
+    if (max_block_size > MODBUS_MAX_READ_REGISTERS)
+      throw ConfigError(json, "node-config-node-modbus-max-block-size",
+                        "Setting 'max_block_size' must not exceed {}",
+                        MODBUS_MAX_READ_REGISTERS);
+
+    if (max_in_flight < 1)
+      throw ConfigError(json, "node-config-node-modbus-max-in-flight",
+                        "Setting 'max_in_flight' must be positive");
+
+    size_t i;
+    json_t *device_json;
+
+    devices.clear();
+    json_array_foreach(devices_json, i, device_json) {
+      devices.push_back(Device::parse(device_json, rate));
+    }
+  } else if (!strcmp(transport, "rtu"))
     connection_settings = Rtu::parse(json);
   else if (!strcmp(transport, "tcp"))
     connection_settings = Tcp::parse(json);
@@ -847,18 +1556,69 @@ int ModbusNode::parse(json_t *json) {
 
   json_t *signals_json;
 
-  if (in_json && (signals_json = json_object_get(in_json, "signals")))
+  if (in_json && (signals_json = json_object_get(in_json, "signals"))) {
     num_in_signals = parseMappings(in_mappings, signals_json);
 
-  if (out_json && (signals_json = json_object_get(out_json, "signals")))
+    if (!devices.empty())
+      distributeMappings(in_mappings, signals_json, true);
+  }
+
+  if (out_json && (signals_json = json_object_get(out_json, "signals"))) {
     num_out_signals = parseMappings(out_mappings, signals_json);
 
+    if (!devices.empty())
+      distributeMappings(out_mappings, signals_json, false);
+  }
+
   return 0;
 }
 
 int ModbusNode::check() { return Node::check(); }
 
 int ModbusNode::start() {
+  if (!devices.empty()) {
+    auto signals = getInputSignals(false);
+
+    in_values.resize(num_in_signals);
+    for (unsigned int i = 0; i < num_in_signals; i++)
+      in_values[i] = signals->getByIndex(i)->init;
+
+    poller_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (poller_fd < 0)
+      throw SystemError("Failed to create eventfd");
+
+    // Connections are established by the poller and retried on failure
+    auto now = time_now();
+    for (auto &d : devices) {
+      d.next_poll = now;
+      d.last_update = {0, 0};
+      d.stale = false;
+
+      d.float_signals.clear();
+      for (auto &mapping : d.in_mappings) {
+        auto add = [&](RegisterMappingSingle const &single) {
+          auto index = single.signal_index;
+          if (signals->getByIndex(index)->type == SignalType::FLOAT)
+            d.float_signals.push_back(index);
+        };
+
+        if (auto single = std::get_if<RegisterMappingSingle>(&mapping))
+          add(*single);
+        else
+          for (auto &single : std::get<RegisterMappingBlock>(mapping))
+            add(single);
+      }
+    }
+
+    for (auto &c : connections)
+      c.retry = now;
+
+    poller_running = true;
+    poller = std::thread(&ModbusNode::pollerRun, this);
+
+    return Node::start();
+  }
+
   if (modbus_connect(modbus_context) == -1)
     throw RuntimeError{"connection failure: {}", modbus_strerror(errno)};
 
@@ -866,6 +1626,24 @@ int ModbusNode::start() {
 }
 
 int ModbusNode::stop() {
+  if (!devices.empty()) {
+    poller_running = false;
+    pollerWakeup();
+
+    if (poller.joinable())
+      poller.join();
+
+    close(poller_fd);
+    poller_fd = -1;
+
+    for (auto &d : devices) {
+      if (d.overruns > 0)
+        logger->warn("Device {} skipped {} poll cycles", d.name, d.overruns);
+    }
+
+    return Node::stop();
+  }
+
   modbus_close(modbus_context);
 
   return Node::stop();
@@ -883,6 +1661,11 @@ std::vector<int> ModbusNode::getNetemFDs() {
 }
 
 const std::string &ModbusNode::getDetails() {
+  if (details.empty() && !devices.empty())
+    details = fmt::format("transport=tcp, #devices={}, #connections={}, "
+                          "max_in_flight={}",
+                          devices.size(), connections.size(), max_in_flight);
+
   if (details.empty()) {
     if (auto tcp = std::get_if<Tcp>(&connection_settings)) {
       details = fmt::format("transport=tcp, remote={}, port={}", tcp->remote,
@@ -12,6 +12,8 @@
 #include <villas/exceptions.hpp>
 #include <villas/node_compat.hpp>
 #include <villas/nodes/mqtt.hpp>
+#include <villas/stats.hpp>
+#include <villas/timing.hpp>
 #include <villas/utils.hpp>
 
 using namespace villas;
@@ -52,9 +54,19 @@ static void mqtt_connect_cb(struct mosquitto *mosq, void *ctx, int result) {
   n->logger->info("Connected to broker {}", m->host);
 
   if (m->subscribe) {
-    ret = mosquitto_subscribe(m->client, nullptr, m->subscribe, m->qos);
+    std::string topic = m->subscribe;
+
+    // Per-signal topics are received via a single wildcard subscription
+    if (m->topic_per_signal)
+      topic += "/#";
+
+    // Messages of a shared subscription are distributed among all members of the group
+    if (m->group)
+      topic = fmt::format("$share/{}/{}", m->group, topic);
+
+    ret = mosquitto_subscribe(m->client, nullptr, topic.c_str(), m->qos);
     if (ret)
-      n->logger->warn("Failed to subscribe to topic '{}': {}", m->subscribe,
+      n->logger->warn("Failed to subscribe to topic '{}': {}", topic,
                       mosquitto_strerror(ret));
   } else
     n->logger->warn("No subscription as no topic is configured");
@@ -65,11 +77,62 @@ static void mqtt_disconnect_cb(struct mosquitto *mosq, void *ctx, int result) {
   auto *m = n->getData<struct mqtt>();
 
   n->logger->info("Disconnected from broker {}", m->host);
+
+  // Unacknowledged messages will not be acknowledged anymore after a reconnect
+  std::lock_guard guard(m->inflight_lock);
+  m->inflight.clear();
+}
+
+// Merge a single value received on a per-signal topic into a new sample
+static void mqtt_message_signal(NodeCompat *n,
+                                const struct mosquitto_message *msg) {
+  int ret;
+  auto *m = n->getData<struct mqtt>();
+  struct Sample *smp;
+
+  auto it = m->topics.find(msg->topic);
+  if (it == m->topics.end()) {
+    n->logger->debug("Skip message for unknown signal topic: {}", msg->topic);
+    return;
+  }
+
+  auto sig = n->getInputSignals(false)->getByIndex(it->second);
+  auto payload = std::string((char *)msg->payload, msg->payloadlen);
+
+  char *end;
+  ret = m->values[it->second].parseString(sig->type, payload.c_str(), &end);
+  if (ret) {
+    n->logger->warn("Received an invalid value for signal '{}': {}",
+                    sig->name, payload);
+    return;
+  }
+
+  smp = sample_alloc(&m->pool);
+  if (!smp) {
+    n->logger->warn("Pool underrun in subscriber");
+    return;
+  }
+
+  smp->length = MIN(m->values.size(), smp->capacity);
+  smp->sequence = m->sequence++;
+  smp->ts.origin = time_now();
+  smp->signals = n->getInputSignals(false);
+  smp->flags = (int)SampleFlags::HAS_DATA | (int)SampleFlags::HAS_SEQUENCE |
+               (int)SampleFlags::HAS_TS_ORIGIN;
+
+  for (unsigned i = 0; i < smp->length; i++)
+    smp->data[i] = m->values[i];
+
+  ret = queue_signalled_push(&m->queue, (void *)smp);
+  if (ret != 1) {
+    n->logger->warn("Failed to enqueue samples");
+    sample_decref(smp);
+  }
 }
 
 static void mqtt_message_cb(struct mosquitto *mosq, void *ctx,
                             const struct mosquitto_message *msg) {
-  int ret;
+  int ret, avail, enqueued;
   auto *n = (NodeCompat *)ctx;
   auto *m = n->getData<struct mqtt>();
   struct Sample *smps[n->in.vectorize];
@@ -77,29 +140,80 @@ static void mqtt_message_cb(struct mosquitto *mosq, void *ctx,
   n->logger->debug("Received a message of {} bytes from broker {}",
                    msg->payloadlen, m->host);
 
-  ret = sample_alloc_many(&m->pool, smps, n->in.vectorize);
-  if (ret <= 0) {
+  if (m->topic_per_signal) {
+    mqtt_message_signal(n, msg);
+    return;
+  }
+
+  avail = sample_alloc_many(&m->pool, smps, n->in.vectorize);
+  if (avail <= 0) {
     n->logger->warn("Pool underrun in subscriber");
     return;
   }
 
   ret = m->formatter->sscan((char *)msg->payload, msg->payloadlen, nullptr,
-                            smps, n->in.vectorize);
+                            smps, avail);
   if (ret < 0) {
     n->logger->warn("Received an invalid message");
     n->logger->warn("  Payload: {}", (char *)msg->payload);
+    sample_decref_many(smps, avail);
     return;
   }
 
   if (ret == 0) {
     n->logger->debug("Skip empty message");
-    sample_decref_many(smps, n->in.vectorize);
+    sample_decref_many(smps, avail);
     return;
   }
 
-  ret = queue_signalled_push_many(&m->queue, (void **)smps, n->in.vectorize);
-  if (ret < (int)n->in.vectorize)
+  enqueued = queue_signalled_push_many(&m->queue, (void **)smps, ret);
+  if (enqueued < ret)
     n->logger->warn("Failed to enqueue samples");
+
+  // Release unused samples back to pool
+  if (enqueued < avail)
+    sample_decref_many(&smps[enqueued], avail - enqueued);
+}
+
+static void mqtt_publish_cb(struct mosquitto *mosq, void *ctx, int mid) {
+  auto *n = (NodeCompat *)ctx;
+  auto *m = n->getData<struct mqtt>();
+  auto now = time_now();
+
+  std::lock_guard guard(m->inflight_lock);
+
+  auto it = m->inflight.find(mid);
+  if (it == m->inflight.end())
+    return;
+
+  // Statistics are updated by the path thread in mqtt_write()
+  if (n->getStats())
+    m->latencies.push_back(time_delta(&it->second, &now));
+
+  m->inflight.erase(it);
+}
+
+// Moves the latencies of acknowledged messages into the node statistics
+static void mqtt_update_stats(NodeCompat *n) {
+  auto *m = n->getData<struct mqtt>();
+  std::vector<double> latencies;
+  size_t inflight;
+
+  auto stats = n->getStats();
+  if (!stats)
+    return;
+
+  {
+    std::lock_guard guard(m->inflight_lock);
+
+    latencies.swap(m->latencies);
+    inflight = m->inflight.size();
+  }
+
+  for (auto latency : latencies)
+    stats->update(Stats::Metric::DELIVERY_LATENCY, latency);
+
+  stats->update(Stats::Metric::IN_FLIGHT, inflight);
 }
 
 static void mqtt_subscribe_cb(struct mosquitto *mosq, void *ctx, int mid,
@@ -110,6 +224,96 @@ static void mqtt_subscribe_cb(struct mosquitto *mosq, void *ctx, int mid,
   n->logger->info("Subscribed to broker {}", m->host);
 }
 
+/* Serialize and publish a single message.
+ *
+ * @return The number of samples which did fit into the message or a negative error.
+ */
+static int mqtt_publish(NodeCompat *n, const struct Sample *const smps[],
+                        unsigned cnt) {
+  int ret, mid;
+  auto *m = n->getData<struct mqtt>();
+
+  size_t wbytes;
+
+  ret = m->formatter->sprint(m->buffer.data(), m->buffer.size(), &wbytes, smps,
+                             cnt);
+  if (ret < 0)
+    return ret;
+  else if (ret == 0) {
+    n->logger->warn("Sample is too large for a single message");
+    return -1;
+  }
+
+  {
+    // Acknowledgements are handled by the network thread only after the message ID has been recorded
+    std::lock_guard guard(m->inflight_lock);
+
+    int rc = mosquitto_publish(m->client, &mid, m->publish, wbytes,
+                               m->buffer.data(), m->qos, m->retain);
+    if (rc != MOSQ_ERR_SUCCESS) {
+      n->logger->warn("Publish failed: {}", mosquitto_strerror(rc));
+      return -abs(rc);
+    }
+
+    m->inflight[mid] = time_now();
+  }
+
+  return ret;
+}
+
+// Publish samples in as many messages as required
+static int mqtt_publish_many(NodeCompat *n, const struct Sample *const smps[],
+                             unsigned cnt) {
+  auto *m = n->getData<struct mqtt>();
+  unsigned published = 0;
+
+  while (published < cnt) {
+    unsigned chunk = cnt - published;
+    if (m->batch.size > 0)
+      chunk = MIN(chunk, m->batch.size);
+
+    int ret = mqtt_publish(n, &smps[published], chunk);
+    if (ret < 0)
+      return ret;
+
+    published += ret;
+  }
+
+  return published;
+}
+
+// Publish all pending samples. Must be called with batch.lock held.
+static int mqtt_flush(NodeCompat *n) {
+  auto *m = n->getData<struct mqtt>();
+  auto &smps = m->batch.samples;
+
+  int ret = mqtt_publish_many(n, smps.data(), smps.size());
+
+  sample_decref_many(smps.data(), smps.size());
+  smps.clear();
+
+  return ret;
+}
+
+// Publishes pending samples once they exceeded the maximum latency
+static void mqtt_flusher(NodeCompat *n) {
+  auto *m = n->getData<struct mqtt>();
+
+  std::unique_lock lock(m->batch.lock);
+
+  while (m->batch.running) {
+    if (m->batch.samples.empty())
+      m->batch.cv.wait(lock);
+    else if (std::chrono::steady_clock::now() >= m->batch.deadline)
+      mqtt_flush(n);
+    else
+      m->batch.cv.wait_until(lock, m->batch.deadline);
+  }
+
+  if (!m->batch.samples.empty())
+    mqtt_flush(n);
+}
+
 int villas::node::mqtt_reverse(NodeCompat *n) {
   auto *m = n->getData<struct mqtt>();
 
@@ -130,6 +334,19 @@ int villas::node::mqtt_init(NodeCompat *n) {
   mosquitto_disconnect_callback_set(m->client, mqtt_disconnect_cb);
   mosquitto_message_callback_set(m->client, mqtt_message_cb);
   mosquitto_subscribe_callback_set(m->client, mqtt_subscribe_cb);
+  mosquitto_publish_callback_set(m->client, mqtt_publish_cb);
+
+  new (&m->topics) std::unordered_map<std::string, unsigned>();
+  new (&m->values) std::vector<union SignalData>();
+  new (&m->batch.samples) std::vector<struct Sample *>();
+  new (&m->batch.deadline) std::chrono::steady_clock::time_point();
+  new (&m->batch.lock) std::mutex();
+  new (&m->batch.cv) std::condition_variable();
+  new (&m->batch.thread) std::thread();
+  new (&m->buffer) std::vector<char>();
+  new (&m->inflight) std::unordered_map<int, struct timespec>();
+  new (&m->latencies) std::vector<double>();
+  new (&m->inflight_lock) std::mutex();
 
   m->formatter = nullptr;
 
@@ -144,6 +361,14 @@ int villas::node::mqtt_init(NodeCompat *n) {
   m->password = nullptr;
   m->publish = nullptr;
   m->subscribe = nullptr;
+  m->group = nullptr;
+  m->protocol = MQTT_PROTOCOL_V311;
+  m->topic_per_signal = false;
+  m->sequence = 0;
+
+  m->batch.size = 0;
+  m->batch.max_latency = 0.1;
+  m->batch.running = false;
 
   m->ssl.enabled = 0;
   m->ssl.insecure = 0;
@@ -165,27 +390,63 @@ int villas::node::mqtt_parse(NodeCompat *n, json_t *json) {
   const char *host;
   const char *publish = nullptr;
   const char *subscribe = nullptr;
+  const char *group = nullptr;
   const char *username = nullptr;
   const char *password = nullptr;
 
   json_error_t err;
   json_t *json_ssl = nullptr;
   json_t *json_format = nullptr;
+  json_t *json_in = nullptr;
+  json_t *json_out = nullptr;
+
+  int protocol = -1;
 
   ret = json_unpack_ex(json, &err, 0,
-                       "{ s?: { s?: s }, s?: { s?: s }, s?: o, s: s, s?: i, "
-                       "s?: i, s?: i, s?: b, s?: s, s?: s, s?: o }",
-                       "out", "publish", &publish, "in", "subscribe",
-                       &subscribe, "format", &json_format, "host", &host,
-                       "port", &m->port, "qos", &m->qos, "keepalive",
-                       &m->keepalive, "retain", &m->retain, "username",
-                       &username, "password", &password, "ssl", &json_ssl);
+                       "{ s?: o, s?: o, s?: o, s: s, s?: i, s?: i, s?: i, "
+                       "s?: b, s?: s, s?: s, s?: o, s?: i }",
+                       "out", &json_out, "in", &json_in, "format",
+                       &json_format, "host", &host, "port", &m->port, "qos",
+                       &m->qos, "keepalive", &m->keepalive, "retain",
+                       &m->retain, "username", &username, "password",
+                       &password, "ssl", &json_ssl, "protocol", &protocol);
   if (ret)
     throw ConfigError(json, err, "node-config-node-mqtt");
 
+  if (json_out) {
+    int batch_size = -1;
+
+    ret = json_unpack_ex(json_out, &err, 0, "{ s?: s, s?: i, s?: F }",
+                         "publish", &publish, "batch_size", &batch_size,
+                         "max_latency", &m->batch.max_latency);
+    if (ret)
+      throw ConfigError(json_out, err, "node-config-node-mqtt-out");
+
+    if (batch_size >= 0)
+      m->batch.size = batch_size;
+
+    if (m->batch.max_latency <= 0)
+      throw ConfigError(json_out, "node-config-node-mqtt-out-max-latency",
+                        "The 'max_latency' setting must be positive");
+  }
+
+  if (json_in) {
+    int tps = -1;
+
+    ret = json_unpack_ex(json_in, &err, 0, "{ s?: s, s?: s, s?: b }",
+                         "subscribe", &subscribe, "group", &group,
+                         "topic_per_signal", &tps);
+    if (ret)
+      throw ConfigError(json_in, err, "node-config-node-mqtt-in");
+
+    if (tps >= 0)
+      m->topic_per_signal = tps != 0;
+  }
+
   m->host = strdup(host);
   m->publish = publish ? strdup(publish) : nullptr;
   m->subscribe = subscribe ? strdup(subscribe) : nullptr;
+  m->group = group ? strdup(group) : nullptr;
   m->username = username ? strdup(username) : nullptr;
   m->password = password ? strdup(password) : nullptr;
 
@@ -194,6 +455,17 @@ int villas::node::mqtt_parse(NodeCompat *n, json_t *json) {
                       "At least one topic has to be specified for node {}",
                       n->getName());
 
+  // Shared subscriptions have been standardized with MQTT v5
+  if (protocol < 0)
+    protocol = m->group ? MQTT_PROTOCOL_V5 : MQTT_PROTOCOL_V311;
+
+  if (protocol != MQTT_PROTOCOL_V31 && protocol != MQTT_PROTOCOL_V311 &&
+      protocol != MQTT_PROTOCOL_V5)
+    throw ConfigError(json, "node-config-node-mqtt-protocol",
+                      "Unsupported MQTT protocol version: {}", protocol);
+
+  m->protocol = protocol;
+
   if (json_ssl) {
     m->ssl.enabled = 1;
 
@@ -250,8 +522,16 @@ int villas::node::mqtt_check(NodeCompat *n) {
     if (ret != MOSQ_ERR_SUCCESS)
       throw RuntimeError("Invalid subscribe topic: '{}': {}", m->subscribe,
                          mosquitto_strerror(ret));
+
+    if (m->topic_per_signal && strpbrk(m->subscribe, "+#"))
+      throw RuntimeError("Subscribe topic must not contain wildcards if "
+                         "'topic_per_signal' is set: '{}'",
+                         m->subscribe);
   }
 
+  if (m->group && strpbrk(m->group, "/+#"))
+    throw RuntimeError("Invalid shared subscription group: '{}'", m->group);
+
   if (m->publish) {
     ret = mosquitto_pub_topic_check(m->publish);
     if (ret != MOSQ_ERR_SUCCESS)
@@ -277,6 +557,31 @@ int villas::node::mqtt_prepare(NodeCompat *n) {
   if (ret)
     return ret;
 
+  if (m->topic_per_signal) {
+    auto sigs = n->getInputSignals(false);
+
+    m->topics.clear();
+    for (unsigned i = 0; i < sigs->size(); i++) {
+      auto sig = sigs->getByIndex(i);
+
+      m->topics[fmt::format("{}/{}", m->subscribe, sig->name)] = i;
+    }
+
+    m->values.assign(sigs->size(), SignalData());
+  }
+
+  // At most a full batch is held back while another write is in progress
+  if (m->batch.size > 1) {
+    ret = pool_init(&m->batch.pool, m->batch.size + n->out.vectorize,
+                    SAMPLE_LENGTH(n->getOutputSignals(false)->size()));
+    if (ret)
+      return ret;
+
+    m->batch.samples.reserve(m->batch.size + n->out.vectorize);
+  }
+
+  m->buffer.resize(DEFAULT_MQTT_BUFFER_SIZE);
+
   return 0;
 }
 
@@ -295,9 +600,19 @@ char *villas::node::mqtt_print(NodeCompat *n) {
   if (m->publish)
     strcatf(&buf, ", out.publish=%s", m->publish);
 
+  if (m->batch.size > 1)
+    strcatf(&buf, ", out.batch_size=%u, out.max_latency=%g", m->batch.size,
+            m->batch.max_latency);
+
   if (m->subscribe)
     strcatf(&buf, ", in.subscribe=%s", m->subscribe);
 
+  if (m->group)
+    strcatf(&buf, ", in.group=%s", m->group);
+
+  if (m->topic_per_signal)
+    strcatf(&buf, ", in.topic_per_signal=yes");
+
   return buf;
 }
 
@@ -315,12 +630,37 @@ int villas::node::mqtt_destroy(NodeCompat *n) {
   if (ret)
     return ret;
 
+  if (m->batch.pool.state == State::INITIALIZED) {
+    ret = pool_destroy(&m->batch.pool);
+    if (ret)
+      return ret;
+  }
+
+  using samples_t = std::vector<struct Sample *>;
+  using topics_t = std::unordered_map<std::string, unsigned>;
+  using values_t = std::vector<union SignalData>;
+  using inflight_t = std::unordered_map<int, struct timespec>;
+
+  m->topics.~topics_t();
+  m->values.~values_t();
+  m->batch.samples.~samples_t();
+  m->batch.cv.~condition_variable();
+  m->batch.lock.~mutex();
+  m->batch.thread.~thread();
+  m->buffer.~vector();
+  m->inflight.~inflight_t();
+  m->latencies.~vector();
+  m->inflight_lock.~mutex();
+
   if (m->publish)
     free(m->publish);
 
   if (m->subscribe)
     free(m->subscribe);
 
+  if (m->group)
+    free(m->group);
+
   if (m->password)
     free(m->password);
 
@@ -340,6 +680,10 @@ int villas::node::mqtt_start(NodeCompat *n) {
   int ret;
   auto *m = n->getData<struct mqtt>();
 
+  ret = mosquitto_int_option(m->client, MOSQ_OPT_PROTOCOL_VERSION, m->protocol);
+  if (ret != MOSQ_ERR_SUCCESS)
+    goto mosquitto_error;
+
   if (m->username && m->password) {
     ret = mosquitto_username_pw_set(m->client, m->username, m->password);
     if (ret != MOSQ_ERR_SUCCESS)
@@ -370,6 +714,11 @@ int villas::node::mqtt_start(NodeCompat *n) {
   if (ret != MOSQ_ERR_SUCCESS)
     goto mosquitto_error;
 
+  if (m->batch.size > 1) {
+    m->batch.running = true;
+    m->batch.thread = std::thread(mqtt_flusher, n);
+  }
+
   return 0;
 
 mosquitto_error:
@@ -382,6 +731,18 @@ int villas::node::mqtt_stop(NodeCompat *n) {
   int ret;
   auto *m = n->getData<struct mqtt>();
 
+  // Publish remaining samples before disconnecting
+  if (m->batch.thread.joinable()) {
+    {
+      std::lock_guard guard(m->batch.lock);
+
+      m->batch.running = false;
+      m->batch.cv.notify_one();
+    }
+
+    m->batch.thread.join();
+  }
+
   ret = mosquitto_disconnect(m->client);
   if (ret != MOSQ_ERR_SUCCESS)
     goto mosquitto_error;
@@ -450,27 +811,53 @@ int villas::node::mqtt_read(NodeCompat *n, struct Sample *const smps[],
 
 int villas::node::mqtt_write(NodeCompat *n, struct Sample *const smps[],
                              unsigned cnt) {
-  int ret;
+  int ret, avail;
   auto *m = n->getData<struct mqtt>();
 
-  size_t wbytes;
+  if (!m->publish) {
+    n->logger->warn(
+        "No publish possible because no publish topic is configured");
+    return cnt;
+  }
 
-  char data[1500];
+  mqtt_update_stats(n);
 
-  ret = m->formatter->sprint(data, sizeof(data), &wbytes, smps, cnt);
-  if (ret < 0)
-    return ret;
+  if (m->batch.size <= 1) {
+    ret = mqtt_publish_many(n, smps, cnt);
+    if (ret < 0)
+      return ret;
 
-  if (m->publish) {
-    ret = mosquitto_publish(m->client, nullptr /* mid */, m->publish, wbytes,
-                            data, m->qos, m->retain);
-    if (ret != MOSQ_ERR_SUCCESS) {
-      n->logger->warn("Publish failed: {}", mosquitto_strerror(ret));
-      return -abs(ret);
-    }
-  } else
-    n->logger->warn(
-        "No publish possible because no publish topic is configured");
+    return cnt;
+  }
+
+  std::lock_guard guard(m->batch.lock);
+
+  // The first pending sample determines the deadline of the batch
+  if (m->batch.samples.empty()) {
+    m->batch.deadline =
+        std::chrono::steady_clock::now() +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(m->batch.max_latency));
+    m->batch.cv.notify_one();
+  }
+
+  auto pending = m->batch.samples.size();
+
+  m->batch.samples.resize(pending + cnt);
+
+  avail = sample_alloc_many(&m->batch.pool, &m->batch.samples[pending], cnt);
+  if (avail < (int)cnt)
+    n->logger->warn("Pool underrun: avail={}", avail);
+
+  sample_copy_many(&m->batch.samples[pending], smps, avail);
+
+  m->batch.samples.resize(pending + avail);
+
+  if (m->batch.samples.size() >= m->batch.size) {
+    ret = mqtt_flush(n);
+    if (ret < 0)
+      return ret;
+  }
 
   return cnt;
 }
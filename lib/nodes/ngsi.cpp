@@ -7,6 +7,8 @@
 
 #include <cstdio>
 #include <cstring>
+#include <functional>
+#include <mutex>
 
 #include <curl/curl.h>
 #include <jansson.h>
@@ -20,6 +22,7 @@
 #include <villas/node/config.hpp>
 #include <villas/node_compat.hpp>
 #include <villas/nodes/ngsi.hpp>
+#include <villas/stats.hpp>
 #include <villas/super_node.hpp>
 #include <villas/timing.hpp>
 #include <villas/utils.hpp>
@@ -203,11 +206,6 @@ public:
   }
 };
 
-struct ngsi_response {
-  char *data;
-  size_t len;
-};
-
 static json_t *ngsi_build_entity(NodeCompat *n,
                                  const struct Sample *const smps[],
                                  unsigned cnt, int flags) {
@@ -416,126 +414,102 @@ static int ngsi_parse_context_response(json_t *json_response, int *code,
   return ret;
 }
 
-static size_t ngsi_request_writer(void *contents, size_t size, size_t nmemb,
-                                  void *userp) {
-  size_t realsize = size * nmemb;
-  struct ngsi_response *mem = (struct ngsi_response *)userp;
-
-  mem->data = (char *)realloc(mem->data, mem->len + realsize + 1);
-  if (mem->data == nullptr) // out of memory!
-    throw MemoryAllocationError();
-
-  memcpy(&(mem->data[mem->len]), contents, realsize);
-  mem->len += realsize;
-  mem->data[mem->len] = 0;
-
-  return realsize;
-}
-
-static int ngsi_request(CURL *handle, const char *endpoint,
-                        const char *operation, json_t *json_request,
-                        json_t **json_response, Logger logger) {
-  struct ngsi_response chunk = {0};
-  char *post = json_dumps(json_request, JSON_INDENT(4));
-  int old;
-  double time;
-  char url[128];
+/* Parses the response of the context broker to a request of the HTTP client.
+ *
+ * The entity of the response is returned in json_rentity unless it is null.
+ */
+static int ngsi_parse_http_response(long code, const std::string &response,
+                                    json_t **json_rentity, Logger logger) {
+  int ret, status;
+  char *reason;
   json_error_t err;
+  json_t *json_entity;
 
-  snprintf(url, sizeof(url), "%s/v1/%s", endpoint, operation);
-
-  curl_easy_setopt(handle, CURLOPT_URL, url);
-  curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, ngsi_request_writer);
-  curl_easy_setopt(handle, CURLOPT_WRITEDATA, (void *)&chunk);
-  curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE, strlen(post));
-  curl_easy_setopt(handle, CURLOPT_POSTFIELDS, post);
-
-  logger->debug("Request to context broker: {}\n{}", url, post);
-
-  // We don't want to leave the handle in an invalid state
-  pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old);
-  CURLcode ret = curl_easy_perform(handle);
-  pthread_setcancelstate(old, nullptr);
+  // Failed requests are already reported by the HTTP client
+  if (code != 200)
+    return -1;
 
-  if (ret) {
-    logger->warn("HTTP request failed: {}", curl_easy_strerror(ret));
-    goto out;
+  json_t *json_response = json_loads(response.c_str(), 0, &err);
+  if (!json_response) {
+    logger->warn("Received invalid JSON: {}", err.text);
+    return -1;
   }
 
-  curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME, &time);
-
-  logger->debug("Request to context broker completed in {} seconds", time);
-  logger->debug("Response from context broker:\n{}", chunk.data);
-
-  *json_response = json_loads(chunk.data, 0, &err);
-  if (!*json_response)
-    logger->warn("Received invalid JSON: {} in {}:{}:{}\n{}", err.text,
-                 err.source, err.line, err.column, chunk.data);
+  ret = ngsi_parse_context_response(json_response, &status, &reason,
+                                    &json_entity, logger);
+  if (!ret) {
+    if (json_rentity)
+      *json_rentity = json_entity;
+    else
+      json_decref(json_entity);
+  }
 
-out:
-  free(post);
-  free(chunk.data);
+  json_decref(json_response);
 
   return ret;
 }
 
-static int ngsi_request_context_query(CURL *handle, const char *endpoint,
-                                      json_t *json_entity,
-                                      json_t **json_rentity, Logger logger) {
-  int ret, code;
-  char *reason;
+/* Queues a query of the context on the HTTP client.
+ *
+ * The resulting entity is taken by the next read.
+ */
+static void ngsi_request_context_query(NodeCompat *n) {
+  auto *i = n->getData<struct ngsi>();
 
-  json_t *json_response;
+  json_t *json_entity = ngsi_build_entity(n, nullptr, 0, 0);
   json_t *json_request = json_pack("{ s: [ O ] }", "entities", json_entity);
+  char *body = json_dumps(json_request, JSON_COMPACT);
 
-  ret = ngsi_request(handle, endpoint, "queryContext", json_request,
-                     &json_response, logger);
-  if (ret) {
-    ret = -1;
-    goto out;
-  }
+  i->http->request(
+      fmt::format("{}/v1/queryContext", i->endpoint), body,
+      [n](long code, const std::string &response, double) {
+        auto *i = n->getData<struct ngsi>();
+        json_t *json_rentity = nullptr;
 
-  ret = ngsi_parse_context_response(json_response, &code, &reason, json_rentity,
-                                    logger);
-  if (ret)
-    goto out2;
+        int ret = ngsi_parse_http_response(code, response, &json_rentity,
+                                           n->logger);
 
-out2:
-  json_decref(json_response);
-out:
-  json_decref(json_request);
+        std::lock_guard<std::mutex> guard(i->query.lock);
 
-  return ret;
+        // Only the latest state of the entity is of interest
+        if (!ret) {
+          if (i->query.entity)
+            json_decref(i->query.entity);
+
+          i->query.entity = json_rentity;
+        }
+
+        i->query.pending = false;
+      });
+
+  free(body);
+  json_decref(json_request);
+  json_decref(json_entity);
 }
 
-static int ngsi_request_context_update(CURL *handle, const char *endpoint,
-                                       const char *action, json_t *json_entity,
-                                       Logger logger) {
-  int ret, code;
-  char *reason;
+/* Queues an update of the context on the HTTP client.
+ *
+ * The update is performed after all previously written samples and before
+ * any later ones. The result is passed to the done callback.
+ */
+static void ngsi_request_context_update(NodeCompat *n, const char *action,
+                                        json_t *json_entity,
+                                        std::function<void(int)> done) {
+  auto *i = n->getData<struct ngsi>();
 
-  json_t *json_response;
   json_t *json_request = json_pack("{ s: s, s: [ O ] }", "updateAction", action,
                                    "contextElements", json_entity);
+  char *body = json_dumps(json_request, JSON_COMPACT);
 
-  ret = ngsi_request(handle, endpoint, "updateContext", json_request,
-                     &json_response, logger);
-  if (ret)
-    goto out;
+  i->http->request(
+      fmt::format("{}/v1/updateContext", i->endpoint), body,
+      [n, done](long code, const std::string &response, double) {
+        done(ngsi_parse_http_response(code, response, nullptr, n->logger));
+      },
+      true);
 
-  json_t *json_rentity;
-  ret = ngsi_parse_context_response(json_response, &code, &reason,
-                                    &json_rentity, logger);
-  if (ret)
-    goto out2;
-
-  json_decref(json_rentity);
-out2:
-  json_decref(json_response);
-out:
+  free(body);
   json_decref(json_request);
-
-  return ret;
 }
 
 int villas::node::ngsi_type_start(villas::node::SuperNode *sn) {
@@ -589,16 +563,27 @@ int villas::node::ngsi_parse(NodeCompat *n, json_t *json) {
 
   ret = json_unpack_ex(json, &err, 0,
                        "{ s?: s, s: s, s: s, s: s, s?: b, s?: F, s?: F, s?: b, "
-                       "s?: b, s?: { s?: o }, s?: { s?: o } }",
+                       "s?: b, s?: { s?: o }, s?: { s?: o, s?: i, s?: F, s?: i "
+                       "} }",
                        "access_token", &i->access_token, "endpoint",
                        &i->endpoint, "entity_id", &i->entity_id, "entity_type",
                        &i->entity_type, "ssl_verify", &i->ssl_verify, "timeout",
                        &i->timeout, "rate", &i->rate, "create", &create,
                        "delete", &remove, "in", "signals", &json_signals_in,
-                       "out", "signals", &json_signals_out);
+                       "out", "signals", &json_signals_out, "batch_size",
+                       &i->batch_size, "max_latency", &i->max_latency,
+                       "max_in_flight", &i->max_in_flight);
   if (ret)
     throw ConfigError(json, err, "node-config-node-ngsi");
 
+  if (i->batch_size <= 0)
+    throw ConfigError(json, "node-config-node-ngsi-batch-size",
+                      "Setting 'out.batch_size' must be positive");
+
+  if (i->max_in_flight <= 0)
+    throw ConfigError(json, "node-config-node-ngsi-max-in-flight",
+                      "Setting 'out.max_in_flight' must be positive");
+
   i->create = create;
   i->remove = remove;
 
@@ -630,9 +615,9 @@ char *villas::node::ngsi_print(NodeCompat *n) {
 int villas::node::ngsi_start(NodeCompat *n) {
   auto *i = n->getData<struct ngsi>();
 
-  i->in.curl = curl_easy_init();
-  i->out.curl = curl_easy_init();
   i->headers = nullptr;
+  i->query.entity = nullptr;
+  i->query.pending = false;
 
   if (i->access_token) {
     char buf[128];
@@ -649,25 +634,42 @@ int villas::node::ngsi_start(NodeCompat *n) {
   i->headers = curl_slist_append(i->headers, "Accept: application/json");
   i->headers = curl_slist_append(i->headers, "Content-Type: application/json");
 
-  CURL *handles[] = {i->in.curl, i->out.curl};
+  /* All requests are performed asynchronously to avoid blocking the path.
+   * Updates are sent to the default URL of the client. */
+  HttpClient::Options opts;
 
-  for (unsigned p = 0; p < ARRAY_LEN(handles); p++) {
-    curl_easy_setopt(handles[p], CURLOPT_SSL_VERIFYPEER, i->ssl_verify);
-    curl_easy_setopt(handles[p], CURLOPT_TIMEOUT_MS, i->timeout * 1e3);
-    curl_easy_setopt(handles[p], CURLOPT_HTTPHEADER, i->headers);
-    curl_easy_setopt(handles[p], CURLOPT_USERAGENT, HTTP_USER_AGENT);
-  }
+  opts.batch_size = i->batch_size;
+  opts.max_latency = i->max_latency;
+  opts.max_in_flight = i->max_in_flight;
+  opts.timeout = i->timeout;
+  opts.ssl_verify = i->ssl_verify;
+
+  i->http = new HttpClient(fmt::format("{}/v1/updateContext", i->endpoint),
+                           opts, n->logger);
 
-  // Create entity and atributes
+  for (auto *hdr = i->headers; hdr; hdr = hdr->next)
+    i->http->addHeader(hdr->data);
+
+  // Updates of multiple writes are joined into a single request
+  i->http->setFraming("{\"updateAction\":\"UPDATE\",\"contextElements\":[",
+                      ",", "]}");
+
+  i->http->setCallback([n](long code, const std::string &response, double) {
+    ngsi_parse_http_response(code, response, nullptr, n->logger);
+  });
+
+  i->http->start();
+
+  // Create entity and atributes before the first update is sent
   if (i->create) {
     json_t *json_entity = ngsi_build_entity(
         n, nullptr, 0, NGSI_ENTITY_ATTRIBUTES | NGSI_ENTITY_METADATA);
 
-    int ret = ngsi_request_context_update(i->out.curl, i->endpoint, "APPEND",
-                                          json_entity, n->logger);
-    if (ret)
-      throw RuntimeError("Failed to create NGSI context for node {}",
+    ngsi_request_context_update(n, "APPEND", json_entity, [n](int ret) {
+      if (ret)
+        n->logger->error("Failed to create NGSI context for node {}",
                          n->getName());
+    });
 
     json_decref(json_entity);
   }
@@ -677,20 +679,29 @@ int villas::node::ngsi_start(NodeCompat *n) {
 
 int villas::node::ngsi_stop(NodeCompat *n) {
   auto *i = n->getData<struct ngsi>();
-  int ret;
+  int ret = -1;
 
   i->task.stop();
 
-  // Delete complete entity (not just attributes)
+  // Delete complete entity (not just attributes) after the remaining updates
   json_t *json_entity = ngsi_build_entity(n, nullptr, 0, 0);
 
-  ret = ngsi_request_context_update(i->out.curl, i->endpoint, "DELETE",
-                                    json_entity, n->logger);
+  ngsi_request_context_update(n, "DELETE", json_entity,
+                              [&ret](int r) { ret = r; });
 
   json_decref(json_entity);
 
-  curl_easy_cleanup(i->in.curl);
-  curl_easy_cleanup(i->out.curl);
+  // Waits for the pending requests at most for the timeout
+  i->http->stop();
+
+  delete i->http;
+  i->http = nullptr;
+
+  if (i->query.entity) {
+    json_decref(i->query.entity);
+    i->query.entity = nullptr;
+  }
+
   curl_slist_free_all(i->headers);
 
   return ret;
@@ -700,26 +711,33 @@ int villas::node::ngsi_read(NodeCompat *n, struct Sample *const smps[],
                             unsigned cnt) {
   auto *i = n->getData<struct ngsi>();
   int ret;
+  bool idle;
+  json_t *json_rentity;
 
   if (i->task.wait() == 0)
     throw SystemError("Failed to wait for task");
 
-  json_t *json_rentity;
-  json_t *json_entity = ngsi_build_entity(n, nullptr, 0, 0);
+  // Take the result of the last completed query without waiting for it
+  {
+    std::lock_guard<std::mutex> guard(i->query.lock);
 
-  ret = ngsi_request_context_query(i->in.curl, i->endpoint, json_entity,
-                                   &json_rentity, n->logger);
-  if (ret)
-    goto out;
+    json_rentity = i->query.entity;
+    i->query.entity = nullptr;
+
+    idle = !i->query.pending;
+    i->query.pending = true;
+  }
+
+  // At most one query is performed at a time
+  if (idle)
+    ngsi_request_context_query(n);
+
+  if (!json_rentity)
+    return 0;
 
   ret = ngsi_parse_entity(n, json_rentity, smps, cnt);
-  if (ret)
-    goto out2;
 
-out2:
   json_decref(json_rentity);
-out:
-  json_decref(json_entity);
 
   return ret;
 }
@@ -727,17 +745,34 @@ out:
 int villas::node::ngsi_write(NodeCompat *n, struct Sample *const smps[],
                              unsigned cnt) {
   auto *i = n->getData<struct ngsi>();
-  int ret;
+
+  if (!i->http)
+    return -1;
 
   json_t *json_entity = ngsi_build_entity(
       n, smps, cnt, NGSI_ENTITY_ATTRIBUTES_OUT | NGSI_ENTITY_VALUES);
 
-  ret = ngsi_request_context_update(i->out.curl, i->endpoint, "UPDATE",
-                                    json_entity, n->logger);
+  char *fragment = json_dumps(json_entity, JSON_COMPACT);
+
+  if (!i->http->push(fragment, cnt))
+    n->logger->warn("Context broker is too slow. Dropping oldest updates");
 
+  free(fragment);
   json_decref(json_entity);
 
-  return ret ? 0 : cnt;
+  // Statistics are only updated here as the client completes in background
+  auto stats = n->getStats();
+  if (stats) {
+    std::vector<double> latencies;
+    i->http->takeLatencies(latencies);
+
+    for (auto latency : latencies)
+      stats->update(Stats::Metric::DELIVERY_LATENCY, latency);
+
+    stats->update(Stats::Metric::IN_FLIGHT, i->http->getInFlight());
+  }
+
+  return cnt;
 }
 
 int villas::node::ngsi_poll_fds(NodeCompat *n, int fds[]) {
@@ -753,6 +788,7 @@ int villas::node::ngsi_init(NodeCompat *n) {
   auto *i = n->getData<struct ngsi>();
 
   new (&i->task) Task(CLOCK_REALTIME);
+  new (&i->query.lock) std::mutex();
 
   ret = list_init(&i->in.signals);
   if (ret)
@@ -767,6 +803,10 @@ int villas::node::ngsi_init(NodeCompat *n) {
   i->ssl_verify = 1;         // verify by default
   i->timeout = 1;            // default value
   i->rate = 1;               // default value
+  i->http = nullptr;
+  i->batch_size = 1;    // send each update immediately
+  i->max_latency = 0;   // default value
+  i->max_in_flight = 4; // default value
 
   return 0;
 }
@@ -796,6 +836,7 @@ int villas::node::ngsi_destroy(NodeCompat *n) {
     return ret;
 
   i->task.~Task();
+  i->query.lock.~mutex();
 
   return 0;
 }
@@ -153,30 +153,33 @@ static int redis_get(NodeCompat *n, struct Sample *const smps[], unsigned cnt) {
 
   case RedisMode::HASH: {
     struct Sample *smp = smps[0];
+    auto sigs = n->getInputSignals(false);
 
     unsigned j = 0;
-    for (auto sig : *n->getInputSignals(false)) {
+    for (auto sig : *sigs) {
       auto *data = &smp->data[j++];
 
       *data = sig->init;
     }
 
-    std::unordered_map<std::string, std::string> kvs;
-    r->conn->context.hgetall(r->key, std::inserter(kvs, kvs.begin()));
+    std::vector<std::pair<std::string, std::string>> kvs;
+    r->conn->context.hgetall(r->key, std::back_inserter(kvs));
 
     int max_idx = -1;
     for (auto &it : kvs) {
       auto &name = it.first;
       auto &value = it.second;
 
-      auto sig = n->getInputSignals(false)->getByName(name);
-      if (!sig)
+      auto field = r->fields.find(name);
+      if (field == r->fields.end())
         continue;
 
-      auto idx = n->getInputSignals(false)->getIndexByName(name);
+      int idx = field->second;
       if (idx > max_idx)
         max_idx = idx;
 
+      auto sig = sigs->getByIndex(idx);
+
       char *end;
       ret = smp->data[idx].parseString(sig->type, value.c_str(), &end);
       if (ret < 0)
@@ -197,12 +200,10 @@ static int redis_get(NodeCompat *n, struct Sample *const smps[], unsigned cnt) {
   }
 }
 
-static void redis_on_message(NodeCompat *n, const std::string &channel,
-                             const std::string &msg) {
+// Decode a message or fetch the current value and pass it to redis_read()
+static void redis_receive(NodeCompat *n, const std::string &msg) {
   auto *r = n->getData<struct redis>();
 
-  n->logger->debug("Message: {}: {}", channel, msg);
-
   int alloc, scanned, pushed = 0;
   unsigned cnt = n->in.vectorize;
   struct Sample *smps[cnt];
@@ -248,6 +249,89 @@ out:
   sample_decref_many(smps + pushed, alloc - pushed);
 }
 
+static void redis_on_message(NodeCompat *n, const std::string &channel,
+                             const std::string &msg) {
+  n->logger->debug("Message: {}: {}", channel, msg);
+
+  redis_receive(n, msg);
+}
+
+// Periodically fetch the key in a separate thread for async = true
+static void redis_poll(NodeCompat *n) {
+  auto *r = n->getData<struct redis>();
+
+  while (r->polling) {
+    try {
+      if (r->task.wait() == 0)
+        break;
+
+      redis_receive(n, {});
+    } catch (const sw::redis::Error &e) {
+      n->logger->error("Failed to poll: {}", e.what());
+    }
+  }
+}
+
+// Queue a batch of commands and send them in a single round trip
+template <typename T>
+static int redis_write_queued(NodeCompat *n, T &queued,
+                              struct Sample *const smps[], unsigned cnt) {
+  int ret;
+  auto *r = n->getData<struct redis>();
+
+  switch (r->mode) {
+  case RedisMode::CHANNEL:
+    for (unsigned i = 0; i < cnt; i++) {
+      char buf[1500];
+      size_t wbytes;
+
+      ret = r->formatter->sprint(buf, sizeof(buf), &wbytes, &smps[i], 1);
+      if (ret < 0) {
+        queued.discard();
+        return ret;
+      }
+
+      queued.publish(r->key, std::string_view(buf, wbytes));
+    }
+    break;
+
+  case RedisMode::KEY: {
+    char buf[1500];
+    size_t wbytes;
+
+    ret = r->formatter->sprint(buf, sizeof(buf), &wbytes, smps, cnt);
+    if (ret < 0)
+      return ret;
+
+    queued.set(r->key, std::string_view(buf, wbytes));
+    break;
+  }
+
+  case RedisMode::HASH: {
+    // We only update the signals with their latest value here.
+    struct Sample *smp = smps[cnt - 1];
+
+    unsigned len = MIN(smp->signals->size(), smp->length);
+
+    r->kvs.resize(len);
+    for (unsigned j = 0; j < len; j++) {
+      const auto sig = smp->signals->getByIndex(j);
+      const auto *data = &smp->data[j];
+
+      r->kvs[j].first = sig->name;
+      r->kvs[j].second = data->toString(sig->type);
+    }
+
+    queued.hmset(r->key, r->kvs.begin(), r->kvs.end());
+    break;
+  }
+  }
+
+  queued.exec();
+
+  return cnt;
+}
+
 int villas::node::redis_init(NodeCompat *n) {
   auto *r = n->getData<struct redis>();
 
@@ -255,10 +339,18 @@ int villas::node::redis_init(NodeCompat *n) {
   r->formatter = nullptr;
   r->notify = true;
   r->rate = 1.0;
+  r->async = false;
+  r->transaction = false;
+  r->pipeline = nullptr;
+  r->tx = nullptr;
 
   new (&r->options) sw::redis::ConnectionOptions;
   new (&r->task) Task(CLOCK_REALTIME);
   new (&r->key) std::string();
+  new (&r->poller) std::thread();
+  new (&r->polling) std::atomic<bool>(false);
+  new (&r->fields) std::unordered_map<std::string, unsigned>();
+  new (&r->kvs) std::vector<std::pair<std::string, std::string>>();
 
   /* We need a timeout in order for RedisConnection::loop() to properly
    * terminate after the node is stopped */
@@ -276,10 +368,18 @@ int villas::node::redis_destroy(NodeCompat *n) {
 
   using string = std::string;
   using redis_co = sw::redis::ConnectionOptions;
+  using thread = std::thread;
+  using atomic_bool = std::atomic<bool>;
+  using field_map = std::unordered_map<std::string, unsigned>;
+  using kv_vector = std::vector<std::pair<std::string, std::string>>;
 
   r->options.~redis_co();
   r->key.~string();
   r->task.~Task();
+  r->poller.~thread();
+  r->polling.~atomic_bool();
+  r->fields.~field_map();
+  r->kvs.~kv_vector();
 
   ret = queue_signalled_destroy(&r->queue);
   if (ret)
@@ -311,6 +411,8 @@ int villas::node::redis_parse(NodeCompat *n, json_t *json) {
   int keepalive = -1;
   int db = -1;
   int notify = -1;
+  int async = -1;
+  int transaction = -1;
 
   double connect_timeout = -1;
   double socket_timeout = -1;
@@ -318,12 +420,14 @@ int villas::node::redis_parse(NodeCompat *n, json_t *json) {
   ret = json_unpack_ex(
       json, &err, 0,
       "{ s?: o, s?: s, s?: s, s?: i, s?: s, s?: s, s?: s, s?: i, s?: { s?: F, "
-      "s?: F }, s?: o, s?: b, s?: s, s?: s, s?: s, s?: b, s?: F }",
+      "s?: F }, s?: o, s?: b, s?: s, s?: s, s?: s, s?: b, s?: F, s?: b, "
+      "s?: b }",
       "format", &json_format, "uri", &uri, "host", &host, "port",
       &r->options.port, "path", &path, "user", &user, "password", &password,
       "db", &db, "timeout", "connect", &connect_timeout, "socket",
       &socket_timeout, "ssl", &json_ssl, "keepalive", &keepalive, "mode", &mode,
-      "key", &key, "channel", &channel, "notify", &notify, "rate", &r->rate);
+      "key", &key, "channel", &channel, "notify", &notify, "rate", &r->rate,
+      "async", &async, "transaction", &transaction);
   if (ret)
     throw ConfigError(json, err, "node-config-node-redis",
                       "Failed to parse node configuration");
@@ -390,6 +494,12 @@ int villas::node::redis_parse(NodeCompat *n, json_t *json) {
   if (notify >= 0)
     r->notify = notify != 0;
 
+  if (async >= 0)
+    r->async = async != 0;
+
+  if (transaction >= 0)
+    r->transaction = transaction != 0;
+
   // Connection options
   if (uri)
     r->options = make_redis_connection_options(uri);
@@ -444,7 +554,9 @@ char *villas::node::redis_print(NodeCompat *n) {
      << ", notify=" << (r->notify ? "yes" : "no");
 
   if (!r->notify)
-    ss << ", rate=" << r->rate;
+    ss << ", rate=" << r->rate << ", async=" << (r->async ? "yes" : "no");
+
+  ss << ", transaction=" << (r->transaction ? "yes" : "no");
 
   ss << ", " << r->options;
 
@@ -461,6 +573,12 @@ int villas::node::redis_prepare(NodeCompat *n) {
   if (r->key.empty())
     r->key = n->getNameShort();
 
+  r->fields.clear();
+
+  unsigned j = 0;
+  for (auto sig : *n->getInputSignals(false))
+    r->fields[sig->name] = j++;
+
   ret = queue_signalled_init(&r->queue, 1024);
   if (ret)
     return ret;
@@ -500,6 +618,11 @@ int villas::node::redis_start(NodeCompat *n) {
 
   r->conn->start();
 
+  if (!r->notify && r->async && r->mode != RedisMode::CHANNEL) {
+    r->polling = true;
+    r->poller = std::thread(redis_poll, n);
+  }
+
   return 0;
 }
 
@@ -509,9 +632,20 @@ int villas::node::redis_stop(NodeCompat *n) {
 
   r->conn->stop();
 
+  if (r->poller.joinable()) {
+    r->polling = false;
+    r->poller.join();
+  }
+
   if (!r->notify)
     r->task.stop();
 
+  delete r->pipeline;
+  delete r->tx;
+
+  r->pipeline = nullptr;
+  r->tx = nullptr;
+
   switch (r->mode) {
   case RedisMode::CHANNEL:
     r->conn->unsubscribe(n, r->key);
@@ -538,7 +672,7 @@ int villas::node::redis_read(NodeCompat *n, struct Sample *const smps[],
   auto *r = n->getData<struct redis>();
 
   // Wait for new data
-  if (r->notify || r->mode == RedisMode::CHANNEL) {
+  if (r->notify || r->async || r->mode == RedisMode::CHANNEL) {
     int pulled_cnt;
     struct Sample *pulled_smps[cnt];
 
@@ -559,65 +693,43 @@ int villas::node::redis_read(NodeCompat *n, struct Sample *const smps[],
 
 int villas::node::redis_write(NodeCompat *n, struct Sample *const smps[],
                               unsigned cnt) {
-  int ret;
   auto *r = n->getData<struct redis>();
 
-  switch (r->mode) {
-  case RedisMode::CHANNEL:
-    for (unsigned i = 0; i < cnt; i++) {
-      char buf[1500];
-      size_t wbytes;
-
-      ret = r->formatter->sprint(buf, sizeof(buf), &wbytes, &smps[i], cnt);
-      if (ret < 0)
-        return ret;
-
-      auto value = std::string_view(buf, wbytes);
-
-      r->conn->context.publish(r->key, value);
+  /* The pipeline and transaction use their own connection and must be
+   * recreated after errors. The transaction is piped, so that the queued
+   * commands are sent together with EXEC in a single round trip. */
+  try {
+    if (r->transaction) {
+      if (!r->tx)
+        r->tx = new sw::redis::Transaction(
+            r->conn->context.transaction(true));
+
+      return redis_write_queued(n, *r->tx, smps, cnt);
+    } else {
+      if (!r->pipeline)
+        r->pipeline = new sw::redis::Pipeline(r->conn->context.pipeline());
+
+      return redis_write_queued(n, *r->pipeline, smps, cnt);
     }
-    break;
-
-  case RedisMode::KEY: {
-    char buf[1500];
-    size_t wbytes;
-
-    ret = r->formatter->sprint(buf, sizeof(buf), &wbytes, smps, cnt);
-    if (ret < 0)
-      return ret;
-
-    auto value = std::string_view(buf, wbytes);
-
-    r->conn->context.set(r->key, value);
-    break;
-  }
-
-  case RedisMode::HASH: {
-    // We only update the signals with their latest value here.
-    struct Sample *smp = smps[cnt - 1];
-
-    std::unordered_map<std::string, std::string> kvs;
+  } catch (const sw::redis::Error &e) {
+    n->logger->error("Failed to write: {}", e.what());
 
-    unsigned len = MIN(smp->signals->size(), smp->length);
-    for (unsigned j = 0; j < len; j++) {
-      const auto sig = smp->signals->getByIndex(j);
-      const auto *data = &smp->data[j];
+    delete r->pipeline;
+    delete r->tx;
 
-      kvs[sig->name] = data->toString(sig->type);
-    }
+    r->pipeline = nullptr;
+    r->tx = nullptr;
 
-    r->conn->context.hmset(r->key, kvs.begin(), kvs.end());
-    break;
-  }
+    return -1;
   }
-
-  return cnt;
 }
 
 int villas::node::redis_poll_fds(NodeCompat *n, int fds[]) {
   auto *r = n->getData<struct redis>();
 
-  fds[0] = r->notify ? queue_signalled_fd(&r->queue) : r->task.getFD();
+  fds[0] = r->notify || r->async || r->mode == RedisMode::CHANNEL
+               ? queue_signalled_fd(&r->queue)
+               : r->task.getFD();
 
   return 1;
 }
@@ -31,32 +31,64 @@ int villas::node::shmem_init(NodeCompat *n) {
   // Default values
   shm->conf.queuelen = -1;
   shm->conf.samplelen = -1;
-  shm->conf.polling = false;
+  shm->conf.mode = QueueSignalledMode::PTHREAD;
   shm->exec = nullptr;
+  shm->state = false;
+  shm->rate = 0;
+
+  new (&shm->task) Task(CLOCK_MONOTONIC);
+
+  return 0;
+}
+
+int villas::node::shmem_destroy(NodeCompat *n) {
+  auto *shm = n->getData<struct shmem>();
+
+  shm->task.~Task();
 
   return 0;
 }
 
 int villas::node::shmem_parse(NodeCompat *n, json_t *json) {
   auto *shm = n->getData<struct shmem>();
-  const char *val, *mode_str = nullptr;
+  const char *val, *mode_str = nullptr, *layout_str = nullptr;
 
   int ret;
   json_t *json_exec = nullptr;
   json_error_t err;
 
   ret = json_unpack_ex(
-      json, &err, 0, "{ s: { s: s }, s: { s: s }, s?: i, s?: o, s?: s }", "out",
+      json, &err, 0,
+      "{ s: { s: s }, s: { s: s }, s?: i, s?: o, s?: s, s?: s, s?: F }", "out",
       "name", &shm->out_name, "in", "name", &shm->in_name, "queuelen",
-      &shm->conf.queuelen, "exec", &json_exec, "mode", &mode_str);
+      &shm->conf.queuelen, "exec", &json_exec, "mode", &mode_str, "layout",
+      &layout_str, "rate", &shm->rate);
   if (ret)
     throw ConfigError(json, err, "node-config-node-shmem");
 
+  if (layout_str) {
+    if (!strcmp(layout_str, "queue"))
+      shm->state = false;
+    else if (!strcmp(layout_str, "state"))
+      shm->state = true;
+    else
+      throw ConfigError(json, "node-config-node-shmem-layout",
+                        "Unknown layout '{}'", layout_str);
+  }
+
+  if (shm->state && shm->rate <= 0)
+    throw ConfigError(json, "node-config-node-shmem-rate",
+                      "Setting 'rate' must be positive for layout 'state'");
+
   if (mode_str) {
     if (!strcmp(mode_str, "polling"))
-      shm->conf.polling = true;
+      shm->conf.mode = QueueSignalledMode::POLLING;
     else if (!strcmp(mode_str, "pthread"))
-      shm->conf.polling = false;
+      shm->conf.mode = QueueSignalledMode::PTHREAD;
+#ifdef HAS_FUTEX
+    else if (!strcmp(mode_str, "futex"))
+      shm->conf.mode = QueueSignalledMode::FUTEX;
+#endif
     else
       throw SystemError("Unknown mode '{}'", mode_str);
   }
@@ -108,6 +140,23 @@ int villas::node::shmem_start(NodeCompat *n) {
   auto *shm = n->getData<struct shmem>();
   int ret;
 
+  /* In state layout, we create both regions before spawning the external
+   * program so it can map them right away. */
+  if (shm->state) {
+    ret = shmem_state_open(shm->in_name, &shm->state_in,
+                           n->getInputSignals(false)->size(), true);
+    if (ret < 0)
+      throw SystemError("Failed to create input state vector (ret={})", ret);
+
+    ret = shmem_state_open(shm->out_name, &shm->state_out,
+                           shm->conf.samplelen, true);
+    if (ret < 0)
+      throw SystemError("Failed to create output state vector (ret={})", ret);
+
+    shm->last_seq = 0;
+    shm->task.setRate(shm->rate);
+  }
+
   if (shm->exec) {
     ret = spawn(shm->exec[0], shm->exec);
     if (!ret)
@@ -116,6 +165,9 @@ int villas::node::shmem_start(NodeCompat *n) {
     sleep(1);
   }
 
+  if (shm->state)
+    return 0;
+
   ret = shmem_int_open(shm->out_name, shm->in_name, &shm->intf, &shm->conf);
   if (ret < 0)
     throw SystemError("Opening shared memory interface failed (ret={})", ret);
@@ -125,16 +177,52 @@ int villas::node::shmem_start(NodeCompat *n) {
 
 int villas::node::shmem_stop(NodeCompat *n) {
   auto *shm = n->getData<struct shmem>();
+  int ret, ret2;
+
+  if (shm->state) {
+    shm->task.stop();
+
+    // Tear down both regions and report the first error
+    ret = shmem_state_close(&shm->state_in, true);
+    ret2 = shmem_state_close(&shm->state_out, true);
+
+    return ret ? ret : ret2;
+  }
 
   return shmem_int_close(&shm->intf);
 }
 
+static int shmem_read_state(NodeCompat *n, struct Sample *const smps[],
+                            unsigned cnt) {
+  auto *shm = n->getData<struct shmem>();
+  int ret;
+
+  if (shm->task.wait() == 0)
+    throw SystemError("Failed to wait for task");
+
+  // Skip the tick if the external process did not update the state
+  ret = shmem_state_read(shm->state_in.state, smps[0], &shm->last_seq);
+  if (ret < 0) {
+    n->logger->warn("Failed to take a consistent snapshot of the input state. "
+                    "Skipping tick");
+    return 0;
+  } else if (ret == 0)
+    return 0;
+
+  smps[0]->signals = n->getInputSignals(false);
+
+  return 1;
+}
+
 int villas::node::shmem_read(NodeCompat *n, struct Sample *const smps[],
                              unsigned cnt) {
   auto *shm = n->getData<struct shmem>();
   int recv;
   struct Sample *shared_smps[cnt];
 
+  if (shm->state)
+    return shmem_read_state(n, smps, cnt);
+
   do {
     recv = shmem_int_read(&shm->intf, shared_smps, cnt);
   } while (recv == 0);
@@ -167,6 +255,10 @@ int villas::node::shmem_write(NodeCompat *n, struct Sample *const smps[],
       *shared_smps[cnt]; // Samples need to be copied to the shared pool first
   int avail, pushed, copied;
 
+  // Only the latest sample of a batch is visible in the state vector
+  if (shm->state)
+    return shmem_state_write(shm->state_out.state, smps[cnt - 1]) ? cnt : 0;
+
   avail = sample_alloc_many(&shm->intf.write.shared->pool, shared_smps, cnt);
   if (avail != (int)cnt)
     n->logger->warn("Pool underrun for shmem node {}", shm->out_name);
@@ -186,9 +278,27 @@ char *villas::node::shmem_print(NodeCompat *n) {
   auto *shm = n->getData<struct shmem>();
   char *buf = nullptr;
 
-  strcatf(&buf, "out_name=%s, in_name=%s, queuelen=%d, polling=%s",
-          shm->out_name, shm->in_name, shm->conf.queuelen,
-          shm->conf.polling ? "yes" : "no");
+  const char *mode_str;
+  switch (shm->conf.mode) {
+  case QueueSignalledMode::POLLING:
+    mode_str = "polling";
+    break;
+
+#ifdef HAS_FUTEX
+  case QueueSignalledMode::FUTEX:
+    mode_str = "futex";
+    break;
+#endif
+
+  default:
+    mode_str = "pthread";
+  }
+
+  strcatf(&buf, "out_name=%s, in_name=%s, queuelen=%d, mode=%s",
+          shm->out_name, shm->in_name, shm->conf.queuelen, mode_str);
+
+  if (shm->state)
+    strcatf(&buf, ", layout=state, rate=%.1f", shm->rate);
 
   if (shm->exec) {
     strcatf(&buf, ", exec='");
@@ -217,6 +327,7 @@ __attribute__((constructor(110))) static void register_plugin() {
   p.write = shmem_write;
   p.prepare = shmem_prepare;
   p.init = shmem_init;
+  p.destroy = shmem_destroy;
 
   static NodeCompatFactory ncp(&p);
 }
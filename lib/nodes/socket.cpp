@@ -20,6 +20,7 @@
 #include <villas/utils.hpp>
 
 #ifdef WITH_SOCKET_LAYER_ETH
+#include <net/if.h>
 #include <netinet/ether.h>
 #endif // WITH_SOCKET_LAYER_ETH
 
@@ -37,6 +38,125 @@ using namespace villas::kernel;
 static NodeCompatType p;
 static NodeCompatFactory ncp(&p);
 
+#ifdef WITH_SOCKET_LAYER_XDP
+#define ETH_HDR_LEN 14
+#define ETH_VLAN_TAG_LEN 4
+
+static xdp::Endpoint *socket_xdp_endpoint(struct Socket *s,
+                                          union sockaddr_union *sa) {
+  char ifname[IF_NAMESIZE];
+
+  if (!if_indextoname(sa->sll.sll_ifindex, ifname))
+    throw SystemError("Failed to get name of interface {}",
+                      sa->sll.sll_ifindex);
+
+  return new xdp::Endpoint(ifname, &s->xdp);
+}
+
+static int socket_xdp_read(NodeCompat *n, struct Sample *const smps[],
+                           unsigned cnt) {
+  auto *s = n->getData<struct Socket>();
+  unsigned rcvd = 0, frames = 0;
+
+  auto handler = [&](const uint8_t *frame, size_t len) {
+    if (len < ETH_HDR_LEN)
+      return;
+
+    auto *eh = (const struct ether_header *)frame;
+    uint16_t type = ntohs(eh->ether_type);
+    size_t hdrlen = ETH_HDR_LEN;
+
+    // Skip an IEEE 802.1Q tag
+    if (type == ETHERTYPE_VLAN && len >= ETH_HDR_LEN + ETH_VLAN_TAG_LEN) {
+      type = ntohs(*(const uint16_t *)(frame + ETH_HDR_LEN + 2));
+      hdrlen += ETH_VLAN_TAG_LEN;
+    }
+
+    // All frames of the queue end up here, not only ours
+    if (type != ntohs(s->in.saddr.sll.sll_protocol))
+      return;
+
+    if (s->verify_source &&
+        memcmp(eh->ether_shost, s->out.saddr.sll.sll_addr, ETHER_ADDR_LEN)) {
+      n->logger->warn("Received packet from unauthorized source: {}",
+                      ether_ntoa((const struct ether_addr *)eh->ether_shost));
+      return;
+    }
+
+    size_t rbytes, bytes = len - hdrlen;
+
+    int ret = s->formatter->sscan((const char *)frame + hdrlen, bytes,
+                                  &rbytes, smps + rcvd, cnt - rcvd);
+    if (ret < 0 || bytes != rbytes)
+      n->logger->warn("Received invalid packet: ret={}, bytes={}, rbytes={}",
+                      ret, bytes, rbytes);
+
+    if (ret > 0)
+      rcvd += ret;
+  };
+
+  /* Descriptors are consumed in batches. Each frame carries at least one
+   * sample, so no more frames than free samples are taken at once. */
+  while (rcvd < cnt && frames < cnt) {
+    unsigned max = std::min(cnt - rcvd, cnt - frames);
+
+    unsigned got = s->xdp_ep->receive(max, handler);
+    if (got == 0)
+      break;
+
+    frames += got;
+  }
+
+  return rcvd;
+}
+
+static int socket_xdp_write(NodeCompat *n, struct Sample *const smps[],
+                            unsigned cnt) {
+  auto *s = n->getData<struct Socket>();
+  auto &tx = s->xdp_ep->getTx();
+
+  int ret, written;
+  size_t wbytes;
+
+  uint8_t *frame = tx.reserve();
+  if (!frame) {
+    n->logger->warn("No free AF_XDP frames left for sending");
+    return 0;
+  }
+
+  // Frames are formatted in place, no copy into the kernel is required
+  ret = s->formatter->sprint((char *)frame + ETH_HDR_LEN,
+                             s->xdp_ep->getFrameSize() - ETH_HDR_LEN, &wbytes,
+                             smps, cnt);
+  if (ret < 0) {
+    n->logger->warn("Failed to format payload: reason={}", ret);
+    return ret;
+  }
+
+  if (wbytes == 0 || wbytes > s->xdp_ep->getFrameSize() - ETH_HDR_LEN) {
+    n->logger->warn("Failed to format payload: wbytes={}", wbytes);
+    return -1;
+  }
+
+  written = ret;
+
+  auto *eh = (struct ether_header *)frame;
+  memcpy(eh->ether_dhost, s->out.saddr.sll.sll_addr, ETHER_ADDR_LEN);
+  memcpy(eh->ether_shost, s->xdp_ep->getAddress(), ETHER_ADDR_LEN);
+  eh->ether_type = s->out.saddr.sll.sll_protocol;
+
+  ret = tx.submit(ETH_HDR_LEN + wbytes);
+  if (ret) {
+    n->logger->warn("AF_XDP transmit ring is full");
+    return 0;
+  }
+
+  tx.flush();
+
+  return written;
+}
+#endif // WITH_SOCKET_LAYER_XDP
+
 int villas::node::socket_type_start(villas::node::SuperNode *sn) {
 #ifdef WITH_NETEM
   if (sn != nullptr) {
@@ -64,6 +184,10 @@ int villas::node::socket_init(NodeCompat *n) {
 
   s->formatter = nullptr;
 
+#ifdef WITH_SOCKET_LAYER_XDP
+  s->xdp_ep = nullptr;
+#endif // WITH_SOCKET_LAYER_XDP
+
   return 0;
 }
 
@@ -104,6 +228,11 @@ char *villas::node::socket_print(NodeCompat *n) {
 
   buf = strf("layer=%s, in.address=%s, out.address=%s", layer, local, remote);
 
+#ifdef WITH_SOCKET_LAYER_XDP
+  if (s->xdp.enabled)
+    strcatf(&buf, ", xdp.queues=%u", s->xdp.num_queues);
+#endif // WITH_SOCKET_LAYER_XDP
+
   if (s->multicast.enabled) {
     char group[INET_ADDRSTRLEN];
     char interface[INET_ADDRSTRLEN];
@@ -154,6 +283,18 @@ int villas::node::socket_check(NodeCompat *n) {
   }
 #endif // WITH_SOCKET_LAYER_ETH
 
+#ifdef WITH_SOCKET_LAYER_XDP
+  if (s->xdp.enabled && s->layer != SocketLayer::ETH)
+    throw RuntimeError("AF_XDP is only supported by the 'eth' layer");
+
+  /* An endpoint on the remote interface would redirect all frames arriving
+   * there into receive rings which are never read. */
+  if (s->xdp.enabled &&
+      s->in.saddr.sll.sll_ifindex != s->out.saddr.sll.sll_ifindex)
+    throw RuntimeError("AF_XDP requires local and remote addresses to use the "
+                       "same interface");
+#endif // WITH_SOCKET_LAYER_XDP
+
   if (s->multicast.enabled) {
     if (s->in.saddr.sa.sa_family != AF_INET)
       throw RuntimeError("Multicast is only supported by IPv4");
@@ -173,6 +314,18 @@ int villas::node::socket_start(NodeCompat *n) {
   // Initialize IO
   s->formatter->start(n->getInputSignals(false), ~(int)SampleFlags::HAS_OFFSET);
 
+#ifdef WITH_SOCKET_LAYER_XDP
+  if (s->xdp.enabled) {
+    s->sd = -1;
+
+    s->xdp_ep = socket_xdp_endpoint(s, &s->in.saddr);
+
+    s->in.buf = s->out.buf = nullptr;
+
+    return 0;
+  }
+#endif // WITH_SOCKET_LAYER_XDP
+
   // Create socket
   switch (s->layer) {
   case SocketLayer::UDP:
@@ -324,6 +477,11 @@ int villas::node::socket_stop(NodeCompat *n) {
   delete[] s->in.buf;
   delete[] s->out.buf;
 
+#ifdef WITH_SOCKET_LAYER_XDP
+  delete s->xdp_ep;
+  s->xdp_ep = nullptr;
+#endif // WITH_SOCKET_LAYER_XDP
+
   return 0;
 }
 
@@ -339,6 +497,11 @@ int villas::node::socket_read(NodeCompat *n, struct Sample *const smps[],
   union sockaddr_union src;
   socklen_t srclen = sizeof(src);
 
+#ifdef WITH_SOCKET_LAYER_XDP
+  if (s->xdp_ep)
+    return socket_xdp_read(n, smps, cnt);
+#endif // WITH_SOCKET_LAYER_XDP
+
   // Receive next sample
   bytes = recvfrom(s->sd, s->in.buf, s->in.buflen, 0, &src.sa, &srclen);
   if (bytes < 0) {
@@ -397,6 +560,11 @@ int villas::node::socket_write(NodeCompat *n, struct Sample *const smps[],
   ssize_t bytes;
   size_t wbytes;
 
+#ifdef WITH_SOCKET_LAYER_XDP
+  if (s->xdp_ep)
+    return socket_xdp_write(n, smps, cnt);
+#endif // WITH_SOCKET_LAYER_XDP
+
 retry:
   ret = s->formatter->sprint(s->out.buf, s->out.buflen, &wbytes, smps, cnt);
   if (ret < 0) {
@@ -471,19 +639,30 @@ int villas::node::socket_parse(NodeCompat *n, json_t *json) {
   json_error_t err;
   json_t *json_multicast = nullptr;
   json_t *json_format = nullptr;
+  json_t *json_xdp = nullptr;
 
   // Default values
   s->layer = SocketLayer::UDP;
   s->verify_source = 0;
 
   ret = json_unpack_ex(
-      json, &err, 0, "{ s?: s, s?: o, s: { s: s }, s: { s: s, s?: b, s?: o } }",
-      "layer", &layer, "format", &json_format, "out", "address", &remote, "in",
-      "address", &local, "verify_source", &s->verify_source, "multicast",
-      &json_multicast);
+      json, &err, 0,
+      "{ s?: s, s?: o, s?: o, s: { s: s }, s: { s: s, s?: b, s?: o } }",
+      "layer", &layer, "format", &json_format, "xdp", &json_xdp, "out",
+      "address", &remote, "in", "address", &local, "verify_source",
+      &s->verify_source, "multicast", &json_multicast);
   if (ret)
     throw ConfigError(json, err, "node-config-node-socket");
 
+  if (json_xdp) {
+#ifdef WITH_SOCKET_LAYER_XDP
+    xdp::parse(json_xdp, &s->xdp);
+#else
+    throw ConfigError(json_xdp, "node-config-node-socket-xdp",
+                      "This build has no AF_XDP support");
+#endif // WITH_SOCKET_LAYER_XDP
+  }
+
   // Format
   if (s->formatter)
     delete s->formatter;
@@ -558,6 +737,11 @@ int villas::node::socket_parse(NodeCompat *n, json_t *json) {
 int villas::node::socket_fds(NodeCompat *n, int fds[]) {
   auto *s = n->getData<struct Socket>();
 
+#ifdef WITH_SOCKET_LAYER_XDP
+  if (s->xdp_ep)
+    return s->xdp_ep->getFDs(fds);
+#endif // WITH_SOCKET_LAYER_XDP
+
   fds[0] = s->sd;
 
   return 1;
@@ -10,6 +10,8 @@
 #include <cstring>
 #include <unistd.h>
 
+#include <algorithm>
+
 #include <villas/exceptions.hpp>
 #include <villas/node_compat.hpp>
 #include <villas/nodes/websocket.hpp>
@@ -58,6 +60,12 @@ static int websocket_connection_init(struct websocket_connection *c) {
   if (!c->buffers.recv || !c->buffers.send)
     throw MemoryAllocationError();
 
+  c->frames.queue = new std::deque<std::shared_ptr<WebSocketFrame>>;
+  c->frames.lock = new std::mutex;
+  c->frames.sent = 0;
+  c->frames.dropped = 0;
+  c->frames.backlog = 0;
+
   c->state = websocket_connection::State::INITIALIZED;
 
   return 0;
@@ -83,6 +91,12 @@ static int websocket_connection_destroy(struct websocket_connection *c) {
   delete c->buffers.recv;
   delete c->buffers.send;
 
+  // Releases our references to the shared frames
+  delete c->frames.queue;
+  delete c->frames.lock;
+
+  free(c->format);
+
   c->wsi = nullptr;
   c->state = websocket_connection::State::DESTROYED;
 
@@ -115,6 +129,50 @@ static int websocket_connection_write(struct websocket_connection *c,
   return 0;
 }
 
+static void websocket_connection_enqueue(struct websocket_connection *c,
+                                         std::shared_ptr<WebSocketFrame> frame) {
+  auto *w = c->node->getData<struct websocket>();
+
+  if (c->state != websocket_connection::State::ESTABLISHED)
+    return;
+
+  {
+    std::lock_guard guard(*c->frames.lock);
+
+    if (c->frames.queue->size() >= w->frame_queue_length) {
+      if (c->frames.dropped == 0)
+        c->node->logger->warn(
+            "Connection can not keep up with sending rate: {}, backlog={}",
+            c->toString(), c->frames.queue->size());
+
+      switch (w->overflow) {
+      case WebSocketOverflow::DROP_OLDEST:
+        c->frames.queue->pop_front();
+        c->frames.dropped++;
+        break;
+
+      case WebSocketOverflow::DROP_NEWEST:
+        c->frames.dropped++;
+        return;
+
+      case WebSocketOverflow::DISCONNECT:
+        c->frames.dropped += c->frames.queue->size() + 1;
+        c->frames.queue->clear();
+        c->state = websocket_connection::State::CLOSING;
+        break;
+      }
+    }
+
+    if (c->state == websocket_connection::State::ESTABLISHED) {
+      c->frames.queue->push_back(frame);
+      c->frames.backlog =
+          std::max(c->frames.backlog, c->frames.queue->size());
+    }
+  }
+
+  web->callbackOnWritable(c->wsi);
+}
+
 static void websocket_connection_close(struct websocket_connection *c,
                                        struct lws *wsi,
                                        enum lws_close_status status,
@@ -128,6 +186,38 @@ static void websocket_connection_close(struct websocket_connection *c,
   c->state = websocket_connection::State::CLOSED;
 }
 
+// Find the node which is addressed by the request URI of a server connection
+static NodeCompat *websocket_lookup_node(struct lws *wsi) {
+  char *node, *lasts;
+  char uri[64];
+
+  if (lws_hdr_copy(wsi, uri, sizeof(uri), WSI_TOKEN_GET_URI) <= 0)
+    return nullptr;
+
+  node = strtok_r(uri, "/.", &lasts);
+  if (!node)
+    return nullptr;
+
+  return dynamic_cast<NodeCompat *>(ncp.instances.lookup(node));
+}
+
+/* Check whether permessage-deflate may be used for a connection.
+ *
+ * Clients of server connections can override the setting of the node
+ * with the "compression" argument of the request URI.
+ *
+ * Example: ws://example.com/node_1.json?compression=0
+ */
+static bool websocket_compression(struct lws *wsi, NodeCompat *n,
+                                  bool server) {
+  char arg[16];
+
+  if (server && lws_get_urlarg_by_name(wsi, "compression=", arg, sizeof(arg)))
+    return strcmp(arg, "0") && strcmp(arg, "false");
+
+  return n->getData<struct websocket>()->compression;
+}
+
 int villas::node::websocket_protocol_cb(struct lws *wsi,
                                         enum lws_callback_reasons reason,
                                         void *user, void *in, size_t len) {
@@ -135,6 +225,20 @@ int villas::node::websocket_protocol_cb(struct lws *wsi,
   struct websocket_connection *c = (struct websocket_connection *)user;
 
   switch (reason) {
+  case LWS_CALLBACK_CONFIRM_EXTENSION_OKAY:
+  case LWS_CALLBACK_CLIENT_CONFIRM_EXTENSION_SUPPORTED: {
+    bool server = reason == LWS_CALLBACK_CONFIRM_EXTENSION_OKAY;
+    auto *n = server ? websocket_lookup_node(wsi) : (c ? c->node : nullptr);
+
+    // A non-zero return value rejects the extension for this connection
+    if (n && !websocket_compression(wsi, n, server)) {
+      n->logger->debug("Rejecting WebSocket extension: {}", (char *)in);
+      return 1;
+    }
+
+    break;
+  }
+
   case LWS_CALLBACK_CLIENT_ESTABLISHED:
   case LWS_CALLBACK_ESTABLISHED:
     if (reason == LWS_CALLBACK_CLIENT_ESTABLISHED)
@@ -198,6 +302,8 @@ int villas::node::websocket_protocol_cb(struct lws *wsi,
         c->node->logger->warn("Failed to find format: format={}", format);
         return -1;
       }
+
+      c->format = strdup(format);
     }
 
     ret = websocket_connection_init(c);
@@ -233,6 +339,12 @@ int villas::node::websocket_protocol_cb(struct lws *wsi,
     c->state = websocket_connection::State::CLOSED;
     c->node->logger->debug("Closed WebSocket connection: {}", c->toString());
 
+    if (c->frames.dropped > 0)
+      c->node->logger->warn("Connection was too slow: {}, frames_sent={}, "
+                            "frames_dropped={}, max_backlog={}",
+                            c->toString(), c->frames.sent, c->frames.dropped,
+                            c->frames.backlog);
+
     if (c->state != websocket_connection::State::CLOSING) {
       // TODO: Attempt reconnect here
     }
@@ -254,6 +366,32 @@ int villas::node::websocket_protocol_cb(struct lws *wsi,
   case LWS_CALLBACK_CLIENT_WRITEABLE:
   case LWS_CALLBACK_SERVER_WRITEABLE: {
     struct Sample *smps[cnt];
+    std::shared_ptr<WebSocketFrame> frame;
+    bool pending;
+
+    // Shared frames of broadcast mode are sent one per callback
+    {
+      std::lock_guard guard(*c->frames.lock);
+
+      if (!c->frames.queue->empty()) {
+        frame = c->frames.queue->front();
+        c->frames.queue->pop_front();
+      }
+
+      pending = !c->frames.queue->empty();
+    }
+
+    if (frame) {
+      ret = lws_write(wsi, (unsigned char *)frame->payload(), frame->length(),
+                      frame->binary ? LWS_WRITE_BINARY : LWS_WRITE_TEXT);
+      if (ret < 0)
+        return ret;
+
+      c->frames.sent++;
+
+      c->node->logger->debug("Send {} samples to connection: {}, bytes={}",
+                             frame->samples, c->toString(), ret);
+    }
 
     pulled = queue_pull_many(&c->queue, (void **)smps, cnt);
     if (pulled > 0) {
@@ -275,11 +413,18 @@ int villas::node::websocket_protocol_cb(struct lws *wsi,
                              pulled, c->toString(), ret);
     }
 
-    if (queue_available(&c->queue) > 0)
+    if (queue_available(&c->queue) > 0 || pending)
       lws_callback_on_writable(wsi);
     else if (c->state == websocket_connection::State::CLOSING) {
-      websocket_connection_close(c, wsi, LWS_CLOSE_STATUS_GOINGAWAY,
-                                 "Node stopped");
+      auto *w = c->node->getData<struct websocket>();
+
+      // With the disconnect policy, dropped frames imply an overflow
+      if (w->overflow == WebSocketOverflow::DISCONNECT && c->frames.dropped > 0)
+        websocket_connection_close(c, wsi, LWS_CLOSE_STATUS_POLICY_VIOLATION,
+                                   "Too slow");
+      else
+        websocket_connection_close(c, wsi, LWS_CLOSE_STATUS_GOINGAWAY,
+                                   "Node stopped");
       return -1;
     }
 
@@ -367,6 +512,12 @@ int villas::node::websocket_init(NodeCompat *n) {
   auto *w = n->getData<struct websocket>();
 
   w->wait = false;
+  w->compression = true;
+  w->broadcast = false;
+  w->frame_queue_length = DEFAULT_WEBSOCKET_FRAME_QUEUE_LENGTH;
+  w->overflow = WebSocketOverflow::DROP_OLDEST;
+
+  w->formatters = new std::map<std::string, Format *>;
 
   int ret = list_init(&w->destinations);
   if (ret)
@@ -407,6 +558,7 @@ int villas::node::websocket_start(NodeCompat *n) {
     if (!c->formatter)
       return -1;
 
+    c->format = strdup(format);
     c->node = n;
     c->destination = d;
 
@@ -497,6 +649,11 @@ int villas::node::websocket_destroy(NodeCompat *n) {
   if (ret)
     return ret;
 
+  for (auto &it : *w->formatters)
+    delete it.second;
+
+  delete w->formatters;
+
   return 0;
 }
 
@@ -517,6 +674,80 @@ int villas::node::websocket_read(NodeCompat *n, struct Sample *const smps[],
   return avail;
 }
 
+/* Serialize a batch of samples into one or more frames.
+ *
+ * Formatters are kept per node and format, as they are only used by the
+ * writing thread.
+ */
+static std::vector<std::shared_ptr<WebSocketFrame>>
+websocket_serialize(NodeCompat *n, const char *format,
+                    struct Sample *const smps[], unsigned cnt) {
+  auto *w = n->getData<struct websocket>();
+  std::vector<std::shared_ptr<WebSocketFrame>> frames;
+  Format *formatter;
+
+  auto it = w->formatters->find(format);
+  if (it == w->formatters->end()) {
+    formatter = FormatFactory::make(format);
+    if (!formatter)
+      return frames;
+
+    formatter->start(n->getInputSignals(false), ~(int)SampleFlags::HAS_OFFSET);
+
+    w->formatters->emplace(format, formatter);
+  } else
+    formatter = it->second;
+
+  auto isBinary = dynamic_cast<BinaryFormat *>(formatter) != nullptr;
+
+  // Samples which do not fit into a single frame are split across multiple frames
+  for (unsigned i = 0; i < cnt;) {
+    size_t wbytes;
+    auto frame = std::make_shared<WebSocketFrame>(DEFAULT_WEBSOCKET_BUFFER_SIZE,
+                                                  isBinary);
+
+    int ret = formatter->sprint(frame->payload(), frame->length(), &wbytes,
+                                &smps[i], cnt - i);
+    if (ret <= 0) {
+      n->logger->warn("Failed to serialize samples: format={}", format);
+      break;
+    }
+
+    frame->setLength(wbytes);
+    frame->samples = ret;
+
+    frames.push_back(frame);
+
+    i += ret;
+  }
+
+  return frames;
+}
+
+static int websocket_broadcast(NodeCompat *n, struct Sample *const smps[],
+                               unsigned cnt) {
+  // Each format is serialized only once per batch
+  std::map<std::string, std::vector<std::shared_ptr<WebSocketFrame>>> frames;
+
+  std::lock_guard guard(connections_lock);
+
+  for (auto *c : connections) {
+    if (c->node != n || c->state != websocket_connection::State::ESTABLISHED)
+      continue;
+
+    auto it = frames.find(c->format);
+    if (it == frames.end())
+      it = frames
+               .emplace(c->format, websocket_serialize(n, c->format, smps, cnt))
+               .first;
+
+    for (auto &frame : it->second)
+      websocket_connection_enqueue(c, frame);
+  }
+
+  return cnt;
+}
+
 int villas::node::websocket_write(NodeCompat *n, struct Sample *const smps[],
                                   unsigned cnt) {
   int avail;
@@ -524,6 +755,9 @@ int villas::node::websocket_write(NodeCompat *n, struct Sample *const smps[],
   auto *w = n->getData<struct websocket>();
   struct Sample *cpys[cnt];
 
+  if (w->broadcast)
+    return websocket_broadcast(n, smps, cnt);
+
   // Make copies of all samples
   avail = sample_alloc_many(&w->pool, cpys, cnt);
   if (avail < (int)cnt)
@@ -535,7 +769,7 @@ int villas::node::websocket_write(NodeCompat *n, struct Sample *const smps[],
     std::lock_guard guard(connections_lock);
     for (auto *c : connections) {
       if (c->node == n)
-        websocket_connection_write(c, cpys, cnt);
+        websocket_connection_write(c, cpys, avail);
     }
   }
 
@@ -553,15 +787,47 @@ int villas::node::websocket_parse(NodeCompat *n, json_t *json) {
   json_t *json_dest;
   json_error_t err;
   int wc = -1;
-
-  ret = json_unpack_ex(json, &err, 0, "{ s?: o, s?: b }", "destinations",
-                       &json_dests, "wait_connected", &wc);
+  int cp = -1;
+  int bc = -1;
+  int ql = -1;
+  const char *overflow = nullptr;
+
+  ret = json_unpack_ex(
+      json, &err, 0, "{ s?: o, s?: b, s?: b, s?: b, s?: i, s?: s }",
+      "destinations", &json_dests, "wait_connected", &wc, "compression", &cp,
+      "broadcast", &bc, "queue_length", &ql, "overflow", &overflow);
   if (ret)
     throw ConfigError(json, err, "node-config-node-websocket");
 
   if (wc >= 0)
     w->wait = wc != 0;
 
+  if (cp >= 0)
+    w->compression = cp != 0;
+
+  if (bc >= 0)
+    w->broadcast = bc != 0;
+
+  if (ql >= 0) {
+    if (ql == 0)
+      throw ConfigError(json, "node-config-node-websocket-queue-length",
+                        "The 'queue_length' setting must be positive");
+
+    w->frame_queue_length = ql;
+  }
+
+  if (overflow) {
+    if (!strcmp(overflow, "drop_oldest"))
+      w->overflow = WebSocketOverflow::DROP_OLDEST;
+    else if (!strcmp(overflow, "drop_newest"))
+      w->overflow = WebSocketOverflow::DROP_NEWEST;
+    else if (!strcmp(overflow, "disconnect"))
+      w->overflow = WebSocketOverflow::DISCONNECT;
+    else
+      throw ConfigError(json, "node-config-node-websocket-overflow",
+                        "Invalid overflow policy: '{}'", overflow);
+  }
+
   list_clear(&w->destinations);
   if (json_dests) {
     if (!json_is_array(json_dests))
@@ -624,6 +890,9 @@ char *villas::node::websocket_print(NodeCompat *n) {
 
   buf = strcatf(&buf, "]");
 
+  if (w->broadcast)
+    buf = strcatf(&buf, ", broadcast=yes, queue_length=%u", w->frame_queue_length);
+
   return buf;
 }
 
@@ -6,6 +6,7 @@
  */
 
 #include <cstring>
+#include <unistd.h>
 #include <zmq.h>
 
 #if ZMQ_VERSION_MAJOR < 4 || (ZMQ_VERSION_MAJOR == 4 && ZMQ_VERSION_MINOR <= 1)
@@ -61,6 +62,19 @@ static int get_monitor_event(void *monitor, int *value, char **address) {
   return event;
 }
 
+// Called by ZeroMQ once a frame referencing the buffer has been sent or dropped
+static void zeromq_buffer_free(void *data, void *hint) {
+  auto *b = (struct zeromq_buffer *)hint;
+
+  if (--b->refcnt == 0)
+    pool_put(b->pool, b);
+}
+
+// Connection-less transports do not emit monitor events we could wait for
+static bool zeromq_endpoint_monitored(const char *ep) {
+  return strncmp(ep, "inproc://", 9) && strncmp(ep, "udp://", 6);
+}
+
 int villas::node::zeromq_reverse(NodeCompat *n) {
   auto *z = n->getData<struct zeromq>();
 
@@ -89,6 +103,8 @@ int villas::node::zeromq_init(NodeCompat *n) {
   z->in.pending = 0;
   z->out.pending = 0;
 
+  z->multipart = 0;
+
   ret = list_init(&z->in.endpoints);
   if (ret)
     return ret;
@@ -147,12 +163,12 @@ int villas::node::zeromq_parse(NodeCompat *n, json_t *json) {
 
   ret = json_unpack_ex(json, &err, 0,
                        "{ s?: { s?: o, s?: s, s?: b }, s?: { s?: o, s?: s, s?: "
-                       "b }, s?: o, s?: s, s?: b, s?: o }",
+                       "b, s?: b }, s?: o, s?: s, s?: b, s?: o }",
                        "in", "subscribe", &json_in_ep, "filter", &in_filter,
                        "bind", &z->in.bind, "out", "publish", &json_out_ep,
-                       "filter", &out_filter, "bind", &z->out.bind, "curve",
-                       &json_curve, "pattern", &type, "ipv6", &z->ipv6,
-                       "format", &json_format);
+                       "filter", &out_filter, "bind", &z->out.bind, "multipart",
+                       &z->multipart, "curve", &json_curve, "pattern", &type,
+                       "ipv6", &z->ipv6, "format", &json_format);
   if (ret)
     throw ConfigError(json, err, "node-config-node-zeromq");
 
@@ -225,6 +241,14 @@ int villas::node::zeromq_parse(NodeCompat *n, json_t *json) {
                         "Invalid type for ZeroMQ node: {}", n->getNameShort());
   }
 
+#ifdef ZMQ_BUILD_DISH
+  // Radio and dish sockets do not support multipart messages
+  if (z->multipart && z->pattern == zeromq::Pattern::RADIODISH)
+    throw ConfigError(json, "node-config-node-zeromq-multipart",
+                      "Multipart messages are not supported by the "
+                      "'radiodish' pattern");
+#endif
+
   return 0;
 }
 
@@ -274,6 +298,9 @@ char *villas::node::zeromq_print(NodeCompat *n) {
   if (z->out.filter)
     strcatf(&buf, ", out.filter=%s", z->out.filter);
 
+  if (z->multipart)
+    strcatf(&buf, ", out.multipart=yes");
+
   return buf;
 }
 
@@ -302,6 +329,11 @@ int villas::node::zeromq_start(NodeCompat *n) {
 
   z->formatter->start(n->getInputSignals(false), ~(int)SampleFlags::HAS_OFFSET);
 
+  ret = pool_init(&z->pool, DEFAULT_ZEROMQ_BUFFERS,
+                  sizeof(struct zeromq_buffer) + DEFAULT_FORMAT_BUFFER_LENGTH);
+  if (ret)
+    return ret;
+
   switch (z->pattern) {
 #ifdef ZMQ_BUILD_DISH
   case zeromq::Pattern::RADIODISH:
@@ -383,8 +415,9 @@ int villas::node::zeromq_start(NodeCompat *n) {
   }
 
   for (auto d : dirs) {
-    const char *mon_ep =
-        d == &z->in ? "inproc://monitor-in" : "inproc://monitor-out";
+    // Monitor endpoints must be unique within the process-wide ZeroMQ context
+    auto mon_ep = fmt::format("inproc://monitor-{}-{}", n->getNameShort(),
+                              d == &z->in ? "in" : "out");
 
     ret = zmq_setsockopt(d->socket, ZMQ_IPV6, &z->ipv6, sizeof(z->ipv6));
     if (ret)
@@ -396,7 +429,7 @@ int villas::node::zeromq_start(NodeCompat *n) {
       goto fail;
 
     // Monitor events on the server
-    ret = zmq_socket_monitor(d->socket, mon_ep, ZMQ_EVENT_ALL);
+    ret = zmq_socket_monitor(d->socket, mon_ep.c_str(), ZMQ_EVENT_ALL);
     if (ret < 0)
       goto fail;
 
@@ -408,7 +441,7 @@ int villas::node::zeromq_start(NodeCompat *n) {
     }
 
     // Connect it to the inproc endpoints so they'll get events
-    ret = zmq_connect(d->mon_socket, mon_ep);
+    ret = zmq_connect(d->mon_socket, mon_ep.c_str());
     if (ret < 0)
       goto fail;
 
@@ -426,7 +459,8 @@ int villas::node::zeromq_start(NodeCompat *n) {
           goto fail;
       }
 
-      d->pending++;
+      if (zeromq_endpoint_monitored(ep))
+        d->pending++;
     }
   }
 
@@ -474,6 +508,17 @@ int villas::node::zeromq_stop(NodeCompat *n) {
       return ret;
   }
 
+  // Frames which are still queued reference our buffers until the linger period expired
+  size_t total = z->pool.len / z->pool.blocksz;
+  for (int i = 0; i < 2000; i++) {
+    if (queue_available(&z->pool.queue) >= total)
+      return pool_destroy(&z->pool);
+
+    usleep(1000);
+  }
+
+  n->logger->warn("Buffers are still in use by ZeroMQ. Leaking pool.");
+
   return 0;
 }
 
@@ -520,13 +565,26 @@ int villas::node::zeromq_read(NodeCompat *n, struct Sample *const smps[],
     }
   }
 
-  // Receive payload
-  ret = zmq_msg_recv(&m, z->in.socket, 0);
-  if (ret < 0)
-    return ret;
+  // Receive payload which might be split into multiple frames
+  recv = 0;
+  do {
+    ret = zmq_msg_recv(&m, z->in.socket, 0);
+    if (ret < 0) {
+      zmq_msg_close(&m);
+      return ret;
+    }
 
-  recv = z->formatter->sscan((const char *)zmq_msg_data(&m), zmq_msg_size(&m),
-                             nullptr, smps, cnt);
+    if (recv < (int)cnt) {
+      ret = z->formatter->sscan((const char *)zmq_msg_data(&m),
+                                zmq_msg_size(&m), nullptr, &smps[recv],
+                                cnt - recv);
+      if (ret < 0)
+        n->logger->warn("Failed to parse frame");
+      else
+        recv += ret;
+    } else
+      n->logger->warn("Dropping frame which exceeds vectorize setting");
+  } while (zmq_msg_more(&m));
 
   ret = zmq_msg_close(&m);
   if (ret)
@@ -535,8 +593,9 @@ int villas::node::zeromq_read(NodeCompat *n, struct Sample *const smps[],
   return recv;
 }
 
-int villas::node::zeromq_write(NodeCompat *n, struct Sample *const smps[],
-                               unsigned cnt) {
+// Copying fallback if all pooled buffers are still in use by ZeroMQ
+static int zeromq_write_copy(NodeCompat *n, struct Sample *const smps[],
+                             unsigned cnt) {
   int ret;
   auto *z = n->getData<struct zeromq>();
 
@@ -549,6 +608,8 @@ int villas::node::zeromq_write(NodeCompat *n, struct Sample *const smps[],
   if (ret <= 0)
     return -1;
 
+  cnt = ret;
+
   ret = zmq_msg_init_size(&m, wbytes);
 
   if (z->out.filter) {
@@ -586,6 +647,89 @@ fail:
   return ret;
 }
 
+int villas::node::zeromq_write(NodeCompat *n, struct Sample *const smps[],
+                               unsigned cnt) {
+  int ret;
+  auto *z = n->getData<struct zeromq>();
+
+  auto *b = (struct zeromq_buffer *)pool_get(&z->pool);
+  if (!b) {
+    n->logger->debug("Buffer pool underrun. Falling back to copying");
+    return zeromq_write_copy(n, smps, cnt);
+  }
+
+  new (&b->refcnt) std::atomic<int>(0);
+  b->pool = &z->pool;
+
+  // Serialize samples into one frame, or one frame per sample
+  size_t len = z->pool.blocksz - sizeof(struct zeromq_buffer);
+  size_t offs[cnt + 1];
+  unsigned frames = 0, sent = 0;
+
+  offs[0] = 0;
+  while (sent < cnt) {
+    size_t wbytes;
+    unsigned num = z->multipart ? 1 : cnt;
+
+    ret = z->formatter->sprint(b->data + offs[frames], len - offs[frames],
+                               &wbytes, &smps[sent], num);
+    if (ret <= 0)
+      break;
+
+    sent += ret;
+    offs[frames + 1] = offs[frames] + wbytes;
+    frames++;
+
+    if (!z->multipart)
+      break;
+  }
+
+  if (frames == 0) {
+    pool_put(&z->pool, b);
+    return -1;
+  }
+
+  b->refcnt = frames;
+
+  if (z->out.filter && z->pattern == zeromq::Pattern::PUBSUB)
+    zmq_send(z->out.socket, z->out.filter, strlen(z->out.filter),
+             ZMQ_SNDMORE); // Send envelope
+
+  for (unsigned f = 0; f < frames; f++) {
+    zmq_msg_t m;
+
+    ret = zmq_msg_init_data(&m, b->data + offs[f], offs[f + 1] - offs[f],
+                            zeromq_buffer_free, b);
+    if (ret < 0) {
+      // Release references of frames which will never be sent
+      if ((b->refcnt -= frames - f) == 0)
+        pool_put(&z->pool, b);
+
+      return ret;
+    }
+
+    ret = 0;
+#ifdef ZMQ_BUILD_DISH
+    if (z->out.filter && z->pattern == zeromq::Pattern::RADIODISH)
+      ret = zmq_msg_set_group(&m, z->out.filter);
+#endif
+
+    if (ret >= 0)
+      ret = zmq_msg_send(&m, z->out.socket, f < frames - 1 ? ZMQ_SNDMORE : 0);
+
+    if (ret < 0) {
+      zmq_msg_close(&m); // Releases the reference of this frame
+
+      if (f < frames - 1 && (b->refcnt -= frames - f - 1) == 0)
+        pool_put(&z->pool, b);
+
+      return ret;
+    }
+  }
+
+  return sent;
+}
+
 int villas::node::zeromq_poll_fds(NodeCompat *n, int fds[]) {
   int ret;
   auto *z = n->getData<struct zeromq>();
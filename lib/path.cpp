@@ -297,11 +297,25 @@ void Path::prepare(NodeList &nodes) {
   hooks.dump(logger, fmt::format("path {}", this->toString()));
 #endif // WITH_HOOKS
 
-  // Prepare pool
+  /* Prepare pool
+   *
+   * Muxed samples and the last sample use the largest class. Each
+   * destination queues up to queuelen clones of them, which are taken from
+   * the smallest class fitting the output of the hooks.
+   */
   auto osigs = getOutputSignals();
-  unsigned pool_size = MAX(1UL, destinations.size()) * queuelen;
+  unsigned capacity = MAX(1UL, osigs->size());
+  unsigned vectorize = 1;
+
+  for (auto ps : sources)
+    vectorize = MAX(vectorize, ps->getNode()->in.vectorize);
+
+  unsigned pool_size =
+      MAX(1UL, destinations.size()) * queuelen + vectorize + 1;
 
-  ret = pool_init(&pool, pool_size, SAMPLE_LENGTH(osigs->size()), pool_mt);
+  ret = pool_classes_init(&pool, pool_size, vectorize, sizeof(Sample),
+                          SAMPLE_DATA_LENGTH(MIN(capacity, 4U)),
+                          SAMPLE_DATA_LENGTH(capacity), pool_mt);
   if (ret)
     throw RuntimeError("Failed to initialize pool of path: {}",
                        this->toString());
@@ -512,6 +526,9 @@ void Path::start() {
                isEnabled() ? "yes" : "no", isReversed() ? "yes" : "no",
                queuelen, original_sequence_no ? "yes" : "no");
 
+  for (auto ps : sources)
+    ps->prepare();
+
 #ifdef WITH_HOOKS
   hooks.start();
 #endif // WITH_HOOKS
@@ -521,7 +538,7 @@ void Path::start() {
   received.reset();
 
   // We initialize the initial sample
-  last_sample = sample_alloc(&pool);
+  last_sample = sample_alloc(&pool, MAX(1UL, getOutputSignals()->size()));
   if (!last_sample)
     throw MemoryAllocationError();
 
@@ -592,7 +609,7 @@ Path::~Path() {
 
   assert(state != State::DESTROYED);
 
-  ret = pool_destroy(&pool);
+  ret = pool_classes_destroy(&pool);
 }
 
 bool Path::isSimple() const {
@@ -664,10 +681,13 @@ json_t *Path::toJson() const {
 #endif // WITH_HOOKS
   json_t *json_sources = json_array();
   json_t *json_destinations = json_array();
+  json_t *json_pools = json_array();
 
-  for (auto ps : sources)
+  for (auto ps : sources) {
     json_array_append_new(json_sources,
                           json_string(ps->node->getNameShort().c_str()));
+    json_array_append_new(json_pools, ps->toJson());
+  }
 
   for (auto pd : destinations)
     json_array_append_new(json_destinations,
@@ -675,14 +695,14 @@ json_t *Path::toJson() const {
 
   json_t *json_path = json_pack(
       "{ s: s, s: s, s: s, s: b, s: b s: b, s: b, s: b, s: b s: i, s: o, s: o, "
-      "s: o, s: o }",
+      "s: o, s: o, s: o }",
       "uuid", uuid::toString(uuid).c_str(), "state",
       stateToString(state).c_str(), "mode", mode == Mode::ANY ? "any" : "all",
       "enabled", enabled, "builtin", builtin, "reversed", reversed,
       "original_sequence_no", original_sequence_no, "last_sequence",
       last_sequence, "poll", poll, "queuelen", queuelen, "signals",
       json_signals, "hooks", json_hooks, "in", json_sources, "out",
-      json_destinations);
+      json_destinations, "pools", json_pools);
 
   return json_path;
 }
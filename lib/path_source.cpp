@@ -23,12 +23,31 @@ using namespace villas;
 using namespace villas::node;
 
 PathSource::PathSource(Path *p, Node *n) : node(n), path(p), masked(false) {
+  pool.state = State::DESTROYED;
+}
+
+/* Initialize the pool once all paths are prepared.
+ *
+ * Secondary path sources are only known at this point.
+ */
+void PathSource::prepare() {
   int ret;
 
-  int pool_size = MAX(DEFAULT_QUEUE_LENGTH, 20 * node->in.vectorize);
-  ret = pool_init(&pool, pool_size,
-                  SAMPLE_LENGTH(node->getInputSignalsMaxCount()),
-                  node->getMemoryType());
+  if (pool.state == State::INITIALIZED)
+    return;
+
+  /* Reads always use the largest class. Read samples live until the end of
+   * read() unless they are referenced by secondary path sources. Hooks
+   * which hold on to samples take a clone from the smallest fitting class. */
+  unsigned vectorize = node->in.vectorize;
+  unsigned retained = (1 + node->in.hooks.size()) * vectorize;
+  unsigned max_capacity = MAX(1U, node->getInputSignalsMaxCount());
+
+  ret = pool_classes_init(&pool, vectorize + retained + getSecondaryBacklog(),
+                          retained, sizeof(Sample),
+                          SAMPLE_DATA_LENGTH(MIN(max_capacity, 4U)),
+                          SAMPLE_DATA_LENGTH(max_capacity),
+                          node->getMemoryType());
   if (ret)
     throw RuntimeError("Failed to initialize pool");
 }
@@ -36,7 +55,15 @@ PathSource::PathSource(Path *p, Node *n) : node(n), path(p), masked(false) {
 PathSource::~PathSource() {
   int ret __attribute__((unused));
 
-  ret = pool_destroy(&pool);
+  ret = pool_classes_destroy(&pool);
+}
+
+json_t *PathSource::toJson() {
+  return json_pack("{ s: s, s: o }", "node", node->getNameShort().c_str(),
+                   "pool",
+                   pool.state == State::INITIALIZED
+                       ? pool_classes_to_json(&pool)
+                       : json_array());
 }
 
 int PathSource::read(int i) {
@@ -50,7 +77,8 @@ int PathSource::read(int i) {
   struct Sample **tomux_smps;
 
   // Fill smps[] free sample blocks from the pool
-  allocated = sample_alloc_many(&pool, read_smps, cnt);
+  allocated = sample_alloc_many(&pool, read_smps, cnt,
+                                node->getInputSignalsMaxCount());
   if (allocated != cnt)
     path->logger->warn("Pool underrun for path source {}", node->getName());
 
@@ -87,9 +115,12 @@ int PathSource::read(int i) {
   }
 
   for (int i = 0; i < tomux; i++) {
-    muxed_smps[i] = i == 0 ? sample_clone(path->last_sample)
-                           : sample_clone(muxed_smps[i - 1]);
-    if (!muxed_smps[i]) {
+    // Muxed samples need room for signals added by the path hooks
+    muxed_smps[i] = sample_alloc(&path->pool, path->last_sample->capacity);
+    if (muxed_smps[i])
+      sample_copy(muxed_smps[i],
+                  i == 0 ? path->last_sample : muxed_smps[i - 1]);
+    else {
       path->logger->error("Pool underrun in path {}", path->toString());
       muxed_initialized = i == 0 ? 0 : i - 1;
       enqueued = -1;
@@ -193,6 +224,11 @@ void PathSource::check() {
 
 MasterPathSource::MasterPathSource(Path *p, Node *n) : PathSource(p, n) {}
 
+// Each secondary queues references to our read samples
+unsigned MasterPathSource::getSecondaryBacklog() {
+  return secondaries.size() * path->queuelen;
+}
+
 void MasterPathSource::writeToSecondaries(struct Sample *smps[], unsigned cnt) {
   for (auto sps : secondaries) {
     int sent = sps->getNode()->write(smps, cnt);
@@ -13,6 +13,7 @@
 #include <villas/utils.hpp>
 
 using namespace villas;
+using namespace villas::node;
 
 int villas::node::pool_init(struct Pool *p, size_t cnt, size_t blocksz,
                             struct memory::Type *m) {
@@ -33,7 +34,13 @@ int villas::node::pool_init(struct Pool *p, size_t cnt, size_t blocksz,
 
   logger->debug("Allocated {:#x} bytes for memory pool", p->len);
 
+  // Avoid page faults when blocks are touched for the first time
+  ret = memory::prefault(buffer, p->len);
+  if (ret)
+    return ret;
+
   p->buffer_off = (char *)buffer - (char *)p;
+  p->classes_off = POOL_NO_CLASSES;
 
   ret = queue_init(&p->queue, LOG2_CEIL(cnt), m);
   if (ret)
@@ -83,3 +90,125 @@ void *villas::node::pool_get(struct Pool *p) {
 int villas::node::pool_put(struct Pool *p, void *buf) {
   return queue_push(&p->queue, buf);
 }
+
+size_t villas::node::pool_available(struct Pool *p) {
+  return queue_available(&p->queue);
+}
+
+// Release the classes of a partially initialized size class set.
+static void pool_classes_release(struct PoolClasses *pc) {
+  while (pc->num_classes > 0) {
+    int ret __attribute__((unused));
+
+    ret = pool_destroy(&pc->pools[--pc->num_classes]);
+  }
+
+  pc->state = State::DESTROYED;
+}
+
+int villas::node::pool_classes_init(struct PoolClasses *pc, size_t cnt,
+                                    size_t small_cnt, size_t hdrsz,
+                                    size_t min_payload, size_t max_payload,
+                                    struct memory::Type *m) {
+  int ret;
+  auto logger = Log::get("pool");
+
+  if (min_payload == 0 || min_payload > max_payload)
+    return -1;
+
+  pc->num_classes = 0;
+
+  for (size_t payload = LOG2_CEIL(min_payload);; payload <<= 1) {
+    if (pc->num_classes >= POOL_MAX_CLASSES) {
+      ret = -1;
+      goto out_destroy;
+    }
+
+    // The largest class is capped at the requested maximum payload size
+    bool last = payload >= max_payload;
+    if (last)
+      payload = max_payload;
+
+    struct Pool *p = &pc->pools[pc->num_classes];
+
+    try {
+      ret = pool_init(p, last ? cnt : small_cnt, hdrsz + payload, m);
+    } catch (...) {
+      pool_classes_release(pc);
+      throw;
+    }
+
+    if (ret)
+      goto out_destroy;
+
+    p->classes_off = (char *)pc - (char *)p;
+    pc->num_classes++;
+
+    if (last)
+      break;
+  }
+
+  logger->debug("New size-classed memory pool: classes={}, min_blocksz={}, "
+                "max_blocksz={}",
+                pc->num_classes, pc->pools[0].blocksz,
+                pc->pools[pc->num_classes - 1].blocksz);
+
+  pc->state = State::INITIALIZED;
+
+  return 0;
+
+out_destroy:
+  pool_classes_release(pc);
+
+  return ret;
+}
+
+int villas::node::pool_classes_destroy(struct PoolClasses *pc) {
+  int ret;
+
+  if (pc->state == State::DESTROYED)
+    return 0;
+
+  for (unsigned i = 0; i < pc->num_classes; i++) {
+    ret = pool_destroy(&pc->pools[i]);
+    if (ret)
+      return ret;
+  }
+
+  pc->state = State::DESTROYED;
+
+  return 0;
+}
+
+struct Pool *villas::node::pool_classes_select(struct PoolClasses *pc,
+                                               size_t blocksz) {
+  for (unsigned i = 0; i < pc->num_classes; i++) {
+    if (pc->pools[i].blocksz >= blocksz)
+      return &pc->pools[i];
+  }
+
+  return nullptr;
+}
+
+struct Pool *villas::node::pool_classes_largest(struct PoolClasses *pc) {
+  return &pc->pools[pc->num_classes - 1];
+}
+
+json_t *villas::node::pool_classes_to_json(struct PoolClasses *pc) {
+  json_t *json_classes = json_array();
+
+  for (unsigned i = 0; i < pc->num_classes; i++) {
+    struct Pool *p = &pc->pools[i];
+
+    size_t total = p->len / p->blocksz;
+    size_t available = pool_available(p);
+
+    json_array_append_new(json_classes,
+                          json_pack("{ s: I, s: I, s: I }", "blocksz",
+                                    (json_int_t)p->blocksz, "total",
+                                    (json_int_t)total, "used",
+                                    (json_int_t)(total - available)));
+  }
+
+  return json_classes;
+}
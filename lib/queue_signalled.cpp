@@ -7,13 +7,69 @@
 
 #include <villas/node/config.hpp>
 #include <villas/queue_signalled.h>
+#include <villas/utils.hpp>
 
 #ifdef HAS_EVENTFD
 #include <sys/eventfd.h>
 #endif
 
+#ifdef HAS_FUTEX
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 using namespace villas::node;
 
+#ifdef HAS_FUTEX
+static long queue_signalled_futex(struct CQueueSignalled *qs, int op,
+                                  uint32_t val) {
+  // Process-private futexes avoid the lookup of the backing page in the kernel
+  if (!((int)qs->flags & (int)QueueSignalledFlags::PROCESS_SHARED))
+    op |= FUTEX_PRIVATE_FLAG;
+
+  return syscall(SYS_futex, (uint32_t *)&qs->futex.seq, op, val, nullptr,
+                 nullptr, 0);
+}
+
+// Signal new data and issue a syscall only if a reader is actually sleeping
+static void queue_signalled_futex_wake(struct CQueueSignalled *qs) {
+  qs->futex.seq.fetch_add(1, std::memory_order_seq_cst);
+
+  if (qs->futex.waiters.load(std::memory_order_seq_cst) > 0)
+    queue_signalled_futex(qs, FUTEX_WAKE, INT_MAX);
+}
+
+/* Wait until the futex word differs from \p seq.
+ *
+ * We first spin for an adaptive number of iterations. The spin count is doubled
+ * whenever spinning succeeded and halved whenever we had to go to sleep.
+ */
+static void queue_signalled_futex_wait(struct CQueueSignalled *qs,
+                                       uint32_t seq) {
+  for (unsigned i = 0; i < qs->futex.spin; i++) {
+    if (qs->futex.seq.load(std::memory_order_acquire) != seq) {
+      qs->futex.spin = MIN(qs->futex.spin * 2, QUEUE_SIGNALLED_FUTEX_SPIN_MAX);
+      return;
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+  }
+
+  qs->futex.spin = MAX(qs->futex.spin / 2, QUEUE_SIGNALLED_FUTEX_SPIN_MIN);
+
+  qs->futex.waiters.fetch_add(1, std::memory_order_seq_cst);
+
+  // Returns immediately with EAGAIN if a writer has already bumped the sequence
+  queue_signalled_futex(qs, FUTEX_WAIT, seq);
+
+  qs->futex.waiters.fetch_sub(1, std::memory_order_seq_cst);
+}
+#endif
+
 static void queue_signalled_cleanup(void *p) {
   struct CQueueSignalled *qs = (struct CQueueSignalled *)p;
 
@@ -28,6 +84,7 @@ int villas::node::queue_signalled_init(struct CQueueSignalled *qs, size_t size,
   int ret;
 
   qs->mode = mode;
+  qs->flags = (enum QueueSignalledFlags)flags;
 
   if (qs->mode == QueueSignalledMode::AUTO) {
 #ifdef __linux__
@@ -75,6 +132,13 @@ int villas::node::queue_signalled_init(struct CQueueSignalled *qs, size_t size,
     if (qs->eventfd < 0)
       return -2;
   }
+#endif
+#ifdef HAS_FUTEX
+  else if (qs->mode == QueueSignalledMode::FUTEX) {
+    new (&qs->futex.seq) std::atomic<uint32_t>(0);
+    new (&qs->futex.waiters) std::atomic<uint32_t>(0);
+    qs->futex.spin = QUEUE_SIGNALLED_FUTEX_SPIN_MIN;
+  }
 #endif
   else
     return -1;
@@ -101,6 +165,11 @@ int villas::node::queue_signalled_destroy(struct CQueueSignalled *qs) {
     if (ret)
       return ret;
   }
+#endif
+#ifdef HAS_FUTEX
+  else if (qs->mode == QueueSignalledMode::FUTEX) {
+    // Nothing todo
+  }
 #endif
   else
     return -1;
@@ -130,6 +199,10 @@ int villas::node::queue_signalled_push(struct CQueueSignalled *qs, void *ptr) {
     if (ret < 0)
       return ret;
   }
+#endif
+#ifdef HAS_FUTEX
+  else if (qs->mode == QueueSignalledMode::FUTEX)
+    queue_signalled_futex_wake(qs);
 #endif
   else
     return -1;
@@ -160,6 +233,10 @@ int villas::node::queue_signalled_push_many(struct CQueueSignalled *qs,
     if (ret < 0)
       return ret;
   }
+#endif
+#ifdef HAS_FUTEX
+  else if (qs->mode == QueueSignalledMode::FUTEX)
+    queue_signalled_futex_wake(qs);
 #endif
   else
     return -1;
@@ -177,6 +254,13 @@ int villas::node::queue_signalled_pull(struct CQueueSignalled *qs, void **ptr) {
     pthread_mutex_lock(&qs->pthread.mutex);
 
   while (!pulled) {
+#ifdef HAS_FUTEX
+    // Snapshot the futex word before checking the queue to avoid lost wakeups
+    uint32_t seq = qs->mode == QueueSignalledMode::FUTEX
+                       ? qs->futex.seq.load(std::memory_order_acquire)
+                       : 0;
+#endif
+
     pulled = queue_pull(&qs->queue, ptr);
     if (pulled < 0)
       break;
@@ -193,6 +277,10 @@ int villas::node::queue_signalled_pull(struct CQueueSignalled *qs, void **ptr) {
         if (ret < 0)
           break;
       }
+#endif
+#ifdef HAS_FUTEX
+      else if (qs->mode == QueueSignalledMode::FUTEX)
+        queue_signalled_futex_wait(qs, seq);
 #endif
       else
         break;
@@ -218,6 +306,13 @@ int villas::node::queue_signalled_pull_many(struct CQueueSignalled *qs,
     pthread_mutex_lock(&qs->pthread.mutex);
 
   while (!pulled) {
+#ifdef HAS_FUTEX
+    // Snapshot the futex word before checking the queue to avoid lost wakeups
+    uint32_t seq = qs->mode == QueueSignalledMode::FUTEX
+                       ? qs->futex.seq.load(std::memory_order_acquire)
+                       : 0;
+#endif
+
     pulled = queue_pull_many(&qs->queue, ptr, cnt);
     if (pulled < 0)
       break;
@@ -234,6 +329,10 @@ int villas::node::queue_signalled_pull_many(struct CQueueSignalled *qs,
         if (ret < 0)
           break;
       }
+#endif
+#ifdef HAS_FUTEX
+      else if (qs->mode == QueueSignalledMode::FUTEX)
+        queue_signalled_futex_wait(qs, seq);
 #endif
       else
         break;
@@ -271,6 +370,10 @@ int villas::node::queue_signalled_close(struct CQueueSignalled *qs) {
     if (ret < 0)
       return ret;
   }
+#endif
+#ifdef HAS_FUTEX
+  else if (qs->mode == QueueSignalledMode::FUTEX)
+    queue_signalled_futex_wake(qs);
 #endif
   else
     return -1;
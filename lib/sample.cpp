@@ -52,6 +52,42 @@ struct Sample *villas::node::sample_alloc(struct Pool *p) {
   return s;
 }
 
+/* Request \p cnt samples from pool \p p.
+ *
+ * For pools which are part of a size class set, the remaining samples are
+ * taken from the next larger classes once \p p is exhausted.
+ */
+static int sample_alloc_classes(struct Pool *p, struct Sample *smps[],
+                                int cnt) {
+  int alloced = sample_alloc_many(p, smps, cnt);
+  if (alloced < 0)
+    return alloced;
+
+  struct PoolClasses *pc = pool_classes(p);
+  if (!pc)
+    return alloced;
+
+  for (unsigned i = p - pc->pools + 1; i < pc->num_classes && alloced < cnt;
+       i++) {
+    int ret = sample_alloc_many(&pc->pools[i], smps + alloced, cnt - alloced);
+    if (ret > 0)
+      alloced += ret;
+  }
+
+  return alloced;
+}
+
+struct Sample *villas::node::sample_alloc(struct PoolClasses *pc,
+                                          unsigned capacity) {
+  struct Sample *smp;
+
+  struct Pool *p = pool_classes_select(pc, SAMPLE_LENGTH(capacity));
+  if (!p)
+    return nullptr;
+
+  return sample_alloc_classes(p, &smp, 1) == 1 ? smp : nullptr;
+}
+
 struct Sample *villas::node::sample_alloc_mem(int capacity) {
   size_t sz = SAMPLE_LENGTH(capacity);
 
@@ -96,6 +132,46 @@ int villas::node::sample_alloc_many(struct Pool *p, struct Sample *smps[],
   return ret;
 }
 
+int villas::node::sample_alloc_many(struct PoolClasses *pc,
+                                    struct Sample *smps[], int cnt,
+                                    unsigned capacity) {
+  struct Pool *p = pool_classes_select(pc, SAMPLE_LENGTH(capacity));
+  if (!p)
+    return -1;
+
+  return sample_alloc_classes(p, smps, cnt);
+}
+
+unsigned villas::node::sample_required_capacity(const struct Sample *s) {
+  unsigned capacity = s->length;
+
+  if (s->signals && s->signals->size() > capacity)
+    capacity = s->signals->size();
+
+  return capacity;
+}
+
+/* Get the pool from which clones of \p smp should be allocated.
+ *
+ * For pools which are part of a size class set we select the smallest class
+ * which still fits \p capacity values. Like for plain pools, clones which
+ * exceed the largest class are truncated.
+ */
+static struct Pool *sample_clone_pool(const struct Sample *smp,
+                                      unsigned capacity) {
+  struct Pool *pool = sample_pool(smp);
+  if (!pool)
+    return nullptr;
+
+  struct PoolClasses *pc = pool_classes(pool);
+  if (!pc)
+    return pool;
+
+  struct Pool *p = pool_classes_select(pc, SAMPLE_LENGTH(capacity));
+
+  return p ? p : pool_classes_largest(pc);
+}
+
 void villas::node::sample_free_many(struct Sample *smps[], int cnt) {
   for (int i = 0; i < cnt; i++)
     sample_free(smps[i]);
@@ -150,12 +226,11 @@ struct Sample *villas::node::sample_clone(struct Sample *orig) {
   struct Sample *clone;
   struct Pool *pool;
 
-  pool = sample_pool(orig);
+  pool = sample_clone_pool(orig, sample_required_capacity(orig));
   if (!pool)
     return nullptr;
 
-  clone = sample_alloc(pool);
-  if (!clone)
+  if (sample_alloc_classes(pool, &clone, 1) != 1)
     return nullptr;
 
   sample_copy(clone, orig);
@@ -172,11 +247,17 @@ int villas::node::sample_clone_many(struct Sample *dsts[],
   if (cnt <= 0)
     return 0;
 
-  pool = sample_pool(srcs[0]);
+  unsigned capacity = 0;
+  for (int i = 0; i < cnt; i++)
+    capacity = MAX(capacity, sample_required_capacity(srcs[i]));
+
+  pool = sample_clone_pool(srcs[0], capacity);
   if (!pool)
     return 0;
 
-  alloced = sample_alloc_many(pool, dsts, cnt);
+  alloced = sample_alloc_classes(pool, dsts, cnt);
+  if (alloced < 0)
+    return 0;
 
   copied = sample_copy_many(dsts, srcs, alloced);
 
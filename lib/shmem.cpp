@@ -6,6 +6,7 @@
  */
 
 #include <cerrno>
+#include <cstring>
 #include <fcntl.h>
 #include <semaphore.h>
 #include <sys/mman.h>
@@ -90,14 +91,12 @@ retry:
     return -5;
   }
 
-  shared->polling = conf->polling;
+  shared->mode = conf->mode;
 
   int flags = (int)QueueSignalledFlags::PROCESS_SHARED;
-  enum QueueSignalledMode mode =
-      conf->polling ? QueueSignalledMode::POLLING : QueueSignalledMode::PTHREAD;
 
-  ret = queue_signalled_init(&shared->queue, conf->queuelen, manager, mode,
-                             flags);
+  ret = queue_signalled_init(&shared->queue, conf->queuelen, manager,
+                             conf->mode, flags);
   if (ret) {
     errno = ENOMEM;
     return -6;
@@ -206,3 +205,138 @@ int villas::node::shmem_int_alloc(struct ShmemInterface *shm,
                                   struct Sample *smps[], unsigned cnt) {
   return sample_alloc_many(&shm->write.shared->pool, smps, cnt);
 }
+
+int villas::node::shmem_state_open(const char *name,
+                                   struct ShmemStateInterface *st,
+                                   unsigned capacity, bool create) {
+  int fd;
+  void *base;
+  struct stat stat_buf;
+
+  if (create) {
+    fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+      return -1;
+
+    st->len = sizeof(struct ShmemState) + SAMPLE_DATA_LENGTH(capacity);
+    if (ftruncate(fd, st->len) < 0) {
+      close(fd);
+      return -2;
+    }
+  } else {
+    fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0)
+      return -1;
+
+    if (fstat(fd, &stat_buf) < 0) {
+      close(fd);
+      return -3;
+    }
+
+    st->len = stat_buf.st_size;
+  }
+
+  base = mmap(nullptr, st->len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (base == MAP_FAILED)
+    return -4;
+
+  st->name = name;
+  st->state = (struct ShmemState *)base;
+
+  if (create) {
+    new (&st->state->seq) std::atomic<uint64_t>(0);
+
+    st->state->capacity = capacity;
+    st->state->length = 0;
+    st->state->flags = 0;
+    st->state->sequence = 0;
+    st->state->ts = {};
+  }
+
+  return 0;
+}
+
+int villas::node::shmem_state_close(struct ShmemStateInterface *st,
+                                    bool unlink) {
+  int ret;
+
+  ret = munmap(st->state, st->len);
+  if (ret)
+    return ret;
+
+  if (unlink)
+    shm_unlink(st->name);
+
+  return 0;
+}
+
+union SignalData *villas::node::shmem_state_write_begin(struct ShmemState *st) {
+  uint64_t seq = st->seq.load(std::memory_order_relaxed);
+
+  st->seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  return st->data;
+}
+
+void villas::node::shmem_state_write_end(struct ShmemState *st,
+                                         unsigned length, uint64_t sequence,
+                                         const struct timespec *ts) {
+  st->length = MIN(length, st->capacity);
+  st->sequence = sequence;
+  st->ts = *ts;
+  st->flags = (int)SampleFlags::HAS_TS_ORIGIN |
+              (int)SampleFlags::HAS_SEQUENCE | (int)SampleFlags::HAS_DATA;
+
+  st->seq.store(st->seq.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+}
+
+int villas::node::shmem_state_write(struct ShmemState *st,
+                                    const struct Sample *smp) {
+  unsigned len = MIN(smp->length, st->capacity);
+
+  union SignalData *data = shmem_state_write_begin(st);
+
+  memcpy(data, smp->data, SAMPLE_DATA_LENGTH(len));
+
+  shmem_state_write_end(st, len, smp->sequence, &smp->ts.origin);
+
+  return 1;
+}
+
+int villas::node::shmem_state_read(struct ShmemState *st, struct Sample *smp,
+                                   uint64_t *last, unsigned retries) {
+  uint64_t seq1, seq2;
+
+  for (unsigned i = 0; i <= retries; i++) {
+    seq1 = st->seq.load(std::memory_order_acquire);
+    if (seq1 == *last)
+      return 0;
+
+    // A write is in progress
+    if (seq1 & 1)
+      continue;
+
+    smp->length = MIN(st->length, smp->capacity);
+    smp->sequence = st->sequence;
+    smp->flags = st->flags;
+    smp->ts.origin = st->ts;
+
+    memcpy(smp->data, st->data, SAMPLE_DATA_LENGTH(smp->length));
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    seq2 = st->seq.load(std::memory_order_relaxed);
+
+    if (seq1 == seq2) {
+      *last = seq1;
+      return 1;
+    }
+  }
+
+  errno = EBUSY;
+
+  return -1;
+}
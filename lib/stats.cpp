@@ -39,6 +39,12 @@ std::unordered_map<Stats::Metric, Stats::MetricDescription> Stats::metrics = {
      {"rtp.pkts_lost", "packets", "Cumulative number of packets lost"}},
     {Stats::Metric::RTP_JITTER,
      {"rtp.jitter", "seconds", "Interarrival jitter"}},
+    {Stats::Metric::DELIVERY_LATENCY,
+     {"delivery_latency", "seconds",
+      "Latency until sent messages are acknowledged by the broker"}},
+    {Stats::Metric::IN_FLIGHT,
+     {"in_flight", "messages",
+      "Number of sent messages which are not acknowledged by the broker yet"}},
 };
 
 std::unordered_map<Stats::Type, Stats::TypeDescription> Stats::types = {
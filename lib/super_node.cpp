@@ -262,6 +262,8 @@ void SuperNode::startNodes() {
     if (!n->isEnabled())
       continue;
 
+    memory::OwnerScope scope("node:" + n->getNameShort());
+
     ret = n->start();
     if (ret)
       throw RuntimeError("Failed to start node: {}", n->getName());
@@ -273,6 +275,8 @@ void SuperNode::startPaths() {
     if (!p->isEnabled())
       continue;
 
+    memory::OwnerScope scope("path:" + uuid::toString(p->uuid));
+
     p->start();
   }
 }
@@ -284,6 +288,8 @@ void SuperNode::prepareNodes() {
     if (!n->isEnabled())
       continue;
 
+    memory::OwnerScope scope("node:" + n->getNameShort());
+
     ret = n->prepare();
     if (ret)
       throw RuntimeError("Failed to prepare node: {}", n->getName());
@@ -295,6 +301,8 @@ void SuperNode::preparePaths() {
     if (!p->isEnabled())
       continue;
 
+    memory::OwnerScope scope("path:" + uuid::toString(p->uuid));
+
     p->prepare(nodes);
   }
 }
@@ -410,6 +418,8 @@ void SuperNode::stop() {
   web.stop();
 #endif
 
+  memory::accounting_print(logger);
+
   state = State::STOPPED;
 }
 
@@ -0,0 +1,372 @@
+/* Kernel-bypass packet I/O with AF_XDP sockets.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <cstring>
+#include <map>
+
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <villas/exceptions.hpp>
+#include <villas/xdp.hpp>
+
+using namespace villas;
+using namespace villas::xdp;
+
+void villas::xdp::parse(json_t *json, struct Options *o) {
+  int ret;
+  json_error_t err;
+  json_t *json_queues = nullptr;
+
+  const char *mode = nullptr;
+  int enabled = 1;
+  int zerocopy = 0;
+  int frames = XDP_DEFAULT_FRAMES;
+
+  ret = json_unpack_ex(json, &err, 0, "{ s?: b, s?: s, s?: b, s?: i, s?: o }",
+                       "enabled", &enabled, "mode", &mode, "zerocopy",
+                       &zerocopy, "frames", &frames, "queues", &json_queues);
+  if (ret)
+    throw ConfigError(json, err, "node-config-node-xdp");
+
+  o->enabled = enabled;
+  o->zerocopy = zerocopy;
+
+  if (!mode || !strcmp(mode, "auto"))
+    o->mode = Mode::AUTO;
+  else if (!strcmp(mode, "skb"))
+    o->mode = Mode::SKB;
+  else if (!strcmp(mode, "native"))
+    o->mode = Mode::NATIVE;
+  else
+    throw ConfigError(json, "node-config-node-xdp-mode",
+                      "Invalid XDP mode: {}", mode);
+
+  if (zerocopy && o->mode == Mode::SKB)
+    throw ConfigError(json, "node-config-node-xdp-zerocopy",
+                      "Zero-copy is not supported in 'skb' mode");
+
+  if (frames <= 0 || (frames & (frames - 1)))
+    throw ConfigError(json, "node-config-node-xdp-frames",
+                      "Setting 'frames' must be a power of two");
+
+  o->frames = frames;
+
+  // A single queue or a list of queues
+  o->num_queues = 0;
+  if (!json_queues)
+    o->queues[o->num_queues++] = 0;
+  else if (json_is_integer(json_queues))
+    o->queues[o->num_queues++] = json_integer_value(json_queues);
+  else if (json_is_array(json_queues)) {
+    size_t i;
+    json_t *json_queue;
+
+    if (json_array_size(json_queues) > XDP_MAX_QUEUES)
+      throw ConfigError(json_queues, "node-config-node-xdp-queues",
+                        "At most {} queues are supported", XDP_MAX_QUEUES);
+
+    json_array_foreach(json_queues, i, json_queue) {
+      if (!json_is_integer(json_queue))
+        throw ConfigError(json_queue, "node-config-node-xdp-queues",
+                          "Queues must be given as integers");
+
+      unsigned queue = json_integer_value(json_queue);
+
+      for (unsigned j = 0; j < o->num_queues; j++) {
+        if (o->queues[j] == queue)
+          throw ConfigError(json_queue, "node-config-node-xdp-queues",
+                            "Queue {} is listed twice", queue);
+      }
+
+      o->queues[o->num_queues++] = queue;
+    }
+  } else
+    throw ConfigError(json_queues, "node-config-node-xdp-queues",
+                      "Setting 'queues' must be an integer or an array");
+
+  if (o->num_queues == 0)
+    throw ConfigError(json_queues, "node-config-node-xdp-queues",
+                      "At least one queue is required");
+
+  /* Every socket keeps XDP_FILL_FRAMES in its fill ring. The transmit ring
+   * of the first socket must still be backed by free frames. */
+  unsigned required =
+      o->num_queues * XDP_FILL_FRAMES + XSK_RING_PROD__DEFAULT_NUM_DESCS;
+  while (o->frames < required)
+    o->frames <<= 1;
+}
+
+Umem::Umem(unsigned frames, size_t fs)
+    : umem(nullptr), area(nullptr), frame_size(fs), num_frames(frames) {
+  int ret;
+
+  size_t len = (size_t)num_frames * frame_size;
+
+  area = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+  if (area == MAP_FAILED)
+    throw SystemError("Failed to allocate UMEM");
+
+  struct xsk_umem_config cfg = {
+      .fill_size = XSK_RING_PROD__DEFAULT_NUM_DESCS,
+      .comp_size = XSK_RING_CONS__DEFAULT_NUM_DESCS,
+      .frame_size = (uint32_t)frame_size,
+      .frame_headroom = XSK_UMEM__DEFAULT_FRAME_HEADROOM,
+      .flags = 0};
+
+  ret = xsk_umem__create(&umem, area, len, &fill, &comp, &cfg);
+  if (ret)
+    throw RuntimeError("Failed to create UMEM: {}", strerror(-ret));
+
+  free_frames.reserve(num_frames);
+  for (unsigned i = 0; i < num_frames; i++)
+    free_frames.push_back((uint64_t)i * frame_size);
+}
+
+Umem::~Umem() {
+  xsk_umem__delete(umem);
+
+  munmap(area, (size_t)num_frames * frame_size);
+}
+
+Umem::Ptr Umem::get(const std::string &ifname, unsigned frames) {
+  static std::mutex mutex;
+  static std::map<std::string, std::weak_ptr<Umem>> umems;
+
+  std::lock_guard<std::mutex> guard(mutex);
+
+  auto u = umems[ifname].lock();
+  if (!u) {
+    u = std::make_shared<Umem>(frames);
+    umems[ifname] = u;
+  }
+
+  return u;
+}
+
+bool Umem::bind(unsigned queue) {
+  std::lock_guard<std::mutex> guard(mutex);
+
+  return queues.insert(queue).second;
+}
+
+void Umem::unbind(unsigned queue) {
+  std::lock_guard<std::mutex> guard(mutex);
+
+  queues.erase(queue);
+}
+
+unsigned Umem::getFree() {
+  std::lock_guard<std::mutex> guard(mutex);
+
+  return free_frames.size();
+}
+
+unsigned Umem::alloc(uint64_t *frames, unsigned cnt) {
+  std::lock_guard<std::mutex> guard(mutex);
+
+  cnt = std::min<size_t>(cnt, free_frames.size());
+
+  for (unsigned i = 0; i < cnt; i++) {
+    frames[i] = free_frames.back();
+    free_frames.pop_back();
+  }
+
+  return cnt;
+}
+
+void Umem::free(const uint64_t *frames, unsigned cnt) {
+  std::lock_guard<std::mutex> guard(mutex);
+
+  free_frames.insert(free_frames.end(), frames, frames + cnt);
+}
+
+Socket::Socket(Umem::Ptr u, const std::string &ifname, unsigned q,
+               const struct Options *o)
+    : umem(u), xsk(nullptr), queue(q), tx_pending(0),
+      tx_frame(Umem::INVALID_FRAME), logger(Log::get("xdp")) {
+  int ret;
+
+  if (!umem->bind(queue))
+    throw RuntimeError("Queue {} of interface {} is already in use", queue,
+                       ifname);
+
+  struct xsk_socket_config cfg;
+  memset(&cfg, 0, sizeof(cfg));
+
+  cfg.rx_size = XSK_RING_CONS__DEFAULT_NUM_DESCS;
+  cfg.tx_size = XSK_RING_PROD__DEFAULT_NUM_DESCS;
+  cfg.bind_flags =
+      XDP_USE_NEED_WAKEUP | (o->zerocopy ? XDP_ZEROCOPY : XDP_COPY);
+
+  switch (o->mode) {
+  case Mode::SKB:
+    cfg.xdp_flags = XDP_FLAGS_SKB_MODE;
+    break;
+
+  case Mode::NATIVE:
+    cfg.xdp_flags = XDP_FLAGS_DRV_MODE;
+    break;
+
+  case Mode::AUTO:
+    cfg.bind_flags &= ~XDP_COPY;
+    break;
+  }
+
+  // libxdp loads a program which redirects all frames of the queue to us
+  ret = xsk_socket__create_shared(&xsk, ifname.c_str(), queue,
+                                  umem->getHandle(), &rx, &tx, &fill, &comp,
+                                  &cfg);
+  if (ret) {
+    umem->unbind(queue);
+
+    throw RuntimeError("Failed to create AF_XDP socket for {} queue {}: {}",
+                       ifname, queue, strerror(-ret));
+  }
+
+  // The UMEM is sized by the first node which uses the interface
+  if (umem->getFree() < XDP_FILL_FRAMES + XSK_RING_PROD__DEFAULT_NUM_DESCS)
+    logger->warn("Too few frames left in UMEM of {} for queue {}. Increase "
+                 "setting 'frames' of the first node using the interface",
+                 ifname, queue);
+
+  refill(XDP_FILL_FRAMES);
+
+  logger->debug("Created AF_XDP socket for {} queue {}", ifname, queue);
+}
+
+Socket::~Socket() {
+  xsk_socket__delete(xsk);
+
+  umem->unbind(queue);
+
+  // Frames owned by the kernel rings are reclaimed with the UMEM
+}
+
+void Socket::refill(unsigned cnt) {
+  uint32_t idx;
+  uint64_t frames[cnt];
+
+  cnt = umem->alloc(frames, cnt);
+
+  unsigned reserved = xsk_ring_prod__reserve(&fill, cnt, &idx);
+  for (unsigned i = 0; i < reserved; i++)
+    *xsk_ring_prod__fill_addr(&fill, idx + i) = frames[i];
+
+  xsk_ring_prod__submit(&fill, reserved);
+
+  if (reserved < cnt)
+    umem->free(frames + reserved, cnt - reserved);
+}
+
+void Socket::complete() {
+  uint32_t idx;
+
+  if (tx_pending == 0)
+    return;
+
+  unsigned done =
+      xsk_ring_cons__peek(&comp, XSK_RING_CONS__DEFAULT_NUM_DESCS, &idx);
+  if (done == 0)
+    return;
+
+  uint64_t frames[done];
+  for (unsigned i = 0; i < done; i++)
+    frames[i] = umem->getFrame(*xsk_ring_cons__comp_addr(&comp, idx + i));
+
+  xsk_ring_cons__release(&comp, done);
+
+  umem->free(frames, done);
+
+  tx_pending -= done;
+}
+
+uint8_t *Socket::reserve() {
+  if (tx_frame != Umem::INVALID_FRAME)
+    return umem->getData(tx_frame);
+
+  complete();
+
+  if (umem->alloc(&tx_frame, 1) != 1) {
+    tx_frame = Umem::INVALID_FRAME;
+    return nullptr;
+  }
+
+  return umem->getData(tx_frame);
+}
+
+int Socket::submit(size_t len) {
+  uint32_t idx;
+
+  if (tx_frame == Umem::INVALID_FRAME)
+    return -1;
+
+  if (xsk_ring_prod__reserve(&tx, 1, &idx) != 1) {
+    // The frame remains reserved for the next attempt
+    flush();
+    return -1;
+  }
+
+  auto *desc = xsk_ring_prod__tx_desc(&tx, idx);
+  desc->addr = tx_frame;
+  desc->len = len;
+
+  xsk_ring_prod__submit(&tx, 1);
+
+  tx_frame = Umem::INVALID_FRAME;
+  tx_pending++;
+
+  return 0;
+}
+
+void Socket::flush() {
+  if (!xsk_ring_prod__needs_wakeup(&tx))
+    return;
+
+  int ret = sendto(getFD(), nullptr, 0, MSG_DONTWAIT, nullptr, 0);
+  if (ret < 0 && errno != EAGAIN && errno != EBUSY && errno != ENOBUFS)
+    logger->warn("Failed to kick AF_XDP socket: {}", strerror(errno));
+}
+
+Endpoint::Endpoint(const std::string &ifn, const struct Options *o)
+    : ifname(ifn), next(0) {
+  int ret;
+
+  umem = Umem::get(ifname, o->frames);
+
+  for (unsigned i = 0; i < o->num_queues; i++)
+    sockets.emplace_back(new Socket(umem, ifname, o->queues[i], o));
+
+  // Outgoing frames carry the address of the interface
+  struct ifreq ifr;
+  memset(&ifr, 0, sizeof(ifr));
+  strncpy(ifr.ifr_name, ifname.c_str(), IFNAMSIZ - 1);
+
+  int sd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sd < 0)
+    throw SystemError("Failed to create socket");
+
+  ret = ioctl(sd, SIOCGIFHWADDR, &ifr);
+  close(sd);
+  if (ret)
+    throw SystemError("Failed to get address of interface {}", ifname);
+
+  memcpy(&address, ifr.ifr_hwaddr.sa_data, ETHER_ADDR_LEN);
+}
+
+int Endpoint::getFDs(int fds[]) {
+  for (unsigned i = 0; i < sockets.size(); i++)
+    fds[i] = sockets[i]->getFD();
+
+  return sockets.size();
+}
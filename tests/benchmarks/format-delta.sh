@@ -0,0 +1,51 @@
+#!/usr/bin/env bash
+#
+# Benchmark of the encoded size and encoding time of the villas.delta format
+# compared to other formats which are commonly used with WebSockets.
+#
+# Author: Steffen Vogel <post@steffenvogel.de>
+# SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+# SPDX-License-Identifier: Apache-2.0
+
+set -e
+
+# Settings
+NUM_SAMPLES=${NUM_SAMPLES:-100000}
+NUM_VALUES=${NUM_VALUES:-64}
+FORMATS=${FORMATS:-"json villas.web protobuf villas.delta"}
+
+DIR=$(mktemp -d)
+pushd ${DIR}
+
+function finish {
+    popd
+    rm -rf ${DIR}
+}
+trap finish EXIT
+
+# Each signal type is benchmarked separately:
+# - constant: none of the values change (best case)
+# - sine:     all values change in every sample (worst case)
+SIGNALS=${SIGNALS:-"constant sine"}
+
+# The compressed size approximates the effect of permessage-deflate
+
+printf "%-10s %-15s %-20s %-20s %-20s\n" "Signal" "Format" "Bytes per sample" "Compressed" "Time per sample"
+
+for SIGNAL in ${SIGNALS}; do
+    villas signal -n -l ${NUM_SAMPLES} -v ${NUM_VALUES} -F 0.1 ${SIGNAL} > input.dat
+
+    for FORMAT in ${FORMATS}; do
+        START=$(date +%s%N)
+        villas convert -t ${NUM_VALUES}f -o ${FORMAT} < input.dat > output.dat
+        END=$(date +%s%N)
+
+        BYTES=$(stat -c %s output.dat)
+        COMPRESSED=$(gzip -c output.dat | wc -c)
+
+        printf "%-10s %-15s %-20s %-20s %-20s\n" ${SIGNAL} ${FORMAT} \
+            "$(( ${BYTES} / ${NUM_SAMPLES} )) B" \
+            "$(( ${COMPRESSED} / ${NUM_SAMPLES} )) B" \
+            "$(( (${END} - ${START}) / ${NUM_SAMPLES} )) ns"
+    done
+done
@@ -0,0 +1,97 @@
+#!/usr/bin/env bash
+#
+# Benchmark of the expr hook against equivalent Lua expressions and hook chains.
+#
+# Author: Steffen Vogel <post@steffenvogel.de>
+# SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+# SPDX-License-Identifier: Apache-2.0
+
+set -e
+
+# Settings
+NUM_SAMPLES=${NUM_SAMPLES:-1000000}
+
+DIR=$(mktemp -d)
+pushd ${DIR}
+
+function finish {
+    popd
+    rm -rf ${DIR}
+}
+trap finish EXIT
+
+# All variants calculate sine * 55 + 100 and round(ramp * 10) / 10
+HOOKS_EXPR='{
+    "type": "expr",
+    "signals": [
+        { "name": "random", "expression": "random" },
+        { "name": "sine", "expression": "sine * 55 + 100" },
+        { "name": "square", "expression": "square" },
+        { "name": "triangle", "expression": "triangle" },
+        { "name": "ramp", "expression": "round(ramp * 10) / 10" }
+    ]
+}'
+
+HOOKS_LUA='{
+    "type": "lua",
+    "signals": [
+        { "name": "random", "expression": "smp.data.random" },
+        { "name": "sine", "expression": "smp.data.sine * 55 + 100" },
+        { "name": "square", "expression": "smp.data.square" },
+        { "name": "triangle", "expression": "smp.data.triangle" },
+        { "name": "ramp", "expression": "math.floor(smp.data.ramp * 10 + 0.5) / 10" }
+    ]
+}'
+
+HOOKS_CHAIN='{
+    "type": "scale",
+    "signal": "sine",
+    "scale": 55,
+    "offset": 100
+}, {
+    "type": "round",
+    "signal": "ramp",
+    "precision": 1
+}'
+
+# Baseline without any hooks
+HOOKS_NONE=''
+
+printf "%-10s %-20s\n" "Variant" "Time per sample"
+
+for VARIANT in NONE CHAIN LUA EXPR; do
+    HOOKS_VAR="HOOKS_${VARIANT}"
+
+    cat > config.json <<EOF
+{
+    "idle_stop": true,
+    "nodes": {
+        "signal_node": {
+            "type": "signal",
+            "signal": "mixed",
+            "realtime": false,
+            "limit": ${NUM_SAMPLES},
+            "rate": 1000,
+            "values": 5
+        },
+        "null_node": {
+            "type": "file",
+            "uri": "/dev/null"
+        }
+    },
+    "paths": [
+        {
+            "in": "signal_node",
+            "out": "null_node",
+            "hooks": [ ${!HOOKS_VAR} ]
+        }
+    ]
+}
+EOF
+
+    START=$(date +%s%N)
+    villas node config.json > /dev/null 2>&1
+    END=$(date +%s%N)
+
+    printf "%-10s %-20s\n" ${VARIANT} "$(( (END - START) / NUM_SAMPLES )) ns"
+done
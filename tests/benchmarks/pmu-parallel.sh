@@ -0,0 +1,58 @@
+#!/usr/bin/env bash
+#
+# Benchmark of the latency of the phasor estimation with parallel channels.
+#
+# Author: Manuel Pitz <manuel.pitz@eonerc.rwth-aachen.de>
+# SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+# SPDX-License-Identifier: Apache-2.0
+
+set -e
+
+# Settings
+
+# ${CHANNELS} and ${THREADS} may be a list.
+
+CHANNELS=(1 2 4 8 16)
+THREADS=(1 2 4 8)
+SAMPLE_RATE=10000
+NUM_SAMPLES=100000
+
+DIR=$(mktemp -d)
+pushd ${DIR}
+
+function finish {
+    popd
+    rm -rf ${DIR}
+}
+trap finish EXIT
+
+printf "%-10s %-10s %-40s\n" "Channels" "Threads" "Estimation time per tick"
+
+for NUM_CHANNELS in "${CHANNELS[@]}"; do
+    SIGNALS=$(seq -s '", "signal' -f '%.0f' 0 $((NUM_CHANNELS - 1)))
+
+    # Generate the input once for all thread counts
+    # Without header, the signals are named signal0, signal1, ...
+    villas signal -n -v ${NUM_CHANNELS} -r ${SAMPLE_RATE} -l ${NUM_SAMPLES} -F 50 -a 230 sine | \
+        grep -v '^#' > input.dat
+
+    for NUM_THREADS in "${THREADS[@]}"; do
+        cat > config.json <<EOF
+{
+    "signals": [ "signal${SIGNALS}" ],
+    "sample_rate": ${SAMPLE_RATE},
+    "dft_rate": 50,
+    "estimation_range": 10,
+    "nominal_freq": 50,
+    "number_plc": 10,
+    "window_type": "hann",
+    "threads": ${NUM_THREADS}
+}
+EOF
+
+        RESULT=$(villas hook -c config.json ip-dft-pmu < input.dat 2>&1 > /dev/null | \
+            grep -o "took .*" || echo "no result")
+
+        printf "%-10s %-10s %-40s\n" ${NUM_CHANNELS} ${NUM_THREADS} "${RESULT}"
+    done
+done
@@ -119,6 +119,7 @@ EOF
 
     # Some nodes require special treatment:
     #   * loopback node: target_node is identical to source_node
+    #   * zeromq_inproc node: both nodes must share a single process
     #   * infiniband node: one node must be executed in a namespace
 
     # loopback
@@ -141,6 +142,26 @@ paths = (
 EOF
     fi
 
+    # inproc:// endpoints are only reachable from within the same process
+    if [ "${NODETYPE}" == "zeromq_inproc" ]; then
+cat > ${CONFIG_TARGET} <<EOF
+@include "${CONFIG//\/tmp\/}"
+
+paths = (
+    {
+        in = "siggen",
+        out = ("source_node", "results_in"),
+    },
+    {
+        in = "target_node",
+        out = "results_out",
+
+        original_sequence_no = true
+    }
+)
+EOF
+    fi
+
     # infiniband
     if [ "${NODETYPE}" == "infiniband" ]; then
         NAMESPACE_CMD='ip netns exec namespace0'
@@ -224,7 +245,7 @@ EOF
                 # Wait for node to complete init
                 sleep 2
 
-                if [ ! "${NODETYPE}" == "loopback" ]; then
+                if [ ! "${NODETYPE}" == "loopback" ] && [ ! "${NODETYPE}" == "zeromq_inproc" ]; then
                     # Start sending pipe
                     VILLAS_LOG_PREFIX=$(colorize "[source] ") \
                     ${NAMESPACE_CMD} cset proc --set=real-time-1 --exec ../../build/src/villas-node -- ${CONFIG_SOURCE} &
@@ -0,0 +1,34 @@
+#!/usr/bin/env bash
+#
+# Integration test for resample hook.
+#
+# Author: Steffen Vogel <post@steffenvogel.de>
+# SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+# SPDX-License-Identifier: Apache-2.0
+
+set -e
+
+DIR=$(mktemp -d)
+pushd ${DIR}
+
+function finish {
+    popd
+    rm -rf ${DIR}
+}
+trap finish EXIT
+
+NUM_SAMPLES=1000
+
+villas signal -r 1000 -l ${NUM_SAMPLES} -n -F 1 sine > input.dat
+
+for MODE in linear cubic fir; do
+    villas hook -o rate=100 -o input_rate=1000 -o mode=${MODE} resample > output.dat < input.dat
+
+    LINES=$(sed -re '/^#/d' output.dat | wc -l)
+
+    # One output sample per ten input samples, minus the latency of the interpolation
+    (( ${LINES} >= ${NUM_SAMPLES} / 10 - 3 && ${LINES} <= ${NUM_SAMPLES} / 10 ))
+
+    # All timestamps are aligned to the 10 ms grid
+    (( $(sed -re '/^#/d' output.dat | cut -f1 | grep -cvE '^[0-9]+\.[0-9]{2}0000000') == 0 ))
+done
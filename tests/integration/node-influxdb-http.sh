@@ -0,0 +1,97 @@
+#!/usr/bin/env bash
+#
+# Integration test for the asynchronous HTTP client of the influxdb node.
+#
+# Samples are posted to a local mock server which accounts the received
+# lines, requests and connections. The sustained throughput is reported.
+#
+# Author: Steffen Vogel <post@steffenvogel.de>
+# SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+# SPDX-License-Identifier: Apache-2.0
+
+set -e
+
+DIR=$(mktemp -d)
+pushd ${DIR}
+
+function finish {
+    kill ${SERVER_PID} 2> /dev/null || true
+    popd
+    rm -rf ${DIR}
+}
+trap finish EXIT
+
+NUM_SAMPLES=${NUM_SAMPLES:-100000}
+NUM_VALUES=${NUM_VALUES:-4}
+RATE=${RATE:-100000}
+PORT=${PORT:-18086}
+
+cat > server.py << EOF
+import http.server
+import socketserver
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def setup(self):
+        super().setup()
+        with open('connections.log', 'a') as f:
+            f.write('1\n')
+
+    def do_POST(self):
+        body = self.rfile.read(int(self.headers['Content-Length']))
+
+        with open('requests.log', 'a') as f:
+            f.write('%d\n' % body.count(b'\\n'))
+
+        self.send_response(204)
+        self.send_header('Content-Length', '0')
+        self.end_headers()
+
+    def log_message(self, *args):
+        pass
+
+class Server(socketserver.ThreadingMixIn, http.server.HTTPServer):
+    daemon_threads = True
+
+Server(('127.0.0.1', ${PORT}), Handler).serve_forever()
+EOF
+
+cat > config.json << EOF
+{
+    "nodes": {
+        "influxdb_node": {
+            "type": "influxdb",
+            "server": "http://127.0.0.1:${PORT}/api/v2/write?org=villas&bucket=villas&precision=ns",
+            "key": "villas",
+
+            "batch_size": 1000,
+            "max_latency": 0.05,
+            "max_in_flight": 4
+        }
+    }
+}
+EOF
+
+python3 server.py &
+SERVER_PID=$!
+
+sleep 1
+
+START=$(date +%s%N)
+
+villas signal -l ${NUM_SAMPLES} -r ${RATE} -v ${NUM_VALUES} sine | \
+villas pipe -s -l ${NUM_SAMPLES} config.json influxdb_node
+
+END=$(date +%s%N)
+
+LINES=$(awk '{ s += $1 } END { print s }' requests.log)
+REQUESTS=$(wc -l < requests.log)
+CONNECTIONS=$(wc -l < connections.log)
+
+echo "Received ${LINES} samples in ${REQUESTS} requests over ${CONNECTIONS} connections"
+echo "Throughput: $(( ${LINES} * 1000000000 / (${END} - ${START}) )) samples/s"
+
+# All samples must arrive and connections must be reused
+(( ${LINES} == ${NUM_SAMPLES} ))
+(( ${CONNECTIONS} <= 4 ))
@@ -0,0 +1,186 @@
+#!/usr/bin/env bash
+#
+# Integration test for the concurrent Modbus TCP client of the modbus node.
+#
+# The devices are served by a local mock server which answers pipelined
+# requests in reverse order, responds with exceptions or not at all depending
+# on the unit and closes the connection periodically.
+#
+# Author: Steffen Vogel <post@steffenvogel.de>
+# SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+# SPDX-License-Identifier: Apache-2.0
+
+if ! villas node -h | grep -q modbus; then
+    echo "Modbus node-type is not supported"
+    exit 99
+fi
+
+set -e
+
+DIR=$(mktemp -d)
+pushd ${DIR}
+
+function finish {
+    kill ${SERVER_PID} 2> /dev/null || true
+    popd
+    rm -rf ${DIR}
+}
+trap finish EXIT
+
+NUM_SAMPLES=${NUM_SAMPLES:-100}
+PORT=${PORT:-15020}
+
+# Unit 1 returns the address as register value, unit 2 responds with an
+# exception and unit 3 never responds
+cat > server.py << 'EOF'
+import socket
+import socketserver
+import struct
+import sys
+import time
+
+REQUESTS_PER_CONNECTION = 200
+
+class Handler(socketserver.BaseRequestHandler):
+    def handle(self):
+        with open('connections.log', 'a') as f:
+            f.write('1\n')
+
+        buf = b''
+        handled = 0
+
+        while handled < REQUESTS_PER_CONNECTION:
+            data = self.request.recv(4096)
+            if not data:
+                return
+
+            # Give the client a chance to pipeline more requests
+            time.sleep(0.005)
+            self.request.setblocking(False)
+            try:
+                buf += data + self.request.recv(4096)
+            except BlockingIOError:
+                buf += data
+            self.request.setblocking(True)
+
+            responses = []
+            while len(buf) >= 7:
+                tid, _, length, unit = struct.unpack('>HHHB', buf[:7])
+                if len(buf) < 6 + length:
+                    break
+
+                pdu, buf = buf[7:6 + length], buf[6 + length:]
+                fc = pdu[0]
+
+                if unit == 1 and fc == 3:
+                    addr, cnt = struct.unpack('>HH', pdu[1:5])
+                    regs = [(addr + i) & 0xFFFF for i in range(cnt)]
+                    pdu = struct.pack('>BB%dH' % cnt, fc, 2 * cnt, *regs)
+                elif unit == 2:
+                    pdu = struct.pack('>BB', fc | 0x80, 2)
+                else:
+                    continue
+
+                responses.append(
+                    struct.pack('>HHHB', tid, 0, len(pdu) + 1, unit) + pdu)
+
+            handled += len(responses)
+
+            with open('pipelined.log', 'a') as f:
+                f.write('%d\n' % len(responses))
+
+            # Answer out of order
+            self.request.sendall(b''.join(reversed(responses)))
+
+class Server(socketserver.ThreadingMixIn, socketserver.TCPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+
+Server(('127.0.0.1', int(sys.argv[1])), Handler).serve_forever()
+EOF
+
+cat > config.json << EOF
+{
+    "nodes": {
+        "modbus_good": {
+            "type": "modbus",
+            "transport": "tcp",
+            "rate": 20,
+            "response_timeout": 0.2,
+            "reconnect_interval": 0.1,
+            "max_in_flight": 8,
+
+            "devices": [
+                { "name": "a", "remote": "127.0.0.1", "port": ${PORT}, "unit": 1, "rate": 50 },
+                { "name": "b", "remote": "127.0.0.1", "port": ${PORT}, "unit": 1, "rate": 50 }
+            ],
+
+            "in": {
+                "signals": [
+                    { "type": "integer", "address": 16, "device": "a" },
+                    { "type": "integer", "address": 32, "device": "a" },
+                    { "type": "integer", "address": 48, "device": "b" },
+                    { "type": "integer", "address": 64, "device": "b" }
+                ]
+            }
+        },
+        "modbus_bad": {
+            "type": "modbus",
+            "transport": "tcp",
+            "rate": 20,
+            "response_timeout": 0.2,
+            "reconnect_interval": 0.1,
+
+            "devices": [
+                { "name": "exception", "remote": "127.0.0.1", "port": ${PORT}, "unit": 2 },
+                { "name": "silent", "remote": "127.0.0.1", "port": ${PORT}, "unit": 3 },
+                { "name": "good", "remote": "127.0.0.1", "port": ${PORT}, "unit": 1 }
+            ],
+
+            "in": {
+                "signals": [
+                    { "type": "float", "address": 16, "device": "exception" },
+                    { "type": "float", "address": 16, "device": "silent" },
+                    { "type": "integer", "address": 16, "device": "good" }
+                ]
+            }
+        }
+    }
+}
+EOF
+
+python3 server.py ${PORT} &
+SERVER_PID=$!
+
+sleep 1
+
+villas pipe -r -l ${NUM_SAMPLES} -T 60 config.json modbus_good > good.dat 2> good.log
+villas pipe -r -l ${NUM_SAMPLES} -T 60 config.json modbus_bad > bad.dat 2> bad.log
+
+# All values must match their addresses despite reordered responses
+SAMPLES=$(grep -v '^#' good.dat | wc -l)
+MISMATCHES=$(grep -v '^#' good.dat | awk '$2 != 16 || $3 != 32 || $4 != 48 || $5 != 64' | wc -l)
+MAX_PIPELINED=$(sort -n pipelined.log | tail -n1)
+CONNECTIONS=$(wc -l < connections.log)
+
+echo "Received ${SAMPLES} samples with ${MISMATCHES} mismatches over ${CONNECTIONS} connections"
+echo "At most ${MAX_PIPELINED} requests were answered at once"
+
+(( ${SAMPLES} == ${NUM_SAMPLES} ))
+(( ${MISMATCHES} == 0 ))
+(( ${MAX_PIPELINED} > 1 ))
+
+# The server closes connections periodically
+(( ${CONNECTIONS} > 2 ))
+
+# Devices which never answer properly are marked invalid without affecting
+# the others
+INVALID=$(grep -v '^#' bad.dat | awk 'tolower($2) ~ /nan/ && tolower($3) ~ /nan/' | wc -l)
+LAST_GOOD=$(grep -v '^#' bad.dat | tail -n1 | awk '{ print $4 }')
+
+(( $(grep -v '^#' bad.dat | wc -l) == ${NUM_SAMPLES} ))
+(( ${INVALID} == ${NUM_SAMPLES} ))
+(( ${LAST_GOOD} == 16 ))
+grep -q "responded with exception 2" bad.log
+grep -q "Response timeout for device silent" bad.log
+grep -q "Values of device silent are stale" bad.log
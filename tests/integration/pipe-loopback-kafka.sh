@@ -0,0 +1,62 @@
+#!/usr/bin/env bash
+#
+# Integration loopback test for villas pipe using a Kafka broker.
+#
+# Author: Steffen Vogel <post@steffenvogel.de>
+# SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+# SPDX-License-Identifier: Apache-2.0
+
+set -e
+
+DIR=$(mktemp -d)
+pushd ${DIR}
+
+function finish {
+    popd
+    rm -rf ${DIR}
+}
+trap finish EXIT
+
+NUM_SAMPLES=${NUM_SAMPLES:-100}
+FORMAT="protobuf"
+VECTORIZE="10"
+TOPIC="test-topic-${RANDOM}"
+
+if [ -n "${CI}" ]; then
+    HOST="kafka"
+else
+    HOST="localhost"
+fi
+
+# Each sample is sent as a separate message in batches of ${VECTORIZE} messages
+cat > config.json << EOF
+{
+    "nodes": {
+        "node1": {
+             "type": "kafka",
+             "format": "${FORMAT}",
+             "vectorize": ${VECTORIZE},
+
+             "server": "${HOST}:9092",
+             "protocol": "PLAINTEXT",
+             "client_id": "villas-node",
+
+             "out": {
+                 "produce": "${TOPIC}",
+                 "linger": 0.001,
+                 "samples_per_message": 1
+             },
+             "in": {
+                 "consume": "${TOPIC}",
+                 "group_id": "villas-node"
+             }
+        }
+    }
+}
+EOF
+
+villas signal -l ${NUM_SAMPLES} -n random > input.dat
+
+villas pipe -l ${NUM_SAMPLES} config.json node1 > output.dat < <(sleep 2; cat input.dat)
+
+villas compare input.dat output.dat
@@ -0,0 +1,65 @@
+#!/usr/bin/env bash
+#
+# Integration loopback test for villas pipe using batched MQTT publishing
+# and a shared subscription.
+#
+# Author: Steffen Vogel <post@steffenvogel.de>
+# SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+# SPDX-License-Identifier: Apache-2.0
+
+set -e
+
+DIR=$(mktemp -d)
+pushd ${DIR}
+
+function finish {
+    popd
+    rm -rf ${DIR}
+}
+trap finish EXIT
+
+NUM_SAMPLES=${NUM_SAMPLES:-100}
+FORMAT="protobuf"
+TOPIC="test-topic-${RANDOM}"
+
+if [ -n "${CI}" ]; then
+    HOST="mosquitto"
+else
+    HOST="localhost"
+fi
+
+# Writes of 5 samples are coalesced into messages of 20 samples
+cat > config.json << EOF
+{
+    "nodes": {
+        "node1": {
+             "type": "mqtt",
+             "format": "${FORMAT}",
+
+             "username": "guest",
+             "password": "guest",
+             "host": "${HOST}",
+             "port": 1883,
+             "qos": 1,
+
+             "out": {
+                 "publish": "${TOPIC}",
+                 "vectorize": 5,
+                 "batch_size": 20,
+                 "max_latency": 0.05
+             },
+             "in": {
+                 "subscribe": "${TOPIC}",
+                 "group": "villas",
+                 "vectorize": 20
+             }
+        }
+    }
+}
+EOF
+
+villas signal -l ${NUM_SAMPLES} -n random > input.dat
+
+villas pipe -l ${NUM_SAMPLES} config.json node1 > output.dat < <(sleep 2; cat input.dat)
+
+villas compare input.dat output.dat
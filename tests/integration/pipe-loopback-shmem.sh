@@ -20,7 +20,7 @@ trap finish EXIT
 NUM_SAMPLES=${NUM_SAMPLES:-10}
 SIGNAL_COUNT=${SIGNAL_COUNT:-10}
 
-for MODE in polling pthread; do
+for MODE in polling pthread futex; do
 for VECTORIZE in 1 5; do
 
 cat > config.json << EOF
@@ -0,0 +1,150 @@
+#!/usr/bin/env bash
+#
+# Integration loopback test for the AF_XDP backend of the socket and
+# iec61850-9-2 node-types.
+#
+# Frames are exchanged over a virtual Ethernet pair inside a network namespace
+# so no special NIC is required. The veth driver supports AF_XDP in skb mode.
+#
+# Author: Steffen Vogel <post@steffenvogel.de>
+# SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+# SPDX-License-Identifier: Apache-2.0
+
+set -e
+
+if [ "${EUID}" -ne 0 ] || [ -n "${CI}" ]; then
+    echo "Test requires root permissions"
+    exit 99
+fi
+
+DIR=$(mktemp -d)
+pushd ${DIR}
+
+NETNS=villas-xdp-$$
+
+function finish {
+    ip netns delete ${NETNS} 2> /dev/null || true
+    popd
+    rm -rf ${DIR}
+}
+trap finish EXIT
+
+NUM_SAMPLES=${NUM_SAMPLES:-100}
+NUM_VALUES=${NUM_VALUES:-4}
+
+ip netns add ${NETNS}
+ip -n ${NETNS} link add vx0 type veth peer name vx1
+ip -n ${NETNS} link set vx0 up
+ip -n ${NETNS} link set vx1 up
+
+MAC0=$(ip netns exec ${NETNS} cat /sys/class/net/vx0/address)
+MAC1=$(ip netns exec ${NETNS} cat /sys/class/net/vx1/address)
+
+# Layer 2 sockets: node1 sends via vx0 to node2 on its peer vx1
+cat > socket.json << EOF
+{
+    "nodes": {
+        "node1": {
+            "type": "socket",
+            "layer": "eth",
+
+            "xdp": {
+                "mode": "skb"
+            },
+
+            "out": {
+                "address": "${MAC1}%vx0:34997"
+            },
+            "in": {
+                "address": "${MAC0}%vx0:34997"
+            }
+        },
+        "node2": {
+            "type": "socket",
+            "layer": "eth",
+
+            "xdp": {
+                "mode": "skb"
+            },
+
+            "out": {
+                "address": "${MAC0}%vx1:34997"
+            },
+            "in": {
+                "address": "${MAC1}%vx1:34997",
+                "signals": {
+                    "count": ${NUM_VALUES},
+                    "type": "float"
+                }
+            }
+        }
+    }
+}
+EOF
+
+villas signal -v ${NUM_VALUES} -l ${NUM_SAMPLES} -n random > input.dat
+
+ip netns exec ${NETNS} \
+villas pipe -r -l ${NUM_SAMPLES} socket.json node2 > output.dat &
+RECV_PID=$!
+
+sleep 1
+
+ip netns exec ${NETNS} \
+villas pipe -s socket.json node1 < input.dat
+
+wait ${RECV_PID}
+
+villas compare input.dat output.dat
+
+# Sampled values: a publisher on vx0 and a subscriber on vx1
+cat > sv.json << EOF
+{
+    "nodes": {
+        "pub": {
+            "type": "iec61850-9-2",
+            "interface": "vx0",
+
+            "xdp": {
+                "mode": "skb"
+            },
+
+            "out": {
+                "sv_id": "1234",
+                "signals": {
+                    "iec_type": "float64",
+                    "count": ${NUM_VALUES}
+                }
+            }
+        },
+        "sub": {
+            "type": "iec61850-9-2",
+            "interface": "vx1",
+
+            "xdp": {
+                "mode": "skb"
+            },
+
+            "in": {
+                "signals": {
+                    "iec_type": "float64",
+                    "count": ${NUM_VALUES}
+                }
+            }
+        }
+    }
+}
+EOF
+
+ip netns exec ${NETNS} \
+villas pipe -r -l ${NUM_SAMPLES} sv.json sub > output.dat &
+SUB_PID=$!
+
+sleep 1
+
+ip netns exec ${NETNS} \
+villas pipe -s sv.json pub < input.dat
+
+wait ${SUB_PID}
+
+villas compare -T input.dat output.dat
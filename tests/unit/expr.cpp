@@ -0,0 +1,111 @@
+/* Unit tests for the expression compiler of the expr hook.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <cmath>
+#include <vector>
+
+#include <criterion/criterion.h>
+
+#include <villas/exceptions.hpp>
+#include <villas/hooks/expr.hpp>
+
+using namespace villas;
+using namespace villas::node::expr;
+
+static double evaluate(const std::string &expr, double x = 0, double y = 0) {
+  Program prog({"x", "y", "name with spaces"});
+
+  prog.compile(expr);
+
+  std::vector<double> regs(prog.getRegisterCount());
+  prog.init(regs.data());
+
+  regs[0] = x;
+  regs[1] = y;
+  regs[2] = 7;
+
+  prog.evaluate(regs.data());
+
+  return regs[prog.getOutput(0)];
+}
+
+// cppcheck-suppress unknownMacro
+Test(expr, evaluate) {
+  cr_assert_float_eq(evaluate("1 + 2 * 3"), 7, 1e-12);
+  cr_assert_float_eq(evaluate("(1 + 2) * 3"), 9, 1e-12);
+  cr_assert_float_eq(evaluate("-2 ^ 2"), -4, 1e-12);
+  cr_assert_float_eq(evaluate("2 ^ 3 ^ 2"), 512, 1e-12);
+  cr_assert_float_eq(evaluate("7 % 4"), 3, 1e-12);
+  cr_assert_float_eq(evaluate("x * y + 1", 3, 4), 13, 1e-12);
+  cr_assert_float_eq(evaluate("x - y - 1", 3, 4), -2, 1e-12);
+  cr_assert_float_eq(evaluate("sqrt(x * x + y * y)", 3, 4), 5, 1e-12);
+  cr_assert_float_eq(evaluate("hypot(x, y)", 3, 4), 5, 1e-12);
+  cr_assert_float_eq(evaluate("max(x, y) - min(x, y)", 3, 4), 1, 1e-12);
+  cr_assert_float_eq(evaluate("sin(pi / 2)"), 1, 1e-12);
+  cr_assert_float_eq(evaluate("${name with spaces} * 2"), 14, 1e-12);
+
+  cr_assert_float_eq(evaluate("x < y", 3, 4), 1, 1e-12);
+  cr_assert_float_eq(evaluate("x >= y", 3, 4), 0, 1e-12);
+  cr_assert_float_eq(evaluate("x != y && !(x == y)", 3, 4), 1, 1e-12);
+  cr_assert_float_eq(evaluate("x > 5 || y > 5", 3, 4), 0, 1e-12);
+  cr_assert_float_eq(evaluate("x > y ? x : y", 3, 4), 4, 1e-12);
+  cr_assert_float_eq(evaluate("x > y ? x : y > 3 ? 10 : 20", 3, 4), 10,
+                     1e-12);
+}
+
+Test(expr, fold) {
+  Program prog({"x"});
+
+  // Constant sub-expressions and identities do not emit any instructions
+  prog.compile("2 * pi * 50");
+  prog.compile("x * 1 + 0");
+  prog.compile("1 > 0 ? x : x * x");
+  cr_assert_eq(prog.getTape().size(), 0);
+  cr_assert_eq(prog.getOutput(1), 0);
+  cr_assert_eq(prog.getOutput(2), 0);
+
+  // Common sub-expressions share their instructions
+  prog.compile("x * x + 1");
+  prog.compile("x * x + 2");
+  cr_assert_eq(prog.getTape().size(), 3);
+}
+
+Test(expr, lanes) {
+  const size_t lanes = 16;
+  Program prog({"x", "y"});
+
+  prog.compile("x * y + sin(x)");
+  prog.compile("x > y");
+
+  std::vector<double> regs(prog.getRegisterCount() * lanes);
+  prog.init(regs.data(), lanes);
+
+  for (size_t l = 0; l < lanes; l++) {
+    regs[0 * lanes + l] = l;
+    regs[1 * lanes + l] = 8;
+  }
+
+  prog.evaluate(regs.data(), lanes);
+
+  for (size_t l = 0; l < lanes; l++) {
+    cr_assert_float_eq(regs[prog.getOutput(0) * lanes + l], l * 8.0 + sin(l),
+                       1e-12);
+    cr_assert_float_eq(regs[prog.getOutput(1) * lanes + l], l > 8 ? 1 : 0,
+                       1e-12);
+  }
+}
+
+Test(expr, errors) {
+  Program prog({"x"});
+
+  for (auto expr : {"x +", "(x", "z * 2", "foo(x)", "atan2(x)", "x x", "${x",
+                    "1 = 2", ""})
+    cr_assert_throw(prog.compile(expr), RuntimeError,
+                    "Expression '%s' must not compile", expr);
+
+  cr_assert_eq(prog.getOutputCount(), 0);
+}
@@ -221,6 +221,9 @@ ParameterizedTestParameters(format, lowlevel) {
       "{ \"type\": \"raw\", \"bits\": 64, \"endianess\": \"little\" }", 1, 64);
   params.emplace_back("{ \"type\": \"villas.human\" }", 10, 0);
   params.emplace_back("{ \"type\": \"villas.binary\" }", 10, 0);
+  params.emplace_back("{ \"type\": \"villas.delta\" }", 10, 0);
+  params.emplace_back(
+      "{ \"type\": \"villas.delta\", \"keyframe_interval\": 3 }", 10, 0);
   params.emplace_back("{ \"type\": \"csv\" }", 10, 0);
   params.emplace_back("{ \"type\": \"tsv\" }", 10, 0);
   params.emplace_back("{ \"type\": \"json\" }", 10, 0);
@@ -314,6 +317,9 @@ ParameterizedTestParameters(format, highlevel) {
       "{ \"type\": \"raw\", \"bits\": 64, \"endianess\": \"little\" }", 1, 64);
   params.emplace_back("{ \"type\": \"villas.human\" }", 10, 0);
   params.emplace_back("{ \"type\": \"villas.binary\" }", 10, 0);
+  params.emplace_back("{ \"type\": \"villas.delta\" }", 10, 0);
+  params.emplace_back(
+      "{ \"type\": \"villas.delta\", \"keyframe_interval\": 3 }", 10, 0);
   params.emplace_back("{ \"type\": \"csv\" }", 10, 0);
   params.emplace_back("{ \"type\": \"tsv\" }", 10, 0);
   params.emplace_back("{ \"type\": \"json\" }", 10, 0);
@@ -109,3 +109,37 @@ Test(memory, manager, .init = init_memory) {
   ret = memory::free(p);
   cr_assert(ret == 0);
 }
+
+Test(memory, accounting, .init = init_memory) {
+  int ret;
+  void *ptr1, *ptr2;
+
+  struct memory::Owner *o = memory::get_owner("test:accounting");
+
+  {
+    memory::OwnerScope scope("test:accounting");
+
+    ptr1 = memory::alloc(1024, &memory::heap);
+    cr_assert_not_null(ptr1);
+
+    ptr2 = memory::alloc(2048, &memory::heap);
+    cr_assert_not_null(ptr2);
+  }
+
+  struct memory::Account *a = &o->accounts[0];
+  cr_assert_eq(a->type, &memory::heap);
+  cr_assert_eq(a->allocations, 2);
+  cr_assert_geq(a->bytes, 3072);
+
+  size_t peak = a->peak;
+
+  ret = memory::free(ptr1);
+  cr_assert_eq(ret, 0);
+
+  ret = memory::free(ptr2);
+  cr_assert_eq(ret, 0);
+
+  cr_assert_eq(a->allocations, 0);
+  cr_assert_eq(a->bytes, 0);
+  cr_assert_eq(a->peak, peak);
+}
@@ -9,10 +9,12 @@
 #include <criterion/parameterized.h>
 
 #include <signal.h>
+#include <sys/resource.h>
 #include <vector>
 
 #include <villas/log.hpp>
 #include <villas/pool.hpp>
+#include <villas/sample.hpp>
 #include <villas/utils.hpp>
 
 using namespace villas;
@@ -77,3 +79,109 @@ ParameterizedTest(struct param *p, pool, basic, .init = init_memory) {
   ret = pool_destroy(&pool);
   cr_assert_eq(ret, 0, "Failed to destroy pool");
 }
+
+// cppcheck-suppress unknownMacro
+Test(pool, classes, .init = init_memory) {
+  int ret;
+  struct PoolClasses pc;
+  struct Pool *p;
+
+  ret = pool_classes_init(&pc, 64, 4, 32, 16, 1000, &memory::heap);
+  cr_assert_eq(ret, 0, "Failed to create size-classed pool");
+
+  // Payloads: 16, 32, 64, 128, 256, 512, 1000
+  cr_assert_eq(pc.num_classes, 7);
+
+  p = pool_classes_select(&pc, 32 + 1);
+  cr_assert_eq(p, &pc.pools[0]);
+
+  // Blocks are padded to cache lines, a payload of 100 needs the 128 class
+  p = pool_classes_select(&pc, 32 + 100);
+  cr_assert_eq(p, &pc.pools[3]);
+  cr_assert_eq(pool_classes(p), &pc);
+  cr_assert_eq(pool_available(p), 4);
+
+  p = pool_classes_select(&pc, 32 + 1000);
+  cr_assert_eq(p, pool_classes_largest(&pc));
+  cr_assert_eq(pool_available(p), 64);
+
+  p = pool_classes_select(&pc, p->blocksz + 1);
+  cr_assert_null(p);
+
+  void *ptr = pool_get(&pc.pools[0]);
+  cr_assert_not_null(ptr);
+  cr_assert_eq(pool_available(&pc.pools[0]), 3);
+
+  ret = pool_put(&pc.pools[0], ptr);
+  cr_assert_eq(ret, 1);
+
+  ret = pool_classes_destroy(&pc);
+  cr_assert_eq(ret, 0, "Failed to destroy size-classed pool");
+}
+
+// cppcheck-suppress unknownMacro
+Test(pool, prefault, .init = init_memory) {
+  int ret;
+  struct Pool pool;
+  struct rusage before, after;
+  const int cnt = 256;
+  const size_t blocksz = 4096;
+  void *ptrs[cnt];
+
+  ret = pool_init(&pool, cnt, blocksz, &memory::heap);
+  cr_assert_eq(ret, 0, "Failed to create pool");
+
+  ret = getrusage(RUSAGE_THREAD, &before);
+  cr_assert_eq(ret, 0);
+
+  // Touching all blocks must not cause any further page faults
+  for (int i = 0; i < cnt; i++) {
+    ptrs[i] = pool_get(&pool);
+    cr_assert_not_null(ptrs[i]);
+
+    memset(ptrs[i], 0xAA, blocksz);
+  }
+
+  ret = getrusage(RUSAGE_THREAD, &after);
+  cr_assert_eq(ret, 0);
+
+  cr_assert_eq(after.ru_minflt, before.ru_minflt,
+               "Touching prefaulted pool caused %ld page faults",
+               after.ru_minflt - before.ru_minflt);
+
+  for (int i = 0; i < cnt; i++)
+    pool_put(&pool, ptrs[i]);
+
+  ret = pool_destroy(&pool);
+  cr_assert_eq(ret, 0, "Failed to destroy pool");
+}
+
+// cppcheck-suppress unknownMacro
+Test(pool, classes_fallback, .init = init_memory) {
+  int ret;
+  struct PoolClasses pc;
+  struct Sample *smps[8];
+
+  ret = pool_classes_init(&pc, 4, 2, sizeof(struct Sample),
+                          SAMPLE_DATA_LENGTH(4), SAMPLE_DATA_LENGTH(16),
+                          &memory::heap);
+  cr_assert_eq(ret, 0, "Failed to create size-classed pool");
+  cr_assert_eq(pc.num_classes, 3);
+
+  // Short samples spill over into the larger classes
+  ret = sample_alloc_many(&pc, smps, 8, 4);
+  cr_assert_eq(ret, 8);
+  cr_assert_eq(pool_available(&pc.pools[0]), 0);
+  cr_assert_eq(pool_available(&pc.pools[1]), 0);
+  cr_assert_eq(pool_available(pool_classes_largest(&pc)), 0);
+
+  struct Sample *smp = sample_alloc(&pc, 4);
+  cr_assert_null(smp);
+
+  sample_decref_many(smps, 8);
+  cr_assert_eq(pool_available(&pc.pools[0]), 2);
+  cr_assert_eq(pool_available(pool_classes_largest(&pc)), 4);
+
+  ret = pool_classes_destroy(&pc);
+  cr_assert_eq(ret, 0, "Failed to destroy size-classed pool");
+}
@@ -101,7 +101,12 @@ ParameterizedTestParameters(queue_signalled, simple) {
     {QueueSignalledMode::POLLING, 0, false},
 #if defined(__linux__) && defined(HAS_EVENTFD)
     {QueueSignalledMode::EVENTFD, 0, false},
-    {QueueSignalledMode::EVENTFD, 0, true}
+    {QueueSignalledMode::EVENTFD, 0, true},
+#endif
+#ifdef HAS_FUTEX
+    {QueueSignalledMode::FUTEX, 0, false},
+    {QueueSignalledMode::FUTEX, (int)QueueSignalledFlags::PROCESS_SHARED,
+     false},
 #endif
   };
 
@@ -0,0 +1,179 @@
+/* Stress tests for the reorder_ts hook.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <criterion/criterion.h>
+#include <unistd.h>
+
+#include <villas/hook.hpp>
+#include <villas/pool.hpp>
+#include <villas/sample.hpp>
+#include <villas/signal_list.hpp>
+
+using namespace villas;
+using namespace villas::node;
+
+extern void init_memory();
+
+#define NUM_SAMPLES 1000000
+
+static Hook::Ptr make_hook(int window_size, double max_latency = 0) {
+  auto hf = plugin::registry->lookup<HookFactory>("reorder_ts");
+  cr_assert_not_null(hf);
+
+  auto h = hf->make(nullptr, nullptr);
+  cr_assert_not_null(h);
+
+  json_t *json = json_pack("{ s: i, s: f }", "window_size", window_size,
+                            "max_latency", max_latency);
+
+  h->parse(json);
+  h->check();
+  h->prepare(std::make_shared<SignalList>(1, SignalType::INTEGER));
+  h->start();
+
+  return h;
+}
+
+// Feed the samples in the given order and return the sequence numbers of the released ones
+static std::vector<uint64_t> reorder(Hook::Ptr h,
+                                     const std::vector<uint64_t> &order) {
+  int ret;
+  struct Pool pool;
+  std::vector<uint64_t> released;
+
+  ret = pool_init(&pool, 1, SAMPLE_LENGTH(1));
+  cr_assert_eq(ret, 0);
+
+  auto *smp = sample_alloc(&pool);
+  cr_assert_not_null(smp);
+
+  for (auto seq : order) {
+    smp->sequence = seq;
+    smp->length = 1;
+    smp->flags = (int)SampleFlags::HAS_SEQUENCE |
+                 (int)SampleFlags::HAS_TS_ORIGIN | (int)SampleFlags::HAS_DATA;
+    smp->ts.origin.tv_sec = seq / 1000;
+    smp->ts.origin.tv_nsec = (seq % 1000) * 1000000;
+    smp->data[0].i = seq;
+
+    if (h->process(smp) == Hook::Reason::OK) {
+      cr_assert_eq(smp->data[0].i, (int64_t)smp->sequence);
+
+      released.push_back(smp->sequence);
+    }
+  }
+
+  h->stop();
+
+  sample_free(smp);
+
+  ret = pool_destroy(&pool);
+  cr_assert_eq(ret, 0);
+
+  return released;
+}
+
+// Samples which are displaced by less than the window are fully reordered
+Test(reorder_ts, bounded_shuffle, .init = init_memory) {
+  const int window_size = 1024;
+
+  std::mt19937_64 rng(1234);
+  std::vector<uint64_t> order(NUM_SAMPLES);
+
+  for (unsigned i = 0; i < order.size(); i++)
+    order[i] = i;
+
+  for (auto it = order.begin(); it < order.end(); it += window_size)
+    std::shuffle(it, std::min(it + window_size, order.end()), rng);
+
+  auto h = make_hook(window_size);
+  auto released = reorder(h, order);
+
+  // The last window_size samples are still held
+  cr_assert_eq(released.size(), NUM_SAMPLES - window_size);
+
+  for (unsigned i = 0; i < released.size(); i++)
+    cr_assert_eq(released[i], i, "Sample %u has sequence %lu", i,
+                 (unsigned long)released[i]);
+}
+
+// Late samples are dropped, all others are released in order
+Test(reorder_ts, random_shuffle, .init = init_memory) {
+  const int window_size = 4096;
+
+  std::mt19937_64 rng(5678);
+  std::vector<uint64_t> order(NUM_SAMPLES);
+
+  for (unsigned i = 0; i < order.size(); i++)
+    order[i] = i;
+
+  std::shuffle(order.begin(), order.end(), rng);
+
+  auto h = make_hook(window_size);
+  auto released = reorder(h, order);
+
+  cr_assert_gt(released.size(), 0);
+  cr_assert_leq(released.size(), NUM_SAMPLES - window_size);
+
+  for (unsigned i = 1; i < released.size(); i++)
+    cr_assert_lt(released[i - 1], released[i]);
+}
+
+static Hook::Reason feed(Hook::Ptr h, struct Sample *smp, uint64_t seq) {
+  smp->sequence = seq;
+  smp->length = 1;
+  smp->flags = (int)SampleFlags::HAS_SEQUENCE |
+               (int)SampleFlags::HAS_TS_ORIGIN | (int)SampleFlags::HAS_DATA;
+  smp->ts.origin.tv_sec = seq;
+  smp->ts.origin.tv_nsec = 0;
+  smp->data[0].i = seq;
+
+  return h->process(smp);
+}
+
+// A sample held longer than max_latency is released before the window fills
+Test(reorder_ts, max_latency, .init = init_memory) {
+  int ret;
+  struct Pool pool;
+
+  ret = pool_init(&pool, 1, SAMPLE_LENGTH(1));
+  cr_assert_eq(ret, 0);
+
+  auto *smp = sample_alloc(&pool);
+  cr_assert_not_null(smp);
+
+  auto h = make_hook(16, 0.2);
+
+  cr_assert_eq(feed(h, smp, 10), Hook::Reason::SKIP_SAMPLE);
+
+  usleep(150000);
+
+  // Sample 5 is now the first in the heap, but sample 10 has been held longer
+  cr_assert_eq(feed(h, smp, 5), Hook::Reason::SKIP_SAMPLE);
+
+  usleep(150000);
+
+  cr_assert_eq(feed(h, smp, 20), Hook::Reason::OK);
+  cr_assert_eq(smp->sequence, 5);
+
+  cr_assert_eq(feed(h, smp, 30), Hook::Reason::OK);
+  cr_assert_eq(smp->sequence, 10);
+
+  // Samples 20 and 30 have just arrived
+  cr_assert_eq(feed(h, smp, 40), Hook::Reason::SKIP_SAMPLE);
+
+  h->stop();
+
+  sample_free(smp);
+
+  ret = pool_destroy(&pool);
+  cr_assert_eq(ret, 0);
+}
@@ -0,0 +1,136 @@
+/* Unit tests for the shared state vector of the shmem node.
+ *
+ * Author: Steffen Vogel <post@steffenvogel.de>
+ * SPDX-FileCopyrightText: 2014-2023 Institute for Automation of Complex Power Systems, RWTH Aachen University
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <criterion/criterion.h>
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <thread>
+
+#include <fmt/format.h>
+#include <unistd.h>
+
+#include <villas/sample.hpp>
+#include <villas/shmem.hpp>
+
+using namespace villas::node;
+
+#define NUM_VALUES 16
+#define NUM_UPDATES 100000
+
+// cppcheck-suppress unknownMacro
+Test(shmem, state_concurrent) {
+  int ret;
+  struct ShmemStateInterface w, r;
+
+  auto name = fmt::format("/villas-test-state-{}", getpid());
+
+  ret = shmem_state_open(name.c_str(), &w, NUM_VALUES, true);
+  cr_assert_eq(ret, 0, "Failed to create state vector");
+
+  // The reader attaches like an external process would
+  ret = shmem_state_open(name.c_str(), &r, 0, false);
+  cr_assert_eq(ret, 0, "Failed to attach to state vector");
+  cr_assert_eq(r.state->capacity, NUM_VALUES);
+
+  std::atomic<bool> done(false);
+
+  std::thread writer([&]() {
+    struct timespec ts = {0, 0};
+
+    for (uint64_t i = 1; i <= NUM_UPDATES; i++) {
+      auto *data = shmem_state_write_begin(w.state);
+
+      for (unsigned k = 0; k < NUM_VALUES; k++)
+        data[k].i = i;
+
+      shmem_state_write_end(w.state, NUM_VALUES, i, &ts);
+    }
+
+    done = true;
+  });
+
+  auto *smp = sample_alloc_mem(NUM_VALUES);
+  uint64_t last = 0, prev = 0;
+  unsigned snapshots = 0, torn = 0;
+
+  while (true) {
+    bool finished = done;
+
+    // Never give up while the writer is alive
+    ret = shmem_state_read(r.state, smp, &last, UINT_MAX);
+    cr_assert_geq(ret, 0);
+
+    if (ret == 1) {
+      cr_assert_eq(smp->length, NUM_VALUES);
+      cr_assert_gt(smp->sequence, prev, "Snapshots must not go back in time");
+
+      for (unsigned k = 0; k < NUM_VALUES; k++) {
+        if (smp->data[k].i != (int64_t)smp->sequence)
+          torn++;
+      }
+
+      prev = smp->sequence;
+      snapshots++;
+    }
+
+    if (finished && ret == 0)
+      break;
+  }
+
+  writer.join();
+
+  cr_assert_eq(torn, 0, "Reader observed %u torn values", torn);
+  cr_assert_gt(snapshots, 0);
+  cr_assert_eq(prev, NUM_UPDATES, "Reader missed the final state");
+
+  sample_free(smp);
+
+  ret = shmem_state_close(&r, false);
+  cr_assert_eq(ret, 0);
+
+  ret = shmem_state_close(&w, true);
+  cr_assert_eq(ret, 0);
+}
+
+// cppcheck-suppress unknownMacro
+Test(shmem, state_dead_writer) {
+  int ret;
+  struct ShmemStateInterface st;
+  struct timespec ts = {0, 0};
+
+  auto name = fmt::format("/villas-test-state-dead-{}", getpid());
+
+  ret = shmem_state_open(name.c_str(), &st, NUM_VALUES, true);
+  cr_assert_eq(ret, 0, "Failed to create state vector");
+
+  auto *smp = sample_alloc_mem(NUM_VALUES);
+  uint64_t last = 0;
+
+  // A writer which dies mid-update leaves the sequence lock odd
+  shmem_state_write_begin(st.state);
+
+  ret = shmem_state_read(st.state, smp, &last, 100);
+  cr_assert_eq(ret, -1);
+  cr_assert_eq(errno, EBUSY);
+  cr_assert_eq(last, 0);
+
+  shmem_state_write_end(st.state, NUM_VALUES, 1, &ts);
+
+  ret = shmem_state_read(st.state, smp, &last, 100);
+  cr_assert_eq(ret, 1);
+  cr_assert_eq(smp->sequence, 1);
+
+  ret = shmem_state_read(st.state, smp, &last, 100);
+  cr_assert_eq(ret, 0);
+
+  sample_free(smp);
+
+  ret = shmem_state_close(&st, true);
+  cr_assert_eq(ret, 0);
+}